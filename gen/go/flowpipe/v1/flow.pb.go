@@ -247,6 +247,113 @@ func (RestartPolicy) EnumDescriptor() ([]byte, []int) {
 	return file_flowpipe_v1_flow_proto_rawDescGZIP(), []int{3}
 }
 
+type ClockSource int32
+
+const (
+	// CLOCK_MONOTONIC.
+	ClockSource_CLOCK_SOURCE_UNSPECIFIED ClockSource = 0
+	// CLOCK_MONOTONIC, explicitly.
+	ClockSource_CLOCK_SOURCE_MONOTONIC ClockSource = 1
+	// Invariant TSC calibrated against CLOCK_MONOTONIC, with a periodic drift
+	// check. Falls back to CLOCK_MONOTONIC on CPUs without an invariant TSC.
+	ClockSource_CLOCK_SOURCE_TSC ClockSource = 2
+)
+
+// Enum value maps for ClockSource.
+var (
+	ClockSource_name = map[int32]string{
+		0: "CLOCK_SOURCE_UNSPECIFIED",
+		1: "CLOCK_SOURCE_MONOTONIC",
+		2: "CLOCK_SOURCE_TSC",
+	}
+	ClockSource_value = map[string]int32{
+		"CLOCK_SOURCE_UNSPECIFIED": 0,
+		"CLOCK_SOURCE_MONOTONIC":   1,
+		"CLOCK_SOURCE_TSC":         2,
+	}
+)
+
+func (x ClockSource) Enum() *ClockSource {
+	p := new(ClockSource)
+	*p = x
+	return p
+}
+
+func (x ClockSource) String() string {
+	return protoimpl.X.EnumStringOf(x.Descriptor(), protoreflect.EnumNumber(x))
+}
+
+func (ClockSource) Descriptor() protoreflect.EnumDescriptor {
+	return file_flowpipe_v1_flow_proto_enumTypes[4].Descriptor()
+}
+
+func (ClockSource) Type() protoreflect.EnumType {
+	return &file_flowpipe_v1_flow_proto_enumTypes[4]
+}
+
+func (x ClockSource) Number() protoreflect.EnumNumber {
+	return protoreflect.EnumNumber(x)
+}
+
+// Deprecated: Use ClockSource.Descriptor instead.
+func (ClockSource) EnumDescriptor() ([]byte, []int) {
+	return file_flowpipe_v1_flow_proto_rawDescGZIP(), []int{4}
+}
+
+type ExecutorMode int32
+
+const (
+	// Executor not specified (one thread per worker).
+	ExecutorMode_EXECUTOR_MODE_UNSPECIFIED ExecutorMode = 0
+	// Every stage worker gets a dedicated OS thread.
+	ExecutorMode_EXECUTOR_MODE_THREAD_PER_WORKER ExecutorMode = 1
+	// Stage workers run as cooperative tasks on a shared work-stealing pool.
+	// Stages with cpu_pinning, realtime_priority or deadline keep dedicated
+	// threads.
+	ExecutorMode_EXECUTOR_MODE_POOL ExecutorMode = 2
+)
+
+// Enum value maps for ExecutorMode.
+var (
+	ExecutorMode_name = map[int32]string{
+		0: "EXECUTOR_MODE_UNSPECIFIED",
+		1: "EXECUTOR_MODE_THREAD_PER_WORKER",
+		2: "EXECUTOR_MODE_POOL",
+	}
+	ExecutorMode_value = map[string]int32{
+		"EXECUTOR_MODE_UNSPECIFIED":       0,
+		"EXECUTOR_MODE_THREAD_PER_WORKER": 1,
+		"EXECUTOR_MODE_POOL":              2,
+	}
+)
+
+func (x ExecutorMode) Enum() *ExecutorMode {
+	p := new(ExecutorMode)
+	*p = x
+	return p
+}
+
+func (x ExecutorMode) String() string {
+	return protoimpl.X.EnumStringOf(x.Descriptor(), protoreflect.EnumNumber(x))
+}
+
+func (ExecutorMode) Descriptor() protoreflect.EnumDescriptor {
+	return file_flowpipe_v1_flow_proto_enumTypes[5].Descriptor()
+}
+
+func (ExecutorMode) Type() protoreflect.EnumType {
+	return &file_flowpipe_v1_flow_proto_enumTypes[5]
+}
+
+func (x ExecutorMode) Number() protoreflect.EnumNumber {
+	return protoreflect.EnumNumber(x)
+}
+
+// Deprecated: Use ExecutorMode.Descriptor instead.
+func (ExecutorMode) EnumDescriptor() ([]byte, []int) {
+	return file_flowpipe_v1_flow_proto_rawDescGZIP(), []int{5}
+}
+
 type ExecutionMode int32
 
 const (
@@ -283,11 +390,11 @@ func (x ExecutionMode) String() string {
 }
 
 func (ExecutionMode) Descriptor() protoreflect.EnumDescriptor {
-	return file_flowpipe_v1_flow_proto_enumTypes[4].Descriptor()
+	return file_flowpipe_v1_flow_proto_enumTypes[6].Descriptor()
 }
 
 func (ExecutionMode) Type() protoreflect.EnumType {
-	return &file_flowpipe_v1_flow_proto_enumTypes[4]
+	return &file_flowpipe_v1_flow_proto_enumTypes[6]
 }
 
 func (x ExecutionMode) Number() protoreflect.EnumNumber {
@@ -296,7 +403,7 @@ func (x ExecutionMode) Number() protoreflect.EnumNumber {
 
 // Deprecated: Use ExecutionMode.Descriptor instead.
 func (ExecutionMode) EnumDescriptor() ([]byte, []int) {
-	return file_flowpipe_v1_flow_proto_rawDescGZIP(), []int{4}
+	return file_flowpipe_v1_flow_proto_rawDescGZIP(), []int{6}
 }
 
 type InMemorySchemaFormat int32
@@ -342,11 +449,11 @@ func (x InMemorySchemaFormat) String() string {
 }
 
 func (InMemorySchemaFormat) Descriptor() protoreflect.EnumDescriptor {
-	return file_flowpipe_v1_flow_proto_enumTypes[5].Descriptor()
+	return file_flowpipe_v1_flow_proto_enumTypes[7].Descriptor()
 }
 
 func (InMemorySchemaFormat) Type() protoreflect.EnumType {
-	return &file_flowpipe_v1_flow_proto_enumTypes[5]
+	return &file_flowpipe_v1_flow_proto_enumTypes[7]
 }
 
 func (x InMemorySchemaFormat) Number() protoreflect.EnumNumber {
@@ -355,7 +462,7 @@ func (x InMemorySchemaFormat) Number() protoreflect.EnumNumber {
 
 // Deprecated: Use InMemorySchemaFormat.Descriptor instead.
 func (InMemorySchemaFormat) EnumDescriptor() ([]byte, []int) {
-	return file_flowpipe_v1_flow_proto_rawDescGZIP(), []int{5}
+	return file_flowpipe_v1_flow_proto_rawDescGZIP(), []int{7}
 }
 
 type ExternalSchemaFormat int32
@@ -405,11 +512,11 @@ func (x ExternalSchemaFormat) String() string {
 }
 
 func (ExternalSchemaFormat) Descriptor() protoreflect.EnumDescriptor {
-	return file_flowpipe_v1_flow_proto_enumTypes[6].Descriptor()
+	return file_flowpipe_v1_flow_proto_enumTypes[8].Descriptor()
 }
 
 func (ExternalSchemaFormat) Type() protoreflect.EnumType {
-	return &file_flowpipe_v1_flow_proto_enumTypes[6]
+	return &file_flowpipe_v1_flow_proto_enumTypes[8]
 }
 
 func (x ExternalSchemaFormat) Number() protoreflect.EnumNumber {
@@ -418,7 +525,7 @@ func (x ExternalSchemaFormat) Number() protoreflect.EnumNumber {
 
 // Deprecated: Use ExternalSchemaFormat.Descriptor instead.
 func (ExternalSchemaFormat) EnumDescriptor() ([]byte, []int) {
-	return file_flowpipe_v1_flow_proto_rawDescGZIP(), []int{6}
+	return file_flowpipe_v1_flow_proto_rawDescGZIP(), []int{8}
 }
 
 // Queue implementation type.
@@ -454,11 +561,11 @@ func (x QueueType) String() string {
 }
 
 func (QueueType) Descriptor() protoreflect.EnumDescriptor {
-	return file_flowpipe_v1_flow_proto_enumTypes[7].Descriptor()
+	return file_flowpipe_v1_flow_proto_enumTypes[9].Descriptor()
 }
 
 func (QueueType) Type() protoreflect.EnumType {
-	return &file_flowpipe_v1_flow_proto_enumTypes[7]
+	return &file_flowpipe_v1_flow_proto_enumTypes[9]
 }
 
 func (x QueueType) Number() protoreflect.EnumNumber {
@@ -467,7 +574,61 @@ func (x QueueType) Number() protoreflect.EnumNumber {
 
 // Deprecated: Use QueueType.Descriptor instead.
 func (QueueType) EnumDescriptor() ([]byte, []int) {
-	return file_flowpipe_v1_flow_proto_rawDescGZIP(), []int{7}
+	return file_flowpipe_v1_flow_proto_rawDescGZIP(), []int{9}
+}
+
+type CpuPlacementMode int32
+
+const (
+	// Placement not specified (only cpu_pinning applies).
+	CpuPlacementMode_CPU_PLACEMENT_MODE_UNSPECIFIED CpuPlacementMode = 0
+	// Only cpu_pinning applies.
+	CpuPlacementMode_CPU_PLACEMENT_MODE_MANUAL CpuPlacementMode = 1
+	// The runtime reads the cgroup cpuset and CPU topology and places stage
+	// workers itself: stages linked by a queue share an L3 domain, and hot
+	// stages get whole physical cores.
+	CpuPlacementMode_CPU_PLACEMENT_MODE_AUTO CpuPlacementMode = 2
+)
+
+// Enum value maps for CpuPlacementMode.
+var (
+	CpuPlacementMode_name = map[int32]string{
+		0: "CPU_PLACEMENT_MODE_UNSPECIFIED",
+		1: "CPU_PLACEMENT_MODE_MANUAL",
+		2: "CPU_PLACEMENT_MODE_AUTO",
+	}
+	CpuPlacementMode_value = map[string]int32{
+		"CPU_PLACEMENT_MODE_UNSPECIFIED": 0,
+		"CPU_PLACEMENT_MODE_MANUAL":      1,
+		"CPU_PLACEMENT_MODE_AUTO":        2,
+	}
+)
+
+func (x CpuPlacementMode) Enum() *CpuPlacementMode {
+	p := new(CpuPlacementMode)
+	*p = x
+	return p
+}
+
+func (x CpuPlacementMode) String() string {
+	return protoimpl.X.EnumStringOf(x.Descriptor(), protoreflect.EnumNumber(x))
+}
+
+func (CpuPlacementMode) Descriptor() protoreflect.EnumDescriptor {
+	return file_flowpipe_v1_flow_proto_enumTypes[10].Descriptor()
+}
+
+func (CpuPlacementMode) Type() protoreflect.EnumType {
+	return &file_flowpipe_v1_flow_proto_enumTypes[10]
+}
+
+func (x CpuPlacementMode) Number() protoreflect.EnumNumber {
+	return protoreflect.EnumNumber(x)
+}
+
+// Deprecated: Use CpuPlacementMode.Descriptor instead.
+func (CpuPlacementMode) EnumDescriptor() ([]byte, []int) {
+	return file_flowpipe_v1_flow_proto_rawDescGZIP(), []int{10}
 }
 
 type FlowState int32
@@ -522,11 +683,11 @@ func (x FlowState) String() string {
 }
 
 func (FlowState) Descriptor() protoreflect.EnumDescriptor {
-	return file_flowpipe_v1_flow_proto_enumTypes[8].Descriptor()
+	return file_flowpipe_v1_flow_proto_enumTypes[11].Descriptor()
 }
 
 func (FlowState) Type() protoreflect.EnumType {
-	return &file_flowpipe_v1_flow_proto_enumTypes[8]
+	return &file_flowpipe_v1_flow_proto_enumTypes[11]
 }
 
 func (x FlowState) Number() protoreflect.EnumNumber {
@@ -535,7 +696,7 @@ func (x FlowState) Number() protoreflect.EnumNumber {
 
 // Deprecated: Use FlowState.Descriptor instead.
 func (FlowState) EnumDescriptor() ([]byte, []int) {
-	return file_flowpipe_v1_flow_proto_rawDescGZIP(), []int{8}
+	return file_flowpipe_v1_flow_proto_rawDescGZIP(), []int{11}
 }
 
 type Flow struct {
@@ -748,7 +909,9 @@ type KubernetesSettings struct {
 	// Optional CPU affinity per stage.
 	CpuPinning map[string]*CpuSet `protobuf:"bytes,4,rep,name=cpu_pinning,json=cpuPinning,proto3" json:"cpu_pinning,omitempty" protobuf_key:"bytes,1,opt,name=key" protobuf_val:"bytes,2,opt,name=value"`
 	// Aggregate resource intent.
-	Resources     *Resources `protobuf:"bytes,5,opt,name=resources,proto3,oneof" json:"resources,omitempty"`
+	Resources *Resources `protobuf:"bytes,5,opt,name=resources,proto3,oneof" json:"resources,omitempty"`
+	// Automatic CPU placement for stages without a cpu_pinning entry.
+	CpuPlacement  *CpuPlacement `protobuf:"bytes,6,opt,name=cpu_placement,json=cpuPlacement,proto3,oneof" json:"cpu_placement,omitempty"`
 	unknownFields protoimpl.UnknownFields
 	sizeCache     protoimpl.SizeCache
 }
@@ -818,6 +981,13 @@ func (x *KubernetesSettings) GetResources() *Resources {
 	return nil
 }
 
+func (x *KubernetesSettings) GetCpuPlacement() *CpuPlacement {
+	if x != nil {
+		return x.CpuPlacement
+	}
+	return nil
+}
+
 // Kubernetes runtime options for flow workloads.
 type KubernetesOptions struct {
 	state protoimpl.MessageState `protogen:"open.v1"`
@@ -1021,7 +1191,21 @@ func (x *KubernetesCronOptions) GetFailedJobsHistoryLimit() int32 {
 type Execution struct {
 	state protoimpl.MessageState `protogen:"open.v1"`
 	// Selected execution mode.
-	Mode          ExecutionMode `protobuf:"varint,1,opt,name=mode,proto3,enum=flowpipe.v1.ExecutionMode" json:"mode,omitempty"`
+	Mode ExecutionMode `protobuf:"varint,1,opt,name=mode,proto3,enum=flowpipe.v1.ExecutionMode" json:"mode,omitempty"`
+	// Run single-threaded producer/consumer pairs in one thread, calling the
+	// consumer directly instead of going through the queue between them.
+	// Queues can override this with QueueSpec.fuse.
+	FuseStages *bool `protobuf:"varint,2,opt,name=fuse_stages,json=fuseStages,proto3,oneof" json:"fuse_stages,omitempty"`
+	// How stage workers are mapped onto OS threads.
+	Executor ExecutorMode `protobuf:"varint,3,opt,name=executor,proto3,enum=flowpipe.v1.ExecutorMode" json:"executor,omitempty"`
+	// Pool size for EXECUTOR_MODE_POOL. Unset or 0 sizes the pool from the
+	// cgroup CPU quota.
+	PoolThreads *uint32 `protobuf:"varint,4,opt,name=pool_threads,json=poolThreads,proto3,oneof" json:"pool_threads,omitempty"`
+	// Thresholds for stages with min_threads/max_threads. Unset fields use
+	// runtime defaults.
+	Autoscale *AutoscalePolicy `protobuf:"bytes,5,opt,name=autoscale,proto3,oneof" json:"autoscale,omitempty"`
+	// Timestamp source for enqueue times and latency measurement.
+	ClockSource   ClockSource `protobuf:"varint,6,opt,name=clock_source,json=clockSource,proto3,enum=flowpipe.v1.ClockSource" json:"clock_source,omitempty"`
 	unknownFields protoimpl.UnknownFields
 	sizeCache     protoimpl.SizeCache
 }
@@ -1063,6 +1247,142 @@ func (x *Execution) GetMode() ExecutionMode {
 	return ExecutionMode_EXECUTION_MODE_UNSPECIFIED
 }
 
+func (x *Execution) GetFuseStages() bool {
+	if x != nil && x.FuseStages != nil {
+		return *x.FuseStages
+	}
+	return false
+}
+
+func (x *Execution) GetExecutor() ExecutorMode {
+	if x != nil {
+		return x.Executor
+	}
+	return ExecutorMode_EXECUTOR_MODE_UNSPECIFIED
+}
+
+func (x *Execution) GetPoolThreads() uint32 {
+	if x != nil && x.PoolThreads != nil {
+		return *x.PoolThreads
+	}
+	return 0
+}
+
+func (x *Execution) GetAutoscale() *AutoscalePolicy {
+	if x != nil {
+		return x.Autoscale
+	}
+	return nil
+}
+
+func (x *Execution) GetClockSource() ClockSource {
+	if x != nil {
+		return x.ClockSource
+	}
+	return ClockSource_CLOCK_SOURCE_UNSPECIFIED
+}
+
+type AutoscalePolicy struct {
+	state protoimpl.MessageState `protogen:"open.v1"`
+	// Supervisor sampling period (default 500).
+	IntervalMs *uint32 `protobuf:"varint,1,opt,name=interval_ms,json=intervalMs,proto3,oneof" json:"interval_ms,omitempty"`
+	// Input occupancy (buffered / capacity, 0-1) at or above which a sample
+	// counts as busy (default 0.75).
+	ScaleUpOccupancy *float64 `protobuf:"fixed64,2,opt,name=scale_up_occupancy,json=scaleUpOccupancy,proto3,oneof" json:"scale_up_occupancy,omitempty"`
+	// Input occupancy at or below which a sample counts as idle (default 0.10).
+	ScaleDownOccupancy *float64 `protobuf:"fixed64,3,opt,name=scale_down_occupancy,json=scaleDownOccupancy,proto3,oneof" json:"scale_down_occupancy,omitempty"`
+	// Mean queue dwell at or above which a sample counts as busy regardless of
+	// occupancy (default 100; 0 disables).
+	ScaleUpDwellMs *uint32 `protobuf:"varint,4,opt,name=scale_up_dwell_ms,json=scaleUpDwellMs,proto3,oneof" json:"scale_up_dwell_ms,omitempty"`
+	// Consecutive busy samples before a worker is added (default 3).
+	ScaleUpSamples *uint32 `protobuf:"varint,5,opt,name=scale_up_samples,json=scaleUpSamples,proto3,oneof" json:"scale_up_samples,omitempty"`
+	// Consecutive idle samples before a worker is retired (default 10).
+	ScaleDownSamples *uint32 `protobuf:"varint,6,opt,name=scale_down_samples,json=scaleDownSamples,proto3,oneof" json:"scale_down_samples,omitempty"`
+	// Minimum time between two scaling decisions of a stage (default 2000).
+	CooldownMs    *uint32 `protobuf:"varint,7,opt,name=cooldown_ms,json=cooldownMs,proto3,oneof" json:"cooldown_ms,omitempty"`
+	unknownFields protoimpl.UnknownFields
+	sizeCache     protoimpl.SizeCache
+}
+
+func (x *AutoscalePolicy) Reset() {
+	*x = AutoscalePolicy{}
+	mi := &file_flowpipe_v1_flow_proto_msgTypes[6]
+	ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
+	ms.StoreMessageInfo(mi)
+}
+
+func (x *AutoscalePolicy) String() string {
+	return protoimpl.X.MessageStringOf(x)
+}
+
+func (*AutoscalePolicy) ProtoMessage() {}
+
+func (x *AutoscalePolicy) ProtoReflect() protoreflect.Message {
+	mi := &file_flowpipe_v1_flow_proto_msgTypes[6]
+	if x != nil {
+		ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
+		if ms.LoadMessageInfo() == nil {
+			ms.StoreMessageInfo(mi)
+		}
+		return ms
+	}
+	return mi.MessageOf(x)
+}
+
+// Deprecated: Use AutoscalePolicy.ProtoReflect.Descriptor instead.
+func (*AutoscalePolicy) Descriptor() ([]byte, []int) {
+	return file_flowpipe_v1_flow_proto_rawDescGZIP(), []int{6}
+}
+
+func (x *AutoscalePolicy) GetIntervalMs() uint32 {
+	if x != nil && x.IntervalMs != nil {
+		return *x.IntervalMs
+	}
+	return 0
+}
+
+func (x *AutoscalePolicy) GetScaleUpOccupancy() float64 {
+	if x != nil && x.ScaleUpOccupancy != nil {
+		return *x.ScaleUpOccupancy
+	}
+	return 0
+}
+
+func (x *AutoscalePolicy) GetScaleDownOccupancy() float64 {
+	if x != nil && x.ScaleDownOccupancy != nil {
+		return *x.ScaleDownOccupancy
+	}
+	return 0
+}
+
+func (x *AutoscalePolicy) GetScaleUpDwellMs() uint32 {
+	if x != nil && x.ScaleUpDwellMs != nil {
+		return *x.ScaleUpDwellMs
+	}
+	return 0
+}
+
+func (x *AutoscalePolicy) GetScaleUpSamples() uint32 {
+	if x != nil && x.ScaleUpSamples != nil {
+		return *x.ScaleUpSamples
+	}
+	return 0
+}
+
+func (x *AutoscalePolicy) GetScaleDownSamples() uint32 {
+	if x != nil && x.ScaleDownSamples != nil {
+		return *x.ScaleDownSamples
+	}
+	return 0
+}
+
+func (x *AutoscalePolicy) GetCooldownMs() uint32 {
+	if x != nil && x.CooldownMs != nil {
+		return *x.CooldownMs
+	}
+	return 0
+}
+
 type StageSpec struct {
 	state protoimpl.MessageState `protogen:"open.v1"`
 	// Unique stage name within the flow.
@@ -1081,13 +1401,42 @@ type StageSpec struct {
 	Plugin *string `protobuf:"bytes,7,opt,name=plugin,proto3,oneof" json:"plugin,omitempty"`
 	// Optional real-time scheduling priority for worker threads (Linux only).
 	RealtimePriority *uint32 `protobuf:"varint,8,opt,name=realtime_priority,json=realtimePriority,proto3,oneof" json:"realtime_priority,omitempty"`
-	unknownFields    protoimpl.UnknownFields
-	sizeCache        protoimpl.SizeCache
+	// Additional input queues. Combined with input_queue (listed first);
+	// inputs are merged fairly.
+	InputQueues []string `protobuf:"bytes,9,rep,name=input_queues,json=inputQueues,proto3" json:"input_queues,omitempty"`
+	// Additional output queues. Combined with output_queue (listed first);
+	// payloads are broadcast, or routed by flat-map stages.
+	OutputQueues []string `protobuf:"bytes,10,rep,name=output_queues,json=outputQueues,proto3" json:"output_queues,omitempty"`
+	// Autoscaling bounds for consumer stages. When they differ, the runtime
+	// starts `threads` workers and adds or retires workers within
+	// [min_threads, max_threads] based on input queue occupancy and dwell.
+	// Unset bounds default to `threads`.
+	MinThreads *uint32 `protobuf:"varint,11,opt,name=min_threads,json=minThreads,proto3,oneof" json:"min_threads,omitempty"`
+	MaxThreads *uint32 `protobuf:"varint,12,opt,name=max_threads,json=maxThreads,proto3,oneof" json:"max_threads,omitempty"`
+	// Batch sink stages only: maximum payloads per consume_batch() call
+	// (default 64) and how long to wait for a batch to fill after its first
+	// payload arrives (default 0: take only what is already queued).
+	BatchSize *uint32 `protobuf:"varint,13,opt,name=batch_size,json=batchSize,proto3,oneof" json:"batch_size,omitempty"`
+	LingerMs  *uint32 `protobuf:"varint,14,opt,name=linger_ms,json=lingerMs,proto3,oneof" json:"linger_ms,omitempty"`
+	// Timer hooks for consumer stages implementing IStageTimers: on_tick()
+	// every tick_ms, on_idle() once no payload arrived for idle_ms.
+	// Unset or 0 disables the hook.
+	TickMs *uint32 `protobuf:"varint,15,opt,name=tick_ms,json=tickMs,proto3,oneof" json:"tick_ms,omitempty"`
+	IdleMs *uint32 `protobuf:"varint,16,opt,name=idle_ms,json=idleMs,proto3,oneof" json:"idle_ms,omitempty"`
+	// NUMA node for this stage's workers: they run on the node's CPUs (unless
+	// cpu_pinning says otherwise) and allocate memory there. Inferred from the
+	// stage's CPU pinning when unset.
+	NumaNode *uint32 `protobuf:"varint,17,opt,name=numa_node,json=numaNode,proto3,oneof" json:"numa_node,omitempty"`
+	// SCHED_DEADLINE reservation for worker threads (Linux only). Exclusive
+	// with realtime_priority.
+	Deadline      *DeadlineSchedule `protobuf:"bytes,18,opt,name=deadline,proto3,oneof" json:"deadline,omitempty"`
+	unknownFields protoimpl.UnknownFields
+	sizeCache     protoimpl.SizeCache
 }
 
 func (x *StageSpec) Reset() {
 	*x = StageSpec{}
-	mi := &file_flowpipe_v1_flow_proto_msgTypes[6]
+	mi := &file_flowpipe_v1_flow_proto_msgTypes[7]
 	ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
 	ms.StoreMessageInfo(mi)
 }
@@ -1099,7 +1448,7 @@ func (x *StageSpec) String() string {
 func (*StageSpec) ProtoMessage() {}
 
 func (x *StageSpec) ProtoReflect() protoreflect.Message {
-	mi := &file_flowpipe_v1_flow_proto_msgTypes[6]
+	mi := &file_flowpipe_v1_flow_proto_msgTypes[7]
 	if x != nil {
 		ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
 		if ms.LoadMessageInfo() == nil {
@@ -1112,7 +1461,7 @@ func (x *StageSpec) ProtoReflect() protoreflect.Message {
 
 // Deprecated: Use StageSpec.ProtoReflect.Descriptor instead.
 func (*StageSpec) Descriptor() ([]byte, []int) {
-	return file_flowpipe_v1_flow_proto_rawDescGZIP(), []int{6}
+	return file_flowpipe_v1_flow_proto_rawDescGZIP(), []int{7}
 }
 
 func (x *StageSpec) GetName() string {
@@ -1171,6 +1520,151 @@ func (x *StageSpec) GetRealtimePriority() uint32 {
 	return 0
 }
 
+func (x *StageSpec) GetInputQueues() []string {
+	if x != nil {
+		return x.InputQueues
+	}
+	return nil
+}
+
+func (x *StageSpec) GetOutputQueues() []string {
+	if x != nil {
+		return x.OutputQueues
+	}
+	return nil
+}
+
+func (x *StageSpec) GetMinThreads() uint32 {
+	if x != nil && x.MinThreads != nil {
+		return *x.MinThreads
+	}
+	return 0
+}
+
+func (x *StageSpec) GetMaxThreads() uint32 {
+	if x != nil && x.MaxThreads != nil {
+		return *x.MaxThreads
+	}
+	return 0
+}
+
+func (x *StageSpec) GetBatchSize() uint32 {
+	if x != nil && x.BatchSize != nil {
+		return *x.BatchSize
+	}
+	return 0
+}
+
+func (x *StageSpec) GetLingerMs() uint32 {
+	if x != nil && x.LingerMs != nil {
+		return *x.LingerMs
+	}
+	return 0
+}
+
+func (x *StageSpec) GetTickMs() uint32 {
+	if x != nil && x.TickMs != nil {
+		return *x.TickMs
+	}
+	return 0
+}
+
+func (x *StageSpec) GetIdleMs() uint32 {
+	if x != nil && x.IdleMs != nil {
+		return *x.IdleMs
+	}
+	return 0
+}
+
+func (x *StageSpec) GetNumaNode() uint32 {
+	if x != nil && x.NumaNode != nil {
+		return *x.NumaNode
+	}
+	return 0
+}
+
+func (x *StageSpec) GetDeadline() *DeadlineSchedule {
+	if x != nil {
+		return x.Deadline
+	}
+	return nil
+}
+
+// Constant-bandwidth reservation: every period_us, a worker may run for
+// runtime_us and gets it before deadline_us has elapsed.
+type DeadlineSchedule struct {
+	state protoimpl.MessageState `protogen:"open.v1"`
+	// CPU time per period, in microseconds.
+	RuntimeUs uint64 `protobuf:"varint,1,opt,name=runtime_us,json=runtimeUs,proto3" json:"runtime_us,omitempty"`
+	// Relative deadline in microseconds. 0 means period_us.
+	DeadlineUs uint64 `protobuf:"varint,2,opt,name=deadline_us,json=deadlineUs,proto3" json:"deadline_us,omitempty"`
+	// Activation period in microseconds.
+	PeriodUs uint64 `protobuf:"varint,3,opt,name=period_us,json=periodUs,proto3" json:"period_us,omitempty"`
+	// SCHED_FIFO priority to use when the kernel refuses the reservation.
+	// Unset keeps the default scheduler.
+	FallbackPriority *uint32 `protobuf:"varint,4,opt,name=fallback_priority,json=fallbackPriority,proto3,oneof" json:"fallback_priority,omitempty"`
+	unknownFields    protoimpl.UnknownFields
+	sizeCache        protoimpl.SizeCache
+}
+
+func (x *DeadlineSchedule) Reset() {
+	*x = DeadlineSchedule{}
+	mi := &file_flowpipe_v1_flow_proto_msgTypes[8]
+	ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
+	ms.StoreMessageInfo(mi)
+}
+
+func (x *DeadlineSchedule) String() string {
+	return protoimpl.X.MessageStringOf(x)
+}
+
+func (*DeadlineSchedule) ProtoMessage() {}
+
+func (x *DeadlineSchedule) ProtoReflect() protoreflect.Message {
+	mi := &file_flowpipe_v1_flow_proto_msgTypes[8]
+	if x != nil {
+		ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
+		if ms.LoadMessageInfo() == nil {
+			ms.StoreMessageInfo(mi)
+		}
+		return ms
+	}
+	return mi.MessageOf(x)
+}
+
+// Deprecated: Use DeadlineSchedule.ProtoReflect.Descriptor instead.
+func (*DeadlineSchedule) Descriptor() ([]byte, []int) {
+	return file_flowpipe_v1_flow_proto_rawDescGZIP(), []int{8}
+}
+
+func (x *DeadlineSchedule) GetRuntimeUs() uint64 {
+	if x != nil {
+		return x.RuntimeUs
+	}
+	return 0
+}
+
+func (x *DeadlineSchedule) GetDeadlineUs() uint64 {
+	if x != nil {
+		return x.DeadlineUs
+	}
+	return 0
+}
+
+func (x *DeadlineSchedule) GetPeriodUs() uint64 {
+	if x != nil {
+		return x.PeriodUs
+	}
+	return 0
+}
+
+func (x *DeadlineSchedule) GetFallbackPriority() uint32 {
+	if x != nil && x.FallbackPriority != nil {
+		return *x.FallbackPriority
+	}
+	return 0
+}
+
 type QueueSpec struct {
 	state protoimpl.MessageState `protogen:"open.v1"`
 	// Queue name.
@@ -1180,14 +1674,21 @@ type QueueSpec struct {
 	// Optional schema definition for queue payloads.
 	Schema *QueueSchema `protobuf:"bytes,3,opt,name=schema,proto3,oneof" json:"schema,omitempty"`
 	// Queue implementation type.
-	Type          *QueueType `protobuf:"varint,4,opt,name=type,proto3,enum=flowpipe.v1.QueueType,oneof" json:"type,omitempty"`
+	Type *QueueType `protobuf:"varint,4,opt,name=type,proto3,enum=flowpipe.v1.QueueType,oneof" json:"type,omitempty"`
+	// Fuse the producer and consumer of this queue (overrides
+	// Execution.fuse_stages). Only applies when the queue has exactly one
+	// producer and one consumer stage, each with threads = 1.
+	Fuse *bool `protobuf:"varint,5,opt,name=fuse,proto3,oneof" json:"fuse,omitempty"`
+	// NUMA node holding the queue's slots. Defaults to its consumers' node,
+	// then its producers', when they are all on one node.
+	NumaNode      *uint32 `protobuf:"varint,6,opt,name=numa_node,json=numaNode,proto3,oneof" json:"numa_node,omitempty"`
 	unknownFields protoimpl.UnknownFields
 	sizeCache     protoimpl.SizeCache
 }
 
 func (x *QueueSpec) Reset() {
 	*x = QueueSpec{}
-	mi := &file_flowpipe_v1_flow_proto_msgTypes[7]
+	mi := &file_flowpipe_v1_flow_proto_msgTypes[9]
 	ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
 	ms.StoreMessageInfo(mi)
 }
@@ -1199,7 +1700,7 @@ func (x *QueueSpec) String() string {
 func (*QueueSpec) ProtoMessage() {}
 
 func (x *QueueSpec) ProtoReflect() protoreflect.Message {
-	mi := &file_flowpipe_v1_flow_proto_msgTypes[7]
+	mi := &file_flowpipe_v1_flow_proto_msgTypes[9]
 	if x != nil {
 		ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
 		if ms.LoadMessageInfo() == nil {
@@ -1212,7 +1713,7 @@ func (x *QueueSpec) ProtoReflect() protoreflect.Message {
 
 // Deprecated: Use QueueSpec.ProtoReflect.Descriptor instead.
 func (*QueueSpec) Descriptor() ([]byte, []int) {
-	return file_flowpipe_v1_flow_proto_rawDescGZIP(), []int{7}
+	return file_flowpipe_v1_flow_proto_rawDescGZIP(), []int{9}
 }
 
 func (x *QueueSpec) GetName() string {
@@ -1243,6 +1744,20 @@ func (x *QueueSpec) GetType() QueueType {
 	return QueueType_QUEUE_TYPE_UNSPECIFIED
 }
 
+func (x *QueueSpec) GetFuse() bool {
+	if x != nil && x.Fuse != nil {
+		return *x.Fuse
+	}
+	return false
+}
+
+func (x *QueueSpec) GetNumaNode() uint32 {
+	if x != nil && x.NumaNode != nil {
+		return *x.NumaNode
+	}
+	return 0
+}
+
 type QueueSchema struct {
 	state protoimpl.MessageState `protogen:"open.v1"`
 	// Runtime representation of messages in the queue.
@@ -1259,7 +1774,7 @@ type QueueSchema struct {
 
 func (x *QueueSchema) Reset() {
 	*x = QueueSchema{}
-	mi := &file_flowpipe_v1_flow_proto_msgTypes[8]
+	mi := &file_flowpipe_v1_flow_proto_msgTypes[10]
 	ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
 	ms.StoreMessageInfo(mi)
 }
@@ -1271,7 +1786,7 @@ func (x *QueueSchema) String() string {
 func (*QueueSchema) ProtoMessage() {}
 
 func (x *QueueSchema) ProtoReflect() protoreflect.Message {
-	mi := &file_flowpipe_v1_flow_proto_msgTypes[8]
+	mi := &file_flowpipe_v1_flow_proto_msgTypes[10]
 	if x != nil {
 		ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
 		if ms.LoadMessageInfo() == nil {
@@ -1284,7 +1799,7 @@ func (x *QueueSchema) ProtoReflect() protoreflect.Message {
 
 // Deprecated: Use QueueSchema.ProtoReflect.Descriptor instead.
 func (*QueueSchema) Descriptor() ([]byte, []int) {
-	return file_flowpipe_v1_flow_proto_rawDescGZIP(), []int{8}
+	return file_flowpipe_v1_flow_proto_rawDescGZIP(), []int{10}
 }
 
 func (x *QueueSchema) GetFormat() InMemorySchemaFormat {
@@ -1329,7 +1844,7 @@ type Resources struct {
 
 func (x *Resources) Reset() {
 	*x = Resources{}
-	mi := &file_flowpipe_v1_flow_proto_msgTypes[9]
+	mi := &file_flowpipe_v1_flow_proto_msgTypes[11]
 	ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
 	ms.StoreMessageInfo(mi)
 }
@@ -1341,7 +1856,7 @@ func (x *Resources) String() string {
 func (*Resources) ProtoMessage() {}
 
 func (x *Resources) ProtoReflect() protoreflect.Message {
-	mi := &file_flowpipe_v1_flow_proto_msgTypes[9]
+	mi := &file_flowpipe_v1_flow_proto_msgTypes[11]
 	if x != nil {
 		ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
 		if ms.LoadMessageInfo() == nil {
@@ -1354,7 +1869,7 @@ func (x *Resources) ProtoReflect() protoreflect.Message {
 
 // Deprecated: Use Resources.ProtoReflect.Descriptor instead.
 func (*Resources) Descriptor() ([]byte, []int) {
-	return file_flowpipe_v1_flow_proto_rawDescGZIP(), []int{9}
+	return file_flowpipe_v1_flow_proto_rawDescGZIP(), []int{11}
 }
 
 func (x *Resources) GetCpuCores() uint32 {
@@ -1388,7 +1903,7 @@ type CpuSet struct {
 
 func (x *CpuSet) Reset() {
 	*x = CpuSet{}
-	mi := &file_flowpipe_v1_flow_proto_msgTypes[10]
+	mi := &file_flowpipe_v1_flow_proto_msgTypes[12]
 	ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
 	ms.StoreMessageInfo(mi)
 }
@@ -1400,7 +1915,7 @@ func (x *CpuSet) String() string {
 func (*CpuSet) ProtoMessage() {}
 
 func (x *CpuSet) ProtoReflect() protoreflect.Message {
-	mi := &file_flowpipe_v1_flow_proto_msgTypes[10]
+	mi := &file_flowpipe_v1_flow_proto_msgTypes[12]
 	if x != nil {
 		ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
 		if ms.LoadMessageInfo() == nil {
@@ -1413,7 +1928,7 @@ func (x *CpuSet) ProtoReflect() protoreflect.Message {
 
 // Deprecated: Use CpuSet.ProtoReflect.Descriptor instead.
 func (*CpuSet) Descriptor() ([]byte, []int) {
-	return file_flowpipe_v1_flow_proto_rawDescGZIP(), []int{10}
+	return file_flowpipe_v1_flow_proto_rawDescGZIP(), []int{12}
 }
 
 func (x *CpuSet) GetCpu() []uint32 {
@@ -1423,6 +1938,60 @@ func (x *CpuSet) GetCpu() []uint32 {
 	return nil
 }
 
+type CpuPlacement struct {
+	state protoimpl.MessageState `protogen:"open.v1"`
+	Mode  CpuPlacementMode       `protobuf:"varint,1,opt,name=mode,proto3,enum=flowpipe.v1.CpuPlacementMode" json:"mode,omitempty"`
+	// Stages that should not share a physical core with other workers.
+	// Empty means every placed stage is hot.
+	HotStages     []string `protobuf:"bytes,2,rep,name=hot_stages,json=hotStages,proto3" json:"hot_stages,omitempty"`
+	unknownFields protoimpl.UnknownFields
+	sizeCache     protoimpl.SizeCache
+}
+
+func (x *CpuPlacement) Reset() {
+	*x = CpuPlacement{}
+	mi := &file_flowpipe_v1_flow_proto_msgTypes[13]
+	ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
+	ms.StoreMessageInfo(mi)
+}
+
+func (x *CpuPlacement) String() string {
+	return protoimpl.X.MessageStringOf(x)
+}
+
+func (*CpuPlacement) ProtoMessage() {}
+
+func (x *CpuPlacement) ProtoReflect() protoreflect.Message {
+	mi := &file_flowpipe_v1_flow_proto_msgTypes[13]
+	if x != nil {
+		ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
+		if ms.LoadMessageInfo() == nil {
+			ms.StoreMessageInfo(mi)
+		}
+		return ms
+	}
+	return mi.MessageOf(x)
+}
+
+// Deprecated: Use CpuPlacement.ProtoReflect.Descriptor instead.
+func (*CpuPlacement) Descriptor() ([]byte, []int) {
+	return file_flowpipe_v1_flow_proto_rawDescGZIP(), []int{13}
+}
+
+func (x *CpuPlacement) GetMode() CpuPlacementMode {
+	if x != nil {
+		return x.Mode
+	}
+	return CpuPlacementMode_CPU_PLACEMENT_MODE_UNSPECIFIED
+}
+
+func (x *CpuPlacement) GetHotStages() []string {
+	if x != nil {
+		return x.HotStages
+	}
+	return nil
+}
+
 type FlowStatus struct {
 	state protoimpl.MessageState `protogen:"open.v1"`
 	// Current lifecycle state.
@@ -1441,7 +2010,7 @@ type FlowStatus struct {
 
 func (x *FlowStatus) Reset() {
 	*x = FlowStatus{}
-	mi := &file_flowpipe_v1_flow_proto_msgTypes[11]
+	mi := &file_flowpipe_v1_flow_proto_msgTypes[14]
 	ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
 	ms.StoreMessageInfo(mi)
 }
@@ -1453,7 +2022,7 @@ func (x *FlowStatus) String() string {
 func (*FlowStatus) ProtoMessage() {}
 
 func (x *FlowStatus) ProtoReflect() protoreflect.Message {
-	mi := &file_flowpipe_v1_flow_proto_msgTypes[11]
+	mi := &file_flowpipe_v1_flow_proto_msgTypes[14]
 	if x != nil {
 		ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
 		if ms.LoadMessageInfo() == nil {
@@ -1466,7 +2035,7 @@ func (x *FlowStatus) ProtoReflect() protoreflect.Message {
 
 // Deprecated: Use FlowStatus.ProtoReflect.Descriptor instead.
 func (*FlowStatus) Descriptor() ([]byte, []int) {
-	return file_flowpipe_v1_flow_proto_rawDescGZIP(), []int{11}
+	return file_flowpipe_v1_flow_proto_rawDescGZIP(), []int{14}
 }
 
 func (x *FlowStatus) GetState() FlowState {
@@ -1538,20 +2107,22 @@ const file_flowpipe_v1_flow_proto_rawDesc = "" +
 	"_executionB\x10\n" +
 	"\x0e_observabilityB\r\n" +
 	"\v_kubernetesB\x15\n" +
-	"\x13_kubernetes_options\"\xb5\x03\n" +
+	"\x13_kubernetes_options\"\x8c\x04\n" +
 	"\x12KubernetesSettings\x12\x19\n" +
 	"\x05image\x18\x01 \x01(\tH\x00R\x05image\x88\x01\x01\x12H\n" +
 	"\x11image_pull_policy\x18\x02 \x01(\x0e2\x1c.flowpipe.v1.ImagePullPolicyR\x0fimagePullPolicy\x12A\n" +
 	"\x0erestart_policy\x18\x03 \x01(\x0e2\x1a.flowpipe.v1.RestartPolicyR\rrestartPolicy\x12P\n" +
 	"\vcpu_pinning\x18\x04 \x03(\v2/.flowpipe.v1.KubernetesSettings.CpuPinningEntryR\n" +
 	"cpuPinning\x129\n" +
-	"\tresources\x18\x05 \x01(\v2\x16.flowpipe.v1.ResourcesH\x01R\tresources\x88\x01\x01\x1aR\n" +
+	"\tresources\x18\x05 \x01(\v2\x16.flowpipe.v1.ResourcesH\x01R\tresources\x88\x01\x01\x12C\n" +
+	"\rcpu_placement\x18\x06 \x01(\v2\x19.flowpipe.v1.CpuPlacementH\x02R\fcpuPlacement\x88\x01\x01\x1aR\n" +
 	"\x0fCpuPinningEntry\x12\x10\n" +
 	"\x03key\x18\x01 \x01(\tR\x03key\x12)\n" +
 	"\x05value\x18\x02 \x01(\v2\x13.flowpipe.v1.CpuSetR\x05value:\x028\x01B\b\n" +
 	"\x06_imageB\f\n" +
 	"\n" +
-	"_resources\"\xa9\x05\n" +
+	"_resourcesB\x10\n" +
+	"\x0e_cpu_placement\"\xa9\x05\n" +
 	"\x11KubernetesOptions\x12L\n" +
 	"\n" +
 	"pod_labels\x18\x01 \x03(\v2-.flowpipe.v1.KubernetesOptions.PodLabelsEntryR\tpodLabels\x12[\n" +
@@ -1584,9 +2155,36 @@ const file_flowpipe_v1_flow_proto_rawDesc = "" +
 	"\b_suspendB\x1c\n" +
 	"\x1a_starting_deadline_secondsB \n" +
 	"\x1e_successful_jobs_history_limitB\x1c\n" +
-	"\x1a_failed_jobs_history_limit\";\n" +
+	"\x1a_failed_jobs_history_limit\"\xed\x02\n" +
 	"\tExecution\x12.\n" +
-	"\x04mode\x18\x01 \x01(\x0e2\x1a.flowpipe.v1.ExecutionModeR\x04mode\"\xdd\x02\n" +
+	"\x04mode\x18\x01 \x01(\x0e2\x1a.flowpipe.v1.ExecutionModeR\x04mode\x12$\n" +
+	"\vfuse_stages\x18\x02 \x01(\bH\x00R\n" +
+	"fuseStages\x88\x01\x01\x125\n" +
+	"\bexecutor\x18\x03 \x01(\x0e2\x19.flowpipe.v1.ExecutorModeR\bexecutor\x12&\n" +
+	"\fpool_threads\x18\x04 \x01(\rH\x01R\vpoolThreads\x88\x01\x01\x12?\n" +
+	"\tautoscale\x18\x05 \x01(\v2\x1c.flowpipe.v1.AutoscalePolicyH\x02R\tautoscale\x88\x01\x01\x12;\n" +
+	"\fclock_source\x18\x06 \x01(\x0e2\x18.flowpipe.v1.ClockSourceR\vclockSourceB\x0e\n" +
+	"\f_fuse_stagesB\x0f\n" +
+	"\r_pool_threadsB\f\n" +
+	"\n" +
+	"_autoscale\"\xeb\x03\n" +
+	"\x0fAutoscalePolicy\x12$\n" +
+	"\vinterval_ms\x18\x01 \x01(\rH\x00R\n" +
+	"intervalMs\x88\x01\x01\x121\n" +
+	"\x12scale_up_occupancy\x18\x02 \x01(\x01H\x01R\x10scaleUpOccupancy\x88\x01\x01\x125\n" +
+	"\x14scale_down_occupancy\x18\x03 \x01(\x01H\x02R\x12scaleDownOccupancy\x88\x01\x01\x12.\n" +
+	"\x11scale_up_dwell_ms\x18\x04 \x01(\rH\x03R\x0escaleUpDwellMs\x88\x01\x01\x12-\n" +
+	"\x10scale_up_samples\x18\x05 \x01(\rH\x04R\x0escaleUpSamples\x88\x01\x01\x121\n" +
+	"\x12scale_down_samples\x18\x06 \x01(\rH\x05R\x10scaleDownSamples\x88\x01\x01\x12$\n" +
+	"\vcooldown_ms\x18\a \x01(\rH\x06R\n" +
+	"cooldownMs\x88\x01\x01B\x0e\n" +
+	"\f_interval_msB\x15\n" +
+	"\x13_scale_up_occupancyB\x17\n" +
+	"\x15_scale_down_occupancyB\x14\n" +
+	"\x12_scale_up_dwell_msB\x13\n" +
+	"\x11_scale_up_samplesB\x15\n" +
+	"\x13_scale_down_samplesB\x0e\n" +
+	"\f_cooldown_ms\"\xc5\x06\n" +
 	"\tStageSpec\x12\x12\n" +
 	"\x04name\x18\x01 \x01(\tR\x04name\x12\x12\n" +
 	"\x04type\x18\x02 \x01(\tR\x04type\x12\x18\n" +
@@ -1596,18 +2194,58 @@ const file_flowpipe_v1_flow_proto_rawDesc = "" +
 	"\foutput_queue\x18\x05 \x01(\tH\x01R\voutputQueue\x88\x01\x01\x12/\n" +
 	"\x06config\x18\x06 \x01(\v2\x17.google.protobuf.StructR\x06config\x12\x1b\n" +
 	"\x06plugin\x18\a \x01(\tH\x02R\x06plugin\x88\x01\x01\x120\n" +
-	"\x11realtime_priority\x18\b \x01(\rH\x03R\x10realtimePriority\x88\x01\x01B\x0e\n" +
+	"\x11realtime_priority\x18\b \x01(\rH\x03R\x10realtimePriority\x88\x01\x01\x12!\n" +
+	"\finput_queues\x18\t \x03(\tR\vinputQueues\x12#\n" +
+	"\routput_queues\x18\n" +
+	" \x03(\tR\foutputQueues\x12$\n" +
+	"\vmin_threads\x18\v \x01(\rH\x04R\n" +
+	"minThreads\x88\x01\x01\x12$\n" +
+	"\vmax_threads\x18\f \x01(\rH\x05R\n" +
+	"maxThreads\x88\x01\x01\x12\"\n" +
+	"\n" +
+	"batch_size\x18\r \x01(\rH\x06R\tbatchSize\x88\x01\x01\x12 \n" +
+	"\tlinger_ms\x18\x0e \x01(\rH\aR\blingerMs\x88\x01\x01\x12\x1c\n" +
+	"\atick_ms\x18\x0f \x01(\rH\bR\x06tickMs\x88\x01\x01\x12\x1c\n" +
+	"\aidle_ms\x18\x10 \x01(\rH\tR\x06idleMs\x88\x01\x01\x12 \n" +
+	"\tnuma_node\x18\x11 \x01(\rH\n" +
+	"R\bnumaNode\x88\x01\x01\x12>\n" +
+	"\bdeadline\x18\x12 \x01(\v2\x1d.flowpipe.v1.DeadlineScheduleH\vR\bdeadline\x88\x01\x01B\x0e\n" +
 	"\f_input_queueB\x0f\n" +
 	"\r_output_queueB\t\n" +
 	"\a_pluginB\x14\n" +
-	"\x12_realtime_priority\"\xb7\x01\n" +
+	"\x12_realtime_priorityB\x0e\n" +
+	"\f_min_threadsB\x0e\n" +
+	"\f_max_threadsB\r\n" +
+	"\v_batch_sizeB\f\n" +
+	"\n" +
+	"_linger_msB\n" +
+	"\n" +
+	"\b_tick_msB\n" +
+	"\n" +
+	"\b_idle_msB\f\n" +
+	"\n" +
+	"_numa_nodeB\v\n" +
+	"\t_deadline\"\xb7\x01\n" +
+	"\x10DeadlineSchedule\x12\x1d\n" +
+	"\n" +
+	"runtime_us\x18\x01 \x01(\x04R\truntimeUs\x12\x1f\n" +
+	"\vdeadline_us\x18\x02 \x01(\x04R\n" +
+	"deadlineUs\x12\x1b\n" +
+	"\tperiod_us\x18\x03 \x01(\x04R\bperiodUs\x120\n" +
+	"\x11fallback_priority\x18\x04 \x01(\rH\x00R\x10fallbackPriority\x88\x01\x01B\x14\n" +
+	"\x12_fallback_priority\"\x89\x02\n" +
 	"\tQueueSpec\x12\x12\n" +
 	"\x04name\x18\x01 \x01(\tR\x04name\x12\x1a\n" +
 	"\bcapacity\x18\x02 \x01(\rR\bcapacity\x125\n" +
 	"\x06schema\x18\x03 \x01(\v2\x18.flowpipe.v1.QueueSchemaH\x00R\x06schema\x88\x01\x01\x12/\n" +
-	"\x04type\x18\x04 \x01(\x0e2\x16.flowpipe.v1.QueueTypeH\x01R\x04type\x88\x01\x01B\t\n" +
+	"\x04type\x18\x04 \x01(\x0e2\x16.flowpipe.v1.QueueTypeH\x01R\x04type\x88\x01\x01\x12\x17\n" +
+	"\x04fuse\x18\x05 \x01(\bH\x02R\x04fuse\x88\x01\x01\x12 \n" +
+	"\tnuma_node\x18\x06 \x01(\rH\x03R\bnumaNode\x88\x01\x01B\t\n" +
 	"\a_schemaB\a\n" +
-	"\x05_type\"\xc9\x01\n" +
+	"\x05_typeB\a\n" +
+	"\x05_fuseB\f\n" +
+	"\n" +
+	"_numa_node\"\xc9\x01\n" +
 	"\vQueueSchema\x129\n" +
 	"\x06format\x18\x01 \x01(\x0e2!.flowpipe.v1.InMemorySchemaFormatR\x06format\x12\x1b\n" +
 	"\tschema_id\x18\x02 \x01(\tR\bschemaId\x12\x1d\n" +
@@ -1627,7 +2265,11 @@ const file_flowpipe_v1_flow_proto_rawDesc = "" +
 	"\n" +
 	"\b_profile\"\x1a\n" +
 	"\x06CpuSet\x12\x10\n" +
-	"\x03cpu\x18\x01 \x03(\rR\x03cpu\"\xd6\x01\n" +
+	"\x03cpu\x18\x01 \x03(\rR\x03cpu\"`\n" +
+	"\fCpuPlacement\x121\n" +
+	"\x04mode\x18\x01 \x01(\x0e2\x1d.flowpipe.v1.CpuPlacementModeR\x04mode\x12\x1d\n" +
+	"\n" +
+	"hot_stages\x18\x02 \x03(\tR\thotStages\"\xd6\x01\n" +
 	"\n" +
 	"FlowStatus\x12,\n" +
 	"\x05state\x18\x01 \x01(\x0e2\x16.flowpipe.v1.FlowStateR\x05state\x12\x18\n" +
@@ -1653,7 +2295,15 @@ const file_flowpipe_v1_flow_proto_rawDesc = "" +
 	"\x1aRESTART_POLICY_UNSPECIFIED\x10\x00\x12\x19\n" +
 	"\x15RESTART_POLICY_ALWAYS\x10\x01\x12\x1d\n" +
 	"\x19RESTART_POLICY_ON_FAILURE\x10\x02\x12\x18\n" +
-	"\x14RESTART_POLICY_NEVER\x10\x03*e\n" +
+	"\x14RESTART_POLICY_NEVER\x10\x03*]\n" +
+	"\vClockSource\x12\x1c\n" +
+	"\x18CLOCK_SOURCE_UNSPECIFIED\x10\x00\x12\x1a\n" +
+	"\x16CLOCK_SOURCE_MONOTONIC\x10\x01\x12\x14\n" +
+	"\x10CLOCK_SOURCE_TSC\x10\x02*j\n" +
+	"\fExecutorMode\x12\x1d\n" +
+	"\x19EXECUTOR_MODE_UNSPECIFIED\x10\x00\x12#\n" +
+	"\x1fEXECUTOR_MODE_THREAD_PER_WORKER\x10\x01\x12\x16\n" +
+	"\x12EXECUTOR_MODE_POOL\x10\x02*e\n" +
 	"\rExecutionMode\x12\x1e\n" +
 	"\x1aEXECUTION_MODE_UNSPECIFIED\x10\x00\x12\x1c\n" +
 	"\x18EXECUTION_MODE_STREAMING\x10\x01\x12\x16\n" +
@@ -1673,7 +2323,11 @@ const file_flowpipe_v1_flow_proto_rawDesc = "" +
 	"\x1eEXTERNAL_SCHEMA_FORMAT_PARQUET\x10\x05*A\n" +
 	"\tQueueType\x12\x1a\n" +
 	"\x16QUEUE_TYPE_UNSPECIFIED\x10\x00\x12\x18\n" +
-	"\x14QUEUE_TYPE_IN_MEMORY\x10\x01*\xba\x01\n" +
+	"\x14QUEUE_TYPE_IN_MEMORY\x10\x01*r\n" +
+	"\x10CpuPlacementMode\x12\"\n" +
+	"\x1eCPU_PLACEMENT_MODE_UNSPECIFIED\x10\x00\x12\x1d\n" +
+	"\x19CPU_PLACEMENT_MODE_MANUAL\x10\x01\x12\x1b\n" +
+	"\x17CPU_PLACEMENT_MODE_AUTO\x10\x02*\xba\x01\n" +
 	"\tFlowState\x12\x1a\n" +
 	"\x16FLOW_STATE_UNSPECIFIED\x10\x00\x12\x16\n" +
 	"\x12FLOW_STATE_PENDING\x10\x01\x12\x18\n" +
@@ -1695,72 +2349,84 @@ func file_flowpipe_v1_flow_proto_rawDescGZIP() []byte {
 	return file_flowpipe_v1_flow_proto_rawDescData
 }
 
-var file_flowpipe_v1_flow_proto_enumTypes = make([]protoimpl.EnumInfo, 9)
-var file_flowpipe_v1_flow_proto_msgTypes = make([]protoimpl.MessageInfo, 17)
+var file_flowpipe_v1_flow_proto_enumTypes = make([]protoimpl.EnumInfo, 12)
+var file_flowpipe_v1_flow_proto_msgTypes = make([]protoimpl.MessageInfo, 20)
 var file_flowpipe_v1_flow_proto_goTypes = []any{
 	(CronConcurrencyPolicy)(0),    // 0: flowpipe.v1.CronConcurrencyPolicy
 	(StreamingWorkloadKind)(0),    // 1: flowpipe.v1.StreamingWorkloadKind
 	(ImagePullPolicy)(0),          // 2: flowpipe.v1.ImagePullPolicy
 	(RestartPolicy)(0),            // 3: flowpipe.v1.RestartPolicy
-	(ExecutionMode)(0),            // 4: flowpipe.v1.ExecutionMode
-	(InMemorySchemaFormat)(0),     // 5: flowpipe.v1.InMemorySchemaFormat
-	(ExternalSchemaFormat)(0),     // 6: flowpipe.v1.ExternalSchemaFormat
-	(QueueType)(0),                // 7: flowpipe.v1.QueueType
-	(FlowState)(0),                // 8: flowpipe.v1.FlowState
-	(*Flow)(nil),                  // 9: flowpipe.v1.Flow
-	(*FlowSpec)(nil),              // 10: flowpipe.v1.FlowSpec
-	(*KubernetesSettings)(nil),    // 11: flowpipe.v1.KubernetesSettings
-	(*KubernetesOptions)(nil),     // 12: flowpipe.v1.KubernetesOptions
-	(*KubernetesCronOptions)(nil), // 13: flowpipe.v1.KubernetesCronOptions
-	(*Execution)(nil),             // 14: flowpipe.v1.Execution
-	(*StageSpec)(nil),             // 15: flowpipe.v1.StageSpec
-	(*QueueSpec)(nil),             // 16: flowpipe.v1.QueueSpec
-	(*QueueSchema)(nil),           // 17: flowpipe.v1.QueueSchema
-	(*Resources)(nil),             // 18: flowpipe.v1.Resources
-	(*CpuSet)(nil),                // 19: flowpipe.v1.CpuSet
-	(*FlowStatus)(nil),            // 20: flowpipe.v1.FlowStatus
-	nil,                           // 21: flowpipe.v1.FlowSpec.LabelsEntry
-	nil,                           // 22: flowpipe.v1.FlowSpec.EnvEntry
-	nil,                           // 23: flowpipe.v1.KubernetesSettings.CpuPinningEntry
-	nil,                           // 24: flowpipe.v1.KubernetesOptions.PodLabelsEntry
-	nil,                           // 25: flowpipe.v1.KubernetesOptions.PodAnnotationsEntry
-	(*ObservabilityConfig)(nil),   // 26: flowpipe.v1.ObservabilityConfig
-	(*structpb.Struct)(nil),       // 27: google.protobuf.Struct
-	(*timestamppb.Timestamp)(nil), // 28: google.protobuf.Timestamp
+	(ClockSource)(0),              // 4: flowpipe.v1.ClockSource
+	(ExecutorMode)(0),             // 5: flowpipe.v1.ExecutorMode
+	(ExecutionMode)(0),            // 6: flowpipe.v1.ExecutionMode
+	(InMemorySchemaFormat)(0),     // 7: flowpipe.v1.InMemorySchemaFormat
+	(ExternalSchemaFormat)(0),     // 8: flowpipe.v1.ExternalSchemaFormat
+	(QueueType)(0),                // 9: flowpipe.v1.QueueType
+	(CpuPlacementMode)(0),         // 10: flowpipe.v1.CpuPlacementMode
+	(FlowState)(0),                // 11: flowpipe.v1.FlowState
+	(*Flow)(nil),                  // 12: flowpipe.v1.Flow
+	(*FlowSpec)(nil),              // 13: flowpipe.v1.FlowSpec
+	(*KubernetesSettings)(nil),    // 14: flowpipe.v1.KubernetesSettings
+	(*KubernetesOptions)(nil),     // 15: flowpipe.v1.KubernetesOptions
+	(*KubernetesCronOptions)(nil), // 16: flowpipe.v1.KubernetesCronOptions
+	(*Execution)(nil),             // 17: flowpipe.v1.Execution
+	(*AutoscalePolicy)(nil),       // 18: flowpipe.v1.AutoscalePolicy
+	(*StageSpec)(nil),             // 19: flowpipe.v1.StageSpec
+	(*DeadlineSchedule)(nil),      // 20: flowpipe.v1.DeadlineSchedule
+	(*QueueSpec)(nil),             // 21: flowpipe.v1.QueueSpec
+	(*QueueSchema)(nil),           // 22: flowpipe.v1.QueueSchema
+	(*Resources)(nil),             // 23: flowpipe.v1.Resources
+	(*CpuSet)(nil),                // 24: flowpipe.v1.CpuSet
+	(*CpuPlacement)(nil),          // 25: flowpipe.v1.CpuPlacement
+	(*FlowStatus)(nil),            // 26: flowpipe.v1.FlowStatus
+	nil,                           // 27: flowpipe.v1.FlowSpec.LabelsEntry
+	nil,                           // 28: flowpipe.v1.FlowSpec.EnvEntry
+	nil,                           // 29: flowpipe.v1.KubernetesSettings.CpuPinningEntry
+	nil,                           // 30: flowpipe.v1.KubernetesOptions.PodLabelsEntry
+	nil,                           // 31: flowpipe.v1.KubernetesOptions.PodAnnotationsEntry
+	(*ObservabilityConfig)(nil),   // 32: flowpipe.v1.ObservabilityConfig
+	(*structpb.Struct)(nil),       // 33: google.protobuf.Struct
+	(*timestamppb.Timestamp)(nil), // 34: google.protobuf.Timestamp
 }
 var file_flowpipe_v1_flow_proto_depIdxs = []int32{
-	10, // 0: flowpipe.v1.Flow.spec:type_name -> flowpipe.v1.FlowSpec
-	20, // 1: flowpipe.v1.Flow.status:type_name -> flowpipe.v1.FlowStatus
-	14, // 2: flowpipe.v1.FlowSpec.execution:type_name -> flowpipe.v1.Execution
-	15, // 3: flowpipe.v1.FlowSpec.stages:type_name -> flowpipe.v1.StageSpec
-	16, // 4: flowpipe.v1.FlowSpec.queues:type_name -> flowpipe.v1.QueueSpec
-	21, // 5: flowpipe.v1.FlowSpec.labels:type_name -> flowpipe.v1.FlowSpec.LabelsEntry
-	26, // 6: flowpipe.v1.FlowSpec.observability:type_name -> flowpipe.v1.ObservabilityConfig
-	11, // 7: flowpipe.v1.FlowSpec.kubernetes:type_name -> flowpipe.v1.KubernetesSettings
-	12, // 8: flowpipe.v1.FlowSpec.kubernetes_options:type_name -> flowpipe.v1.KubernetesOptions
-	22, // 9: flowpipe.v1.FlowSpec.env:type_name -> flowpipe.v1.FlowSpec.EnvEntry
+	13, // 0: flowpipe.v1.Flow.spec:type_name -> flowpipe.v1.FlowSpec
+	26, // 1: flowpipe.v1.Flow.status:type_name -> flowpipe.v1.FlowStatus
+	17, // 2: flowpipe.v1.FlowSpec.execution:type_name -> flowpipe.v1.Execution
+	19, // 3: flowpipe.v1.FlowSpec.stages:type_name -> flowpipe.v1.StageSpec
+	21, // 4: flowpipe.v1.FlowSpec.queues:type_name -> flowpipe.v1.QueueSpec
+	27, // 5: flowpipe.v1.FlowSpec.labels:type_name -> flowpipe.v1.FlowSpec.LabelsEntry
+	32, // 6: flowpipe.v1.FlowSpec.observability:type_name -> flowpipe.v1.ObservabilityConfig
+	14, // 7: flowpipe.v1.FlowSpec.kubernetes:type_name -> flowpipe.v1.KubernetesSettings
+	15, // 8: flowpipe.v1.FlowSpec.kubernetes_options:type_name -> flowpipe.v1.KubernetesOptions
+	28, // 9: flowpipe.v1.FlowSpec.env:type_name -> flowpipe.v1.FlowSpec.EnvEntry
 	2,  // 10: flowpipe.v1.KubernetesSettings.image_pull_policy:type_name -> flowpipe.v1.ImagePullPolicy
 	3,  // 11: flowpipe.v1.KubernetesSettings.restart_policy:type_name -> flowpipe.v1.RestartPolicy
-	23, // 12: flowpipe.v1.KubernetesSettings.cpu_pinning:type_name -> flowpipe.v1.KubernetesSettings.CpuPinningEntry
-	18, // 13: flowpipe.v1.KubernetesSettings.resources:type_name -> flowpipe.v1.Resources
-	24, // 14: flowpipe.v1.KubernetesOptions.pod_labels:type_name -> flowpipe.v1.KubernetesOptions.PodLabelsEntry
-	25, // 15: flowpipe.v1.KubernetesOptions.pod_annotations:type_name -> flowpipe.v1.KubernetesOptions.PodAnnotationsEntry
-	1,  // 16: flowpipe.v1.KubernetesOptions.streaming_workload_kind:type_name -> flowpipe.v1.StreamingWorkloadKind
-	13, // 17: flowpipe.v1.KubernetesOptions.cron:type_name -> flowpipe.v1.KubernetesCronOptions
-	0,  // 18: flowpipe.v1.KubernetesCronOptions.concurrency_policy:type_name -> flowpipe.v1.CronConcurrencyPolicy
-	4,  // 19: flowpipe.v1.Execution.mode:type_name -> flowpipe.v1.ExecutionMode
-	27, // 20: flowpipe.v1.StageSpec.config:type_name -> google.protobuf.Struct
-	17, // 21: flowpipe.v1.QueueSpec.schema:type_name -> flowpipe.v1.QueueSchema
-	7,  // 22: flowpipe.v1.QueueSpec.type:type_name -> flowpipe.v1.QueueType
-	5,  // 23: flowpipe.v1.QueueSchema.format:type_name -> flowpipe.v1.InMemorySchemaFormat
-	8,  // 24: flowpipe.v1.FlowStatus.state:type_name -> flowpipe.v1.FlowState
-	28, // 25: flowpipe.v1.FlowStatus.last_updated:type_name -> google.protobuf.Timestamp
-	19, // 26: flowpipe.v1.KubernetesSettings.CpuPinningEntry.value:type_name -> flowpipe.v1.CpuSet
-	27, // [27:27] is the sub-list for method output_type
-	27, // [27:27] is the sub-list for method input_type
-	27, // [27:27] is the sub-list for extension type_name
-	27, // [27:27] is the sub-list for extension extendee
-	0,  // [0:27] is the sub-list for field type_name
+	29, // 12: flowpipe.v1.KubernetesSettings.cpu_pinning:type_name -> flowpipe.v1.KubernetesSettings.CpuPinningEntry
+	23, // 13: flowpipe.v1.KubernetesSettings.resources:type_name -> flowpipe.v1.Resources
+	25, // 14: flowpipe.v1.KubernetesSettings.cpu_placement:type_name -> flowpipe.v1.CpuPlacement
+	30, // 15: flowpipe.v1.KubernetesOptions.pod_labels:type_name -> flowpipe.v1.KubernetesOptions.PodLabelsEntry
+	31, // 16: flowpipe.v1.KubernetesOptions.pod_annotations:type_name -> flowpipe.v1.KubernetesOptions.PodAnnotationsEntry
+	1,  // 17: flowpipe.v1.KubernetesOptions.streaming_workload_kind:type_name -> flowpipe.v1.StreamingWorkloadKind
+	16, // 18: flowpipe.v1.KubernetesOptions.cron:type_name -> flowpipe.v1.KubernetesCronOptions
+	0,  // 19: flowpipe.v1.KubernetesCronOptions.concurrency_policy:type_name -> flowpipe.v1.CronConcurrencyPolicy
+	6,  // 20: flowpipe.v1.Execution.mode:type_name -> flowpipe.v1.ExecutionMode
+	5,  // 21: flowpipe.v1.Execution.executor:type_name -> flowpipe.v1.ExecutorMode
+	18, // 22: flowpipe.v1.Execution.autoscale:type_name -> flowpipe.v1.AutoscalePolicy
+	4,  // 23: flowpipe.v1.Execution.clock_source:type_name -> flowpipe.v1.ClockSource
+	33, // 24: flowpipe.v1.StageSpec.config:type_name -> google.protobuf.Struct
+	20, // 25: flowpipe.v1.StageSpec.deadline:type_name -> flowpipe.v1.DeadlineSchedule
+	22, // 26: flowpipe.v1.QueueSpec.schema:type_name -> flowpipe.v1.QueueSchema
+	9,  // 27: flowpipe.v1.QueueSpec.type:type_name -> flowpipe.v1.QueueType
+	7,  // 28: flowpipe.v1.QueueSchema.format:type_name -> flowpipe.v1.InMemorySchemaFormat
+	10, // 29: flowpipe.v1.CpuPlacement.mode:type_name -> flowpipe.v1.CpuPlacementMode
+	11, // 30: flowpipe.v1.FlowStatus.state:type_name -> flowpipe.v1.FlowState
+	34, // 31: flowpipe.v1.FlowStatus.last_updated:type_name -> google.protobuf.Timestamp
+	24, // 32: flowpipe.v1.KubernetesSettings.CpuPinningEntry.value:type_name -> flowpipe.v1.CpuSet
+	33, // [33:33] is the sub-list for method output_type
+	33, // [33:33] is the sub-list for method input_type
+	33, // [33:33] is the sub-list for extension type_name
+	33, // [33:33] is the sub-list for extension extendee
+	0,  // [0:33] is the sub-list for field type_name
 }
 
 func init() { file_flowpipe_v1_flow_proto_init() }
@@ -1773,17 +2439,20 @@ func file_flowpipe_v1_flow_proto_init() {
 	file_flowpipe_v1_flow_proto_msgTypes[2].OneofWrappers = []any{}
 	file_flowpipe_v1_flow_proto_msgTypes[3].OneofWrappers = []any{}
 	file_flowpipe_v1_flow_proto_msgTypes[4].OneofWrappers = []any{}
+	file_flowpipe_v1_flow_proto_msgTypes[5].OneofWrappers = []any{}
 	file_flowpipe_v1_flow_proto_msgTypes[6].OneofWrappers = []any{}
 	file_flowpipe_v1_flow_proto_msgTypes[7].OneofWrappers = []any{}
 	file_flowpipe_v1_flow_proto_msgTypes[8].OneofWrappers = []any{}
 	file_flowpipe_v1_flow_proto_msgTypes[9].OneofWrappers = []any{}
+	file_flowpipe_v1_flow_proto_msgTypes[10].OneofWrappers = []any{}
+	file_flowpipe_v1_flow_proto_msgTypes[11].OneofWrappers = []any{}
 	type x struct{}
 	out := protoimpl.TypeBuilder{
 		File: protoimpl.DescBuilder{
 			GoPackagePath: reflect.TypeOf(x{}).PkgPath(),
 			RawDescriptor: unsafe.Slice(unsafe.StringData(file_flowpipe_v1_flow_proto_rawDesc), len(file_flowpipe_v1_flow_proto_rawDesc)),
-			NumEnums:      9,
-			NumMessages:   17,
+			NumEnums:      12,
+			NumMessages:   20,
 			NumExtensions: 0,
 			NumServices:   0,
 		},
@@ -285,16 +285,17 @@ func (ObservabilityConfig_LoggingConfig_LogProcessorType) EnumDescriptor() ([]by
 }
 
 type ObservabilityConfig struct {
-	state          protoimpl.MessageState             `protogen:"open.v1"`
-	MetricsEnabled bool                               `protobuf:"varint,1,opt,name=metrics_enabled,json=metricsEnabled,proto3" json:"metrics_enabled,omitempty"`
-	TracingEnabled bool                               `protobuf:"varint,2,opt,name=tracing_enabled,json=tracingEnabled,proto3" json:"tracing_enabled,omitempty"`
-	LogsEnabled    bool                               `protobuf:"varint,3,opt,name=logs_enabled,json=logsEnabled,proto3" json:"logs_enabled,omitempty"`
-	OtlpEndpoint   string                             `protobuf:"bytes,4,opt,name=otlp_endpoint,json=otlpEndpoint,proto3" json:"otlp_endpoint,omitempty"`
-	Transport      OtlpTransport                      `protobuf:"varint,5,opt,name=transport,proto3,enum=flowpipe.v1.OtlpTransport" json:"transport,omitempty"`
-	Tracing        *ObservabilityConfig_TracingConfig `protobuf:"bytes,6,opt,name=tracing,proto3" json:"tracing,omitempty"`
-	Metrics        *ObservabilityConfig_MetricsConfig `protobuf:"bytes,7,opt,name=metrics,proto3" json:"metrics,omitempty"`
-	Logging        *ObservabilityConfig_LoggingConfig `protobuf:"bytes,8,opt,name=logging,proto3" json:"logging,omitempty"`
-	Debug          bool                               `protobuf:"varint,9,opt,name=debug,proto3" json:"debug,omitempty"`
+	state          protoimpl.MessageState              `protogen:"open.v1"`
+	MetricsEnabled bool                                `protobuf:"varint,1,opt,name=metrics_enabled,json=metricsEnabled,proto3" json:"metrics_enabled,omitempty"`
+	TracingEnabled bool                                `protobuf:"varint,2,opt,name=tracing_enabled,json=tracingEnabled,proto3" json:"tracing_enabled,omitempty"`
+	LogsEnabled    bool                                `protobuf:"varint,3,opt,name=logs_enabled,json=logsEnabled,proto3" json:"logs_enabled,omitempty"`
+	OtlpEndpoint   string                              `protobuf:"bytes,4,opt,name=otlp_endpoint,json=otlpEndpoint,proto3" json:"otlp_endpoint,omitempty"`
+	Transport      OtlpTransport                       `protobuf:"varint,5,opt,name=transport,proto3,enum=flowpipe.v1.OtlpTransport" json:"transport,omitempty"`
+	Tracing        *ObservabilityConfig_TracingConfig  `protobuf:"bytes,6,opt,name=tracing,proto3" json:"tracing,omitempty"`
+	Metrics        *ObservabilityConfig_MetricsConfig  `protobuf:"bytes,7,opt,name=metrics,proto3" json:"metrics,omitempty"`
+	Logging        *ObservabilityConfig_LoggingConfig  `protobuf:"bytes,8,opt,name=logging,proto3" json:"logging,omitempty"`
+	Sampling       *ObservabilityConfig_SamplingConfig `protobuf:"bytes,10,opt,name=sampling,proto3" json:"sampling,omitempty"`
+	Debug          bool                                `protobuf:"varint,9,opt,name=debug,proto3" json:"debug,omitempty"`
 	unknownFields  protoimpl.UnknownFields
 	sizeCache      protoimpl.SizeCache
 }
@@ -385,6 +386,13 @@ func (x *ObservabilityConfig) GetLogging() *ObservabilityConfig_LoggingConfig {
 	return nil
 }
 
+func (x *ObservabilityConfig) GetSampling() *ObservabilityConfig_SamplingConfig {
+	if x != nil {
+		return x.Sampling
+	}
+	return nil
+}
+
 func (x *ObservabilityConfig) GetDebug() bool {
 	if x != nil {
 		return x.Debug
@@ -516,8 +524,17 @@ type ObservabilityConfig_MetricsConfig struct {
 	MinCollectionIntervalMs uint32 `protobuf:"varint,7,opt,name=min_collection_interval_ms,json=minCollectionIntervalMs,proto3" json:"min_collection_interval_ms,omitempty"`
 	CollectionIntervalMs    uint32 `protobuf:"varint,8,opt,name=collection_interval_ms,json=collectionIntervalMs,proto3" json:"collection_interval_ms,omitempty"`
 	LatencyBudgetMs         uint32 `protobuf:"varint,9,opt,name=latency_budget_ms,json=latencyBudgetMs,proto3" json:"latency_budget_ms,omitempty"`
-	unknownFields           protoimpl.UnknownFields
-	sizeCache               protoimpl.SizeCache
+	// Unix socket path serving in-process latency quantiles (stage latency,
+	// queue dwell, end-to-end). Setting it turns on runtime-side recording
+	// even without an OTLP exporter. Empty: no socket.
+	HistogramSocket string `protobuf:"bytes,10,opt,name=histogram_socket,json=histogramSocket,proto3" json:"histogram_socket,omitempty"`
+	// Port on 127.0.0.1 serving stage, queue and jemalloc metrics in the
+	// Prometheus text format at /metrics. Works without an OTLP exporter
+	// (leave metrics_enabled off to skip it) and honours the granularity
+	// controls above. 0: no endpoint.
+	PrometheusPort uint32 `protobuf:"varint,11,opt,name=prometheus_port,json=prometheusPort,proto3" json:"prometheus_port,omitempty"`
+	unknownFields  protoimpl.UnknownFields
+	sizeCache      protoimpl.SizeCache
 }
 
 func (x *ObservabilityConfig_MetricsConfig) Reset() {
@@ -613,13 +630,31 @@ func (x *ObservabilityConfig_MetricsConfig) GetLatencyBudgetMs() uint32 {
 	return 0
 }
 
+func (x *ObservabilityConfig_MetricsConfig) GetHistogramSocket() string {
+	if x != nil {
+		return x.HistogramSocket
+	}
+	return ""
+}
+
+func (x *ObservabilityConfig_MetricsConfig) GetPrometheusPort() uint32 {
+	if x != nil {
+		return x.PrometheusPort
+	}
+	return 0
+}
+
 // ==========================================================
 // Logging configuration
 // ==========================================================
 type ObservabilityConfig_LoggingConfig struct {
-	state         protoimpl.MessageState                             `protogen:"open.v1"`
-	Processor     ObservabilityConfig_LoggingConfig_LogProcessorType `protobuf:"varint,1,opt,name=processor,proto3,enum=flowpipe.v1.ObservabilityConfig_LoggingConfig_LogProcessorType" json:"processor,omitempty"`
-	Batch         *ObservabilityConfig_LoggingConfig_BatchConfig     `protobuf:"bytes,2,opt,name=batch,proto3" json:"batch,omitempty"`
+	state     protoimpl.MessageState                             `protogen:"open.v1"`
+	Processor ObservabilityConfig_LoggingConfig_LogProcessorType `protobuf:"varint,1,opt,name=processor,proto3,enum=flowpipe.v1.ObservabilityConfig_LoggingConfig_LogProcessorType" json:"processor,omitempty"`
+	Batch     *ObservabilityConfig_LoggingConfig_BatchConfig     `protobuf:"bytes,2,opt,name=batch,proto3" json:"batch,omitempty"`
+	// Slots in the runtime's async log ring (rounded up to a power of two).
+	// Records logged while every slot is taken are dropped and counted.
+	// 0: 4096.
+	AsyncRingSize uint32 `protobuf:"varint,3,opt,name=async_ring_size,json=asyncRingSize,proto3" json:"async_ring_size,omitempty"`
 	unknownFields protoimpl.UnknownFields
 	sizeCache     protoimpl.SizeCache
 }
@@ -668,6 +703,72 @@ func (x *ObservabilityConfig_LoggingConfig) GetBatch() *ObservabilityConfig_Logg
 	return nil
 }
 
+func (x *ObservabilityConfig_LoggingConfig) GetAsyncRingSize() uint32 {
+	if x != nil {
+		return x.AsyncRingSize
+	}
+	return 0
+}
+
+// ==========================================================
+// Record sampling
+// ==========================================================
+// Which records the runners time, add to latency histograms and trace.
+// Counters stay exact. Each worker thread samples independently.
+type ObservabilityConfig_SamplingConfig struct {
+	state protoimpl.MessageState `protogen:"open.v1"`
+	// Sample one record in every `one_in` (0 or 1: every record).
+	OneIn uint32 `protobuf:"varint,1,opt,name=one_in,json=oneIn,proto3" json:"one_in,omitempty"`
+	// At most this many sampled records per second per worker (0: no cap).
+	MaxPerSecond  uint32 `protobuf:"varint,2,opt,name=max_per_second,json=maxPerSecond,proto3" json:"max_per_second,omitempty"`
+	unknownFields protoimpl.UnknownFields
+	sizeCache     protoimpl.SizeCache
+}
+
+func (x *ObservabilityConfig_SamplingConfig) Reset() {
+	*x = ObservabilityConfig_SamplingConfig{}
+	mi := &file_flowpipe_v1_observability_proto_msgTypes[4]
+	ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
+	ms.StoreMessageInfo(mi)
+}
+
+func (x *ObservabilityConfig_SamplingConfig) String() string {
+	return protoimpl.X.MessageStringOf(x)
+}
+
+func (*ObservabilityConfig_SamplingConfig) ProtoMessage() {}
+
+func (x *ObservabilityConfig_SamplingConfig) ProtoReflect() protoreflect.Message {
+	mi := &file_flowpipe_v1_observability_proto_msgTypes[4]
+	if x != nil {
+		ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
+		if ms.LoadMessageInfo() == nil {
+			ms.StoreMessageInfo(mi)
+		}
+		return ms
+	}
+	return mi.MessageOf(x)
+}
+
+// Deprecated: Use ObservabilityConfig_SamplingConfig.ProtoReflect.Descriptor instead.
+func (*ObservabilityConfig_SamplingConfig) Descriptor() ([]byte, []int) {
+	return file_flowpipe_v1_observability_proto_rawDescGZIP(), []int{0, 3}
+}
+
+func (x *ObservabilityConfig_SamplingConfig) GetOneIn() uint32 {
+	if x != nil {
+		return x.OneIn
+	}
+	return 0
+}
+
+func (x *ObservabilityConfig_SamplingConfig) GetMaxPerSecond() uint32 {
+	if x != nil {
+		return x.MaxPerSecond
+	}
+	return 0
+}
+
 // --------------------------------------------------------
 // Batch trace processor tuning
 // --------------------------------------------------------
@@ -683,7 +784,7 @@ type ObservabilityConfig_TracingConfig_BatchConfig struct {
 
 func (x *ObservabilityConfig_TracingConfig_BatchConfig) Reset() {
 	*x = ObservabilityConfig_TracingConfig_BatchConfig{}
-	mi := &file_flowpipe_v1_observability_proto_msgTypes[4]
+	mi := &file_flowpipe_v1_observability_proto_msgTypes[5]
 	ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
 	ms.StoreMessageInfo(mi)
 }
@@ -695,7 +796,7 @@ func (x *ObservabilityConfig_TracingConfig_BatchConfig) String() string {
 func (*ObservabilityConfig_TracingConfig_BatchConfig) ProtoMessage() {}
 
 func (x *ObservabilityConfig_TracingConfig_BatchConfig) ProtoReflect() protoreflect.Message {
-	mi := &file_flowpipe_v1_observability_proto_msgTypes[4]
+	mi := &file_flowpipe_v1_observability_proto_msgTypes[5]
 	if x != nil {
 		ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
 		if ms.LoadMessageInfo() == nil {
@@ -751,7 +852,7 @@ type ObservabilityConfig_LoggingConfig_BatchConfig struct {
 
 func (x *ObservabilityConfig_LoggingConfig_BatchConfig) Reset() {
 	*x = ObservabilityConfig_LoggingConfig_BatchConfig{}
-	mi := &file_flowpipe_v1_observability_proto_msgTypes[5]
+	mi := &file_flowpipe_v1_observability_proto_msgTypes[6]
 	ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
 	ms.StoreMessageInfo(mi)
 }
@@ -763,7 +864,7 @@ func (x *ObservabilityConfig_LoggingConfig_BatchConfig) String() string {
 func (*ObservabilityConfig_LoggingConfig_BatchConfig) ProtoMessage() {}
 
 func (x *ObservabilityConfig_LoggingConfig_BatchConfig) ProtoReflect() protoreflect.Message {
-	mi := &file_flowpipe_v1_observability_proto_msgTypes[5]
+	mi := &file_flowpipe_v1_observability_proto_msgTypes[6]
 	if x != nil {
 		ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
 		if ms.LoadMessageInfo() == nil {
@@ -811,7 +912,7 @@ var File_flowpipe_v1_observability_proto protoreflect.FileDescriptor
 
 const file_flowpipe_v1_observability_proto_rawDesc = "" +
 	"\n" +
-	"\x1fflowpipe/v1/observability.proto\x12\vflowpipe.v1\"\x91\x14\n" +
+	"\x1fflowpipe/v1/observability.proto\x12\vflowpipe.v1\"\xa9\x16\n" +
 	"\x13ObservabilityConfig\x12'\n" +
 	"\x0fmetrics_enabled\x18\x01 \x01(\bR\x0emetricsEnabled\x12'\n" +
 	"\x0ftracing_enabled\x18\x02 \x01(\bR\x0etracingEnabled\x12!\n" +
@@ -820,7 +921,9 @@ const file_flowpipe_v1_observability_proto_rawDesc = "" +
 	"\ttransport\x18\x05 \x01(\x0e2\x1a.flowpipe.v1.OtlpTransportR\ttransport\x12H\n" +
 	"\atracing\x18\x06 \x01(\v2..flowpipe.v1.ObservabilityConfig.TracingConfigR\atracing\x12H\n" +
 	"\ametrics\x18\a \x01(\v2..flowpipe.v1.ObservabilityConfig.MetricsConfigR\ametrics\x12H\n" +
-	"\alogging\x18\b \x01(\v2..flowpipe.v1.ObservabilityConfig.LoggingConfigR\alogging\x12\x14\n" +
+	"\alogging\x18\b \x01(\v2..flowpipe.v1.ObservabilityConfig.LoggingConfigR\alogging\x12K\n" +
+	"\bsampling\x18\n" +
+	" \x01(\v2/.flowpipe.v1.ObservabilityConfig.SamplingConfigR\bsampling\x12\x14\n" +
 	"\x05debug\x18\t \x01(\bR\x05debug\x1a\xd5\b\n" +
 	"\rTracingConfig\x12W\n" +
 	"\n" +
@@ -850,7 +953,7 @@ const file_flowpipe_v1_observability_proto_rawDesc = "" +
 	"\x16ATTRIBUTES_UNSPECIFIED\x10\x00\x12\x16\n" +
 	"\x12ATTRIBUTES_MINIMAL\x10\x01\x12\x17\n" +
 	"\x13ATTRIBUTES_STANDARD\x10\x02\x12\x16\n" +
-	"\x12ATTRIBUTES_VERBOSE\x10\x03\x1a\xef\x03\n" +
+	"\x12ATTRIBUTES_VERBOSE\x10\x03\x1a\xc3\x04\n" +
 	"\rMetricsConfig\x124\n" +
 	"\x16stage_metrics_disabled\x18\x01 \x01(\bR\x14stageMetricsDisabled\x124\n" +
 	"\x16queue_metrics_disabled\x18\x02 \x01(\bR\x14queueMetricsDisabled\x122\n" +
@@ -860,10 +963,14 @@ const file_flowpipe_v1_observability_proto_rawDesc = "" +
 	"\x19jemalloc_metrics_disabled\x18\x06 \x01(\bR\x17jemallocMetricsDisabled\x12;\n" +
 	"\x1amin_collection_interval_ms\x18\a \x01(\rR\x17minCollectionIntervalMs\x124\n" +
 	"\x16collection_interval_ms\x18\b \x01(\rR\x14collectionIntervalMs\x12*\n" +
-	"\x11latency_budget_ms\x18\t \x01(\rR\x0flatencyBudgetMs\x1a\xe7\x03\n" +
+	"\x11latency_budget_ms\x18\t \x01(\rR\x0flatencyBudgetMs\x12)\n" +
+	"\x10histogram_socket\x18\n" +
+	" \x01(\tR\x0fhistogramSocket\x12'\n" +
+	"\x0fprometheus_port\x18\v \x01(\rR\x0eprometheusPort\x1a\x8f\x04\n" +
 	"\rLoggingConfig\x12]\n" +
 	"\tprocessor\x18\x01 \x01(\x0e2?.flowpipe.v1.ObservabilityConfig.LoggingConfig.LogProcessorTypeR\tprocessor\x12P\n" +
-	"\x05batch\x18\x02 \x01(\v2:.flowpipe.v1.ObservabilityConfig.LoggingConfig.BatchConfigR\x05batch\x1a\xbe\x01\n" +
+	"\x05batch\x18\x02 \x01(\v2:.flowpipe.v1.ObservabilityConfig.LoggingConfig.BatchConfigR\x05batch\x12&\n" +
+	"\x0fasync_ring_size\x18\x03 \x01(\rR\rasyncRingSize\x1a\xbe\x01\n" +
 	"\vBatchConfig\x12$\n" +
 	"\x0emax_queue_size\x18\x01 \x01(\rR\fmaxQueueSize\x121\n" +
 	"\x15max_export_batch_size\x18\x02 \x01(\rR\x12maxExportBatchSize\x12*\n" +
@@ -872,7 +979,10 @@ const file_flowpipe_v1_observability_proto_rawDesc = "" +
 	"\x10LogProcessorType\x12\x1d\n" +
 	"\x19LOG_PROCESSOR_UNSPECIFIED\x10\x00\x12\x18\n" +
 	"\x14LOG_PROCESSOR_SIMPLE\x10\x01\x12\x17\n" +
-	"\x13LOG_PROCESSOR_BATCH\x10\x02*a\n" +
+	"\x13LOG_PROCESSOR_BATCH\x10\x02\x1aM\n" +
+	"\x0eSamplingConfig\x12\x15\n" +
+	"\x06one_in\x18\x01 \x01(\rR\x05oneIn\x12$\n" +
+	"\x0emax_per_second\x18\x02 \x01(\rR\fmaxPerSecond*a\n" +
 	"\rOtlpTransport\x12\x1e\n" +
 	"\x1aOTLP_TRANSPORT_UNSPECIFIED\x10\x00\x12\x17\n" +
 	"\x13OTLP_TRANSPORT_GRPC\x10\x01\x12\x17\n" +
@@ -891,7 +1001,7 @@ func file_flowpipe_v1_observability_proto_rawDescGZIP() []byte {
 }
 
 var file_flowpipe_v1_observability_proto_enumTypes = make([]protoimpl.EnumInfo, 5)
-var file_flowpipe_v1_observability_proto_msgTypes = make([]protoimpl.MessageInfo, 6)
+var file_flowpipe_v1_observability_proto_msgTypes = make([]protoimpl.MessageInfo, 7)
 var file_flowpipe_v1_observability_proto_goTypes = []any{
 	(OtlpTransport)(0), // 0: flowpipe.v1.OtlpTransport
 	(ObservabilityConfig_TracingConfig_TraceHint)(0),          // 1: flowpipe.v1.ObservabilityConfig.TracingConfig.TraceHint
@@ -902,25 +1012,27 @@ var file_flowpipe_v1_observability_proto_goTypes = []any{
 	(*ObservabilityConfig_TracingConfig)(nil),                 // 6: flowpipe.v1.ObservabilityConfig.TracingConfig
 	(*ObservabilityConfig_MetricsConfig)(nil),                 // 7: flowpipe.v1.ObservabilityConfig.MetricsConfig
 	(*ObservabilityConfig_LoggingConfig)(nil),                 // 8: flowpipe.v1.ObservabilityConfig.LoggingConfig
-	(*ObservabilityConfig_TracingConfig_BatchConfig)(nil),     // 9: flowpipe.v1.ObservabilityConfig.TracingConfig.BatchConfig
-	(*ObservabilityConfig_LoggingConfig_BatchConfig)(nil),     // 10: flowpipe.v1.ObservabilityConfig.LoggingConfig.BatchConfig
+	(*ObservabilityConfig_SamplingConfig)(nil),                // 9: flowpipe.v1.ObservabilityConfig.SamplingConfig
+	(*ObservabilityConfig_TracingConfig_BatchConfig)(nil),     // 10: flowpipe.v1.ObservabilityConfig.TracingConfig.BatchConfig
+	(*ObservabilityConfig_LoggingConfig_BatchConfig)(nil),     // 11: flowpipe.v1.ObservabilityConfig.LoggingConfig.BatchConfig
 }
 var file_flowpipe_v1_observability_proto_depIdxs = []int32{
 	0,  // 0: flowpipe.v1.ObservabilityConfig.transport:type_name -> flowpipe.v1.OtlpTransport
 	6,  // 1: flowpipe.v1.ObservabilityConfig.tracing:type_name -> flowpipe.v1.ObservabilityConfig.TracingConfig
 	7,  // 2: flowpipe.v1.ObservabilityConfig.metrics:type_name -> flowpipe.v1.ObservabilityConfig.MetricsConfig
 	8,  // 3: flowpipe.v1.ObservabilityConfig.logging:type_name -> flowpipe.v1.ObservabilityConfig.LoggingConfig
-	1,  // 4: flowpipe.v1.ObservabilityConfig.TracingConfig.trace_hint:type_name -> flowpipe.v1.ObservabilityConfig.TracingConfig.TraceHint
-	2,  // 5: flowpipe.v1.ObservabilityConfig.TracingConfig.processor:type_name -> flowpipe.v1.ObservabilityConfig.TracingConfig.TraceProcessorType
-	9,  // 6: flowpipe.v1.ObservabilityConfig.TracingConfig.batch:type_name -> flowpipe.v1.ObservabilityConfig.TracingConfig.BatchConfig
-	3,  // 7: flowpipe.v1.ObservabilityConfig.TracingConfig.attribute_level:type_name -> flowpipe.v1.ObservabilityConfig.TracingConfig.AttributeLevel
-	4,  // 8: flowpipe.v1.ObservabilityConfig.LoggingConfig.processor:type_name -> flowpipe.v1.ObservabilityConfig.LoggingConfig.LogProcessorType
-	10, // 9: flowpipe.v1.ObservabilityConfig.LoggingConfig.batch:type_name -> flowpipe.v1.ObservabilityConfig.LoggingConfig.BatchConfig
-	10, // [10:10] is the sub-list for method output_type
-	10, // [10:10] is the sub-list for method input_type
-	10, // [10:10] is the sub-list for extension type_name
-	10, // [10:10] is the sub-list for extension extendee
-	0,  // [0:10] is the sub-list for field type_name
+	9,  // 4: flowpipe.v1.ObservabilityConfig.sampling:type_name -> flowpipe.v1.ObservabilityConfig.SamplingConfig
+	1,  // 5: flowpipe.v1.ObservabilityConfig.TracingConfig.trace_hint:type_name -> flowpipe.v1.ObservabilityConfig.TracingConfig.TraceHint
+	2,  // 6: flowpipe.v1.ObservabilityConfig.TracingConfig.processor:type_name -> flowpipe.v1.ObservabilityConfig.TracingConfig.TraceProcessorType
+	10, // 7: flowpipe.v1.ObservabilityConfig.TracingConfig.batch:type_name -> flowpipe.v1.ObservabilityConfig.TracingConfig.BatchConfig
+	3,  // 8: flowpipe.v1.ObservabilityConfig.TracingConfig.attribute_level:type_name -> flowpipe.v1.ObservabilityConfig.TracingConfig.AttributeLevel
+	4,  // 9: flowpipe.v1.ObservabilityConfig.LoggingConfig.processor:type_name -> flowpipe.v1.ObservabilityConfig.LoggingConfig.LogProcessorType
+	11, // 10: flowpipe.v1.ObservabilityConfig.LoggingConfig.batch:type_name -> flowpipe.v1.ObservabilityConfig.LoggingConfig.BatchConfig
+	11, // [11:11] is the sub-list for method output_type
+	11, // [11:11] is the sub-list for method input_type
+	11, // [11:11] is the sub-list for extension type_name
+	11, // [11:11] is the sub-list for extension extendee
+	0,  // [0:11] is the sub-list for field type_name
 }
 
 func init() { file_flowpipe_v1_observability_proto_init() }
@@ -934,7 +1046,7 @@ func file_flowpipe_v1_observability_proto_init() {
 			GoPackagePath: reflect.TypeOf(x{}).PkgPath(),
 			RawDescriptor: unsafe.Slice(unsafe.StringData(file_flowpipe_v1_observability_proto_rawDesc), len(file_flowpipe_v1_observability_proto_rawDesc)),
 			NumEnums:      5,
-			NumMessages:   6,
+			NumMessages:   7,
 			NumExtensions: 0,
 			NumServices:   0,
 		},
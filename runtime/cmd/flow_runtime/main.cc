@@ -1,11 +1,14 @@
 #include <google/protobuf/util/json_util.h>
 #include <yaml-cpp/yaml.h>
 
+#include <chrono>
+#include <exception>
 #include <fstream>
 #include <iostream>
 #include <sstream>
 #include <string>
 
+#include "flowpipe/flow_spec.h"
 #include "flowpipe/observability/local_logging.h"
 #include "flowpipe/observability/logging_runtime.h"
 #include "flowpipe/observability/observability.h"
@@ -83,6 +86,78 @@ static bool LoadFromJson(const std::string& path, flowpipe::v1::FlowSpec& flow)
   return true;
 }
 
+// ------------------------------------------------------------
+// Load flow spec from binary protobuf (see --compile)
+// ------------------------------------------------------------
+static bool LoadFromBinary(const std::string& path, flowpipe::v1::FlowSpec& flow) {
+  FP_LOG_DEBUG_FMT("loading flow spec from binary protobuf: {}", path);
+
+  std::string error;
+  if (!flowpipe::ReadFlowSpecBinary(path, &flow, &error)) {
+    std::cerr << "binary protobuf load failed: " << error << "\n";
+    return false;
+  }
+
+  FP_LOG_DEBUG("flow spec loaded successfully from binary protobuf");
+  return true;
+}
+
+static bool IsBinarySpecPath(const std::string& path) {
+  return path.ends_with(".pb") || path.ends_with(".binpb");
+}
+
+// ------------------------------------------------------------
+// Load flow spec by file extension
+// ------------------------------------------------------------
+static bool LoadFlowSpec(const std::string& path, flowpipe::v1::FlowSpec& flow) {
+  if (path.ends_with(".yaml") || path.ends_with(".yml")) {
+    return LoadFromYaml(path, flow);
+  }
+  if (path.ends_with(".json")) {
+    return LoadFromJson(path, flow);
+  }
+  if (IsBinarySpecPath(path)) {
+    return LoadFromBinary(path, flow);
+  }
+  std::cerr << "unsupported file type (use .yaml, .json or .pb)\n";
+  return false;
+}
+
+// ------------------------------------------------------------
+// --compile: validate + normalize once, write binary protobuf
+// ------------------------------------------------------------
+static int CompileFlowSpec(const std::string& in_path, const std::string& out_path) {
+  if (!IsBinarySpecPath(out_path)) {
+    std::cerr << "compiled spec must be written to a .pb file: " << out_path << "\n";
+    return 1;
+  }
+
+  flowpipe::v1::FlowSpec flow;
+  if (!LoadFlowSpec(in_path, flow)) {
+    std::cerr << "failed to load flow config\n";
+    return 1;
+  }
+
+  try {
+    flowpipe::ValidateFlowSpec(flow);
+  } catch (const std::exception& e) {
+    std::cerr << "invalid flow spec: " << e.what() << "\n";
+    return 1;
+  }
+  flowpipe::NormalizeFlowSpec(&flow);
+
+  std::string error;
+  if (!flowpipe::WriteFlowSpecBinary(flow, out_path, &error)) {
+    std::cerr << error << "\n";
+    return 1;
+  }
+
+  std::cout << "compiled " << in_path << " -> " << out_path << " (" << flow.ByteSizeLong()
+            << " bytes, " << flow.stages_size() << " stages, " << flow.queues_size()
+            << " queues)\n";
+  return 0;
+}
+
 // ============================================================
 // Main
 // ============================================================
@@ -96,8 +171,13 @@ int main(int argc, char** argv) {
   // ----------------------------------------------------------
   // Argument parsing
   // ----------------------------------------------------------
+  if (argc == 4 && std::string(argv[1]) == "--compile") {
+    return CompileFlowSpec(argv[2], argv[3]);
+  }
+
   if (argc != 2) {
-    std::cerr << "usage: flow_runtime <flow.yaml|flow.json>\n";
+    std::cerr << "usage: flow_runtime <flow.yaml|flow.json|flow.pb>\n"
+                 "       flow_runtime --compile <flow.yaml|flow.json> <flow.pb>\n";
     return 1;
   }
 
@@ -109,20 +189,14 @@ int main(int argc, char** argv) {
   // ----------------------------------------------------------
   // Load flow specification
   // ----------------------------------------------------------
-  bool ok = false;
-  if (path.ends_with(".yaml") || path.ends_with(".yml")) {
-    ok = LoadFromYaml(path, flow);
-  } else if (path.ends_with(".json")) {
-    ok = LoadFromJson(path, flow);
-  } else {
-    std::cerr << "unsupported file type (use .yaml or .json)\n";
-    return 1;
-  }
-
-  if (!ok) {
+  const auto load_start = std::chrono::steady_clock::now();
+  if (!LoadFlowSpec(path, flow)) {
     std::cerr << "failed to load flow config\n";
     return 1;
   }
+  const auto load_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                           std::chrono::steady_clock::now() - load_start)
+                           .count();
 
   FP_LOG_DEBUG("flow spec loaded successfully");
 
@@ -130,6 +204,7 @@ int main(int argc, char** argv) {
   if (flow.has_observability()) {
     flowpipe::observability::InitLocalLogging(flow.observability().debug());
   }
+  FP_LOG_DEBUG_FMT("flow spec loaded in {} us", load_us);
 
   // ----------------------------------------------------------
   // Observability initialization
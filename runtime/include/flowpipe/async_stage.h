@@ -0,0 +1,206 @@
+#pragma once
+
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <utility>
+
+#include "flowpipe/stage.h"
+
+namespace flowpipe {
+
+/**
+ * Coroutine return type for async stage methods.
+ *
+ * Lazily started: the body runs when the Task is co_awaited (or driven by
+ * the runtime). Exceptions thrown by the body are rethrown to the awaiter.
+ */
+class [[nodiscard]] Task {
+ public:
+  struct promise_type {
+    std::coroutine_handle<> continuation = std::noop_coroutine();
+    std::exception_ptr error;
+
+    Task get_return_object() noexcept {
+      return Task{std::coroutine_handle<promise_type>::from_promise(*this)};
+    }
+
+    std::suspend_always initial_suspend() noexcept {
+      return {};
+    }
+
+    struct FinalAwaiter {
+      bool await_ready() noexcept {
+        return false;
+      }
+      std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> h) noexcept {
+        return h.promise().continuation;
+      }
+      void await_resume() noexcept {}
+    };
+
+    FinalAwaiter final_suspend() noexcept {
+      return {};
+    }
+
+    void return_void() noexcept {}
+
+    void unhandled_exception() noexcept {
+      error = std::current_exception();
+    }
+  };
+
+  Task() noexcept = default;
+  explicit Task(std::coroutine_handle<promise_type> handle) noexcept : handle_(handle) {}
+
+  Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+  Task& operator=(Task&& other) noexcept {
+    if (this != &other) {
+      if (handle_) {
+        handle_.destroy();
+      }
+      handle_ = std::exchange(other.handle_, {});
+    }
+    return *this;
+  }
+
+  Task(const Task&) = delete;
+  Task& operator=(const Task&) = delete;
+
+  ~Task() {
+    if (handle_) {
+      handle_.destroy();
+    }
+  }
+
+  bool await_ready() const noexcept {
+    return !handle_ || handle_.done();
+  }
+
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+    handle_.promise().continuation = awaiting;
+    return handle_;
+  }
+
+  void await_resume() const {
+    if (handle_ && handle_.promise().error) {
+      std::rethrow_exception(handle_.promise().error);
+    }
+  }
+
+ private:
+  std::coroutine_handle<promise_type> handle_;
+};
+
+// Readiness flags for IoContext::watch() and FdAwaiter results. The event
+// loop maps them to and from the platform's poller.
+inline constexpr uint32_t kIoReadable = 1u << 0;
+inline constexpr uint32_t kIoWritable = 1u << 1;
+inline constexpr uint32_t kIoError = 1u << 2;   // reported only
+inline constexpr uint32_t kIoHangup = 1u << 3;  // reported only
+
+/**
+ * Event loop handle passed to async stages.
+ *
+ * Each async worker thread runs one loop; every coroutine of that worker is
+ * resumed on it, so stage state needs no locking across its own coroutines.
+ * File descriptors must be non-blocking.
+ */
+class IoContext {
+ public:
+  virtual ~IoContext() = default;
+
+  // Resume `waiter` once `fd` reports any of `events` (kIoReadable, kIoWritable).
+  // The ready mask is stored in `*revents`. One waiter per fd at a time.
+  virtual void watch(int fd, uint32_t events, std::coroutine_handle<> waiter,
+                     uint32_t* revents) = 0;
+
+  // Resume `waiter` after `delay`.
+  virtual void resume_after(std::chrono::nanoseconds delay, std::coroutine_handle<> waiter) = 0;
+
+  class FdAwaiter {
+   public:
+    FdAwaiter(IoContext& io, int fd, uint32_t events) noexcept
+        : io_(io), fd_(fd), events_(events) {}
+
+    bool await_ready() const noexcept {
+      return false;
+    }
+    void await_suspend(std::coroutine_handle<> waiter) {
+      io_.watch(fd_, events_, waiter, &revents_);
+    }
+    // Returns the ready event mask (may include kIoError / kIoHangup).
+    uint32_t await_resume() const noexcept {
+      return revents_;
+    }
+
+   private:
+    IoContext& io_;
+    int fd_;
+    uint32_t events_;
+    uint32_t revents_ = 0;
+  };
+
+  class SleepAwaiter {
+   public:
+    SleepAwaiter(IoContext& io, std::chrono::nanoseconds delay) noexcept
+        : io_(io), delay_(delay) {}
+
+    bool await_ready() const noexcept {
+      return delay_.count() <= 0;
+    }
+    void await_suspend(std::coroutine_handle<> waiter) {
+      io_.resume_after(delay_, waiter);
+    }
+    void await_resume() const noexcept {}
+
+   private:
+    IoContext& io_;
+    std::chrono::nanoseconds delay_;
+  };
+
+  FdAwaiter readable(int fd) noexcept {
+    return FdAwaiter(*this, fd, kIoReadable);
+  }
+
+  FdAwaiter writable(int fd) noexcept {
+    return FdAwaiter(*this, fd, kIoWritable);
+  }
+
+  SleepAwaiter sleep_for(std::chrono::nanoseconds delay) noexcept {
+    return SleepAwaiter(*this, delay);
+  }
+};
+
+/**
+ * Async sink stage
+ *
+ * Consumes payloads with up to max_in_flight() coroutines running at once
+ * per worker thread. The payload stays alive until the returned Task finishes.
+ */
+struct IAsyncSinkStage : IStage {
+  virtual Task consume_async(StageContext& ctx, IoContext& io, const Payload& input) = 0;
+
+  virtual size_t max_in_flight() const {
+    return 64;
+  }
+};
+
+/**
+ * Async transform stage
+ *
+ * Like ITransformStage, but several payloads may be in flight per worker.
+ * Outputs are forwarded in completion order, not input order.
+ */
+struct IAsyncTransformStage : IStage {
+  virtual Task process_async(StageContext& ctx, IoContext& io, const Payload& input,
+                             Payload& output) = 0;
+
+  virtual size_t max_in_flight() const {
+    return 64;
+  }
+};
+
+}  // namespace flowpipe
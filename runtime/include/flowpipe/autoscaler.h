@@ -0,0 +1,208 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "flowpipe/queue_runtime.h"
+#include "flowpipe/stage.h"
+#include "flowpipe/stage_metrics.h"
+
+namespace flowpipe {
+
+// Thresholds shared by every autoscaled stage of a flow.
+struct AutoscalePolicy {
+  // Supervisor sampling period.
+  std::chrono::milliseconds interval{500};
+
+  // Input fill ratio (buffered / capacity over all inputs) at or above which
+  // a sample counts as busy, and at or below which it counts as idle.
+  double scale_up_occupancy = 0.75;
+  double scale_down_occupancy = 0.10;
+
+  // Mean queue dwell at or above which a sample counts as busy, whatever the
+  // occupancy. Zero disables the dwell signal.
+  std::chrono::milliseconds scale_up_dwell{100};
+
+  // Consecutive busy (idle) samples needed before adding (retiring) a worker.
+  uint32_t scale_up_samples = 3;
+  uint32_t scale_down_samples = 10;
+
+  // Minimum time between two decisions for the same stage.
+  std::chrono::milliseconds cooldown{2000};
+};
+
+// One supervisor observation of a stage's inputs.
+struct ScalingSample {
+  double occupancy = 0.0;
+  uint64_t mean_dwell_ns = 0;  // over payloads dequeued since the previous sample
+};
+
+/**
+ * Hysteresis for one stage.
+ *
+ * Busy and idle thresholds are apart, a decision needs a run of consecutive
+ * samples, and a cooldown follows every decision, so a stage does not flap
+ * around a single threshold.
+ */
+class ScalingController {
+ public:
+  ScalingController(const AutoscalePolicy& policy, uint32_t min_workers, uint32_t max_workers);
+
+  // Returns +1 to add a worker, -1 to retire one, 0 to hold.
+  int Observe(const ScalingSample& sample, uint32_t workers,
+              std::chrono::steady_clock::time_point now);
+
+ private:
+  AutoscalePolicy policy_;
+  uint32_t min_workers_;
+  uint32_t max_workers_;
+  uint32_t busy_run_ = 0;
+  uint32_t idle_run_ = 0;
+  std::chrono::steady_clock::time_point last_decision_{};
+};
+
+/**
+ * Metrics decorator for autoscaled workers: accumulates queue dwell for the
+ * supervisor and forwards every call to the flow's metrics.
+ */
+class ScalingMetrics final : public StageMetrics {
+ public:
+  explicit ScalingMetrics(StageMetrics* inner)
+      : StageMetrics(inner ? inner->sampling() : SamplingOptions{}), inner_(inner) {}
+
+  void RecordQueueDequeue(const QueueRuntime& queue, const Payload& payload) noexcept override;
+  void CountQueueDequeue(const QueueRuntime& queue, const Payload& payload) noexcept override;
+  void RecordQueueEnqueue(const QueueRuntime& queue) noexcept override;
+  void RecordStageLatency(const char* stage_name, uint64_t latency_ns) noexcept override;
+  void CountStageRecord(const char* stage_name) noexcept override;
+  void RecordStageError(const char* stage_name) noexcept override;
+  void RecordEndToEndLatency(const char* stage_name, uint64_t latency_ns) noexcept override;
+  void RecordStageWorkers(const char* stage_name, int64_t delta) noexcept override;
+  void RecordStageScaling(const char* stage_name, bool scale_up) noexcept override;
+  void RecordStageCpu(const char* stage_name, uint32_t cpu, uint32_t l3,
+                      uint32_t numa_node) noexcept override;
+
+  // Mean dwell of payloads dequeued since the previous call (0 if none).
+  uint64_t TakeMeanDwellNs() noexcept;
+
+ private:
+  StageMetrics* inner_;
+  std::atomic<uint64_t> dwell_sum_ns_{0};
+  std::atomic<uint64_t> dwell_count_{0};
+};
+
+/**
+ * Worker threads of one autoscaled consumer stage.
+ *
+ * Every worker owns a stage instance. Retired workers finish the payload in
+ * hand and exit; their threads are joined on the next Tick(). `finished`
+ * runs once, on the last worker's thread, when no worker is left.
+ */
+class ScaledStage {
+ public:
+  struct Hooks {
+    // New stage instance for an added worker. May throw.
+    std::function<IStage*()> create;
+    // Worker body; returns when the worker retires or the stage finishes.
+    std::function<void(IStage* stage, uint32_t worker, const std::atomic<bool>& retire,
+                       StageMetrics* metrics)>
+        run;
+    std::function<void(IStage* stage)> destroy;
+    std::function<void()> finished;
+  };
+
+  ScaledStage(std::string name, QueueList inputs, uint32_t min_workers, uint32_t max_workers,
+              const AutoscalePolicy& policy, StageMetrics* metrics, Hooks hooks);
+  ~ScaledStage();
+
+  ScaledStage(const ScaledStage&) = delete;
+  ScaledStage& operator=(const ScaledStage&) = delete;
+
+  const std::string& name() const noexcept {
+    return name_;
+  }
+
+  // Starts one worker per stage instance. Takes ownership of the instances.
+  void Start(const std::vector<IStage*>& stages);
+
+  // One supervisor step: reap exited workers, sample inputs, scale.
+  void Tick(std::chrono::steady_clock::time_point now);
+
+  // Workers that are running and not retiring.
+  uint32_t active_workers() const;
+
+  // Joins every worker thread. Call after the flow stopped.
+  void Join();
+
+ private:
+  struct Worker {
+    uint32_t index = 0;
+    std::atomic<bool> retire{false};
+    std::atomic<bool> exited{false};
+    std::thread thread;
+  };
+
+  void Launch(IStage* stage);  // requires mu_
+  void WorkerMain(Worker* worker, IStage* stage);
+  void ScaleUp(const ScalingSample& sample);
+  void ScaleDown(const ScalingSample& sample);
+  void Reap();
+  double Occupancy() const;
+
+  const std::string name_;
+  const QueueList inputs_;
+  const uint32_t min_workers_;
+  const uint32_t max_workers_;
+  StageMetrics* metrics_;
+  ScalingMetrics worker_metrics_;
+  ScalingController controller_;
+  Hooks hooks_;
+
+  mutable std::mutex mu_;
+  std::list<std::unique_ptr<Worker>> workers_;
+  uint32_t active_ = 0;  // live and not retiring (guarded by mu_)
+  uint32_t live_ = 0;    // threads still running (guarded by mu_)
+  uint32_t next_index_ = 0;
+  bool finished_ = false;  // last worker exited; no more scaling (guarded by mu_)
+};
+
+/**
+ * Supervisor thread that ticks every autoscaled stage once per interval.
+ */
+class Autoscaler {
+ public:
+  explicit Autoscaler(std::chrono::milliseconds interval);
+  ~Autoscaler();
+
+  Autoscaler(const Autoscaler&) = delete;
+  Autoscaler& operator=(const Autoscaler&) = delete;
+
+  // Stages are not owned and must outlive Stop().
+  void Add(ScaledStage* stage);
+
+  void Start();
+
+  // Idempotent; joins the supervisor thread.
+  void Stop();
+
+ private:
+  void Loop();
+
+  const std::chrono::milliseconds interval_;
+  std::vector<ScaledStage*> stages_;
+  std::thread thread_;
+  std::mutex mu_;
+  std::condition_variable cv_;
+  bool stopping_ = false;  // guarded by mu_
+};
+
+}  // namespace flowpipe
@@ -1,10 +1,15 @@
 #pragma once
 
+#include <algorithm>
+#include <chrono>
 #include <condition_variable>
 #include <cstddef>
 #include <deque>
+#include <memory>
+#include <memory_resource>
 #include <mutex>
 #include <optional>
+#include <vector>
 
 #include "flowpipe/queue.h"
 
@@ -15,6 +20,14 @@ class BoundedQueue : public IQueue<T> {
  public:
   explicit BoundedQueue(std::size_t capacity) : capacity_(capacity) {}
 
+  // Element storage comes from `upstream` through a pool owned by the queue,
+  // e.g. a NumaMemoryResource for node-local slots.
+  BoundedQueue(std::size_t capacity, std::shared_ptr<std::pmr::memory_resource> upstream)
+      : capacity_(capacity),
+        upstream_(std::move(upstream)),
+        pool_(std::make_unique<std::pmr::unsynchronized_pool_resource>(upstream_.get())),
+        queue_(pool_.get()) {}
+
   bool push(T item, const StopToken& stop) override {
     std::unique_lock lock(mu_);
     // Block until there is space, the queue is closed, or stop is requested.
@@ -29,6 +42,7 @@ class BoundedQueue : public IQueue<T> {
 
     queue_.push_back(std::move(item));
     not_empty_.notify_one();
+    notify_observers();
     return true;
   }
 
@@ -39,27 +53,107 @@ class BoundedQueue : public IQueue<T> {
                     [this, &stop] { return stop.stop_requested() || closed_ || !queue_.empty(); });
 
     if (!queue_.empty()) {
-      T item = std::move(queue_.front());
-      queue_.pop_front();
-      not_full_.notify_one();
-      return item;
+      return take_front();
     }
     return std::nullopt;
   }
 
+  std::optional<T> pop_for(std::chrono::nanoseconds timeout, const StopToken& stop) override {
+    std::unique_lock lock(mu_);
+    not_empty_.wait_for(
+        lock, timeout, [this, &stop] { return stop.stop_requested() || closed_ || !queue_.empty(); });
+
+    if (!queue_.empty()) {
+      return take_front();
+    }
+    return std::nullopt;
+  }
+
+  TryPushResult try_push(T& item) override {
+    std::lock_guard lock(mu_);
+    if (closed_) {
+      return TryPushResult::kClosed;
+    }
+    if (queue_.size() >= capacity_) {
+      return TryPushResult::kFull;
+    }
+
+    queue_.push_back(std::move(item));
+    not_empty_.notify_one();
+    notify_observers();
+    return TryPushResult::kPushed;
+  }
+
+  std::optional<T> try_pop() override {
+    std::lock_guard lock(mu_);
+    if (queue_.empty()) {
+      return std::nullopt;
+    }
+    return take_front();
+  }
+
+  bool drained() const override {
+    std::lock_guard lock(mu_);
+    return closed_ && queue_.empty();
+  }
+
+  std::size_t size() const override {
+    std::lock_guard lock(mu_);
+    return queue_.size();
+  }
+
+  void wake_all() override {
+    std::lock_guard lock(mu_);
+    not_empty_.notify_all();
+    not_full_.notify_all();
+    notify_observers();
+  }
+
   void close() override {
     std::lock_guard lock(mu_);
     closed_ = true;
     not_empty_.notify_all();
     not_full_.notify_all();
+    notify_observers();
+  }
+
+  void add_observer(QueueObserver* observer) override {
+    std::lock_guard lock(mu_);
+    observers_.push_back(observer);
+  }
+
+  void remove_observer(QueueObserver* observer) override {
+    std::lock_guard lock(mu_);
+    observers_.erase(std::remove(observers_.begin(), observers_.end(), observer),
+                     observers_.end());
   }
 
  private:
+  // Requires mu_ held and a non-empty queue.
+  T take_front() {
+    T item = std::move(queue_.front());
+    queue_.pop_front();
+    not_full_.notify_one();
+    notify_observers();
+    return item;
+  }
+
+  // Requires mu_ held. Observers are rare, so the common path is one branch.
+  void notify_observers() noexcept {
+    for (auto* observer : observers_) {
+      observer->notify();
+    }
+  }
+
   std::size_t capacity_;
-  std::mutex mu_;
+  mutable std::mutex mu_;
   std::condition_variable not_empty_;
   std::condition_variable not_full_;
-  std::deque<T> queue_;
+  // The pool is only touched under mu_; the deque must be destroyed first.
+  std::shared_ptr<std::pmr::memory_resource> upstream_;
+  std::unique_ptr<std::pmr::unsynchronized_pool_resource> pool_;
+  std::pmr::deque<T> queue_;
+  std::vector<QueueObserver*> observers_;
   bool closed_{false};
 };
 
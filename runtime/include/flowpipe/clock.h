@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define FLOWPIPE_HAVE_TSC 1
+#else
+#define FLOWPIPE_HAVE_TSC 0
+#endif
+
+namespace flowpipe {
+
+// CLOCK_MONOTONIC in nanoseconds.
+inline uint64_t MonotonicNowNs() noexcept {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+namespace detail {
+
+// TSC -> CLOCK_MONOTONIC mapping: ns = base_ns + (tsc - base_tsc) * mult / 2^32.
+// Written by the calibration and drift-check code under a sequence lock
+// (odd `seq` while an update is in progress).
+struct TscMapping {
+  std::atomic<bool> enabled{false};
+  std::atomic<uint32_t> seq{0};
+  std::atomic<uint64_t> base_tsc{0};
+  std::atomic<uint64_t> base_ns{0};
+  std::atomic<uint64_t> mult{0};
+};
+
+extern TscMapping g_tsc_mapping;
+
+// 64x64 -> 128-bit products for the fixed-point scaling; __extension__ keeps
+// -Wpedantic quiet about the non-standard type.
+__extension__ typedef unsigned __int128 Uint128;
+
+}  // namespace detail
+
+/**
+ * Hot-path timestamp in the CLOCK_MONOTONIC timebase (nanoseconds).
+ *
+ * Reads the TSC and scales it when EnableTscClock() succeeded, otherwise
+ * reads CLOCK_MONOTONIC. Values from either source are comparable, so
+ * timestamps taken before and after switching can still be subtracted
+ * (within the calibration error).
+ */
+inline uint64_t FastNowNs() noexcept {
+#if FLOWPIPE_HAVE_TSC
+  const auto& m = detail::g_tsc_mapping;
+  if (m.enabled.load(std::memory_order_relaxed)) {
+    uint32_t seq = 0;
+    uint64_t base_tsc = 0;
+    uint64_t base_ns = 0;
+    uint64_t mult = 0;
+    do {
+      seq = m.seq.load(std::memory_order_acquire);
+      base_tsc = m.base_tsc.load(std::memory_order_relaxed);
+      base_ns = m.base_ns.load(std::memory_order_relaxed);
+      mult = m.mult.load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((seq & 1) != 0 || seq != m.seq.load(std::memory_order_relaxed));
+
+    const uint64_t tsc = __rdtsc();
+    if (tsc <= base_tsc) {
+      return base_ns;
+    }
+    return base_ns +
+           static_cast<uint64_t>((static_cast<detail::Uint128>(tsc - base_tsc) * mult) >> 32);
+  }
+#endif
+  return MonotonicNowNs();
+}
+
+// True if the CPU advertises an invariant TSC (constant rate across P/C
+// states). Always false off x86.
+bool HasInvariantTsc() noexcept;
+
+// Calibrates the TSC against CLOCK_MONOTONIC and switches FastNowNs() to it.
+// A background thread re-checks the mapping every `drift_check_interval`:
+// small drift is corrected by recalibrating, large drift switches back to
+// CLOCK_MONOTONIC. Returns false, leaving CLOCK_MONOTONIC in use, when the
+// CPU has no invariant TSC or calibration fails.
+bool EnableTscClock(std::chrono::milliseconds drift_check_interval = std::chrono::seconds(1));
+
+// Stops the drift check and switches FastNowNs() back to CLOCK_MONOTONIC.
+void DisableTscClock();
+
+// True while FastNowNs() reads the TSC.
+inline bool TscClockActive() noexcept {
+  return detail::g_tsc_mapping.enabled.load(std::memory_order_relaxed);
+}
+
+}  // namespace flowpipe
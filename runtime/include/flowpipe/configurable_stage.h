@@ -4,6 +4,8 @@
 
 namespace flowpipe {
 
+struct IStage;
+
 class ConfigurableStage {
  public:
   virtual ~ConfigurableStage() = default;
@@ -12,6 +14,19 @@ class ConfigurableStage {
   // The config is opaque to the runtime.
   // The plugin is responsible for parsing & validating.
   virtual bool configure(const google::protobuf::Struct& config) = 0;
+
+  // Optional. Returns a new, already configured instance for another worker
+  // of the same stage, sharing this one's immutable state (lookup tables,
+  // compiled regexes, ...) instead of rebuilding it. The runtime configures
+  // one instance and clones it for the rest; the clone is allocated like
+  // flowpipe_create_stage() would, since flowpipe_destroy_stage() frees it.
+  // Returning nullptr (the default) constructs and configures every worker.
+  // The runtime clones a given instance from one thread at a time, but the
+  // clones then run on their own worker threads alongside it: state they
+  // share must not change after configure() unless it is synchronized.
+  virtual IStage* clone() const {
+    return nullptr;
+  }
 };
 
 }  // namespace flowpipe
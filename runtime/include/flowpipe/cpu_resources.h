@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace flowpipe {
+
+// CPU quota of the process cgroup in CPUs (cgroup v2 cpu.max, or v1
+// cpu.cfs_quota_us / cpu.cfs_period_us). nullopt when unlimited or unknown.
+std::optional<double> CgroupCpuQuota();
+
+// CPUs the runtime may keep busy: the affinity mask size, capped by the
+// cgroup CPU quota rounded up. Always >= 1.
+size_t AvailableCpuCount();
+
+// Parses a kernel CPU list ("0-3,8,10-11") into sorted, unique CPU ids.
+// Malformed entries are skipped.
+std::vector<uint32_t> ParseCpuList(const std::string& list);
+
+// CPUs of the process cpuset cgroup (v2 cpuset.cpus.effective, or v1
+// cpuset.effective_cpus / cpuset.cpus). nullopt when unknown.
+std::optional<std::vector<uint32_t>> CgroupCpuset();
+
+// CPUs this process may run on: the affinity mask intersected with the
+// cgroup cpuset. Sorted.
+std::vector<uint32_t> UsableCpus();
+
+}  // namespace flowpipe
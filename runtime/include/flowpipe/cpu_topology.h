@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace flowpipe {
+
+// One logical CPU and the hardware it shares.
+struct CpuInfo {
+  uint32_t cpu = 0;
+  uint32_t core = 0;       // lowest CPU id among its SMT siblings
+  uint32_t l3 = 0;         // lowest CPU id sharing its last-level cache
+  uint32_t numa_node = 0;
+};
+
+/**
+ * Cores, SMT siblings, L3 domains and NUMA nodes of a set of CPUs, read
+ * from sysfs. Missing files degrade gracefully: a CPU without cache info
+ * is its own package's L3 domain, one without a node link is on node 0.
+ */
+class CpuTopology {
+ public:
+  CpuTopology() = default;
+  explicit CpuTopology(std::vector<CpuInfo> cpus);
+
+  // `sysfs_cpu_root` is normally /sys/devices/system/cpu.
+  static CpuTopology Detect(const std::vector<uint32_t>& cpus,
+                            const std::string& sysfs_cpu_root = "/sys/devices/system/cpu");
+
+  const std::vector<CpuInfo>& cpus() const noexcept {
+    return cpus_;
+  }
+
+  // nullptr when the CPU is not part of this topology.
+  const CpuInfo* find(uint32_t cpu) const noexcept;
+
+  size_t core_count() const;
+  size_t l3_count() const;
+  size_t numa_node_count() const;
+
+ private:
+  std::vector<CpuInfo> cpus_;  // sorted by cpu id
+};
+
+// One stage competing for CPUs in an automatic placement.
+struct PlacementRequest {
+  std::string stage;
+  uint32_t workers = 1;
+  bool hot = true;  // wants whole physical cores
+};
+
+struct StagePlacement {
+  std::string stage;
+  std::vector<uint32_t> cpus;   // sorted; the affinity mask of every worker
+  bool shares_smt = false;      // shares a physical core with another worker
+  bool oversubscribed = false;  // fewer CPUs than workers were left
+};
+
+/**
+ * Places stages on CPUs.
+ *
+ * Stages linked by an edge (producer, consumer index into `stages`) form a
+ * group that is kept inside one L3 domain, spilling to domains on the same
+ * NUMA node first when it does not fit. Hot stages are placed first and
+ * get one thread of each physical core, leaving its siblings unused; other
+ * stages pack siblings. Those idle siblings are only handed out once no free
+ * CPU is left. Every stage gets at least one CPU: when none are left it
+ * shares the whole L3 domain of its group.
+ *
+ * Returns one entry per request, in request order.
+ */
+std::vector<StagePlacement> PlanCpuPlacement(const CpuTopology& topology,
+                                             const std::vector<PlacementRequest>& stages,
+                                             const std::vector<std::pair<size_t, size_t>>& edges);
+
+}  // namespace flowpipe
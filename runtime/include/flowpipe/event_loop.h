@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <optional>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+#include "flowpipe/async_stage.h"
+
+namespace flowpipe {
+
+/**
+ * epoll-backed IoContext driving the coroutines of one async stage worker.
+ * Linux only: elsewhere the constructor throws, and the runtime rejects
+ * flows with async stages at startup.
+ *
+ * Not thread-safe except for Wake(), which interrupts a blocked RunOnce()
+ * from any thread (queue observers use it to signal new input).
+ */
+class EventLoop final : public IoContext {
+ public:
+  EventLoop();
+  ~EventLoop() override;
+
+  EventLoop(const EventLoop&) = delete;
+  EventLoop& operator=(const EventLoop&) = delete;
+
+  void watch(int fd, uint32_t events, std::coroutine_handle<> waiter,
+             uint32_t* revents) override;
+  void resume_after(std::chrono::nanoseconds delay, std::coroutine_handle<> waiter) override;
+
+  // Waits for fd readiness, due timers or Wake() and resumes the waiting
+  // coroutines. Blocks at most `timeout` (nullopt = until something happens).
+  void RunOnce(std::optional<std::chrono::milliseconds> timeout);
+
+  void Wake() noexcept;
+
+  // Coroutines currently waiting on an fd or timer.
+  size_t pending() const noexcept {
+    return watches_.size() + timers_.size();
+  }
+
+ private:
+  struct Watch {
+    std::coroutine_handle<> waiter;
+    uint32_t* revents;
+  };
+
+  struct Timer {
+    std::chrono::steady_clock::time_point deadline;
+    uint64_t seq;
+    std::coroutine_handle<> waiter;
+
+    bool operator>(const Timer& other) const noexcept {
+      return deadline != other.deadline ? deadline > other.deadline : seq > other.seq;
+    }
+  };
+
+  void ResumeDueTimers();
+
+  int epoll_fd_ = -1;
+  int wake_fd_ = -1;
+  std::unordered_map<int, Watch> watches_;
+  std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers_;
+  uint64_t timer_seq_ = 0;
+};
+
+}  // namespace flowpipe
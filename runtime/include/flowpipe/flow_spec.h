@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+
+#include "flowpipe/v1/flow.pb.h"
+
+namespace flowpipe {
+
+// Plugin a stage loads: the explicit `plugin`, else libstage_<type>.so.
+std::string StagePluginName(const flowpipe::v1::StageSpec& stage);
+
+// Structural checks that need no plugins: queue names and capacities,
+// stage names and thread counts, and that every queue a stage lists exists
+// (once per side). Throws std::runtime_error on the first problem.
+// Runtime::run calls it before creating anything.
+void ValidateFlowSpec(const flowpipe::v1::FlowSpec& spec);
+
+// Rewrites a spec into the explicit form the runtime would resolve anyway:
+// queue types set, stage plugin names set, and single input_queue /
+// output_queue folded into the repeated lists. Running it twice is a no-op.
+void NormalizeFlowSpec(flowpipe::v1::FlowSpec* spec);
+
+// Binary FlowSpec files (.pb). Serialization is deterministic, so the same
+// spec always produces the same bytes. Both return false and set `error` on
+// failure.
+bool ReadFlowSpecBinary(const std::string& path, flowpipe::v1::FlowSpec* spec,
+                        std::string* error);
+bool WriteFlowSpecBinary(const flowpipe::v1::FlowSpec& spec, const std::string& path,
+                         std::string* error);
+
+}  // namespace flowpipe
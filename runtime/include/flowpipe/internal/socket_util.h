@@ -0,0 +1,24 @@
+#pragma once
+
+// Socket calls shared by the observability endpoints, kept portable across
+// Linux and the BSDs/macOS; not installed.
+
+#include <string_view>
+
+namespace flowpipe::observability::detail {
+
+// Sets FD_CLOEXEC on `fd`. Returns false on failure.
+bool SetCloseOnExec(int fd);
+
+// socket(2) with FD_CLOEXEC set. Returns -1 on failure, with errno set.
+int OpenStreamSocket(int domain);
+
+// accept(2) with FD_CLOEXEC set and SIGPIPE suppressed on the client. Returns
+// -1 on failure, with errno set.
+int AcceptClient(int listen_fd);
+
+// Sends all of `data`, retrying on EINTR. A peer that went away fails the
+// call instead of raising SIGPIPE.
+bool SendAll(int fd, std::string_view data);
+
+}  // namespace flowpipe::observability::detail
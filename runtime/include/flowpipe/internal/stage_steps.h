@@ -0,0 +1,1324 @@
+#pragma once
+
+// Building blocks of the stage runners: input/output sets, the per-payload
+// steps and the threaded loops that drive them. Internal to the runtime and
+// not installed; statically linked stages instantiate the loops on their
+// concrete type through internal/static_stage_runner.h.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "flowpipe/clock.h"
+#include "flowpipe/observability/logging_runtime.h"
+#include "flowpipe/queue_wait_set.h"
+#include "flowpipe/stage_metrics.h"
+#include "flowpipe/stage_runner.h"
+
+#if FLOWPIPE_ENABLE_OTEL
+#include <opentelemetry/common/timestamp.h>
+#include <opentelemetry/trace/span_context.h>
+#include <opentelemetry/trace/span_id.h>
+#include <opentelemetry/trace/trace_id.h>
+#include <opentelemetry/trace/tracer.h>
+
+#include "flowpipe/observability/observability_state.h"
+#endif
+
+namespace flowpipe::detail {
+
+// ------------------------------------------------------------
+// Time helper (monotonic timebase, nanoseconds; TSC-backed when enabled)
+// ------------------------------------------------------------
+inline uint64_t now_ns() noexcept {
+  return FastNowNs();
+}
+
+// ------------------------------------------------------------
+// Record sampling
+// ------------------------------------------------------------
+// Per-worker choice of which records to time, histogram and trace. Every
+// `one_in`-th record is a candidate; with max_per_second set, candidates are
+// dropped once the worker has sampled that many in the current second.
+class RecordSampler {
+ public:
+  explicit RecordSampler(const SamplingOptions& options) noexcept
+      : one_in_(std::max<uint32_t>(1, options.one_in)),
+        max_per_second_(options.max_per_second) {}
+
+  bool Sample() noexcept {
+    if (one_in_ > 1 && ++skipped_ < one_in_) {
+      return false;
+    }
+    skipped_ = 0;
+    if (max_per_second_ == 0) {
+      return true;
+    }
+
+    const uint64_t now = now_ns();
+    if (now - window_start_ns_ >= kWindowNs) {
+      window_start_ns_ = now;
+      taken_ = 0;
+    }
+    if (taken_ >= max_per_second_) {
+      return false;
+    }
+    ++taken_;
+    return true;
+  }
+
+ private:
+  static constexpr uint64_t kWindowNs = 1'000'000'000;
+
+  const uint32_t one_in_;
+  const uint32_t max_per_second_;
+  uint32_t skipped_ = 0;
+  uint32_t taken_ = 0;
+  uint64_t window_start_ns_ = 0;
+};
+
+inline SamplingOptions SamplingFor(const StageMetrics* metrics) noexcept {
+  return metrics ? metrics->sampling() : SamplingOptions{};
+}
+
+// Dequeues are always counted; only sampled ones measure queue dwell.
+inline void RecordDequeue(StageMetrics* metrics, const QueueRuntime& queue,
+                          const Payload& payload, bool sampled) noexcept {
+  if (!metrics) {
+    return;
+  }
+  if (sampled) {
+    metrics->RecordQueueDequeue(queue, payload);
+  } else {
+    metrics->CountQueueDequeue(queue, payload);
+  }
+}
+
+// Processed records are always counted; only sampled ones were timed.
+inline void RecordProcessed(StageMetrics* metrics, const std::string& stage_name, bool sampled,
+                            uint64_t start_ns, uint64_t end_ns) noexcept {
+  if (!metrics) {
+    return;
+  }
+  if (sampled) {
+    metrics->RecordStageLatency(stage_name.c_str(), end_ns - start_ns);
+  } else {
+    metrics->CountStageRecord(stage_name.c_str());
+  }
+}
+
+// Sinks report, for sampled records, the time since the record entered the
+// flow.
+inline void RecordEndToEnd(StageMetrics* metrics, const std::string& stage_name,
+                           const PayloadMeta& meta, uint64_t end_ns) noexcept {
+  if (metrics && meta.origin_ts_ns > 0 && end_ns > meta.origin_ts_ns) {
+    metrics->RecordEndToEndLatency(stage_name.c_str(), end_ns - meta.origin_ts_ns);
+  }
+}
+
+inline bool ValidateInputSchema(const QueueRuntime& queue, const Payload& payload,
+                                const char* stage_name) {
+  if (queue.schema_id.empty()) {
+    return true;
+  }
+
+  if (payload.meta.schema_id.empty()) {
+    FP_LOG_ERROR_FMT("stage '{}' received payload without schema_id on queue '{}'", stage_name,
+                     queue.name);
+    return false;
+  }
+
+  if (payload.meta.schema_id != queue.schema_id) {
+    FP_LOG_ERROR_FMT(
+        "stage '{}' received payload with schema_id '{}' on queue '{}' (expected '{}')", stage_name,
+        payload.meta.schema_id, queue.name, queue.schema_id);
+    return false;
+  }
+
+  return true;
+}
+
+inline bool ApplyOutputSchema(const QueueRuntime& queue, Payload& payload, const char* stage_name) {
+  if (queue.schema_id.empty()) {
+    return true;
+  }
+
+  if (payload.meta.schema_id.empty()) {
+    payload.meta.schema_id = queue.schema_id;
+    return true;
+  }
+
+  if (payload.meta.schema_id != queue.schema_id) {
+    FP_LOG_ERROR_FMT(
+        "stage '{}' produced payload with schema_id '{}' for queue '{}' (expected "
+        "'{}')",
+        stage_name, payload.meta.schema_id, queue.name, queue.schema_id);
+    return false;
+  }
+
+  return true;
+}
+
+#if FLOWPIPE_ENABLE_OTEL
+
+inline bool StageSpansEnabled() noexcept {
+  return flowpipe::observability::GetOtelState().stage_spans_enabled;
+}
+
+inline bool QueueSpansEnabled() noexcept {
+  return flowpipe::observability::GetOtelState().queue_spans_enabled;
+}
+
+inline bool RecordSpansEnabled() noexcept {
+  return flowpipe::observability::GetOtelState().record_spans_enabled;
+}
+
+// Cached by InitTracing(); non-null whenever one of the span flags is set.
+inline const opentelemetry::nostd::shared_ptr<opentelemetry::trace::Tracer>& GetTracer() noexcept {
+  return flowpipe::observability::GetOtelState().tracer;
+}
+
+// Span context in the payload's trace with one of its span ids (if present).
+inline opentelemetry::trace::SpanContext PayloadSpanContext(
+    const PayloadMeta& meta, const uint8_t (&span_id_bytes)[PayloadMeta::span_id_size]) {
+  if (!meta.has_trace()) {
+    return opentelemetry::trace::SpanContext::GetInvalid();
+  }
+
+  opentelemetry::trace::TraceId trace_id{
+      opentelemetry::nostd::span<const uint8_t, PayloadMeta::trace_id_size>(meta.trace_id)};
+
+  opentelemetry::trace::SpanId span_id{
+      opentelemetry::nostd::span<const uint8_t, PayloadMeta::span_id_size>(span_id_bytes)};
+
+  opentelemetry::trace::TraceFlags flags{static_cast<uint8_t>(meta.flags & 0xFF)};
+
+  return opentelemetry::trace::SpanContext{trace_id, span_id, flags, /*is_remote=*/true};
+}
+
+// Build a parent span context from PayloadMeta (if present)
+inline opentelemetry::trace::SpanContext SpanContextFromPayload(const PayloadMeta& meta) {
+  return PayloadSpanContext(meta, meta.span_id);
+}
+
+// Context the record entered the flow under: its trace and the span it
+// carried at its first enqueue. Invalid if it had no span by then.
+inline opentelemetry::trace::SpanContext OriginSpanContextFromPayload(const PayloadMeta& meta) {
+  return PayloadSpanContext(meta, meta.origin_span_id);
+}
+
+// Write child span context back into payload metadata
+inline void WriteSpanToPayload(const opentelemetry::trace::SpanContext& ctx,
+                               PayloadMeta& meta) noexcept {
+  if (!ctx.IsValid()) {
+    std::memset(meta.trace_id, 0, PayloadMeta::trace_id_size);
+    std::memset(meta.span_id, 0, PayloadMeta::span_id_size);
+    meta.flags = 0;
+    return;
+  }
+
+  ctx.trace_id().CopyBytesTo(
+      opentelemetry::nostd::span<uint8_t, PayloadMeta::trace_id_size>(meta.trace_id));
+
+  ctx.span_id().CopyBytesTo(
+      opentelemetry::nostd::span<uint8_t, PayloadMeta::span_id_size>(meta.span_id));
+
+  meta.flags = ctx.trace_flags().flags();
+}
+
+// Records a span for an interval that has already elapsed, from runtime
+// timestamps (now_ns() timebase), and returns its context.
+inline opentelemetry::trace::SpanContext EmitElapsedSpan(
+    opentelemetry::nostd::string_view name, const opentelemetry::trace::SpanContext& parent,
+    uint64_t start_ns, uint64_t end_ns, opentelemetry::nostd::string_view attr_key,
+    const std::string& attr_value) {
+  const int64_t offset_ns = flowpipe::observability::GetOtelState().system_offset_ns;
+
+  opentelemetry::trace::StartSpanOptions opts;
+  opts.start_system_time = opentelemetry::common::SystemTimestamp(
+      std::chrono::nanoseconds(static_cast<int64_t>(start_ns) + offset_ns));
+  opts.start_steady_time =
+      opentelemetry::common::SteadyTimestamp(std::chrono::nanoseconds(start_ns));
+  if (parent.IsValid()) {
+    opts.parent = parent;
+  }
+
+  auto span = GetTracer()->StartSpan(name, opts);
+  span->SetAttribute(attr_key, opentelemetry::nostd::string_view(attr_value));
+
+  opentelemetry::trace::EndSpanOptions end;
+  end.end_steady_time = opentelemetry::common::SteadyTimestamp(std::chrono::nanoseconds(end_ns));
+  span->End(end);
+  return span->GetContext();
+}
+
+// Parent for the span of a stage consuming `meta` from `queue`. With queue
+// spans on, first records the record's wait in the queue, from the enqueue
+// stamp to `dequeue_ns` (a timestamp the caller already took), and nests
+// the stage span under it.
+inline opentelemetry::trace::SpanContext QueueWaitSpan(const QueueRuntime& queue,
+                                                       const PayloadMeta& meta,
+                                                       uint64_t dequeue_ns) {
+  auto parent = SpanContextFromPayload(meta);
+  if (!QueueSpansEnabled() || meta.enqueue_ts_ns == 0 || dequeue_ns < meta.enqueue_ts_ns) {
+    return parent;
+  }
+  return EmitElapsedSpan("flowpipe.queue.wait", parent, meta.enqueue_ts_ns, dequeue_ns,
+                         "flowpipe.queue", queue.name);
+}
+
+// With record spans on, records a sampled record's whole trip through the
+// flow, from entry to the end of the sink that consumed it. The span hangs
+// off the context the record entered with, not the last stage's span, which
+// started long after it; without one it is a root span.
+inline void RecordSpan(const std::string& stage_name, const PayloadMeta& meta, uint64_t end_ns) {
+  if (!RecordSpansEnabled() || meta.origin_ts_ns == 0 || end_ns < meta.origin_ts_ns) {
+    return;
+  }
+  EmitElapsedSpan("flowpipe.record", OriginSpanContextFromPayload(meta), meta.origin_ts_ns,
+                  end_ns, "flowpipe.stage", stage_name);
+}
+
+#endif  // FLOWPIPE_ENABLE_OTEL
+
+// ------------------------------------------------------------
+// Stage inputs (one or many queues, merged fairly)
+// ------------------------------------------------------------
+
+class InputSet {
+ public:
+  // Non-blocking users (pooled tasks) only call TryPop() and skip the wait set.
+  explicit InputSet(const QueueList& inputs, bool blocking = true)
+      : inputs_(inputs), observed_(blocking && inputs.size() > 1) {
+    if (observed_) {
+      for (auto* input : inputs_) {
+        input->queue->add_observer(&waits_);
+      }
+    }
+  }
+
+  ~InputSet() {
+    if (observed_) {
+      for (auto* input : inputs_) {
+        input->queue->remove_observer(&waits_);
+      }
+    }
+  }
+
+  InputSet(const InputSet&) = delete;
+  InputSet& operator=(const InputSet&) = delete;
+
+  // Blocks until a payload is available on any input, every input is
+  // drained, or stop is requested. Inputs are polled round-robin starting
+  // after the queue that produced the previous payload, so a busy queue
+  // cannot starve the others.
+  std::optional<Payload> Pop(const StopToken& stop, QueueRuntime*& from) {
+    if (inputs_.size() == 1) {
+      from = inputs_.front();
+      return from->queue->pop(stop);
+    }
+
+    while (!stop.stop_requested()) {
+      const uint64_t seen = waits_.epoch();
+      bool all_drained = true;
+
+      for (size_t n = 0; n < inputs_.size(); ++n) {
+        const size_t index = (next_ + n) % inputs_.size();
+        auto* input = inputs_[index];
+        if (auto item = input->queue->try_pop()) {
+          next_ = index + 1;
+          from = input;
+          return item;
+        }
+        if (!input->queue->drained()) {
+          all_drained = false;
+        }
+      }
+
+      if (all_drained) {
+        return std::nullopt;
+      }
+      waits_.wait(seen, stop);
+    }
+    return std::nullopt;
+  }
+
+  // Like Pop(), but gives up at `deadline`.
+  std::optional<Payload> PopUntil(const StopToken& stop, QueueRuntime*& from,
+                                  std::chrono::steady_clock::time_point deadline) {
+    if (inputs_.size() == 1) {
+      from = inputs_.front();
+      const auto remaining = deadline - std::chrono::steady_clock::now();
+      if (remaining <= std::chrono::steady_clock::duration::zero()) {
+        return from->queue->try_pop();
+      }
+      return from->queue->pop_for(remaining, stop);
+    }
+
+    while (!stop.stop_requested()) {
+      const uint64_t seen = waits_.epoch();
+      bool drained = false;
+      if (auto item = TryPop(from, drained)) {
+        return item;
+      }
+      if (drained || !waits_.wait_until(seen, stop, deadline)) {
+        return std::nullopt;
+      }
+    }
+    return std::nullopt;
+  }
+
+  // Non-blocking round-robin pop. Sets `drained` when every input is closed
+  // and empty.
+  std::optional<Payload> TryPop(QueueRuntime*& from, bool& drained) {
+    drained = true;
+    for (size_t n = 0; n < inputs_.size(); ++n) {
+      const size_t index = (next_ + n) % inputs_.size();
+      auto* input = inputs_[index];
+      if (auto item = input->queue->try_pop()) {
+        next_ = index + 1;
+        from = input;
+        drained = false;
+        return item;
+      }
+      if (!input->queue->drained()) {
+        drained = false;
+      }
+    }
+    return std::nullopt;
+  }
+
+  // True once every input is closed and empty.
+  bool Drained() const {
+    for (auto* input : inputs_) {
+      if (!input->queue->drained()) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Wakes peer workers blocked on any of the inputs.
+  void CloseAll() {
+    for (auto* input : inputs_) {
+      input->queue->close();
+    }
+  }
+
+ private:
+  const QueueList& inputs_;
+  const bool observed_;
+  QueueWaitSet waits_;
+  size_t next_ = 0;
+};
+
+// ------------------------------------------------------------
+// Stage outputs (one or many queues, routed or broadcast)
+// ------------------------------------------------------------
+class OutputSet {
+ public:
+  OutputSet(const QueueList& outputs, StageContext& ctx, StageMetrics* metrics,
+            const std::string& stage_name)
+      : outputs_(outputs),
+        ctx_(ctx),
+        metrics_(metrics),
+        stage_name_(stage_name),
+        closed_(outputs.size(), false),
+        open_(outputs.size()) {}
+
+  size_t size() const noexcept {
+    return outputs_.size();
+  }
+
+  // True once stop was requested during a push or every output is closed.
+  bool done() const noexcept {
+    return done_;
+  }
+
+  // Returns false when the stream should end. A payload routed to an output
+  // that closed while others remain open is dropped. Only `sampled` records
+  // are stamped with their enqueue time, plus records entering the flow,
+  // whose stamp is also their origin.
+  bool Push(size_t index, Payload payload, bool sampled) {
+    if (done_) {
+      return false;
+    }
+    if (closed_[index]) {
+      return true;
+    }
+
+    auto& output = *outputs_[index];
+    if (!ApplyOutputSchema(output, payload, stage_name_.c_str())) {
+      if (metrics_) {
+        metrics_->RecordStageError(stage_name_.c_str());
+      }
+      return true;
+    }
+
+    if (sampled || payload.meta.origin_ts_ns == 0) {
+      payload.meta.enqueue_ts_ns = now_ns();
+      if (payload.meta.origin_ts_ns == 0) {
+        payload.meta.origin_ts_ns = payload.meta.enqueue_ts_ns;
+        std::memcpy(payload.meta.origin_span_id, payload.meta.span_id, PayloadMeta::span_id_size);
+      }
+    } else {
+      // Not the stamp of the queue the input came from.
+      payload.meta.enqueue_ts_ns = 0;
+    }
+    if (deferred_) {
+      if (!deferred_->empty()) {
+        deferred_->emplace_back(index, std::move(payload));
+        return true;
+      }
+      return Offer(index, payload);
+    }
+
+    if (!output.queue->push(std::move(payload), ctx_.stop)) {
+      MarkClosed(index);
+      return !done_;
+    }
+
+    if (metrics_) {
+      metrics_->RecordQueueEnqueue(output);
+    }
+    return true;
+  }
+
+  // Pooled tasks and async workers must not block: pushes to a full output
+  // are parked here, in order, until FlushDeferred() moves them out.
+  void SetDeferred(std::deque<std::pair<size_t, Payload>>* deferred) noexcept {
+    deferred_ = deferred;
+  }
+
+  bool has_deferred() const noexcept {
+    return deferred_ && !deferred_->empty();
+  }
+
+  // Returns true once nothing is left parked.
+  bool FlushDeferred() {
+    while (has_deferred() && !done_) {
+      auto& [index, payload] = deferred_->front();
+      if (!closed_[index]) {
+        switch (outputs_[index]->queue->try_push(payload)) {
+          case TryPushResult::kFull:
+            return false;
+          case TryPushResult::kPushed:
+            if (metrics_) {
+              metrics_->RecordQueueEnqueue(*outputs_[index]);
+            }
+            break;
+          case TryPushResult::kClosed:
+            MarkClosed(index);
+            break;
+        }
+      }
+      deferred_->pop_front();
+    }
+    if (done_ && deferred_) {
+      deferred_->clear();
+    }
+    return true;
+  }
+
+  // Sends a copy of the payload to every open output.
+  bool Broadcast(Payload payload, bool sampled) {
+    if (outputs_.size() == 1) {
+      return Push(0, std::move(payload), sampled);
+    }
+
+    size_t last = outputs_.size();
+    for (size_t i = 0; i < outputs_.size(); ++i) {
+      if (!closed_[i]) {
+        last = i;
+      }
+    }
+
+    for (size_t i = 0; i < outputs_.size() && !done_; ++i) {
+      if (closed_[i]) {
+        continue;
+      }
+      if (i == last) {
+        return Push(i, std::move(payload), sampled);
+      }
+      Push(i, payload, sampled);
+    }
+    return !done_;
+  }
+
+ private:
+  bool Offer(size_t index, Payload& payload) {
+    switch (outputs_[index]->queue->try_push(payload)) {
+      case TryPushResult::kPushed:
+        if (metrics_) {
+          metrics_->RecordQueueEnqueue(*outputs_[index]);
+        }
+        return true;
+      case TryPushResult::kFull:
+        deferred_->emplace_back(index, std::move(payload));
+        return true;
+      case TryPushResult::kClosed:
+        MarkClosed(index);
+        return !done_;
+    }
+    return true;
+  }
+
+  void MarkClosed(size_t index) {
+    if (ctx_.stop.stop_requested()) {
+      FP_LOG_DEBUG_FMT("stage '{}' stop requested while pushing", stage_name_);
+      done_ = true;
+      return;
+    }
+
+    FP_LOG_DEBUG_FMT("stage '{}' output queue '{}' closed", stage_name_, outputs_[index]->name);
+    closed_[index] = true;
+    if (--open_ == 0) {
+      done_ = true;
+    }
+  }
+
+  const QueueList& outputs_;
+  StageContext& ctx_;
+  StageMetrics* metrics_;
+  const std::string& stage_name_;
+  std::vector<bool> closed_;
+  size_t open_;
+  bool done_ = false;
+  std::deque<std::pair<size_t, Payload>>* deferred_ = nullptr;
+};
+
+// ------------------------------------------------------------
+// Flat-map emitter (one per runner, reused across inputs)
+// ------------------------------------------------------------
+class QueueEmitter final : public Emitter {
+ public:
+  QueueEmitter(OutputSet& outputs, StageMetrics* metrics, const std::string& stage_name)
+      : outputs_(outputs), metrics_(metrics), stage_name_(stage_name) {}
+
+  // Rebind to the next input, and whether it was sampled, before calling
+  // the stage.
+  void Reset(const PayloadMeta* input_meta, bool sampled) noexcept {
+    input_meta_ = input_meta;
+    sampled_ = sampled;
+  }
+
+#if FLOWPIPE_ENABLE_OTEL
+  void SetSpanContext(const opentelemetry::trace::SpanContext* span_ctx) noexcept {
+    span_ctx_ = span_ctx;
+  }
+#endif
+
+  bool emit(Payload payload) override {
+    if (outputs_.done()) {
+      return false;
+    }
+    InheritInputMeta(payload.meta);
+    return outputs_.Broadcast(std::move(payload), sampled_);
+  }
+
+  bool emit_to(size_t output, Payload payload) override {
+    if (outputs_.done()) {
+      return false;
+    }
+    if (output >= outputs_.size()) {
+      FP_LOG_ERROR_FMT("flat-map stage '{}' emitted to output {} but only {} are wired",
+                       stage_name_, output, outputs_.size());
+      if (metrics_) {
+        metrics_->RecordStageError(stage_name_.c_str());
+      }
+      return true;
+    }
+    InheritInputMeta(payload.meta);
+    return outputs_.Push(output, std::move(payload), sampled_);
+  }
+
+  size_t output_count() const override {
+    return outputs_.size();
+  }
+
+ private:
+  void InheritInputMeta(PayloadMeta& meta) const noexcept {
+#if FLOWPIPE_ENABLE_OTEL
+    // The stage span is the parent of everything emitted for this input.
+    if (span_ctx_) {
+      WriteSpanToPayload(*span_ctx_, meta);
+    }
+#endif
+    if (!input_meta_) {
+      return;
+    }
+
+    if (!meta.has_trace() && input_meta_->has_trace()) {
+      std::memcpy(meta.trace_id, input_meta_->trace_id, PayloadMeta::trace_id_size);
+      std::memcpy(meta.span_id, input_meta_->span_id, PayloadMeta::span_id_size);
+      meta.flags = input_meta_->flags;
+    }
+
+    if (!meta.attrs) {
+      meta.attrs = input_meta_->attrs;
+    }
+
+    if (meta.origin_ts_ns == 0) {
+      meta.origin_ts_ns = input_meta_->origin_ts_ns;
+      std::memcpy(meta.origin_span_id, input_meta_->origin_span_id, PayloadMeta::span_id_size);
+    }
+  }
+
+  OutputSet& outputs_;
+  StageMetrics* metrics_;
+  const std::string& stage_name_;
+  const PayloadMeta* input_meta_ = nullptr;
+  bool sampled_ = false;
+#if FLOWPIPE_ENABLE_OTEL
+  const opentelemetry::trace::SpanContext* span_ctx_ = nullptr;
+#endif
+};
+
+// ------------------------------------------------------------
+// Per-payload consumer steps
+// ------------------------------------------------------------
+// Shared by the threaded runners, fused queues (which run the step inline on
+// the producer's thread) and statically linked stages. `Stage` is the stage
+// interface, or a final stage class so its calls bind directly.
+enum class StepResult {
+  kContinue,    // ready for the next input
+  kOutputDone,  // every output closed or stop requested
+  kFailed,      // stage threw; global stop already requested
+};
+
+template <typename Stage>
+class BasicSourceStep {
+ public:
+  static constexpr const char* kKind = "source";
+
+  BasicSourceStep(Stage* stage, StageContext& ctx, const QueueList& outputs,
+                  StageMetrics* metrics)
+      : stage_(stage),
+        ctx_(ctx),
+        metrics_(metrics),
+        sampler_(SamplingFor(metrics)),
+        stage_name_(stage->name()),
+        out_(outputs, ctx, metrics, stage_name_) {}
+
+  BasicSourceStep(const BasicSourceStep&) = delete;
+  BasicSourceStep& operator=(const BasicSourceStep&) = delete;
+
+  const std::string& name() const noexcept {
+    return stage_name_;
+  }
+
+  OutputSet* outputs() noexcept {
+    return &out_;
+  }
+
+  // Produces and forwards one payload. kOutputDone also covers end-of-stream.
+  StepResult Produce() {
+    Payload payload;
+
+    const bool sampled = sampler_.Sample();
+    const uint64_t start_ns = sampled ? now_ns() : 0;
+    bool produced = false;
+    try {
+      produced = stage_->produce(ctx_, payload);
+    } catch (const std::exception& ex) {
+      FP_LOG_ERROR_FMT("source stage '{}' threw exception: {}", stage_name_, ex.what());
+      if (metrics_) {
+        metrics_->RecordStageError(stage_name_.c_str());
+      }
+      ctx_.request_stop();
+      return StepResult::kFailed;
+    } catch (...) {
+      FP_LOG_ERROR_FMT("source stage '{}' threw unknown exception", stage_name_);
+      if (metrics_) {
+        metrics_->RecordStageError(stage_name_.c_str());
+      }
+      ctx_.request_stop();
+      return StepResult::kFailed;
+    }
+    const uint64_t end_ns = sampled ? now_ns() : 0;
+
+#if FLOWPIPE_ENABLE_OTEL
+    // Create the span AFTER produce() so we can use the trace context that
+    // produce() extracted from the incoming message (e.g. W3C traceparent from
+    // NATS headers) as the parent.  Creating the span before produce() would
+    // start it with no parent and WriteSpanToPayload would overwrite the
+    // incoming context, breaking the link to the gateway/client trace.
+    if (sampled && StageSpansEnabled() && produced) {
+      const auto& tracer = GetTracer();
+      auto parent_ctx = SpanContextFromPayload(payload.meta);
+
+      opentelemetry::trace::StartSpanOptions opts;
+      if (parent_ctx.IsValid()) {
+        opts.parent = parent_ctx;
+      }
+
+      auto span = tracer->StartSpan(stage_name_, opts);
+      WriteSpanToPayload(span->GetContext(), payload.meta);
+      span->End();
+    }
+#endif
+
+    if (!produced) {
+      FP_LOG_DEBUG_FMT("source stage '{}' returned no payload (terminating)", stage_name_);
+      return StepResult::kOutputDone;
+    }
+
+    RecordProcessed(metrics_, stage_name_, sampled, start_ns, end_ns);
+
+    if (!out_.Broadcast(std::move(payload), sampled)) {
+      FP_LOG_DEBUG_FMT("source stage '{}' output queue closed or stop requested", stage_name_);
+      return StepResult::kOutputDone;
+    }
+    return StepResult::kContinue;
+  }
+
+ private:
+  Stage* stage_;
+  StageContext& ctx_;
+  StageMetrics* metrics_;
+  RecordSampler sampler_;
+  const std::string stage_name_;
+  OutputSet out_;
+};
+
+using SourceStep = BasicSourceStep<ISourceStage>;
+
+template <typename Stage>
+class BasicTransformStep {
+ public:
+  static constexpr const char* kKind = "transform";
+
+  BasicTransformStep(Stage* stage, StageContext& ctx, const QueueList& outputs,
+                     StageMetrics* metrics)
+      : stage_(stage),
+        ctx_(ctx),
+        metrics_(metrics),
+        sampler_(SamplingFor(metrics)),
+        stage_name_(stage->name()),
+        out_(outputs, ctx, metrics, stage_name_) {}
+
+  BasicTransformStep(const BasicTransformStep&) = delete;
+  BasicTransformStep& operator=(const BasicTransformStep&) = delete;
+
+  const std::string& name() const noexcept {
+    return stage_name_;
+  }
+
+  OutputSet* outputs() noexcept {
+    return &out_;
+  }
+
+  StepResult Process(const QueueRuntime& input, const Payload& in_payload) {
+    const bool sampled = sampler_.Sample();
+    RecordDequeue(metrics_, input, in_payload, sampled);
+
+    if (!ValidateInputSchema(input, in_payload, stage_name_.c_str())) {
+      if (metrics_) {
+        metrics_->RecordStageError(stage_name_.c_str());
+      }
+      return StepResult::kContinue;
+    }
+
+    // Also the dequeue time of the queue-wait span.
+    const uint64_t start_ns = sampled ? now_ns() : 0;
+
+#if FLOWPIPE_ENABLE_OTEL
+    opentelemetry::nostd::shared_ptr<opentelemetry::trace::Span> span;
+    std::unique_ptr<opentelemetry::trace::Scope> scope;
+
+    if (sampled) {
+      auto parent_ctx = QueueWaitSpan(input, in_payload.meta, start_ns);
+      if (StageSpansEnabled()) {
+        const auto& tracer = GetTracer();
+        opentelemetry::trace::StartSpanOptions opts;
+        if (parent_ctx.IsValid()) {
+          opts.parent = parent_ctx;
+        }
+
+        span = tracer->StartSpan(stage_name_, opts);
+        scope = std::make_unique<opentelemetry::trace::Scope>(tracer->WithActiveSpan(span));
+      }
+    }
+#endif
+
+    Payload out_payload;
+    out_payload.meta = in_payload.meta;
+
+    try {
+      stage_->process(ctx_, in_payload, out_payload);
+    } catch (const std::exception& ex) {
+      FP_LOG_ERROR_FMT("transform stage '{}' threw exception: {}", stage_name_, ex.what());
+      if (metrics_) {
+        metrics_->RecordStageError(stage_name_.c_str());
+      }
+      ctx_.request_stop();
+#if FLOWPIPE_ENABLE_OTEL
+      if (span) {
+        span->End();
+      }
+#endif
+      return StepResult::kFailed;
+    } catch (...) {
+      FP_LOG_ERROR_FMT("transform stage '{}' threw unknown exception", stage_name_);
+      if (metrics_) {
+        metrics_->RecordStageError(stage_name_.c_str());
+      }
+      ctx_.request_stop();
+#if FLOWPIPE_ENABLE_OTEL
+      if (span) {
+        span->End();
+      }
+#endif
+      return StepResult::kFailed;
+    }
+    const uint64_t end_ns = sampled ? now_ns() : 0;
+
+#if FLOWPIPE_ENABLE_OTEL
+    if (span) {
+      WriteSpanToPayload(span->GetContext(), out_payload.meta);
+      span->End();
+    }
+#endif
+
+    RecordProcessed(metrics_, stage_name_, sampled, start_ns, end_ns);
+
+    if (!out_.Broadcast(std::move(out_payload), sampled)) {
+      return StepResult::kOutputDone;
+    }
+    return StepResult::kContinue;
+  }
+
+ private:
+  Stage* stage_;
+  StageContext& ctx_;
+  StageMetrics* metrics_;
+  RecordSampler sampler_;
+  const std::string stage_name_;
+  OutputSet out_;
+};
+
+using TransformStep = BasicTransformStep<ITransformStage>;
+
+template <typename Stage>
+class BasicFlatMapStep {
+ public:
+  static constexpr const char* kKind = "flat-map";
+
+  BasicFlatMapStep(Stage* stage, StageContext& ctx, const QueueList& outputs,
+                   StageMetrics* metrics)
+      : stage_(stage),
+        ctx_(ctx),
+        metrics_(metrics),
+        sampler_(SamplingFor(metrics)),
+        stage_name_(stage->name()),
+        out_(outputs, ctx, metrics, stage_name_),
+        emitter_(out_, metrics, stage_name_) {}
+
+  BasicFlatMapStep(const BasicFlatMapStep&) = delete;
+  BasicFlatMapStep& operator=(const BasicFlatMapStep&) = delete;
+
+  const std::string& name() const noexcept {
+    return stage_name_;
+  }
+
+  OutputSet* outputs() noexcept {
+    return &out_;
+  }
+
+  StepResult Process(const QueueRuntime& input, const Payload& in_payload) {
+    const bool sampled = sampler_.Sample();
+    RecordDequeue(metrics_, input, in_payload, sampled);
+
+    if (!ValidateInputSchema(input, in_payload, stage_name_.c_str())) {
+      if (metrics_) {
+        metrics_->RecordStageError(stage_name_.c_str());
+      }
+      return StepResult::kContinue;
+    }
+
+    // Also the dequeue time of the queue-wait span.
+    const uint64_t start_ns = sampled ? now_ns() : 0;
+
+#if FLOWPIPE_ENABLE_OTEL
+    opentelemetry::nostd::shared_ptr<opentelemetry::trace::Span> span;
+    std::unique_ptr<opentelemetry::trace::Scope> scope;
+    opentelemetry::trace::SpanContext span_ctx = opentelemetry::trace::SpanContext::GetInvalid();
+
+    if (sampled) {
+      auto parent_ctx = QueueWaitSpan(input, in_payload.meta, start_ns);
+      if (StageSpansEnabled()) {
+        const auto& tracer = GetTracer();
+        opentelemetry::trace::StartSpanOptions opts;
+        if (parent_ctx.IsValid()) {
+          opts.parent = parent_ctx;
+        }
+
+        span = tracer->StartSpan(stage_name_, opts);
+        scope = std::make_unique<opentelemetry::trace::Scope>(tracer->WithActiveSpan(span));
+        span_ctx = span->GetContext();
+      }
+    }
+    emitter_.SetSpanContext(span ? &span_ctx : nullptr);
+#endif
+
+    emitter_.Reset(&in_payload.meta, sampled);
+
+    try {
+      stage_->process(ctx_, in_payload, emitter_);
+    } catch (const std::exception& ex) {
+      FP_LOG_ERROR_FMT("flat-map stage '{}' threw exception: {}", stage_name_, ex.what());
+      if (metrics_) {
+        metrics_->RecordStageError(stage_name_.c_str());
+      }
+      ctx_.request_stop();
+#if FLOWPIPE_ENABLE_OTEL
+      if (span) {
+        span->End();
+      }
+#endif
+      return StepResult::kFailed;
+    } catch (...) {
+      FP_LOG_ERROR_FMT("flat-map stage '{}' threw unknown exception", stage_name_);
+      if (metrics_) {
+        metrics_->RecordStageError(stage_name_.c_str());
+      }
+      ctx_.request_stop();
+#if FLOWPIPE_ENABLE_OTEL
+      if (span) {
+        span->End();
+      }
+#endif
+      return StepResult::kFailed;
+    }
+    const uint64_t end_ns = sampled ? now_ns() : 0;
+
+#if FLOWPIPE_ENABLE_OTEL
+    if (span) {
+      span->End();
+    }
+#endif
+
+    RecordProcessed(metrics_, stage_name_, sampled, start_ns, end_ns);
+
+    if (out_.done()) {
+      return StepResult::kOutputDone;
+    }
+    return StepResult::kContinue;
+  }
+
+ private:
+  Stage* stage_;
+  StageContext& ctx_;
+  StageMetrics* metrics_;
+  RecordSampler sampler_;
+  const std::string stage_name_;
+  OutputSet out_;
+  QueueEmitter emitter_;
+};
+
+using FlatMapStep = BasicFlatMapStep<IFlatMapStage>;
+
+template <typename Stage>
+class BasicSinkStep {
+ public:
+  static constexpr const char* kKind = "sink";
+
+  BasicSinkStep(Stage* stage, StageContext& ctx, StageMetrics* metrics)
+      : stage_(stage),
+        ctx_(ctx),
+        metrics_(metrics),
+        sampler_(SamplingFor(metrics)),
+        stage_name_(stage->name()) {}
+
+  // Uniform constructor for generic task code; sinks have no outputs.
+  BasicSinkStep(Stage* stage, StageContext& ctx, const QueueList&, StageMetrics* metrics)
+      : BasicSinkStep(stage, ctx, metrics) {}
+
+  BasicSinkStep(const BasicSinkStep&) = delete;
+  BasicSinkStep& operator=(const BasicSinkStep&) = delete;
+
+  const std::string& name() const noexcept {
+    return stage_name_;
+  }
+
+  OutputSet* outputs() noexcept {
+    return nullptr;
+  }
+
+  StepResult Process(const QueueRuntime& input, const Payload& payload) {
+    const bool sampled = sampler_.Sample();
+    RecordDequeue(metrics_, input, payload, sampled);
+
+    if (!ValidateInputSchema(input, payload, stage_name_.c_str())) {
+      if (metrics_) {
+        metrics_->RecordStageError(stage_name_.c_str());
+      }
+      return StepResult::kContinue;
+    }
+
+    // Also the dequeue time of the queue-wait span.
+    const uint64_t start_ns = sampled ? now_ns() : 0;
+
+#if FLOWPIPE_ENABLE_OTEL
+    opentelemetry::nostd::shared_ptr<opentelemetry::trace::Span> span;
+    std::unique_ptr<opentelemetry::trace::Scope> scope;
+
+    if (sampled) {
+      auto parent_ctx = QueueWaitSpan(input, payload.meta, start_ns);
+      if (StageSpansEnabled()) {
+        const auto& tracer = GetTracer();
+        opentelemetry::trace::StartSpanOptions opts;
+        if (parent_ctx.IsValid()) {
+          opts.parent = parent_ctx;
+        }
+
+        span = tracer->StartSpan(stage_name_, opts);
+        scope = std::make_unique<opentelemetry::trace::Scope>(tracer->WithActiveSpan(span));
+      }
+    }
+#endif
+
+    try {
+      stage_->consume(ctx_, payload);
+    } catch (const std::exception& ex) {
+      FP_LOG_ERROR_FMT("sink stage '{}' threw exception: {}", stage_name_, ex.what());
+      if (metrics_) {
+        metrics_->RecordStageError(stage_name_.c_str());
+      }
+      ctx_.request_stop();
+#if FLOWPIPE_ENABLE_OTEL
+      if (span) {
+        span->End();
+      }
+#endif
+      return StepResult::kFailed;
+    } catch (...) {
+      FP_LOG_ERROR_FMT("sink stage '{}' threw unknown exception", stage_name_);
+      if (metrics_) {
+        metrics_->RecordStageError(stage_name_.c_str());
+      }
+      ctx_.request_stop();
+#if FLOWPIPE_ENABLE_OTEL
+      if (span) {
+        span->End();
+      }
+#endif
+      return StepResult::kFailed;
+    }
+    const uint64_t end_ns = sampled ? now_ns() : 0;
+
+#if FLOWPIPE_ENABLE_OTEL
+    if (span) {
+      span->End();
+    }
+#endif
+
+    RecordProcessed(metrics_, stage_name_, sampled, start_ns, end_ns);
+    if (sampled) {
+      RecordEndToEnd(metrics_, stage_name_, payload.meta, end_ns);
+#if FLOWPIPE_ENABLE_OTEL
+      RecordSpan(stage_name_, payload.meta, end_ns);
+#endif
+    }
+    return StepResult::kContinue;
+  }
+
+ private:
+  Stage* stage_;
+  StageContext& ctx_;
+  StageMetrics* metrics_;
+  RecordSampler sampler_;
+  const std::string stage_name_;
+};
+
+using SinkStep = BasicSinkStep<ISinkStage>;
+
+// ------------------------------------------------------------
+// Timer hooks
+// ------------------------------------------------------------
+// Schedules IStageTimers callbacks for one worker. The input loop blocks no
+// later than deadline() and calls Fire() whenever it wakes up.
+class StageTimers {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  StageTimers(IStage* stage, const TimerOptions& options, StageContext& ctx,
+              StageMetrics* metrics, const std::string& stage_name)
+      : options_(options), ctx_(ctx), metrics_(metrics), stage_name_(stage_name) {
+    if (options_.tick.count() <= 0 && options_.idle.count() <= 0) {
+      return;
+    }
+    hooks_ = dynamic_cast<IStageTimers*>(stage);
+    if (!hooks_) {
+      FP_LOG_WARN_FMT("stage '{}' sets tick_ms/idle_ms but does not implement IStageTimers",
+                      stage_name_);
+      return;
+    }
+    next_tick_ = Clock::now() + options_.tick;
+  }
+
+  bool enabled() const noexcept {
+    return hooks_ != nullptr;
+  }
+
+  // Latest time the worker may block before a hook is due.
+  Clock::time_point deadline() const noexcept {
+    auto next = Clock::time_point::max();
+    if (options_.tick.count() > 0) {
+      next = std::min(next, next_tick_);
+    }
+    if (idle_armed_) {
+      next = std::min(next, idle_at_);
+    }
+    return next;
+  }
+
+  // A payload was handled; restarts the idle period.
+  void Activity(Clock::time_point now) noexcept {
+    if (options_.idle.count() > 0) {
+      idle_at_ = now + options_.idle;
+      idle_armed_ = true;
+    }
+  }
+
+  // Runs every hook that is due. Returns false if one threw; global stop is
+  // already requested.
+  bool Fire(Clock::time_point now) {
+    if (options_.tick.count() > 0 && now >= next_tick_) {
+      // Missed ticks are skipped rather than replayed back to back.
+      next_tick_ += options_.tick;
+      if (next_tick_ <= now) {
+        next_tick_ = now + options_.tick;
+      }
+      if (!Invoke("on_tick", [this] { hooks_->on_tick(ctx_); })) {
+        return false;
+      }
+    }
+    if (idle_armed_ && now >= idle_at_) {
+      idle_armed_ = false;
+      if (!Invoke("on_idle", [this] { hooks_->on_idle(ctx_); })) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+ private:
+  template <typename Fn>
+  bool Invoke(const char* hook, Fn&& fn) {
+    try {
+      fn();
+      return true;
+    } catch (const std::exception& ex) {
+      FP_LOG_ERROR_FMT("stage '{}' {} threw exception: {}", stage_name_, hook, ex.what());
+    } catch (...) {
+      FP_LOG_ERROR_FMT("stage '{}' {} threw unknown exception", stage_name_, hook);
+    }
+    if (metrics_) {
+      metrics_->RecordStageError(stage_name_.c_str());
+    }
+    ctx_.request_stop();
+    return false;
+  }
+
+  const TimerOptions options_;
+  StageContext& ctx_;
+  StageMetrics* metrics_;
+  const std::string stage_name_;
+  IStageTimers* hooks_ = nullptr;
+  Clock::time_point next_tick_{};
+  Clock::time_point idle_at_{};
+  bool idle_armed_ = false;
+};
+
+// Blocking pop that wakes up in time for the next timer hook. Returns
+// nullopt on timeout too; callers tell it apart with stop/Drained().
+inline std::optional<Payload> PopOrTimeout(InputSet& in, const StopToken& stop,
+                                           QueueRuntime*& from, const StageTimers& timers) {
+  if (!timers.enabled() || timers.deadline() == StageTimers::Clock::time_point::max()) {
+    return in.Pop(stop, from);
+  }
+  return in.PopUntil(stop, from, timers.deadline());
+}
+
+// Threaded consumer loop: pop from the inputs until they drain, stop is
+// requested, or the step reports that it is done. A set `retire` flag only
+// ends the loop between payloads; pushes keep the flow-wide stop token.
+template <typename Step>
+void RunInputLoop(Step& step, const QueueList& inputs, StageContext& ctx, StageTimers& timers,
+                  const std::atomic<bool>* retire = nullptr) {
+  FP_LOG_DEBUG_FMT("{} stage '{}' runner started", Step::kKind, step.name());
+
+  InputSet in(inputs);
+  const StopToken stop = ctx.stop.with_local(retire);
+
+  while (!stop.stop_requested()) {
+    QueueRuntime* input = nullptr;
+    auto item = PopOrTimeout(in, stop, input, timers);
+    if (!item.has_value() && timers.enabled() && !stop.stop_requested() && !in.Drained()) {
+      if (!timers.Fire(StageTimers::Clock::now())) {
+        in.CloseAll();
+        break;
+      }
+      continue;
+    }
+    if (!item.has_value()) {
+      if (retire && retire->load(std::memory_order_acquire)) {
+        FP_LOG_DEBUG_FMT("{} stage '{}' worker retired", Step::kKind, step.name());
+      } else if (ctx.stop.stop_requested()) {
+        FP_LOG_DEBUG_FMT("{} stage '{}' stop requested", Step::kKind, step.name());
+      } else {
+        FP_LOG_DEBUG_FMT("{} stage '{}' input queue closed", Step::kKind, step.name());
+      }
+      break;
+    }
+
+    const StepResult result = step.Process(*input, *item);
+    if (result == StepResult::kFailed) {
+      in.CloseAll();  // wake peer workers blocked on pop()
+      break;
+    }
+    if (result == StepResult::kOutputDone) {
+      FP_LOG_DEBUG_FMT("{} stage '{}' output queue closed or stop requested", Step::kKind,
+                       step.name());
+      break;
+    }
+
+    if (timers.enabled()) {
+      const auto now = StageTimers::Clock::now();
+      timers.Activity(now);
+      if (!timers.Fire(now)) {
+        in.CloseAll();
+        break;
+      }
+    }
+  }
+
+  FP_LOG_DEBUG_FMT("{} stage '{}' runner exiting", Step::kKind, step.name());
+}
+
+// Threaded source loop: produce until end-of-stream, stop, or every output
+// closes.
+template <typename Step>
+void RunSourceLoop(Step& step, StageContext& ctx) {
+  FP_LOG_DEBUG_FMT("source stage '{}' runner started", step.name());
+
+  while (!ctx.stop.stop_requested()) {
+    if (step.Produce() != StepResult::kContinue) {
+      break;
+    }
+  }
+
+  FP_LOG_DEBUG_FMT("source stage '{}' runner exiting", step.name());
+}
+
+}  // namespace flowpipe::detail
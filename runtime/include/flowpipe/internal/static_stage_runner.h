@@ -0,0 +1,57 @@
+#pragma once
+
+// Runners specialized on a statically linked stage class. Only stage sources
+// compiled into flow_runtime (FLOWPIPE_STATIC_STAGES) reach this header,
+// through plugin.h; it is not installed.
+
+#include <type_traits>
+
+#include "flowpipe/internal/stage_steps.h"
+#include "flowpipe/static_stage.h"
+
+namespace flowpipe {
+
+/**
+ * Dedicated-thread runner for `Stage`.
+ *
+ * Same behaviour and metrics as RunSourceStage/RunTransformStage/... but
+ * the step templates are instantiated on `Stage`; declare the class final
+ * so the compiler can devirtualize and inline the per-payload call.
+ */
+template <typename Stage>
+void RunStaticStage(IStage* base, StageContext& ctx, const QueueList& inputs,
+                    const QueueList& outputs, StageMetrics* metrics, const TimerOptions& options) {
+  auto* stage = static_cast<Stage*>(base);
+  if constexpr (std::is_base_of_v<ISourceStage, Stage>) {
+    detail::BasicSourceStep<Stage> step(stage, ctx, outputs, metrics);
+    detail::RunSourceLoop(step, ctx);
+  } else if constexpr (std::is_base_of_v<ITransformStage, Stage>) {
+    detail::BasicTransformStep<Stage> step(stage, ctx, outputs, metrics);
+    detail::StageTimers timers(stage, options, ctx, metrics, step.name());
+    detail::RunInputLoop(step, inputs, ctx, timers);
+  } else if constexpr (std::is_base_of_v<IFlatMapStage, Stage>) {
+    detail::BasicFlatMapStep<Stage> step(stage, ctx, outputs, metrics);
+    detail::StageTimers timers(stage, options, ctx, metrics, step.name());
+    detail::RunInputLoop(step, inputs, ctx, timers);
+  } else {
+    static_assert(std::is_base_of_v<ISinkStage, Stage>, "no static runner for this stage kind");
+    detail::BasicSinkStep<Stage> step(stage, ctx, metrics);
+    detail::StageTimers timers(stage, options, ctx, metrics, step.name());
+    detail::RunInputLoop(step, inputs, ctx, timers);
+  }
+}
+
+// Runner for `Stage`, or nullptr when its kind has no specialized loop
+// (batch and async stages keep the generic runners).
+template <typename Stage>
+constexpr StaticRunFn StaticRunnerFor() {
+  if constexpr (std::is_base_of_v<ISourceStage, Stage> ||
+                std::is_base_of_v<ITransformStage, Stage> ||
+                std::is_base_of_v<IFlatMapStage, Stage> || std::is_base_of_v<ISinkStage, Stage>) {
+    return &RunStaticStage<Stage>;
+  } else {
+    return nullptr;
+  }
+}
+
+}  // namespace flowpipe
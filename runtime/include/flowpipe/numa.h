@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace flowpipe {
+
+// NUMA nodes of this host (1 when unknown or not NUMA).
+uint32_t NumaNodeCount(const std::string& sysfs_node_root = "/sys/devices/system/node");
+
+// CPUs of a NUMA node, from sysfs. Empty when unknown.
+std::vector<uint32_t> NumaNodeCpus(uint32_t node,
+                                   const std::string& sysfs_node_root = "/sys/devices/system/node");
+
+// The node all `cpus` belong to; nullopt if they span nodes or are unknown.
+std::optional<uint32_t> NumaNodeOfCpus(const std::vector<uint32_t>& cpus);
+
+// Makes the calling thread prefer `node` for memory it faults in from now
+// on (set_mempolicy MPOL_PREFERRED). Falls back to other nodes when `node`
+// is full. Returns false if the kernel refused.
+bool PreferThreadMemoryNode(uint32_t node);
+
+/**
+ * Upstream memory resource whose pages live on one NUMA node.
+ *
+ * Every allocation is its own mmap() region bound with mbind(); wrap it in
+ * a pool resource so repeated small allocations reuse chunks. If binding
+ * fails the memory is still usable, just not node-local.
+ */
+class NumaMemoryResource final : public std::pmr::memory_resource {
+ public:
+  explicit NumaMemoryResource(uint32_t node) : node_(node) {}
+
+  uint32_t node() const noexcept {
+    return node_;
+  }
+
+ private:
+  void* do_allocate(size_t bytes, size_t alignment) override;
+  void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+  bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+  const uint32_t node_;
+};
+
+}  // namespace flowpipe
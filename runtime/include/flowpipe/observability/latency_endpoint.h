@@ -0,0 +1,58 @@
+#pragma once
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "flowpipe/observability/runtime_metrics.h"
+
+namespace flowpipe::observability {
+
+// ------------------------------------------------------------
+// Local latency snapshots
+// ------------------------------------------------------------
+// Quantiles of the runtime-side histograms (stage latency, queue dwell and
+// end-to-end latency), read straight from RuntimeMetrics without going
+// through an exporter. Used by the histogram socket and the SIGUSR1 dump.
+
+// One line per non-empty histogram:
+//   <kind> <label>=<value>... count=N mean=N p50=N p90=N p99=N p999=N max=N
+// with kind one of stage_latency, queue_dwell, end_to_end; values in ns.
+std::string FormatLatencyReport(const std::vector<StageTotals>& stages,
+                                const std::vector<QueueTotals>& queues);
+
+// FormatLatencyReport() over the current RuntimeMetrics totals.
+std::string LatencyReport();
+
+/**
+ * Serves LatencyReport() on a Unix stream socket.
+ *
+ * Every connection receives one snapshot and is closed, e.g.
+ * `socat - UNIX-CONNECT:<path>`. Reports are built on the endpoint's own
+ * thread from relaxed reads of the shards; workers never wait on it.
+ */
+class LatencyEndpoint {
+ public:
+  LatencyEndpoint() = default;
+  ~LatencyEndpoint();
+
+  LatencyEndpoint(const LatencyEndpoint&) = delete;
+  LatencyEndpoint& operator=(const LatencyEndpoint&) = delete;
+
+  // Binds `path` (replacing a stale socket file) and starts serving.
+  // Returns false, after logging why, if the socket cannot be set up.
+  bool Start(const std::string& path);
+
+  // Stops serving and removes the socket file. Idempotent.
+  void Stop();
+
+ private:
+  void Serve();
+
+  std::string path_;
+  int listen_fd_ = -1;
+  int wake_pipe_[2] = {-1, -1};
+  std::thread thread_;
+};
+
+}  // namespace flowpipe::observability
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+#include "flowpipe/observability/logging.h"
+
+namespace flowpipe::observability {
+
+// One log call, as queued for the drain thread. Messages up to kInlineBytes
+// are stored in the record itself; longer ones are copied to the heap.
+struct LogRecord {
+  static constexpr size_t kInlineBytes = 200;
+
+  std::chrono::system_clock::time_point time;
+  const char* file = nullptr;
+  int line = 0;
+  LogLevel level = LogLevel::Info;
+  uint32_t size = 0;
+  std::unique_ptr<char[]> overflow;
+  char inline_text[kInlineBytes];
+
+  std::string_view text() const noexcept {
+    return {overflow ? overflow.get() : inline_text, size};
+  }
+};
+
+/**
+ * Bounded multi-producer, single-consumer ring of log records.
+ *
+ * Producers claim a slot with one CAS on the head and publish it with a
+ * release store of the slot's sequence number (Vyukov's bounded queue), so
+ * a log call never takes a lock or waits for the consumer. When every slot
+ * is taken the record is dropped and counted instead.
+ *
+ * Drain() must not run on two threads at once; callers serialize it.
+ */
+class LogRing {
+ public:
+  // `capacity` is rounded up to a power of two (at least 2).
+  explicit LogRing(size_t capacity);
+
+  LogRing(const LogRing&) = delete;
+  LogRing& operator=(const LogRing&) = delete;
+
+  // Queues a record. Returns false, counting the drop, when the ring is full.
+  bool TryPush(LogLevel level, std::string_view message, const char* file, int line,
+               std::chrono::system_clock::time_point time);
+
+  // Hands queued records to `sink` in order, oldest first, and frees their
+  // slots. Stops at the first slot a producer has claimed but not yet
+  // published. Returns the number of records handed out.
+  template <typename Sink>
+  size_t Drain(Sink&& sink) {
+    size_t drained = 0;
+    while (true) {
+      Slot& slot = slots_[tail_ & mask_];
+      if (slot.seq.load(std::memory_order_acquire) != tail_ + 1) {
+        return drained;
+      }
+      sink(static_cast<const LogRecord&>(slot.record));
+      slot.record.overflow.reset();
+      slot.seq.store(tail_ + mask_ + 1, std::memory_order_release);
+      ++tail_;
+      ++drained;
+    }
+  }
+
+  size_t capacity() const noexcept {
+    return mask_ + 1;
+  }
+
+  // Records dropped because the ring was full, since construction.
+  uint64_t dropped() const noexcept {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  struct alignas(64) Slot {
+    std::atomic<uint64_t> seq{0};
+    LogRecord record;
+  };
+
+  size_t mask_;
+  std::unique_ptr<Slot[]> slots_;
+  alignas(64) std::atomic<uint64_t> head_{0};
+  alignas(64) uint64_t tail_ = 0;
+  std::atomic<uint64_t> dropped_{0};
+};
+
+}  // namespace flowpipe::observability
@@ -1,7 +1,8 @@
 #pragma once
 
+#include <atomic>
 #include <cstdint>
-#include <string>
+#include <string_view>
 
 namespace flowpipe::observability {
 
@@ -16,13 +17,34 @@ enum class LogLevel : uint8_t {
   Fatal = 4,
 };
 
+namespace detail {
+// Lowest level that is emitted. Owned by the runtime.
+extern std::atomic<uint8_t> g_min_log_level;
+}  // namespace detail
+
+// ------------------------------------------------------------
+// Level check
+//
+// One relaxed load. The FP_LOG_* macros check it before evaluating their
+// message, so disabled levels cost no formatting or allocation.
+// ------------------------------------------------------------
+inline bool LogEnabled(LogLevel level) noexcept {
+  return static_cast<uint8_t>(level) >=
+         detail::g_min_log_level.load(std::memory_order_relaxed);
+}
+
+// Sets the lowest emitted level (default: Info). Implemented by the runtime.
+void SetLogLevel(LogLevel min_level) noexcept;
+
 // ------------------------------------------------------------
 // Emit a log record
 //
 // Implemented by the runtime.
-// Safe to call from plugins and stages.
+// Safe to call from plugins and stages. Once the runtime has started async
+// logging, the message is copied into a ring and written by a background
+// thread; it may be dropped (and counted) if the ring is full.
 // ------------------------------------------------------------
-void Log(LogLevel level, const std::string& message, const char* file = nullptr, int line = 0);
+void Log(LogLevel level, std::string_view message, const char* file = nullptr, int line = 0);
 
 }  // namespace flowpipe::observability
 
@@ -35,26 +57,24 @@ void Log(LogLevel level, const std::string& message, const char* file = nullptr,
 //  - source-location aware
 //  - OTEL-agnostic
 //  - spdlog-agnostic
+//  - free when the level is disabled (`msg` is not evaluated)
 //
 
+#define FP_LOG_AT_LEVEL_(level, msg)                                         \
+  do {                                                                       \
+    if (::flowpipe::observability::LogEnabled(level)) {                      \
+      ::flowpipe::observability::Log((level), (msg), __FILE__, __LINE__);    \
+    }                                                                        \
+  } while (0)
+
 // ---- plain string logging
 
-#define FP_LOG_DEBUG(msg)                                                                     \
-  ::flowpipe::observability::Log(::flowpipe::observability::LogLevel::Debug, (msg), __FILE__, \
-                                 __LINE__)
+#define FP_LOG_DEBUG(msg) FP_LOG_AT_LEVEL_(::flowpipe::observability::LogLevel::Debug, msg)
 
-#define FP_LOG_INFO(msg)                                                                     \
-  ::flowpipe::observability::Log(::flowpipe::observability::LogLevel::Info, (msg), __FILE__, \
-                                 __LINE__)
+#define FP_LOG_INFO(msg) FP_LOG_AT_LEVEL_(::flowpipe::observability::LogLevel::Info, msg)
 
-#define FP_LOG_WARN(msg)                                                                     \
-  ::flowpipe::observability::Log(::flowpipe::observability::LogLevel::Warn, (msg), __FILE__, \
-                                 __LINE__)
+#define FP_LOG_WARN(msg) FP_LOG_AT_LEVEL_(::flowpipe::observability::LogLevel::Warn, msg)
 
-#define FP_LOG_ERROR(msg)                                                                     \
-  ::flowpipe::observability::Log(::flowpipe::observability::LogLevel::Error, (msg), __FILE__, \
-                                 __LINE__)
+#define FP_LOG_ERROR(msg) FP_LOG_AT_LEVEL_(::flowpipe::observability::LogLevel::Error, msg)
 
-#define FP_LOG_FATAL(msg)                                                                     \
-  ::flowpipe::observability::Log(::flowpipe::observability::LogLevel::Fatal, (msg), __FILE__, \
-                                 __LINE__)
+#define FP_LOG_FATAL(msg) FP_LOG_AT_LEVEL_(::flowpipe::observability::LogLevel::Fatal, msg)
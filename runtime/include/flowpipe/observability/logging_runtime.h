@@ -2,7 +2,8 @@
 
 #include <fmt/core.h>
 
-#include <utility>
+#include <cstddef>
+#include <cstdint>
 
 #include "defaults.h"
 #include "flowpipe/observability/logging.h"
@@ -17,17 +18,39 @@ void InitLogging(const flowpipe::v1::ObservabilityConfig* cfg, const GlobalDefau
                  bool debug);
 
 // ------------------------------------------------------------
-// Runtime-only lazy formatting helper
+// Async logging
 //
-// Owns formatting cost and policy.
+// After StartAsyncLogging(), Log() copies records into a lock-free ring of
+// `ring_size` slots and a background thread writes them to spdlog and OTEL.
+// Records logged while the ring is full are dropped; the drain thread
+// reports how many. The ring is allocated by the first call and reused by
+// later ones.
+//
+// FlushLogs() writes everything queued so far on the calling thread.
+// StopAsyncLogging() flushes, joins the drain thread and makes Log()
+// synchronous again. Both are safe to call when async logging is off.
+// ------------------------------------------------------------
+void StartAsyncLogging(size_t ring_size);
+void FlushLogs();
+void StopAsyncLogging();
+
+// Records dropped because the async ring was full, since process start.
+uint64_t DroppedLogRecords() noexcept;
+
+// ------------------------------------------------------------
+// Runtime-only formatting helpers
+//
+// VLogFmt formats into a stack buffer (no allocation for typical messages)
+// and passes the result to Log(). LogFmt is the type-safe front end; the
+// macros below only call it when the level is enabled.
 // ------------------------------------------------------------
+void VLogFmt(LogLevel level, const char* file, int line, fmt::string_view fmt_str,
+             fmt::format_args args);
+
 template <typename... Args>
 inline void LogFmt(LogLevel level, const char* file, int line, fmt::format_string<Args...> fmt_str,
                    Args&&... args) {
-  // Optional future hook:
-  // if (!IsLogEnabled(level)) return;
-
-  Log(level, fmt::format(fmt_str, std::forward<Args>(args)...), file, line);
+  VLogFmt(level, file, line, fmt_str, fmt::make_format_args(args...));
 }
 
 }  // namespace flowpipe::observability
@@ -35,23 +58,28 @@ inline void LogFmt(LogLevel level, const char* file, int line, fmt::format_strin
 // ============================================================
 // Runtime-only fmt logging macros
 // ============================================================
+//
+// Arguments are not evaluated when the level is disabled.
+//
+
+#define FP_LOG_AT_LEVEL_FMT_(level, fmt, ...)                                                    \
+  do {                                                                                           \
+    if (::flowpipe::observability::LogEnabled(level)) {                                          \
+      ::flowpipe::observability::LogFmt((level), __FILE__, __LINE__, fmt, ##__VA_ARGS__);        \
+    }                                                                                            \
+  } while (0)
 
-#define FP_LOG_DEBUG_FMT(fmt, ...)                                                        \
-  ::flowpipe::observability::LogFmt(::flowpipe::observability::LogLevel::Debug, __FILE__, \
-                                    __LINE__, fmt, ##__VA_ARGS__)
+#define FP_LOG_DEBUG_FMT(fmt, ...) \
+  FP_LOG_AT_LEVEL_FMT_(::flowpipe::observability::LogLevel::Debug, fmt, ##__VA_ARGS__)
 
-#define FP_LOG_INFO_FMT(fmt, ...)                                                                  \
-  ::flowpipe::observability::LogFmt(::flowpipe::observability::LogLevel::Info, __FILE__, __LINE__, \
-                                    fmt, ##__VA_ARGS__)
+#define FP_LOG_INFO_FMT(fmt, ...) \
+  FP_LOG_AT_LEVEL_FMT_(::flowpipe::observability::LogLevel::Info, fmt, ##__VA_ARGS__)
 
-#define FP_LOG_WARN_FMT(fmt, ...)                                                                  \
-  ::flowpipe::observability::LogFmt(::flowpipe::observability::LogLevel::Warn, __FILE__, __LINE__, \
-                                    fmt, ##__VA_ARGS__)
+#define FP_LOG_WARN_FMT(fmt, ...) \
+  FP_LOG_AT_LEVEL_FMT_(::flowpipe::observability::LogLevel::Warn, fmt, ##__VA_ARGS__)
 
-#define FP_LOG_ERROR_FMT(fmt, ...)                                                        \
-  ::flowpipe::observability::LogFmt(::flowpipe::observability::LogLevel::Error, __FILE__, \
-                                    __LINE__, fmt, ##__VA_ARGS__)
+#define FP_LOG_ERROR_FMT(fmt, ...) \
+  FP_LOG_AT_LEVEL_FMT_(::flowpipe::observability::LogLevel::Error, fmt, ##__VA_ARGS__)
 
-#define FP_LOG_FATAL_FMT(fmt, ...)                                                        \
-  ::flowpipe::observability::LogFmt(::flowpipe::observability::LogLevel::Fatal, __FILE__, \
-                                    __LINE__, fmt, ##__VA_ARGS__)
+#define FP_LOG_FATAL_FMT(fmt, ...) \
+  FP_LOG_AT_LEVEL_FMT_(::flowpipe::observability::LogLevel::Fatal, fmt, ##__VA_ARGS__)
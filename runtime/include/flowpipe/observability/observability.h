@@ -11,6 +11,7 @@ namespace flowpipe::observability {
 //
 // - Initializes logging, tracing, and metrics based on the
 //   provided ObservabilityConfig.
+// - Switches FP_LOG_* to the async log ring (see StartAsyncLogging).
 // - Safe to call multiple times (idempotent).
 // - If OpenTelemetry is disabled at build time, this is a no-op.
 //
@@ -22,6 +23,7 @@ void InitFromProto(const flowpipe::v1::ObservabilityConfig* cfg);
 // Gracefully shuts down observability providers and exporters.
 //
 // Shutdown order:
+//   0. Async log ring (drained, then logging is synchronous again)
 //   1. Logs
 //   2. Traces
 //   3. Metrics
@@ -29,7 +31,7 @@ void InitFromProto(const flowpipe::v1::ObservabilityConfig* cfg);
 // - Flushes pending telemetry
 // - Stops background threads
 // - Safe to call multiple times
-// - No-op if OpenTelemetry is disabled
+// - Only drains the log ring if OpenTelemetry is disabled
 //
 void ShutdownObservability();
 
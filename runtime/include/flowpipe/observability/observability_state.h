@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <vector>
 
@@ -10,6 +11,7 @@
 #include <opentelemetry/sdk/logs/logger_provider.h>
 #include <opentelemetry/sdk/metrics/meter_provider.h>
 #include <opentelemetry/sdk/trace/tracer_provider.h>
+#include <opentelemetry/trace/tracer.h>
 #include <opentelemetry/trace/tracer_provider.h>
 
 #endif  // FLOWPIPE_ENABLE_OTEL
@@ -31,6 +33,10 @@ struct OtelState {
   std::vector<opentelemetry::nostd::shared_ptr<opentelemetry::metrics::ObservableInstrument>>
       jemalloc_instruments;
 
+  // Observable views over RuntimeMetrics (stage/queue counters and buckets)
+  std::vector<opentelemetry::nostd::shared_ptr<opentelemetry::metrics::ObservableInstrument>>
+      runtime_instruments;
+
   // ----------------------------------------------------------
   // Metrics runtime flags (cached from MetricsConfig)
   // ----------------------------------------------------------
@@ -43,11 +49,19 @@ struct OtelState {
   bool jemalloc_metrics_enabled = true;
 
   // ----------------------------------------------------------
-  // Tracing runtime flags (for symmetry / future use)
+  // Tracing runtime state (cached from TracingConfig)
   // ----------------------------------------------------------
   bool stage_spans_enabled = false;
   bool queue_spans_enabled = false;
   bool record_spans_enabled = false;
+
+  // Set whenever a span flag is; stages use it instead of asking the
+  // provider per record.
+  opentelemetry::nostd::shared_ptr<opentelemetry::trace::Tracer> tracer;
+
+  // system_clock minus CLOCK_MONOTONIC, in ns, taken at InitTracing().
+  // Converts runtime timestamps into span start times.
+  int64_t system_offset_ns = 0;
 #endif
 };
 
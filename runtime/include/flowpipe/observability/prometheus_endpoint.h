@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "flowpipe/observability/runtime_metrics.h"
+
+namespace flowpipe::observability {
+
+// ------------------------------------------------------------
+// Prometheus scrape endpoint
+// ------------------------------------------------------------
+// Serves the RuntimeMetrics totals (and jemalloc stats) in the Prometheus
+// text exposition format, for deployments that scrape the runtime instead
+// of running an OTLP collector. Names follow what a collector would publish
+// for the OTEL instruments: dots become underscores and counters get a
+// `_total` suffix, e.g. flowpipe.stage.process.count ->
+// flowpipe_stage_process_count_total.
+
+// Stage and queue families for the given totals. Latency, dwell and
+// end-to-end histograms are included when `histograms` is set, with the
+// power-of-two `le` buckets of the OTEL export.
+std::string FormatPrometheusMetrics(const std::vector<StageTotals>& stages,
+                                    const std::vector<QueueTotals>& queues, bool histograms);
+
+// FormatPrometheusMetrics() over the current RuntimeMetrics totals, limited
+// to what RuntimeMetrics records, followed by the jemalloc gauges when
+// `jemalloc` is set and the runtime is built against jemalloc's headers.
+std::string PrometheusScrape(bool jemalloc);
+
+/**
+ * Minimal HTTP/1.1 server answering `GET /metrics` on 127.0.0.1.
+ *
+ * One thread blocks in poll() until a scraper connects; nothing is computed
+ * between scrapes. Each connection gets one response and is closed.
+ */
+class PrometheusEndpoint {
+ public:
+  PrometheusEndpoint() = default;
+  ~PrometheusEndpoint();
+
+  PrometheusEndpoint(const PrometheusEndpoint&) = delete;
+  PrometheusEndpoint& operator=(const PrometheusEndpoint&) = delete;
+
+  // Listens on 127.0.0.1:`port` (0 picks a free port, see port()) and
+  // starts serving. Returns false, after logging why, if the port cannot be
+  // bound.
+  bool Start(uint16_t port, bool jemalloc);
+
+  // Stops serving and closes the port. Idempotent.
+  void Stop();
+
+  // Port being served, 0 when stopped.
+  uint16_t port() const noexcept {
+    return port_;
+  }
+
+ private:
+  void Serve();
+  void Respond(int client);
+
+  bool jemalloc_ = false;
+  uint16_t port_ = 0;
+  int listen_fd_ = -1;
+  int wake_pipe_[2] = {-1, -1};
+  std::thread thread_;
+};
+
+}  // namespace flowpipe::observability
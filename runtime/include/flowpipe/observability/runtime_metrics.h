@@ -0,0 +1,298 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace flowpipe::observability {
+
+// ------------------------------------------------------------
+// Runtime-side metric storage
+// ------------------------------------------------------------
+// Hot-path stage and queue metrics are kept in per-thread shards instead of
+// going through the OTEL API on every record. Each thread owns one shard per
+// stage/queue series, padded to its own cache line and written without
+// locked instructions. Exporters fold the shards when they collect (see
+// InitMetrics for the OTEL observable callbacks). When a thread exits its
+// shards go back to their series, counts included, for the next thread that
+// records there, so short-lived workers do not grow the shard lists.
+
+inline constexpr size_t kCacheLineSize = 64;
+
+// Attribute set of one series, e.g. {{"flow", "etl"}, {"stage", "parse"}}.
+// Computed once when the series is registered and reused by every export.
+using MetricLabels = std::vector<std::pair<std::string, std::string>>;
+
+// Index of a registered series; stable for the life of the process.
+using SeriesId = uint32_t;
+
+// Counter with a single writer thread. add() is a relaxed load + store, not
+// an atomic read-modify-write; other threads read a recent value.
+class LocalCounter {
+ public:
+  void add(uint64_t n = 1) noexcept {
+    value_.store(value_.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+  }
+
+  uint64_t value() const noexcept {
+    return value_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  std::atomic<uint64_t> value_{0};
+};
+
+// Single-writer log-linear (HDR-style) histogram. Values below
+// 2^(kSubBucketBits + 1) get a bucket each; above that, every power-of-two
+// range is split into 2^kSubBucketBits equal sub-buckets, so a bucket spans
+// at most 1/16 of the values it holds. Recording touches one bucket and the
+// sum, as with a plain power-of-two histogram.
+class LocalHistogram {
+ public:
+  static constexpr unsigned kSubBucketBits = 4;
+  static constexpr size_t kSubBuckets = size_t{1} << kSubBucketBits;
+  static constexpr size_t kBuckets = (64 - kSubBucketBits + 1) * kSubBuckets;
+
+  void record(uint64_t value) noexcept {
+    buckets_[BucketOf(value)].add();
+    sum_.add(value);
+  }
+
+  static size_t BucketOf(uint64_t value) noexcept {
+    const auto width = static_cast<unsigned>(std::bit_width(value));
+    if (width <= kSubBucketBits + 1) {
+      return static_cast<size_t>(value);
+    }
+    const unsigned shift = width - kSubBucketBits - 1;
+    return shift * kSubBuckets + static_cast<size_t>(value >> shift);
+  }
+
+  // Smallest value bucket `index` holds.
+  static uint64_t LowerBound(size_t index) noexcept {
+    if (index < 2 * kSubBuckets) {
+      return index;
+    }
+    const size_t shift = index / kSubBuckets - 1;
+    return static_cast<uint64_t>(index % kSubBuckets + kSubBuckets) << shift;
+  }
+
+  // Largest value bucket `index` holds.
+  static uint64_t UpperBound(size_t index) noexcept {
+    return index + 1 >= kBuckets ? UINT64_MAX : LowerBound(index + 1) - 1;
+  }
+
+  uint64_t bucket(size_t index) const noexcept {
+    return buckets_[index].value();
+  }
+
+  uint64_t sum() const noexcept {
+    return sum_.value();
+  }
+
+ private:
+  std::array<LocalCounter, kBuckets> buckets_;
+  LocalCounter sum_;
+};
+
+// Sum of several LocalHistograms at one point in time.
+struct HistogramSnapshot {
+  std::array<uint64_t, LocalHistogram::kBuckets> buckets{};
+  uint64_t count = 0;
+  uint64_t sum = 0;
+
+  void Add(const LocalHistogram& histogram) noexcept;
+
+  // Upper bound of the bucket holding the q-th quantile (0 <= q <= 1), so
+  // the result is never below the true value. 0 when empty.
+  uint64_t ValueAtQuantile(double q) const noexcept;
+
+  // Upper bound of the highest populated bucket. 0 when empty.
+  uint64_t Max() const noexcept;
+
+  // Octaves of the `le` ladder below: 2^4 - 1 = 15 ns up to 2^36 - 1 ns
+  // (about 68.7 s). Larger values only reach the +Inf bucket.
+  static constexpr unsigned kFirstOctave = 4;
+  static constexpr unsigned kLastOctave = 36;
+
+  // Buckets merged per power of two as cumulative (le, count) pairs, with
+  // le = 2^n - 1 for every n in [kFirstOctave, kLastOctave], empty buckets
+  // included. This is the classic-histogram shape the exporters publish;
+  // every series and every scrape gets the same ladder, so buckets can be
+  // summed by `le` across series and over time.
+  std::vector<std::pair<uint64_t, uint64_t>> CumulativeOctaves() const;
+};
+
+// One thread's share of a stage series.
+struct alignas(kCacheLineSize) StageShard {
+  LocalCounter processed;
+  LocalCounter errors;
+  LocalHistogram latency;
+  LocalHistogram end_to_end;  // sinks only: time since the record entered the flow
+
+  // Autoscaled stages only. Workers are started by the supervisor and
+  // stopped by the exiting worker, so each direction has its own counter.
+  LocalCounter workers_started;
+  LocalCounter workers_stopped;
+  LocalCounter scale_ups;
+  LocalCounter scale_downs;
+};
+
+// One thread's share of a queue series.
+struct alignas(kCacheLineSize) QueueShard {
+  LocalCounter enqueued;
+  LocalCounter dequeued;
+  LocalCounter cross_node;
+  LocalCounter cross_node_bytes;
+  LocalHistogram dwell;
+};
+
+// A CPU that automatic placement assigned to a stage.
+struct CpuAssignment {
+  uint32_t cpu = 0;
+  uint32_t l3 = 0;
+  uint32_t numa_node = 0;
+
+  bool operator==(const CpuAssignment&) const = default;
+};
+
+struct StageTotals {
+  MetricLabels labels;
+  uint64_t processed = 0;
+  uint64_t errors = 0;
+  HistogramSnapshot latency;
+  HistogramSnapshot end_to_end;
+  uint64_t workers_started = 0;
+  uint64_t workers_stopped = 0;
+  uint64_t scale_ups = 0;
+  uint64_t scale_downs = 0;
+  std::vector<CpuAssignment> cpus;
+
+  // Whether the autoscaler ran this stage; only then are the worker and
+  // scaling series published.
+  bool autoscaled() const noexcept {
+    return workers_started > 0;
+  }
+  // Workers running at collection time.
+  uint64_t workers() const noexcept {
+    return workers_started >= workers_stopped ? workers_started - workers_stopped : 0;
+  }
+};
+
+struct QueueTotals {
+  MetricLabels labels;
+  uint64_t enqueued = 0;
+  uint64_t dequeued = 0;
+  uint64_t cross_node = 0;
+  uint64_t cross_node_bytes = 0;
+  HistogramSnapshot dwell;
+};
+
+/**
+ * Process-wide registry of sharded stage and queue series.
+ *
+ * The runtime registers one series per wired stage and queue and records
+ * through the returned SeriesId; name-based lookups create a series labelled
+ * only with the stage or queue name. Series live for the rest of the process,
+ * so shard references handed out stay valid and totals only grow. Recording
+ * is off until an exporter calls Configure().
+ */
+class RuntimeMetrics {
+ public:
+  static RuntimeMetrics& Get();
+
+  RuntimeMetrics(const RuntimeMetrics&) = delete;
+  RuntimeMetrics& operator=(const RuntimeMetrics&) = delete;
+
+  // Set before workers start; read without synchronization afterwards.
+  void Configure(bool stages, bool queues, bool histograms) noexcept {
+    stages_enabled_ = stages;
+    queues_enabled_ = queues;
+    histograms_enabled_ = histograms;
+  }
+
+  bool stages_enabled() const noexcept {
+    return stages_enabled_;
+  }
+  bool queues_enabled() const noexcept {
+    return queues_enabled_;
+  }
+  bool histograms_enabled() const noexcept {
+    return histograms_enabled_;
+  }
+
+  // Returns the series with exactly these labels, registering it if needed.
+  SeriesId RegisterStage(MetricLabels labels);
+  SeriesId RegisterQueue(MetricLabels labels);
+
+  // The calling thread's shard of a series. The first call per thread and
+  // series takes a lock; later ones index a thread-local table.
+  StageShard& stage(SeriesId id);
+  QueueShard& queue(SeriesId id);
+
+  // Same, for the series labelled {"stage", name} / {"queue", name}. Adds a
+  // thread-local name lookup in front of the id path.
+  StageShard& stage(const char* name);
+  QueueShard& queue(const std::string& name);
+
+  // Records that placement gave stage series `id` this CPU; repeats of the
+  // same assignment are ignored. Not for hot paths: takes the lock.
+  void AddStageCpu(SeriesId id, const CpuAssignment& cpu);
+
+  // Sums every shard, one entry per series in creation order.
+  std::vector<StageTotals> CollectStages() const;
+  std::vector<QueueTotals> CollectQueues() const;
+
+  // Shards allocated so far across all series; at most one per series and
+  // concurrently recording thread.
+  size_t shard_count() const;
+
+ private:
+  RuntimeMetrics() = default;
+
+  template <typename Shard>
+  struct Series {
+    MetricLabels labels;
+    std::deque<Shard> shards;  // stable addresses; appended under mutex_
+    std::vector<Shard*> free;  // released by exited threads, under mutex_
+  };
+
+  template <typename Shard>
+  struct SeriesSet {
+    std::map<MetricLabels, SeriesId> index;
+    std::deque<Series<Shard>> series;
+  };
+
+  // A thread's shards by SeriesId; the destructor releases them at thread exit.
+  template <typename Shard>
+  struct ThreadShards {
+    SeriesSet<Shard>* set = nullptr;
+    std::vector<Shard*> bound;
+
+    ~ThreadShards();
+  };
+
+  template <typename Shard>
+  SeriesId Register(SeriesSet<Shard>& set, MetricLabels labels);
+
+  template <typename Shard>
+  Shard& BindShard(ThreadShards<Shard>& owned, SeriesId id);
+
+  bool stages_enabled_ = false;
+  bool queues_enabled_ = false;
+  bool histograms_enabled_ = false;
+
+  mutable std::mutex mutex_;
+  SeriesSet<StageShard> stages_;
+  SeriesSet<QueueShard> queues_;
+  std::map<SeriesId, std::vector<CpuAssignment>> stage_cpus_;
+};
+
+}  // namespace flowpipe::observability
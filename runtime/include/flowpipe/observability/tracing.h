@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+
 #include "defaults.h"
 #include "flowpipe/v1/observability.pb.h"
 
@@ -10,4 +12,18 @@ namespace flowpipe::observability {
 void InitTracing(const flowpipe::v1::ObservabilityConfig* cfg, const GlobalDefaults& global,
                  bool debug);
 
+// ------------------------------------------------------------
+// Span and trace ids
+//
+// Used by the runtime's tracer provider. Each thread runs its own splitmix64
+// sequence, seeded once from the process seed, so an id costs a few
+// multiplies: no lock, shared cache line or syscall per span.
+// ------------------------------------------------------------
+
+// Random, never zero.
+uint64_t NextSpanId() noexcept;
+
+// Fills `out` with a random trace id that is never all zeros.
+void NextTraceId(uint8_t (&out)[16]) noexcept;
+
 }  // namespace flowpipe::observability
@@ -33,10 +33,18 @@ struct PayloadMeta {
   // Monotonic enqueue timestamp (nanoseconds)
   uint64_t enqueue_ts_ns = 0;
 
+  // Monotonic time the record entered the flow (nanoseconds): its first
+  // enqueue, carried over to the records derived from it.
+  uint64_t origin_ts_ns = 0;
+
   // W3C trace identifiers (opaque bytes)
   uint8_t trace_id[trace_id_size]{};
   uint8_t span_id[span_id_size]{};
 
+  // span_id as of the record's first enqueue, carried over like
+  // origin_ts_ns; parents the span of the record's whole trip.
+  uint8_t origin_span_id[span_id_size]{};
+
   // Bit flags (sampled, error, future use)
   uint32_t flags = 0;
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "flowpipe/observability/logging.h"
 #include "flowpipe/stage.h"
 
 namespace flowpipe {
@@ -22,3 +23,50 @@ constexpr const char* FLOWPIPE_CREATE_STAGE_SYMBOL = "flowpipe_create_stage";
 constexpr const char* FLOWPIPE_DESTROY_STAGE_SYMBOL = "flowpipe_destroy_stage";
 
 }  // namespace flowpipe
+
+// ------------------------------------------------------------
+// Stage entry points
+// ------------------------------------------------------------
+// FLOWPIPE_STAGE_PLUGIN(noop_transform, NoopTransform) defines the factory
+// for a stage class, once per stage source file.
+//
+// Normally it exports the flowpipe_create_stage/flowpipe_destroy_stage
+// symbols of a dlopen() plugin. When the file is compiled into the runtime
+// binary (FLOWPIPE_STATIC_STAGES, see the top-level CMake option of the same
+// name) it registers the class under TYPE instead, together with a runner
+// specialized on it.
+#ifdef FLOWPIPE_STATIC_STAGES
+
+#include "flowpipe/internal/static_stage_runner.h"
+
+#define FLOWPIPE_STAGE_PLUGIN(TYPE, CLASS)                                                     \
+  namespace {                                                                                  \
+  ::flowpipe::IStage* flowpipe_static_create_##TYPE() {                                        \
+    FP_LOG_INFO("creating " #TYPE " stage");                                                   \
+    return new CLASS();                                                                        \
+  }                                                                                            \
+  void flowpipe_static_destroy_##TYPE(::flowpipe::IStage* stage) {                             \
+    FP_LOG_INFO("destroying " #TYPE " stage");                                                 \
+    delete stage;                                                                              \
+  }                                                                                            \
+  [[maybe_unused]] const bool flowpipe_static_registered_##TYPE =                              \
+      ::flowpipe::RegisterStaticStage({#TYPE, &flowpipe_static_create_##TYPE,                  \
+                                       &flowpipe_static_destroy_##TYPE,                        \
+                                       ::flowpipe::StaticRunnerFor<CLASS>()});                 \
+  }
+
+#else
+
+#define FLOWPIPE_STAGE_PLUGIN(TYPE, CLASS)                                                     \
+  extern "C" {                                                                                 \
+  FLOWPIPE_PLUGIN_API ::flowpipe::IStage* flowpipe_create_stage() {                            \
+    FP_LOG_INFO("creating " #TYPE " stage");                                                   \
+    return new CLASS();                                                                        \
+  }                                                                                            \
+  FLOWPIPE_PLUGIN_API void flowpipe_destroy_stage(::flowpipe::IStage* stage) {                 \
+    FP_LOG_INFO("destroying " #TYPE " stage");                                                 \
+    delete stage;                                                                              \
+  }                                                                                            \
+  }
+
+#endif  // FLOWPIPE_STATIC_STAGES
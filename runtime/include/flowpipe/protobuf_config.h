@@ -1,5 +1,6 @@
 #pragma once
 
+#include <google/protobuf/message.h>
 #include <google/protobuf/struct.pb.h>
 #include <google/protobuf/util/json_util.h>
 
@@ -7,6 +8,15 @@
 
 namespace flowpipe {
 
+// Fills `out` from `config` by walking the Struct with reflection, following
+// the proto3 JSON mapping (original or json_name keys, enums by name or
+// number, maps from nested Structs). Returns false with `error` set when a
+// key or value does not fit `out`, or when the target needs a mapping this
+// walker does not implement (bytes, Timestamp, Duration, FieldMask, Any);
+// `out` is then partially filled.
+bool StructToMessage(const google::protobuf::Struct& config, google::protobuf::Message* out,
+                     std::string* error = nullptr);
+
 template <typename Config>
 class ProtobufConfigParser {
  public:
@@ -19,6 +29,13 @@ class ProtobufConfigParser {
       return false;
     }
 
+    if (StructToMessage(config, out)) {
+      return true;
+    }
+
+    // Fallback: JSON round trip. Also covers the mappings StructToMessage
+    // leaves out and reports errors in the JSON parser's words.
+    out->Clear();
     std::string json;
     auto status = google::protobuf::util::MessageToJsonString(config, &json);
     if (!status.ok()) {
@@ -1,11 +1,34 @@
 #pragma once
 
+#include <chrono>
+#include <cstddef>
 #include <optional>
 
 #include "stop_token.h"
 
 namespace flowpipe {
 
+/**
+ * Receives a wake-up whenever an observed queue gains an item,
+ * frees space, or closes.
+ *
+ * notify() runs on the thread that changed the queue, possibly while the
+ * queue's internal lock is held: it must be cheap and must not call back
+ * into the queue.
+ */
+class QueueObserver {
+ public:
+  virtual ~QueueObserver() = default;
+  virtual void notify() noexcept = 0;
+};
+
+// Outcome of a non-blocking push.
+enum class TryPushResult {
+  kPushed,
+  kFull,
+  kClosed,
+};
+
 template <typename T>
 class IQueue {
  public:
@@ -14,6 +37,29 @@ class IQueue {
   virtual bool push(T item, const StopToken& stop) = 0;
   virtual std::optional<T> pop(const StopToken& stop) = 0;
   virtual void close() = 0;
+
+  // Like pop(), but also returns nullopt once `timeout` elapses. Check
+  // drained() to tell a timeout from a closed queue.
+  virtual std::optional<T> pop_for(std::chrono::nanoseconds timeout, const StopToken& stop) = 0;
+
+  // Non-blocking push. The item is moved from only when it was pushed.
+  virtual TryPushResult try_push(T& item) = 0;
+
+  // Non-blocking pop. Returns nullopt when the queue is currently empty.
+  virtual std::optional<T> try_pop() = 0;
+
+  // True once the queue is closed and every buffered item has been popped.
+  virtual bool drained() const = 0;
+
+  // Number of buffered items (a snapshot; used for occupancy sampling).
+  virtual std::size_t size() const = 0;
+
+  // Wakes every caller blocked in push()/pop() so it rechecks its stop token.
+  virtual void wake_all() = 0;
+
+  // Observers are not owned and must be removed before they are destroyed.
+  virtual void add_observer(QueueObserver* observer) = 0;
+  virtual void remove_observer(QueueObserver* observer) = 0;
 };
 
 }  // namespace flowpipe
@@ -1,7 +1,10 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
+#include <optional>
 #include <string>
+#include <vector>
 
 #include "flowpipe/payload.h"
 #include "flowpipe/queue.h"
@@ -21,6 +24,20 @@ struct QueueRuntime {
 
   // Optional schema identifier for payload validation.
   std::string schema_id;
+
+  // NUMA node of the queue storage, when bound.
+  std::optional<uint32_t> numa_node;
+
+  // Producers and consumers run on different NUMA nodes; every dequeue is
+  // counted as cross-node traffic.
+  bool cross_node = false;
+
+  // Metrics series resolved at wiring time (StageMetrics::BindQueue);
+  // UINT32_MAX records by queue name instead.
+  uint32_t metrics_id = UINT32_MAX;
 };
 
+// Queues a stage reads from or writes to, in StageSpec order.
+using QueueList = std::vector<QueueRuntime*>;
+
 }  // namespace flowpipe
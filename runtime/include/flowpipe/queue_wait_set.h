@@ -0,0 +1,67 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+#include "flowpipe/queue.h"
+#include "flowpipe/stop_token.h"
+
+namespace flowpipe {
+
+/**
+ * Blocks a consumer until any of several observed queues changes.
+ *
+ * Usage (lost-wakeup free):
+ *   auto seen = waits.epoch();
+ *   ... try_pop() every queue ...
+ *   if nothing was ready: waits.wait(seen, stop);
+ *
+ * Like BoundedQueue, a stop request alone does not wake a waiter; the
+ * runtime closes queues after requesting stop, and close() notifies.
+ */
+class QueueWaitSet final : public QueueObserver {
+ public:
+  void notify() noexcept override {
+    {
+      std::lock_guard lock(mu_);
+      ++epoch_;
+      if (waiters_ == 0) {
+        return;
+      }
+    }
+    cv_.notify_all();
+  }
+
+  uint64_t epoch() const {
+    std::lock_guard lock(mu_);
+    return epoch_;
+  }
+
+  void wait(uint64_t seen, const StopToken& stop) {
+    std::unique_lock lock(mu_);
+    ++waiters_;
+    cv_.wait(lock, [&] { return epoch_ != seen || stop.stop_requested(); });
+    --waiters_;
+  }
+
+  // Returns false if `deadline` passed without a notification.
+  bool wait_until(uint64_t seen, const StopToken& stop,
+                  std::chrono::steady_clock::time_point deadline) {
+    std::unique_lock lock(mu_);
+    ++waiters_;
+    const bool woken =
+        cv_.wait_until(lock, deadline, [&] { return epoch_ != seen || stop.stop_requested(); });
+    --waiters_;
+    return woken;
+  }
+
+ private:
+  mutable std::mutex mu_;
+  std::condition_variable cv_;
+  uint64_t epoch_ = 0;
+  uint32_t waiters_ = 0;
+};
+
+}  // namespace flowpipe
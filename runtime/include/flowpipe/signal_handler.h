@@ -6,14 +6,27 @@ namespace flowpipe {
 
 class SignalHandler {
  public:
-  // Install handlers for SIGINT and SIGTERM.
+  // Install handlers for SIGINT and SIGTERM, plus SIGUSR1 as a dump request.
   // stop_flag must remain valid for the lifetime of the process.
   static void install(std::atomic<bool>& stop_flag);
 
   // Relay any received signal to the stop flag using release semantics.
-  // Must be called periodically from the main thread (not from a signal handler).
+  // Must be called from the main thread (not from a signal handler).
   // Returns true if a signal was relayed.
   static bool relay() noexcept;
+
+  // Returns true, once, if SIGUSR1 arrived since the previous call. Like
+  // relay(), called from the main thread after wait() returns.
+  static bool take_dump_request() noexcept;
+
+  // Wakes the thread blocked in wait(). Async-signal-safe; callable from any
+  // thread once install() ran.
+  static void notify() noexcept;
+
+  // Blocks until notify() is called or a signal arrives, returning at once
+  // if that happened since the previous call. Without an eventfd (non-Linux
+  // or creation failed) it degrades to a short sleep.
+  static void wait() noexcept;
 };
 
 }  // namespace flowpipe
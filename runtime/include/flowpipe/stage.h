@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+#include <span>
 #include <string>
 
 #include "payload.h"
@@ -35,6 +37,7 @@ struct IStage {
  *
  * Produces payloads.
  * Return false to indicate end-of-stream.
+ * With several output queues, every payload is broadcast to all of them.
  */
 struct ISourceStage : IStage {
   virtual bool produce(StageContext& ctx, Payload& out) = 0;
@@ -44,11 +47,46 @@ struct ISourceStage : IStage {
  * Transform stage
  *
  * Transforms one input payload into one output payload.
+ * With several output queues, every payload is broadcast to all of them.
  */
 struct ITransformStage : IStage {
   virtual void process(StageContext& ctx, const Payload& input, Payload& output) = 0;
 };
 
+/**
+ * Output handle passed to flat-map stages.
+ *
+ * The runtime owns everything downstream of emit():
+ * schema application, enqueue timestamps and queue metrics.
+ */
+struct Emitter {
+  virtual ~Emitter() = default;
+
+  // Forward one payload to every stage output.
+  // Payloads without trace context or attributes inherit them from the input.
+  // Returns false once all outputs are closed or stop was requested; the stage
+  // should stop emitting and return.
+  virtual bool emit(Payload payload) = 0;
+
+  // Forward one payload to a single output (index into the stage's output
+  // queues, in spec order). Out-of-range indices are counted as stage errors.
+  virtual bool emit_to(size_t output, Payload payload) = 0;
+
+  // Number of output queues wired to the stage.
+  virtual size_t output_count() const = 0;
+};
+
+/**
+ * Flat-map stage
+ *
+ * Transforms one input payload into zero, one or many output payloads.
+ * Use this for filters, splitters and content-based routers instead of
+ * ITransformStage.
+ */
+struct IFlatMapStage : IStage {
+  virtual void process(StageContext& ctx, const Payload& input, Emitter& out) = 0;
+};
+
 /**
  * Sink stage
  *
@@ -58,4 +96,38 @@ struct ISinkStage : IStage {
   virtual void consume(StageContext& ctx, const Payload& input) = 0;
 };
 
+/**
+ * Optional timer hooks for transform, flat-map, sink and batch sink stages.
+ *
+ * Implement alongside the stage interface. Hooks run on the worker's own
+ * thread between payloads, so they never race process()/consume():
+ *  - on_tick() every StageSpec.tick_ms, under load or not
+ *  - on_idle() once no payload arrived for StageSpec.idle_ms after the last
+ *    one; it fires again only after the next payload
+ * Use them to flush buffered output when the stream goes quiet.
+ */
+struct IStageTimers {
+  virtual ~IStageTimers() = default;
+
+  virtual void on_tick(StageContext& ctx) {
+    (void)ctx;
+  }
+
+  virtual void on_idle(StageContext& ctx) {
+    (void)ctx;
+  }
+};
+
+/**
+ * Batch sink stage
+ *
+ * Consumes payloads in groups. The runtime gathers up to
+ * StageSpec.batch_size payloads, waiting at most StageSpec.linger_ms after
+ * the first one, so a partial batch is still delivered when traffic stops.
+ * Batches are never empty; the payloads are only valid during the call.
+ */
+struct IBatchSinkStage : IStage {
+  virtual void consume_batch(StageContext& ctx, std::span<const Payload> batch) = 0;
+};
+
 }  // namespace flowpipe
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <string>
 
 namespace flowpipe {
 
@@ -8,6 +9,13 @@ namespace flowpipe {
 struct Payload;
 struct QueueRuntime;
 
+// Which records a worker times, histograms and traces (see RecordSampler).
+// The defaults sample every record.
+struct SamplingOptions {
+  uint32_t one_in = 1;          // 0 or 1: every record
+  uint32_t max_per_second = 0;  // 0: no cap
+};
+
 /**
  * Runtime-owned metrics facade for stages and queues.
  *
@@ -17,10 +25,22 @@ struct QueueRuntime;
  *  - may be a no-op if metrics are disabled
  *
  * Stages never include or depend on this.
+ *
+ * Runtime::run creates one bound instance per wired stage. A bound instance
+ * resolves its metric series (and its flow/stage labels) once, at wiring
+ * time, and records stage metrics under it; the stage_name arguments of the
+ * Record* methods are then only used by unbound instances. Queue metrics use
+ * the series the runtime stored in QueueRuntime::metrics_id, when set.
  */
 class StageMetrics {
  public:
+  // Unbound: stage metrics are looked up by stage name on every record.
   StageMetrics() = default;
+
+  // Bound to one stage of a flow. An empty flow name omits the flow label.
+  StageMetrics(const std::string& flow_name, const std::string& stage_name,
+               const SamplingOptions& sampling = {});
+
   virtual ~StageMetrics() = default;
 
   StageMetrics(const StageMetrics&) = delete;
@@ -30,9 +50,12 @@ class StageMetrics {
   // Queue metrics
   // ------------------------------------------------------------
 
-  // Called when a payload is dequeued from a queue
+  // Called when a sampled payload is dequeued from a queue
   virtual void RecordQueueDequeue(const QueueRuntime& queue, const Payload& payload) noexcept;
 
+  // Called when an unsampled payload is dequeued: counted, no dwell time
+  virtual void CountQueueDequeue(const QueueRuntime& queue, const Payload& payload) noexcept;
+
   // Called when a payload is enqueued into a queue
   virtual void RecordQueueEnqueue(const QueueRuntime& queue) noexcept;
 
@@ -40,11 +63,56 @@ class StageMetrics {
   // Stage metrics
   // ------------------------------------------------------------
 
-  // Called after a stage processes a payload
+  // Called after a stage processes a sampled payload
   virtual void RecordStageLatency(const char* stage_name, uint64_t latency_ns) noexcept;
 
+  // Called after a stage processes an unsampled payload: counted, not timed
+  virtual void CountStageRecord(const char* stage_name) noexcept;
+
   // Called when a stage reports an error
   virtual void RecordStageError(const char* stage_name) noexcept;
+
+  // Called after a sink consumes a sampled payload, with the time since the
+  // payload (or the record it was derived from) entered the flow
+  virtual void RecordEndToEndLatency(const char* stage_name, uint64_t latency_ns) noexcept;
+
+  // ------------------------------------------------------------
+  // Autoscaling metrics
+  // ------------------------------------------------------------
+
+  // Called when an autoscaled stage starts (delta > 0) or stops (delta < 0) workers
+  virtual void RecordStageWorkers(const char* stage_name, int64_t delta) noexcept;
+
+  // Called when the autoscaler decides to add or retire a worker
+  virtual void RecordStageScaling(const char* stage_name, bool scale_up) noexcept;
+
+  // ------------------------------------------------------------
+  // Placement metrics
+  // ------------------------------------------------------------
+
+  // Called once per CPU in a stage's automatic placement
+  virtual void RecordStageCpu(const char* stage_name, uint32_t cpu, uint32_t l3,
+                              uint32_t numa_node) noexcept;
+
+  // Series id of the shared queue metrics for `queue_name`, for
+  // QueueRuntime::metrics_id.
+  static uint32_t BindQueue(const std::string& flow_name, const std::string& queue_name);
+
+  // Sampling the stage's workers apply to latency, histograms and spans.
+  const SamplingOptions& sampling() const noexcept {
+    return sampling_;
+  }
+
+ protected:
+  // Unbound, with the given sampling; for wrappers that forward to another
+  // instance.
+  explicit StageMetrics(const SamplingOptions& sampling) : sampling_(sampling) {}
+
+ private:
+  static constexpr uint32_t kUnbound = UINT32_MAX;
+
+  uint32_t stage_series_ = kUnbound;
+  SamplingOptions sampling_;
 };
 
 }  // namespace flowpipe
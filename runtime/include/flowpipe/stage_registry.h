@@ -2,6 +2,8 @@
 
 #include <google/protobuf/struct.pb.h>
 
+#include <condition_variable>
+#include <cstddef>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -21,8 +23,15 @@ class StageRegistry {
   StageRegistry(const StageRegistry&) = delete;
   StageRegistry& operator=(const StageRegistry&) = delete;
 
+  // Thread-safe. Concurrent calls load distinct plugins and construct and
+  // configure their stages in parallel; a plugin is loaded only once.
   IStage* create_stage(const std::string& plugin_name,
                        const google::protobuf::Struct* config = nullptr);
+  // Clones a configured instance through ConfigurableStage::clone() and
+  // tracks the clone like a created stage. Returns nullptr when the stage
+  // does not support cloning or is not tracked by this registry. The
+  // prototype must stay alive for the duration of the call.
+  IStage* clone_stage(IStage* prototype);
   void destroy_stage(IStage* stage);
   void shutdown();
 
@@ -32,16 +41,32 @@ class StageRegistry {
     IStage* stage = nullptr;
   };
 
+  // Counts a create_stage()/clone_stage() call in pending_creates_ for its
+  // lifetime.
+  class PendingCreate;
+
+  // Serializes loading of one plugin without blocking other plugins.
+  struct PluginSlot {
+    std::mutex load_mutex;
+    bool loaded = false;  // guarded by load_mutex
+    LoadedPlugin plugin;
+  };
+
   std::unique_ptr<StageLoader> loader_;
-  // Guards the full registry lifecycle state (plugins_ + instances_).
+  // Guards the registry containers (plugins_ + instances_) and
+  // pending_creates_; plugin code runs outside it.
   // Ordering contract:
-  //  - shutdown() holds this lock while it tears down instances/plugins so it
-  //    cannot race with concurrent destroy_stage() calls.
-  //  - create_stage() and destroy_stage() both hold this lock while mutating
-  //    registry containers, so workers cannot insert while another thread is
-  //    erasing.
+  //  - create_stage() holds this lock only to look up the plugin slot and to
+  //    record the new instance. Loading, create(), configure() and clone()
+  //    happen unlocked, counted in pending_creates_.
+  //  - destroy_stage() holds this lock while it destroys an instance, so it
+  //    cannot race with shutdown().
+  //  - shutdown() waits for pending creates to finish, then holds this lock
+  //    while it tears down instances/plugins.
   mutable std::mutex lifecycle_mutex_;
-  std::unordered_map<std::string, LoadedPlugin> plugins_;
+  std::condition_variable creates_done_;
+  size_t pending_creates_ = 0;
+  std::unordered_map<std::string, std::unique_ptr<PluginSlot>> plugins_;
   std::vector<StageInstance> instances_;
 };
 
@@ -1,11 +1,34 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+
+#include "flowpipe/async_stage.h"
 #include "flowpipe/queue_runtime.h"
 #include "flowpipe/stage.h"
 #include "flowpipe/stage_metrics.h"
 
 namespace flowpipe {
 
+// Runners accept one or more queues per side:
+//  - several inputs are polled round-robin and block without spinning
+//    until any of them has data or all of them are drained
+//  - several outputs receive a copy of every payload (broadcast), except
+//    for flat-map stages, which may route with Emitter::emit_to()
+//  - an output that closes early is skipped; the runner stops once every
+//    output is closed
+//
+// Consumer runners take optional TimerOptions and call IStageTimers hooks
+// on the worker thread when the stage implements them.
+
+// Timer hook periods, from StageSpec.tick_ms/idle_ms. Zero disables a hook.
+struct TimerOptions {
+  std::chrono::milliseconds tick{0};
+  std::chrono::milliseconds idle{0};
+};
+
 /**
  * Runtime wrapper for source stages.
  *
@@ -17,7 +40,7 @@ namespace flowpipe {
  *  - modify stage behavior
  *  - expose metrics to plugins
  */
-void RunSourceStage(ISourceStage* stage, StageContext& ctx, QueueRuntime& output,
+void RunSourceStage(ISourceStage* stage, StageContext& ctx, const QueueList& outputs,
                     StageMetrics* metrics);
 
 /**
@@ -30,8 +53,22 @@ void RunSourceStage(ISourceStage* stage, StageContext& ctx, QueueRuntime& output
  *
  * Stage remains unaware of metrics and timing.
  */
-void RunTransformStage(ITransformStage* stage, StageContext& ctx, QueueRuntime& input,
-                       QueueRuntime& output, StageMetrics* metrics);
+void RunTransformStage(ITransformStage* stage, StageContext& ctx, const QueueList& inputs,
+                       const QueueList& outputs, StageMetrics* metrics,
+                       const TimerOptions& timers = {});
+
+/**
+ * Runtime wrapper for flat-map stages.
+ *
+ * Owns:
+ *  - dequeue
+ *  - queue latency metrics
+ *  - stage execution latency
+ *  - schema, timestamps and enqueue metrics for every emitted payload
+ */
+void RunFlatMapStage(IFlatMapStage* stage, StageContext& ctx, const QueueList& inputs,
+                     const QueueList& outputs, StageMetrics* metrics,
+                     const TimerOptions& timers = {});
 
 /**
  * Runtime wrapper for sink stages.
@@ -41,6 +78,114 @@ void RunTransformStage(ITransformStage* stage, StageContext& ctx, QueueRuntime&
  *  - queue latency metrics
  *  - stage execution latency
  */
-void RunSinkStage(ISinkStage* stage, StageContext& ctx, QueueRuntime& input, StageMetrics* metrics);
+void RunSinkStage(ISinkStage* stage, StageContext& ctx, const QueueList& inputs,
+                  StageMetrics* metrics, const TimerOptions& timers = {});
+
+// Batching limits for RunBatchSinkStage, from StageSpec.batch_size/linger_ms.
+struct BatchOptions {
+  size_t max_size = 64;
+  std::chrono::milliseconds linger{0};
+};
+
+/**
+ * Runtime wrapper for batch sink stages.
+ *
+ * Owns:
+ *  - dequeue and batching (size and linger deadline)
+ *  - queue latency metrics, per payload
+ *  - stage execution latency, per batch
+ */
+void RunBatchSinkStage(IBatchSinkStage* stage, StageContext& ctx, const QueueList& inputs,
+                       StageMetrics* metrics, const BatchOptions& options,
+                       const TimerOptions& timers = {});
+
+/**
+ * Consumer worker that can be retired while the flow keeps running.
+ *
+ * Runs a transform, flat-map or sink stage like the runners above and also
+ * returns once `retire` is set. The payload in hand is always finished and
+ * forwarded; the rest of the input is left to the stage's other workers.
+ * After setting `retire`, call IQueue::wake_all() on the inputs so a worker
+ * blocked in pop() notices.
+ */
+void RunRetirableWorker(IStage* stage, StageContext& ctx, const QueueList& inputs,
+                        const QueueList& outputs, StageMetrics* metrics,
+                        const std::atomic<bool>& retire, const TimerOptions& timers = {});
+
+/**
+ * Runtime wrappers for async stages.
+ *
+ * Each call runs an epoll event loop on the calling thread and keeps up to
+ * stage->max_in_flight() payloads in flight. New input is only dequeued
+ * while every output has room, so backpressure still holds. Metrics match
+ * the synchronous runners; stage latency spans the whole coroutine.
+ */
+void RunAsyncTransformStage(IAsyncTransformStage* stage, StageContext& ctx,
+                            const QueueList& inputs, const QueueList& outputs,
+                            StageMetrics* metrics);
+
+void RunAsyncSinkStage(IAsyncSinkStage* stage, StageContext& ctx, const QueueList& inputs,
+                       StageMetrics* metrics);
+
+/**
+ * Operator fusion.
+ *
+ * Builds the queue for an edge whose only consumer runs inline on its
+ * producer's thread. push() performs the consumer's dequeue, schema check,
+ * stage call and output forwarding directly, with the same metrics as a
+ * threaded runner. The consumer must be a transform, flat-map or sink stage
+ * reading from `input` only; `outputs` must outlive the returned queue.
+ */
+std::shared_ptr<IQueue<Payload>> MakeFusedQueue(IStage* consumer, StageContext& ctx,
+                                                QueueRuntime& input, const QueueList& outputs,
+                                                StageMetrics* metrics);
+
+/**
+ * Cooperative stage worker for the pooled executor.
+ *
+ * RunSlice() handles a bounded number of payloads and never blocks on a
+ * queue: it returns kBlocked when every input is empty or an output is full,
+ * and the executor parks the task until one of queues() changes. Payloads
+ * that did not fit are held by the task and flushed first on the next slice.
+ * Stage code (produce/process/consume) may still block its pool thread.
+ */
+class StageTask {
+ public:
+  enum class Status {
+    kReady,    // more work is likely available
+    kBlocked,  // wait for activity on queues()
+    kDone,     // worker finished; the stage may be destroyed
+  };
+
+  virtual ~StageTask() = default;
+  virtual Status RunSlice() = 0;
+  virtual QueueList queues() const = 0;
+};
+
+std::unique_ptr<StageTask> MakeStageTask(IStage* stage, StageContext& ctx, QueueList inputs,
+                                         QueueList outputs, StageMetrics* metrics);
+
+// ------------------------------------------------------------
+// Single-queue convenience overloads
+// ------------------------------------------------------------
+inline void RunSourceStage(ISourceStage* stage, StageContext& ctx, QueueRuntime& output,
+                           StageMetrics* metrics) {
+  RunSourceStage(stage, ctx, QueueList{&output}, metrics);
+}
+
+inline void RunTransformStage(ITransformStage* stage, StageContext& ctx, QueueRuntime& input,
+                              QueueRuntime& output, StageMetrics* metrics) {
+  RunTransformStage(stage, ctx, QueueList{&input}, QueueList{&output}, metrics);
+}
+
+inline void RunFlatMapStage(IFlatMapStage* stage, StageContext& ctx, QueueRuntime& input,
+                            QueueRuntime& output, StageMetrics* metrics) {
+  RunFlatMapStage(stage, ctx, QueueList{&input}, QueueList{&output}, metrics);
+}
+
+inline void RunSinkStage(ISinkStage* stage, StageContext& ctx, QueueRuntime& input,
+                         StageMetrics* metrics) {
+  RunSinkStage(stage, ctx, QueueList{&input}, metrics);
+}
 
 }  // namespace flowpipe
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string>
+
+#include "flowpipe/plugin.h"
+#include "flowpipe/stage.h"
+#include "flowpipe/stage_runner.h"
+
+namespace flowpipe {
+
+// Threaded runner of a statically linked stage, specialized on its type.
+using StaticRunFn = void (*)(IStage* stage, StageContext& ctx, const QueueList& inputs,
+                             const QueueList& outputs, StageMetrics* metrics,
+                             const TimerOptions& timers);
+
+/**
+ * A stage compiled into the runtime binary instead of loaded with dlopen().
+ *
+ * `type` is the stage type as in StageSpec.type; flows keep naming the
+ * plugin file (libstage_<type>.so) and the loader resolves it here first.
+ * `run` drives a dedicated worker thread with the step loops instantiated
+ * on the concrete class (StaticRunnerFor in internal/static_stage_runner.h),
+ * so produce/process/consume calls can be inlined. It is null for stage
+ * kinds without a specialized loop.
+ */
+struct StaticStage {
+  const char* type = nullptr;
+  CreateStageFn create = nullptr;
+  DestroyStageFn destroy = nullptr;
+  StaticRunFn run = nullptr;
+};
+
+// Adds a stage to the process-wide table. Called from static initializers
+// (FLOWPIPE_STAGE_PLUGIN); returns false if the type is already taken.
+bool RegisterStaticStage(const StaticStage& stage);
+
+// Stage registered for a plugin name ("<type>" or "libstage_<type>.so").
+// Paths never match. nullptr when the stage is not linked in.
+const StaticStage* FindStaticStage(const std::string& plugin_name);
+
+}  // namespace flowpipe
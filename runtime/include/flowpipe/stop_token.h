@@ -12,23 +12,39 @@ namespace flowpipe {
  */
 class StopToken {
  public:
+  // Called once by the request_stop() that sets the flag, so a waiting
+  // supervisor notices without polling.
+  using WakeFn = void (*)() noexcept;
+
   StopToken() noexcept : flag_(nullptr) {}
 
-  explicit StopToken(std::atomic<bool>* flag) noexcept : flag_(flag) {}
+  explicit StopToken(std::atomic<bool>* flag, WakeFn wake = nullptr) noexcept
+      : flag_(flag), wake_(wake) {}
 
   // Returns true if stop has been requested
   bool stop_requested() const noexcept {
-    return flag_ && flag_->load(std::memory_order_acquire);
+    return (flag_ && flag_->load(std::memory_order_acquire)) ||
+           (local_ && local_->load(std::memory_order_acquire));
+  }
+
+  // Copy that also reports stop once `local` is set, so the runtime can stop
+  // a single worker. request_stop() still targets the shared flag.
+  StopToken with_local(const std::atomic<bool>* local) const noexcept {
+    StopToken token(*this);
+    token.local_ = local;
+    return token;
   }
 
   void request_stop() const noexcept {
-    if (flag_) {
-      flag_->store(true, std::memory_order_release);
+    if (flag_ && !flag_->exchange(true, std::memory_order_acq_rel) && wake_) {
+      wake_();
     }
   }
 
  private:
   std::atomic<bool>* flag_;
+  WakeFn wake_ = nullptr;
+  const std::atomic<bool>* local_ = nullptr;
 };
 
 }  // namespace flowpipe
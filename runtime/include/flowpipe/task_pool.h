@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "flowpipe/stage_runner.h"
+
+namespace flowpipe {
+
+/**
+ * Fixed-size work-stealing executor for pooled stage workers.
+ *
+ * Each pool thread owns a deque: it runs its most recently scheduled task
+ * first and steals the oldest task of a peer when its own deque is empty.
+ * Tasks that report kBlocked are parked and rescheduled by a QueueObserver
+ * registered on their queues, so an idle pool sleeps instead of polling.
+ */
+class TaskPool {
+ public:
+  using DoneCallback = std::function<void()>;
+
+  explicit TaskPool(size_t threads);
+  ~TaskPool();
+
+  TaskPool(const TaskPool&) = delete;
+  TaskPool& operator=(const TaskPool&) = delete;
+
+  size_t size() const noexcept {
+    return workers_.size();
+  }
+
+  // Runs the task until it reports kDone, then calls on_done on a pool thread.
+  void Submit(std::unique_ptr<StageTask> task, DoneCallback on_done);
+
+  // Blocks until every submitted task is done, then stops the pool threads.
+  void Shutdown();
+
+ private:
+  class Entry;
+
+  struct Worker {
+    std::mutex mu;
+    std::deque<Entry*> tasks;
+  };
+
+  void Schedule(Entry* entry);
+  Entry* Take(size_t self);
+  void Run(Entry* entry);
+  void Finish(Entry* entry);
+  void WorkerLoop(size_t self);
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::vector<std::thread> threads_;
+  std::atomic<size_t> next_worker_{0};
+
+  std::mutex mu_;
+  std::condition_variable work_cv_;
+  std::condition_variable done_cv_;
+  size_t queued_ = 0;      // scheduled entries not yet taken (guarded by mu_)
+  size_t live_tasks_ = 0;  // submitted, not finished (guarded by mu_)
+  bool stopping_ = false;  // guarded by mu_
+};
+
+}  // namespace flowpipe
@@ -0,0 +1,383 @@
+#include "flowpipe/autoscaler.h"
+
+#include <algorithm>
+#include <exception>
+#include <utility>
+
+#include "flowpipe/clock.h"
+#include "flowpipe/observability/logging_runtime.h"
+#include "flowpipe/payload.h"
+
+namespace flowpipe {
+
+// ------------------------------------------------------------
+// Hysteresis
+// ------------------------------------------------------------
+ScalingController::ScalingController(const AutoscalePolicy& policy, uint32_t min_workers,
+                                     uint32_t max_workers)
+    : policy_(policy), min_workers_(min_workers), max_workers_(max_workers) {
+  policy_.scale_up_samples = std::max<uint32_t>(policy_.scale_up_samples, 1);
+  policy_.scale_down_samples = std::max<uint32_t>(policy_.scale_down_samples, 1);
+}
+
+int ScalingController::Observe(const ScalingSample& sample, uint32_t workers,
+                               std::chrono::steady_clock::time_point now) {
+  const uint64_t dwell_threshold_ns =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(policy_.scale_up_dwell).count();
+  const bool busy = sample.occupancy >= policy_.scale_up_occupancy ||
+                    (dwell_threshold_ns > 0 && sample.mean_dwell_ns >= dwell_threshold_ns);
+  const bool idle = !busy && sample.occupancy <= policy_.scale_down_occupancy;
+
+  busy_run_ = busy ? busy_run_ + 1 : 0;
+  idle_run_ = idle ? idle_run_ + 1 : 0;
+
+  const bool cooling = last_decision_ != std::chrono::steady_clock::time_point{} &&
+                       now - last_decision_ < policy_.cooldown;
+  if (cooling) {
+    return 0;
+  }
+
+  if (busy_run_ >= policy_.scale_up_samples && workers < max_workers_) {
+    busy_run_ = 0;
+    last_decision_ = now;
+    return 1;
+  }
+  if (idle_run_ >= policy_.scale_down_samples && workers > min_workers_) {
+    idle_run_ = 0;
+    last_decision_ = now;
+    return -1;
+  }
+  return 0;
+}
+
+// ------------------------------------------------------------
+// Dwell sampling
+// ------------------------------------------------------------
+void ScalingMetrics::RecordQueueDequeue(const QueueRuntime& queue,
+                                        const Payload& payload) noexcept {
+  if (payload.meta.enqueue_ts_ns > 0) {
+    const uint64_t now_ns = FastNowNs();
+    if (now_ns > payload.meta.enqueue_ts_ns) {
+      dwell_sum_ns_.fetch_add(now_ns - payload.meta.enqueue_ts_ns, std::memory_order_relaxed);
+      dwell_count_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+  if (inner_) {
+    inner_->RecordQueueDequeue(queue, payload);
+  }
+}
+
+// Unsampled dequeues carry no dwell sample; the mean covers sampled ones.
+void ScalingMetrics::CountQueueDequeue(const QueueRuntime& queue,
+                                       const Payload& payload) noexcept {
+  if (inner_) {
+    inner_->CountQueueDequeue(queue, payload);
+  }
+}
+
+void ScalingMetrics::RecordQueueEnqueue(const QueueRuntime& queue) noexcept {
+  if (inner_) {
+    inner_->RecordQueueEnqueue(queue);
+  }
+}
+
+void ScalingMetrics::RecordStageLatency(const char* stage_name, uint64_t latency_ns) noexcept {
+  if (inner_) {
+    inner_->RecordStageLatency(stage_name, latency_ns);
+  }
+}
+
+void ScalingMetrics::CountStageRecord(const char* stage_name) noexcept {
+  if (inner_) {
+    inner_->CountStageRecord(stage_name);
+  }
+}
+
+void ScalingMetrics::RecordStageError(const char* stage_name) noexcept {
+  if (inner_) {
+    inner_->RecordStageError(stage_name);
+  }
+}
+
+void ScalingMetrics::RecordEndToEndLatency(const char* stage_name,
+                                           uint64_t latency_ns) noexcept {
+  if (inner_) {
+    inner_->RecordEndToEndLatency(stage_name, latency_ns);
+  }
+}
+
+void ScalingMetrics::RecordStageWorkers(const char* stage_name, int64_t delta) noexcept {
+  if (inner_) {
+    inner_->RecordStageWorkers(stage_name, delta);
+  }
+}
+
+void ScalingMetrics::RecordStageScaling(const char* stage_name, bool scale_up) noexcept {
+  if (inner_) {
+    inner_->RecordStageScaling(stage_name, scale_up);
+  }
+}
+
+void ScalingMetrics::RecordStageCpu(const char* stage_name, uint32_t cpu, uint32_t l3,
+                                    uint32_t numa_node) noexcept {
+  if (inner_) {
+    inner_->RecordStageCpu(stage_name, cpu, l3, numa_node);
+  }
+}
+
+uint64_t ScalingMetrics::TakeMeanDwellNs() noexcept {
+  // The two exchanges are not atomic together; a dequeue racing with them
+  // only shifts one sample into the next period.
+  const uint64_t count = dwell_count_.exchange(0, std::memory_order_relaxed);
+  const uint64_t sum = dwell_sum_ns_.exchange(0, std::memory_order_relaxed);
+  return count > 0 ? sum / count : 0;
+}
+
+// ------------------------------------------------------------
+// Scaled stage
+// ------------------------------------------------------------
+ScaledStage::ScaledStage(std::string name, QueueList inputs, uint32_t min_workers,
+                         uint32_t max_workers, const AutoscalePolicy& policy,
+                         StageMetrics* metrics, Hooks hooks)
+    : name_(std::move(name)),
+      inputs_(std::move(inputs)),
+      min_workers_(min_workers),
+      max_workers_(max_workers),
+      metrics_(metrics),
+      worker_metrics_(metrics),
+      controller_(policy, min_workers, max_workers),
+      hooks_(std::move(hooks)) {}
+
+ScaledStage::~ScaledStage() {
+  Join();
+}
+
+void ScaledStage::Start(const std::vector<IStage*>& stages) {
+  std::lock_guard lock(mu_);
+  for (auto* stage : stages) {
+    Launch(stage);
+  }
+  FP_LOG_INFO_FMT("stage '{}' autoscaling between {} and {} workers (started {})", name_,
+                  min_workers_, max_workers_, active_);
+}
+
+void ScaledStage::Launch(IStage* stage) {
+  auto worker = std::make_unique<Worker>();
+  worker->index = next_index_++;
+  auto* raw = worker.get();
+  workers_.push_back(std::move(worker));
+  ++live_;
+  ++active_;
+  if (metrics_) {
+    metrics_->RecordStageWorkers(name_.c_str(), 1);
+  }
+  raw->thread = std::thread([this, raw, stage]() { WorkerMain(raw, stage); });
+}
+
+void ScaledStage::WorkerMain(Worker* worker, IStage* stage) {
+  FP_LOG_DEBUG_FMT("stage '{}' autoscaled worker {} started", name_, worker->index);
+
+  hooks_.run(stage, worker->index, worker->retire, &worker_metrics_);
+  hooks_.destroy(stage);
+
+  if (metrics_) {
+    metrics_->RecordStageWorkers(name_.c_str(), -1);
+  }
+  FP_LOG_DEBUG_FMT("stage '{}' autoscaled worker {} stopped", name_, worker->index);
+
+  bool last = false;
+  {
+    std::lock_guard lock(mu_);
+    --live_;
+    if (!worker->retire.load(std::memory_order_relaxed)) {
+      --active_;
+    }
+    if (live_ == 0) {
+      finished_ = true;
+      last = true;
+    }
+  }
+  worker->exited.store(true, std::memory_order_release);
+
+  if (last) {
+    hooks_.finished();
+  }
+}
+
+void ScaledStage::Tick(std::chrono::steady_clock::time_point now) {
+  Reap();
+
+  ScalingSample sample;
+  sample.occupancy = Occupancy();
+  sample.mean_dwell_ns = worker_metrics_.TakeMeanDwellNs();
+
+  uint32_t active = 0;
+  {
+    std::lock_guard lock(mu_);
+    if (finished_) {
+      return;
+    }
+    active = active_;
+  }
+
+  const int decision = controller_.Observe(sample, active, now);
+  if (decision > 0) {
+    ScaleUp(sample);
+  } else if (decision < 0) {
+    ScaleDown(sample);
+  }
+}
+
+void ScaledStage::ScaleUp(const ScalingSample& sample) {
+  // Plugin construction may be slow; keep it outside the lock.
+  IStage* stage = nullptr;
+  try {
+    stage = hooks_.create();
+  } catch (const std::exception& ex) {
+    FP_LOG_WARN_FMT("stage '{}' could not add a worker: {}", name_, ex.what());
+    return;
+  }
+
+  uint32_t active = 0;
+  bool launched = false;
+  {
+    std::lock_guard lock(mu_);
+    if (!finished_ && active_ < max_workers_) {
+      Launch(stage);
+      launched = true;
+      active = active_;
+    }
+  }
+  if (!launched) {
+    hooks_.destroy(stage);
+    return;
+  }
+
+  FP_LOG_INFO_FMT("stage '{}' scaled up to {} workers (occupancy {:.2f}, dwell {} us)", name_,
+                  active, sample.occupancy, sample.mean_dwell_ns / 1000);
+  if (metrics_) {
+    metrics_->RecordStageScaling(name_.c_str(), true);
+  }
+}
+
+void ScaledStage::ScaleDown(const ScalingSample& sample) {
+  uint32_t active = 0;
+  {
+    std::lock_guard lock(mu_);
+    if (finished_ || active_ <= min_workers_) {
+      return;
+    }
+
+    // Retire the newest worker; older ones keep their warm caches.
+    for (auto it = workers_.rbegin(); it != workers_.rend(); ++it) {
+      auto& worker = **it;
+      if (!worker.retire.load(std::memory_order_relaxed) &&
+          !worker.exited.load(std::memory_order_acquire)) {
+        worker.retire.store(true, std::memory_order_release);
+        --active_;
+        break;
+      }
+    }
+    active = active_;
+  }
+
+  for (auto* input : inputs_) {
+    input->queue->wake_all();
+  }
+
+  FP_LOG_INFO_FMT("stage '{}' scaled down to {} workers (occupancy {:.2f}, dwell {} us)", name_,
+                  active, sample.occupancy, sample.mean_dwell_ns / 1000);
+  if (metrics_) {
+    metrics_->RecordStageScaling(name_.c_str(), false);
+  }
+}
+
+void ScaledStage::Reap() {
+  std::vector<std::unique_ptr<Worker>> exited;
+  {
+    std::lock_guard lock(mu_);
+    for (auto it = workers_.begin(); it != workers_.end();) {
+      if ((*it)->exited.load(std::memory_order_acquire)) {
+        exited.push_back(std::move(*it));
+        it = workers_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+  for (auto& worker : exited) {
+    worker->thread.join();
+  }
+}
+
+uint32_t ScaledStage::active_workers() const {
+  std::lock_guard lock(mu_);
+  return active_;
+}
+
+void ScaledStage::Join() {
+  std::list<std::unique_ptr<Worker>> workers;
+  {
+    std::lock_guard lock(mu_);
+    workers.swap(workers_);
+  }
+  for (auto& worker : workers) {
+    if (worker->thread.joinable()) {
+      worker->thread.join();
+    }
+  }
+}
+
+double ScaledStage::Occupancy() const {
+  uint64_t buffered = 0;
+  uint64_t capacity = 0;
+  for (auto* input : inputs_) {
+    buffered += input->queue->size();
+    capacity += input->capacity;
+  }
+  return capacity > 0 ? static_cast<double>(buffered) / static_cast<double>(capacity) : 0.0;
+}
+
+// ------------------------------------------------------------
+// Supervisor
+// ------------------------------------------------------------
+Autoscaler::Autoscaler(std::chrono::milliseconds interval) : interval_(interval) {}
+
+Autoscaler::~Autoscaler() {
+  Stop();
+}
+
+void Autoscaler::Add(ScaledStage* stage) {
+  stages_.push_back(stage);
+}
+
+void Autoscaler::Start() {
+  thread_ = std::thread([this]() { Loop(); });
+  FP_LOG_INFO_FMT("autoscaler supervising {} stages every {} ms", stages_.size(),
+                  interval_.count());
+}
+
+void Autoscaler::Stop() {
+  {
+    std::lock_guard lock(mu_);
+    stopping_ = true;
+  }
+  cv_.notify_all();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+void Autoscaler::Loop() {
+  std::unique_lock lock(mu_);
+  while (!cv_.wait_for(lock, interval_, [this] { return stopping_; })) {
+    lock.unlock();
+    const auto now = std::chrono::steady_clock::now();
+    for (auto* stage : stages_) {
+      stage->Tick(now);
+    }
+    lock.lock();
+  }
+}
+
+}  // namespace flowpipe
@@ -0,0 +1,227 @@
+#include "flowpipe/clock.h"
+
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+
+#if FLOWPIPE_HAVE_TSC
+#include <cpuid.h>
+#endif
+
+#include "flowpipe/observability/logging_runtime.h"
+
+namespace flowpipe {
+
+namespace detail {
+TscMapping g_tsc_mapping;
+}  // namespace detail
+
+namespace {
+
+#if FLOWPIPE_HAVE_TSC
+
+// Plausible TSC rates; anything outside means calibration went wrong.
+constexpr double kMinTscGhz = 0.1;
+constexpr double kMaxTscGhz = 20.0;
+
+// Calibration window of the initial estimate.
+constexpr auto kCalibrationWindow = std::chrono::milliseconds(20);
+
+// Drift (ns per check) above which the mapping is corrected, and above which
+// the TSC is not trusted any more.
+constexpr int64_t kRecalibrateDriftNs = 1'000;
+constexpr int64_t kMaxDriftNs = 1'000'000;
+
+struct ClockPair {
+  uint64_t tsc = 0;
+  uint64_t ns = 0;
+};
+
+// TSC reading and the CLOCK_MONOTONIC time it was taken at. Keeps the try
+// whose two monotonic reads were closest together.
+ClockPair SamplePair() {
+  ClockPair best;
+  uint64_t best_window = UINT64_MAX;
+  for (int i = 0; i < 8; ++i) {
+    const uint64_t before = MonotonicNowNs();
+    const uint64_t tsc = __rdtsc();
+    const uint64_t after = MonotonicNowNs();
+    if (after - before < best_window) {
+      best_window = after - before;
+      best = ClockPair{tsc, before + (after - before) / 2};
+    }
+  }
+  return best;
+}
+
+// ns-per-tick between two pairs, as a 32.32 fixed-point multiplier.
+uint64_t SlopeMult(const ClockPair& from, const ClockPair& to) {
+  const uint64_t ticks = to.tsc - from.tsc;
+  const uint64_t ns = to.ns - from.ns;
+  return static_cast<uint64_t>((static_cast<detail::Uint128>(ns) << 32) / ticks);
+}
+
+uint64_t MapTsc(uint64_t tsc, uint64_t base_tsc, uint64_t base_ns, uint64_t mult) {
+  if (tsc <= base_tsc) {
+    return base_ns;
+  }
+  return base_ns +
+         static_cast<uint64_t>((static_cast<detail::Uint128>(tsc - base_tsc) * mult) >> 32);
+}
+
+// Single writer at a time (callers hold ClockState::mutex).
+void Publish(uint64_t base_tsc, uint64_t base_ns, uint64_t mult) {
+  auto& m = detail::g_tsc_mapping;
+  const uint32_t seq = m.seq.load(std::memory_order_relaxed);
+  m.seq.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  m.base_tsc.store(base_tsc, std::memory_order_relaxed);
+  m.base_ns.store(base_ns, std::memory_order_relaxed);
+  m.mult.store(mult, std::memory_order_relaxed);
+  m.seq.store(seq + 2, std::memory_order_release);
+}
+
+#endif  // FLOWPIPE_HAVE_TSC
+
+struct ClockState {
+  std::mutex mutex;
+  std::condition_variable wake;
+  bool stop = false;
+  std::thread drift_check;
+
+  // A drift check still running at exit is stopped rather than left joinable.
+  ~ClockState() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stop = true;
+    }
+    wake.notify_all();
+    if (drift_check.joinable()) {
+      drift_check.join();
+    }
+  }
+};
+
+ClockState& State() {
+  static ClockState state;
+  return state;
+}
+
+#if FLOWPIPE_HAVE_TSC
+
+// Compares the mapping with CLOCK_MONOTONIC once per interval. The slope is
+// re-derived from the first calibration point, so it gets more precise the
+// longer the runtime runs. A mapping that runs ahead is slewed (slowed down
+// over the next interval) rather than stepped back, keeping FastNowNs()
+// monotonic; one that lags is stepped forward.
+void DriftCheckLoop(ClockPair anchor, std::chrono::milliseconds interval) {
+  auto& state = State();
+  auto& m = detail::g_tsc_mapping;
+  const auto interval_ns = static_cast<int64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(interval).count());
+
+  std::unique_lock<std::mutex> lock(state.mutex);
+  while (!state.wake.wait_for(lock, interval, [&] { return state.stop; })) {
+    const ClockPair now = SamplePair();
+    const uint64_t predicted =
+        MapTsc(now.tsc, m.base_tsc.load(std::memory_order_relaxed),
+               m.base_ns.load(std::memory_order_relaxed), m.mult.load(std::memory_order_relaxed));
+    const int64_t drift = static_cast<int64_t>(predicted - now.ns);
+
+    if (std::llabs(drift) > kMaxDriftNs) {
+      FP_LOG_WARN_FMT("tsc clock: drifted {} ns from CLOCK_MONOTONIC; falling back", drift);
+      m.enabled.store(false, std::memory_order_relaxed);
+      return;
+    }
+    if (std::llabs(drift) <= kRecalibrateDriftNs) {
+      continue;
+    }
+
+    const uint64_t mult = SlopeMult(anchor, now);
+    if (drift > 0 && drift < interval_ns) {
+      const auto slewed = static_cast<uint64_t>(static_cast<detail::Uint128>(mult) *
+                                                (interval_ns - drift) / interval_ns);
+      Publish(now.tsc, predicted, slewed);
+    } else {
+      Publish(now.tsc, now.ns, mult);
+    }
+    FP_LOG_DEBUG_FMT("tsc clock: corrected {} ns of drift", drift);
+  }
+}
+
+#endif  // FLOWPIPE_HAVE_TSC
+
+}  // namespace
+
+bool HasInvariantTsc() noexcept {
+#if FLOWPIPE_HAVE_TSC
+  unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+  if (__get_cpuid_max(0x80000000, nullptr) < 0x80000007) {
+    return false;
+  }
+  if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) {
+    return false;
+  }
+  return (edx & (1u << 8)) != 0;
+#else
+  return false;
+#endif
+}
+
+bool EnableTscClock(std::chrono::milliseconds drift_check_interval) {
+#if FLOWPIPE_HAVE_TSC
+  if (TscClockActive()) {
+    return true;
+  }
+  if (!HasInvariantTsc()) {
+    FP_LOG_WARN("tsc clock: CPU has no invariant TSC; using CLOCK_MONOTONIC");
+    return false;
+  }
+
+  DisableTscClock();  // joins a drift check that gave up on its own
+
+  const ClockPair first = SamplePair();
+  std::this_thread::sleep_for(kCalibrationWindow);
+  const ClockPair second = SamplePair();
+
+  const double ghz = static_cast<double>(second.tsc - first.tsc) /
+                     static_cast<double>(second.ns - first.ns);
+  if (second.tsc <= first.tsc || ghz < kMinTscGhz || ghz > kMaxTscGhz) {
+    FP_LOG_WARN_FMT("tsc clock: calibration failed ({:.3f} GHz); using CLOCK_MONOTONIC", ghz);
+    return false;
+  }
+
+  auto& state = State();
+  {
+    std::lock_guard<std::mutex> lock(state.mutex);
+    Publish(second.tsc, second.ns, SlopeMult(first, second));
+    detail::g_tsc_mapping.enabled.store(true, std::memory_order_relaxed);
+    state.stop = false;
+  }
+  state.drift_check = std::thread(DriftCheckLoop, first, drift_check_interval);
+
+  FP_LOG_INFO_FMT("tsc clock: enabled at {:.3f} GHz (drift check every {} ms)", ghz,
+                  drift_check_interval.count());
+  return true;
+#else
+  (void)drift_check_interval;
+  FP_LOG_WARN("tsc clock: not supported on this architecture; using CLOCK_MONOTONIC");
+  return false;
+#endif
+}
+
+void DisableTscClock() {
+  auto& state = State();
+  {
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.stop = true;
+    detail::g_tsc_mapping.enabled.store(false, std::memory_order_relaxed);
+  }
+  state.wake.notify_all();
+  if (state.drift_check.joinable()) {
+    state.drift_check.join();
+  }
+}
+
+}  // namespace flowpipe
@@ -0,0 +1,159 @@
+#include "flowpipe/cpu_resources.h"
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "flowpipe/observability/logging_runtime.h"
+
+namespace flowpipe {
+
+namespace {
+
+#ifdef __linux__
+constexpr unsigned long kMaxCpus = CPU_SETSIZE;
+#else
+constexpr unsigned long kMaxCpus = 1024;
+#endif
+
+std::optional<double> ReadCgroupV2Quota() {
+  std::ifstream in("/sys/fs/cgroup/cpu.max");
+  std::string quota;
+  double period = 0;
+  if (!(in >> quota >> period) || quota == "max" || period <= 0) {
+    return std::nullopt;
+  }
+  try {
+    return std::stod(quota) / period;
+  } catch (...) {
+    return std::nullopt;
+  }
+}
+
+std::optional<double> ReadCgroupV1Quota() {
+  std::ifstream quota_in("/sys/fs/cgroup/cpu/cpu.cfs_quota_us");
+  std::ifstream period_in("/sys/fs/cgroup/cpu/cpu.cfs_period_us");
+  double quota = 0;
+  double period = 0;
+  if (!(quota_in >> quota) || !(period_in >> period) || quota <= 0 || period <= 0) {
+    return std::nullopt;
+  }
+  return quota / period;
+}
+
+std::optional<std::vector<uint32_t>> ReadCpuListFile(const char* path) {
+  std::ifstream in(path);
+  std::string list;
+  if (!std::getline(in, list)) {
+    return std::nullopt;
+  }
+  auto cpus = ParseCpuList(list);
+  if (cpus.empty()) {
+    return std::nullopt;
+  }
+  return cpus;
+}
+
+}  // namespace
+
+std::optional<double> CgroupCpuQuota() {
+  if (auto quota = ReadCgroupV2Quota()) {
+    return quota;
+  }
+  return ReadCgroupV1Quota();
+}
+
+size_t AvailableCpuCount() {
+  size_t cpus = std::max(1u, std::thread::hardware_concurrency());
+
+#ifdef __linux__
+  cpu_set_t mask;
+  CPU_ZERO(&mask);
+  if (sched_getaffinity(0, sizeof(mask), &mask) == 0) {
+    cpus = std::max(1, CPU_COUNT(&mask));
+  }
+#endif
+
+  if (auto quota = CgroupCpuQuota()) {
+    const auto quota_cpus = static_cast<size_t>(std::ceil(*quota));
+    FP_LOG_DEBUG_FMT("cgroup cpu quota {:.2f} CPUs (affinity allows {})", *quota, cpus);
+    cpus = std::min(cpus, std::max<size_t>(1, quota_cpus));
+  }
+
+  return cpus;
+}
+
+std::vector<uint32_t> ParseCpuList(const std::string& list) {
+  std::vector<uint32_t> cpus;
+  std::istringstream in(list);
+  std::string range;
+  while (std::getline(in, range, ',')) {
+    try {
+      const auto dash = range.find('-');
+      const unsigned long first = std::stoul(range.substr(0, dash));
+      const unsigned long last =
+          dash == std::string::npos ? first : std::stoul(range.substr(dash + 1));
+      for (unsigned long cpu = first; cpu <= last && cpu < kMaxCpus; ++cpu) {
+        cpus.push_back(static_cast<uint32_t>(cpu));
+      }
+    } catch (...) {
+      continue;
+    }
+  }
+  std::sort(cpus.begin(), cpus.end());
+  cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+  return cpus;
+}
+
+std::optional<std::vector<uint32_t>> CgroupCpuset() {
+  for (const char* path : {"/sys/fs/cgroup/cpuset.cpus.effective",
+                           "/sys/fs/cgroup/cpuset/cpuset.effective_cpus",
+                           "/sys/fs/cgroup/cpuset/cpuset.cpus"}) {
+    if (auto cpus = ReadCpuListFile(path)) {
+      return cpus;
+    }
+  }
+  return std::nullopt;
+}
+
+std::vector<uint32_t> UsableCpus() {
+  std::vector<uint32_t> cpus;
+#ifdef __linux__
+  cpu_set_t mask;
+  CPU_ZERO(&mask);
+  if (sched_getaffinity(0, sizeof(mask), &mask) == 0) {
+    for (uint32_t cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &mask)) {
+        cpus.push_back(cpu);
+      }
+    }
+  }
+#endif
+  if (cpus.empty()) {
+    for (uint32_t cpu = 0; cpu < std::max(1u, std::thread::hardware_concurrency()); ++cpu) {
+      cpus.push_back(cpu);
+    }
+  }
+
+  // The affinity mask normally reflects the cpuset already; intersect anyway
+  // in case the runtime was started with a wider mask than its cgroup.
+  if (auto cpuset = CgroupCpuset()) {
+    std::vector<uint32_t> allowed;
+    std::set_intersection(cpus.begin(), cpus.end(), cpuset->begin(), cpuset->end(),
+                          std::back_inserter(allowed));
+    if (!allowed.empty()) {
+      cpus = std::move(allowed);
+    }
+  }
+  return cpus;
+}
+
+}  // namespace flowpipe
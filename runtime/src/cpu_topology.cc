@@ -0,0 +1,330 @@
+#include "flowpipe/cpu_topology.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <numeric>
+#include <optional>
+#include <set>
+
+#include "flowpipe/cpu_resources.h"
+
+namespace flowpipe {
+
+namespace {
+
+namespace fs = std::filesystem;
+
+std::optional<std::string> ReadLine(const fs::path& path) {
+  std::ifstream in(path);
+  std::string line;
+  if (!std::getline(in, line)) {
+    return std::nullopt;
+  }
+  return line;
+}
+
+// Lowest CPU of a sysfs CPU list file, if readable.
+std::optional<uint32_t> FirstCpuOf(const fs::path& path) {
+  const auto line = ReadLine(path);
+  if (!line) {
+    return std::nullopt;
+  }
+  const auto cpus = ParseCpuList(*line);
+  if (cpus.empty()) {
+    return std::nullopt;
+  }
+  return cpus.front();
+}
+
+std::optional<uint32_t> ReadL3Domain(const fs::path& cpu_dir) {
+  std::error_code ec;
+  for (const auto& entry : fs::directory_iterator(cpu_dir / "cache", ec)) {
+    const auto name = entry.path().filename().string();
+    if (name.rfind("index", 0) != 0) {
+      continue;
+    }
+    if (ReadLine(entry.path() / "level").value_or("") == "3") {
+      return FirstCpuOf(entry.path() / "shared_cpu_list");
+    }
+  }
+  return std::nullopt;
+}
+
+std::optional<uint32_t> ReadNumaNode(const fs::path& cpu_dir) {
+  std::error_code ec;
+  for (const auto& entry : fs::directory_iterator(cpu_dir, ec)) {
+    const auto name = entry.path().filename().string();
+    if (name.size() > 4 && name.rfind("node", 0) == 0 &&
+        std::all_of(name.begin() + 4, name.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+      return static_cast<uint32_t>(std::stoul(name.substr(4)));
+    }
+  }
+  return std::nullopt;
+}
+
+}  // namespace
+
+// ------------------------------------------------------------
+// Topology
+// ------------------------------------------------------------
+CpuTopology::CpuTopology(std::vector<CpuInfo> cpus) : cpus_(std::move(cpus)) {
+  std::sort(cpus_.begin(), cpus_.end(),
+            [](const CpuInfo& a, const CpuInfo& b) { return a.cpu < b.cpu; });
+}
+
+CpuTopology CpuTopology::Detect(const std::vector<uint32_t>& cpus,
+                                const std::string& sysfs_cpu_root) {
+  std::vector<CpuInfo> infos;
+  infos.reserve(cpus.size());
+  for (const auto cpu : cpus) {
+    const fs::path dir = fs::path(sysfs_cpu_root) / ("cpu" + std::to_string(cpu));
+    CpuInfo info;
+    info.cpu = cpu;
+    info.core = FirstCpuOf(dir / "topology" / "thread_siblings_list").value_or(cpu);
+    // Without cache info, fall back to the package as the sharing domain.
+    info.l3 = ReadL3Domain(dir).value_or(
+        FirstCpuOf(dir / "topology" / "core_siblings_list").value_or(0));
+    info.numa_node = ReadNumaNode(dir).value_or(0);
+    infos.push_back(info);
+  }
+  return CpuTopology(std::move(infos));
+}
+
+const CpuInfo* CpuTopology::find(uint32_t cpu) const noexcept {
+  const auto it = std::lower_bound(cpus_.begin(), cpus_.end(), cpu,
+                                   [](const CpuInfo& info, uint32_t id) { return info.cpu < id; });
+  return it != cpus_.end() && it->cpu == cpu ? &*it : nullptr;
+}
+
+size_t CpuTopology::core_count() const {
+  std::set<uint32_t> cores;
+  for (const auto& info : cpus_) {
+    cores.insert(info.core);
+  }
+  return cores.size();
+}
+
+size_t CpuTopology::l3_count() const {
+  std::set<uint32_t> domains;
+  for (const auto& info : cpus_) {
+    domains.insert(info.l3);
+  }
+  return domains.size();
+}
+
+size_t CpuTopology::numa_node_count() const {
+  std::set<uint32_t> nodes;
+  for (const auto& info : cpus_) {
+    nodes.insert(info.numa_node);
+  }
+  return nodes.size();
+}
+
+// ------------------------------------------------------------
+// Placement
+// ------------------------------------------------------------
+namespace {
+
+struct Core {
+  std::vector<uint32_t> threads;  // sorted
+  size_t used = 0;                // threads handed out
+  bool exclusive = false;         // taken whole by a hot stage
+
+  size_t free() const noexcept {
+    return exclusive ? 0 : threads.size() - used;
+  }
+};
+
+struct Domain {
+  uint32_t numa_node = 0;
+  std::vector<Core> cores;
+
+  size_t free() const noexcept {
+    size_t total = 0;
+    for (const auto& core : cores) {
+      total += core.free();
+    }
+    return total;
+  }
+
+  std::vector<uint32_t> all_threads() const {
+    std::vector<uint32_t> cpus;
+    for (const auto& core : cores) {
+      cpus.insert(cpus.end(), core.threads.begin(), core.threads.end());
+    }
+    return cpus;
+  }
+};
+
+std::vector<Domain> BuildDomains(const CpuTopology& topology) {
+  std::map<uint32_t, std::map<uint32_t, Core>> by_l3;
+  std::map<uint32_t, uint32_t> l3_node;
+  for (const auto& info : topology.cpus()) {
+    by_l3[info.l3][info.core].threads.push_back(info.cpu);
+    l3_node.emplace(info.l3, info.numa_node);
+  }
+
+  std::vector<Domain> domains;
+  for (auto& [l3, cores] : by_l3) {
+    Domain domain;
+    domain.numa_node = l3_node[l3];
+    for (auto& [key, core] : cores) {
+      domain.cores.push_back(std::move(core));
+    }
+    domains.push_back(std::move(domain));
+  }
+  return domains;
+}
+
+size_t FindRoot(std::vector<size_t>& parent, size_t i) {
+  while (parent[i] != i) {
+    parent[i] = parent[parent[i]];
+    i = parent[i];
+  }
+  return i;
+}
+
+// One whole core per CPU; the siblings stay idle.
+void TakeWholeCores(Domain& domain, uint32_t wanted, std::vector<uint32_t>& cpus) {
+  for (auto& core : domain.cores) {
+    if (cpus.size() >= wanted) {
+      return;
+    }
+    if (core.used == 0 && !core.threads.empty()) {
+      cpus.push_back(core.threads.front());
+      core.used = 1;
+      core.exclusive = true;
+    }
+  }
+}
+
+// Single threads, filling half-used cores before opening new ones. Returns
+// true if a thread shared its core with another taken thread.
+bool TakeThreads(Domain& domain, uint32_t wanted, std::vector<uint32_t>& cpus) {
+  bool shared = false;
+  for (const bool partial : {true, false}) {
+    for (auto& core : domain.cores) {
+      if ((core.used > 0) != partial) {
+        continue;
+      }
+      while (cpus.size() < wanted && core.free() > 0) {
+        shared = shared || core.used > 0;
+        cpus.push_back(core.threads[core.used++]);
+      }
+    }
+  }
+  return shared;
+}
+
+// Last resort before oversubscribing: the idle siblings of hot cores.
+bool TakeIdleSiblings(Domain& domain, uint32_t wanted, std::vector<uint32_t>& cpus) {
+  bool taken = false;
+  for (auto& core : domain.cores) {
+    while (cpus.size() < wanted && core.exclusive && core.used < core.threads.size()) {
+      cpus.push_back(core.threads[core.used++]);
+      taken = true;
+    }
+  }
+  return taken;
+}
+
+}  // namespace
+
+std::vector<StagePlacement> PlanCpuPlacement(const CpuTopology& topology,
+                                             const std::vector<PlacementRequest>& stages,
+                                             const std::vector<std::pair<size_t, size_t>>& edges) {
+  std::vector<StagePlacement> plan(stages.size());
+  for (size_t i = 0; i < stages.size(); ++i) {
+    plan[i].stage = stages[i].stage;
+  }
+  auto domains = BuildDomains(topology);
+  if (domains.empty()) {
+    return plan;
+  }
+
+  // Connected stages form one group.
+  std::vector<size_t> parent(stages.size());
+  std::iota(parent.begin(), parent.end(), 0);
+  for (const auto& [producer, consumer] : edges) {
+    if (producer < stages.size() && consumer < stages.size()) {
+      parent[FindRoot(parent, producer)] = FindRoot(parent, consumer);
+    }
+  }
+  std::map<size_t, std::vector<size_t>> groups_by_root;
+  for (size_t i = 0; i < stages.size(); ++i) {
+    groups_by_root[FindRoot(parent, i)].push_back(i);
+  }
+
+  std::vector<std::vector<size_t>> groups;
+  for (auto& [root, members] : groups_by_root) {
+    // Hot stages pick their cores first.
+    std::stable_partition(members.begin(), members.end(),
+                          [&stages](size_t i) { return stages[i].hot; });
+    groups.push_back(std::move(members));
+  }
+  auto demand = [&stages](const std::vector<size_t>& group) {
+    uint64_t total = 0;
+    for (const auto i : group) {
+      total += stages[i].workers;
+    }
+    return total;
+  };
+  // Largest groups first, so they get the emptiest domains.
+  std::stable_sort(groups.begin(), groups.end(),
+                   [&](const auto& a, const auto& b) { return demand(a) > demand(b); });
+
+  for (const auto& group : groups) {
+    size_t home = 0;
+    for (size_t d = 1; d < domains.size(); ++d) {
+      if (domains[d].free() > domains[home].free()) {
+        home = d;
+      }
+    }
+
+    // Home domain, then the rest of its NUMA node, then remote nodes.
+    std::vector<size_t> order{home};
+    for (const bool same_node : {true, false}) {
+      for (size_t d = 0; d < domains.size(); ++d) {
+        if (d != home && (domains[d].numa_node == domains[home].numa_node) == same_node) {
+          order.push_back(d);
+        }
+      }
+    }
+
+    for (const auto i : group) {
+      const auto& request = stages[i];
+      auto& placement = plan[i];
+      const uint32_t wanted = std::max<uint32_t>(request.workers, 1);
+
+      if (request.hot) {
+        for (const auto d : order) {
+          TakeWholeCores(domains[d], wanted, placement.cpus);
+        }
+      }
+      for (const auto d : order) {
+        if (TakeThreads(domains[d], wanted, placement.cpus) && request.hot) {
+          placement.shares_smt = true;
+        }
+      }
+      for (const auto d : order) {
+        if (TakeIdleSiblings(domains[d], wanted, placement.cpus)) {
+          placement.shares_smt = true;
+        }
+      }
+
+      if (placement.cpus.size() < wanted) {
+        placement.oversubscribed = true;
+      }
+      if (placement.cpus.empty()) {
+        placement.cpus = domains[home].all_threads();
+      }
+      std::sort(placement.cpus.begin(), placement.cpus.end());
+    }
+  }
+
+  return plan;
+}
+
+}  // namespace flowpipe
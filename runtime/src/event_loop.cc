@@ -0,0 +1,177 @@
+#include "flowpipe/event_loop.h"
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "flowpipe/observability/logging_runtime.h"
+
+namespace flowpipe {
+
+#ifdef __linux__
+
+namespace {
+
+uint32_t ToEpollEvents(uint32_t events) noexcept {
+  uint32_t out = 0;
+  if (events & kIoReadable) {
+    out |= EPOLLIN;
+  }
+  if (events & kIoWritable) {
+    out |= EPOLLOUT;
+  }
+  return out;
+}
+
+uint32_t FromEpollEvents(uint32_t events) noexcept {
+  uint32_t out = 0;
+  if (events & EPOLLIN) {
+    out |= kIoReadable;
+  }
+  if (events & EPOLLOUT) {
+    out |= kIoWritable;
+  }
+  if (events & EPOLLERR) {
+    out |= kIoError;
+  }
+  if (events & EPOLLHUP) {
+    out |= kIoHangup;
+  }
+  return out;
+}
+
+}  // namespace
+
+EventLoop::EventLoop() {
+  epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+  if (epoll_fd_ < 0) {
+    FP_LOG_ERROR_FMT("epoll_create1 failed: {}", std::strerror(errno));
+    throw std::runtime_error("failed to create event loop");
+  }
+
+  wake_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (wake_fd_ < 0) {
+    FP_LOG_ERROR_FMT("eventfd failed: {}", std::strerror(errno));
+    close(epoll_fd_);
+    throw std::runtime_error("failed to create event loop wake fd");
+  }
+
+  epoll_event ev{};
+  ev.events = EPOLLIN;
+  ev.data.fd = wake_fd_;
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &ev) != 0) {
+    FP_LOG_ERROR_FMT("epoll_ctl(wake fd) failed: {}", std::strerror(errno));
+    close(wake_fd_);
+    close(epoll_fd_);
+    throw std::runtime_error("failed to register event loop wake fd");
+  }
+}
+
+EventLoop::~EventLoop() {
+  close(wake_fd_);
+  close(epoll_fd_);
+}
+
+void EventLoop::watch(int fd, uint32_t events, std::coroutine_handle<> waiter,
+                      uint32_t* revents) {
+  if (watches_.count(fd) > 0) {
+    throw std::runtime_error("fd " + std::to_string(fd) + " already has a waiter");
+  }
+
+  epoll_event ev{};
+  ev.events = ToEpollEvents(events) | EPOLLONESHOT;
+  ev.data.fd = fd;
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) != 0) {
+    throw std::runtime_error("epoll_ctl failed for fd " + std::to_string(fd) + ": " +
+                             std::strerror(errno));
+  }
+  watches_.emplace(fd, Watch{waiter, revents});
+}
+
+void EventLoop::resume_after(std::chrono::nanoseconds delay, std::coroutine_handle<> waiter) {
+  timers_.push(Timer{std::chrono::steady_clock::now() + delay, timer_seq_++, waiter});
+}
+
+void EventLoop::Wake() noexcept {
+  const uint64_t one = 1;
+  // EAGAIN means the counter is already non-zero: a wake-up is pending.
+  [[maybe_unused]] ssize_t written = write(wake_fd_, &one, sizeof(one));
+}
+
+void EventLoop::RunOnce(std::optional<std::chrono::milliseconds> timeout) {
+  int timeout_ms = timeout ? static_cast<int>(timeout->count()) : -1;
+  if (!timers_.empty()) {
+    const auto until_due = std::chrono::ceil<std::chrono::milliseconds>(
+        timers_.top().deadline - std::chrono::steady_clock::now());
+    const int due_ms = static_cast<int>(std::max<int64_t>(0, until_due.count()));
+    timeout_ms = timeout_ms < 0 ? due_ms : std::min(timeout_ms, due_ms);
+  }
+
+  std::array<epoll_event, 64> events;
+  const int n = epoll_wait(epoll_fd_, events.data(), static_cast<int>(events.size()), timeout_ms);
+  if (n < 0 && errno != EINTR) {
+    FP_LOG_ERROR_FMT("epoll_wait failed: {}", std::strerror(errno));
+    throw std::runtime_error("epoll_wait failed");
+  }
+
+  for (int i = 0; i < n; ++i) {
+    const int fd = events[i].data.fd;
+    if (fd == wake_fd_) {
+      uint64_t count = 0;
+      [[maybe_unused]] ssize_t read_bytes = read(wake_fd_, &count, sizeof(count));
+      continue;
+    }
+
+    auto it = watches_.find(fd);
+    if (it == watches_.end()) {
+      continue;
+    }
+    const Watch watch = it->second;
+    watches_.erase(it);
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+
+    *watch.revents = FromEpollEvents(events[i].events);
+    watch.waiter.resume();
+  }
+
+  ResumeDueTimers();
+}
+
+#else  // !__linux__
+
+EventLoop::EventLoop() {
+  FP_LOG_ERROR_FMT("async stages need the epoll event loop, which is only built on Linux");
+  throw std::runtime_error("event loop not supported on this platform");
+}
+
+EventLoop::~EventLoop() = default;
+
+void EventLoop::watch(int, uint32_t, std::coroutine_handle<>, uint32_t*) {}
+
+void EventLoop::resume_after(std::chrono::nanoseconds, std::coroutine_handle<>) {}
+
+void EventLoop::Wake() noexcept {}
+
+void EventLoop::RunOnce(std::optional<std::chrono::milliseconds>) {}
+
+#endif  // __linux__
+
+void EventLoop::ResumeDueTimers() {
+  const auto now = std::chrono::steady_clock::now();
+  while (!timers_.empty() && timers_.top().deadline <= now) {
+    auto waiter = timers_.top().waiter;
+    timers_.pop();
+    waiter.resume();
+  }
+}
+
+}  // namespace flowpipe
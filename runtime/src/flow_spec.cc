@@ -0,0 +1,172 @@
+#include "flowpipe/flow_spec.h"
+
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+#include <unordered_set>
+
+#include "flowpipe/observability/logging_runtime.h"
+
+namespace flowpipe {
+
+namespace {
+
+void ValidateStageQueues(const std::string& stage_name, const char* side,
+                         const std::optional<std::string>& single,
+                         const google::protobuf::RepeatedPtrField<std::string>& extra,
+                         const std::unordered_set<std::string>& queues) {
+  std::unordered_set<std::string> seen;
+  auto check = [&](const std::string& name) {
+    if (!queues.count(name)) {
+      FP_LOG_ERROR_FMT("stage '{}' references unknown queue '{}'", stage_name, name);
+      throw std::runtime_error("unknown queue '" + name + "' for stage: " + stage_name);
+    }
+    if (!seen.insert(name).second) {
+      FP_LOG_ERROR_FMT("stage '{}' lists {} queue '{}' more than once", stage_name, side, name);
+      throw std::runtime_error("duplicate " + std::string(side) + " queue for stage: " +
+                               stage_name);
+    }
+  };
+  if (single) {
+    check(*single);
+  }
+  for (const auto& name : extra) {
+    check(name);
+  }
+}
+
+// Moves the single-queue field to the front of the repeated list, which is
+// where the runtime puts it when resolving a stage's queues.
+void FoldQueue(std::string single, google::protobuf::RepeatedPtrField<std::string>* extra) {
+  extra->Add(std::move(single));
+  std::rotate(extra->begin(), extra->end() - 1, extra->end());
+}
+
+}  // namespace
+
+std::string StagePluginName(const flowpipe::v1::StageSpec& stage) {
+  // Explicit plugin wins, otherwise default to type-based naming.
+  return stage.has_plugin() ? stage.plugin() : "libstage_" + stage.type() + ".so";
+}
+
+void ValidateFlowSpec(const flowpipe::v1::FlowSpec& spec) {
+  std::unordered_set<std::string> queues;
+  for (const auto& q : spec.queues()) {
+    if (q.name().empty()) {
+      FP_LOG_ERROR("invalid queue: name is required");
+      throw std::runtime_error("queue name is required");
+    }
+    if (q.capacity() == 0) {
+      FP_LOG_ERROR_FMT("invalid queue '{}': capacity must be > 0", q.name());
+      throw std::runtime_error("queue capacity must be > 0: " + q.name());
+    }
+    if (q.has_schema() && q.schema().schema_id().empty()) {
+      FP_LOG_ERROR_FMT("invalid queue '{}': schema_id is required when schema is set", q.name());
+      throw std::runtime_error("queue schema_id is required: " + q.name());
+    }
+    if (q.type() != flowpipe::v1::QUEUE_TYPE_UNSPECIFIED &&
+        q.type() != flowpipe::v1::QUEUE_TYPE_IN_MEMORY) {
+      FP_LOG_ERROR_FMT("unsupported queue type {} for queue '{}'", static_cast<int>(q.type()),
+                       q.name());
+      throw std::runtime_error("unsupported queue type for queue: " + q.name());
+    }
+    if (!queues.insert(q.name()).second) {
+      FP_LOG_ERROR_FMT("duplicate queue name '{}'", q.name());
+      throw std::runtime_error("duplicate queue name: " + q.name());
+    }
+  }
+
+  std::unordered_set<std::string> stages;
+  for (const auto& s : spec.stages()) {
+    if (s.name().empty()) {
+      FP_LOG_ERROR("invalid stage: name is required");
+      throw std::runtime_error("stage name is required");
+    }
+    if (!stages.insert(s.name()).second) {
+      FP_LOG_ERROR_FMT("duplicate stage name '{}'", s.name());
+      throw std::runtime_error("duplicate stage name: " + s.name());
+    }
+    if (s.type().empty() && !s.has_plugin()) {
+      FP_LOG_ERROR_FMT("invalid stage '{}': type or plugin is required", s.name());
+      throw std::runtime_error("stage type or plugin is required: " + s.name());
+    }
+    if (s.threads() < 1) {
+      FP_LOG_ERROR_FMT("invalid stage '{}': threads must be >= 1", s.name());
+      throw std::runtime_error("stage threads must be >= 1: " + s.name());
+    }
+    ValidateStageQueues(
+        s.name(), "input",
+        s.has_input_queue() ? std::optional<std::string>(s.input_queue()) : std::nullopt,
+        s.input_queues(), queues);
+    ValidateStageQueues(
+        s.name(), "output",
+        s.has_output_queue() ? std::optional<std::string>(s.output_queue()) : std::nullopt,
+        s.output_queues(), queues);
+  }
+}
+
+void NormalizeFlowSpec(flowpipe::v1::FlowSpec* spec) {
+  for (auto& q : *spec->mutable_queues()) {
+    if (q.type() == flowpipe::v1::QUEUE_TYPE_UNSPECIFIED) {
+      q.set_type(flowpipe::v1::QUEUE_TYPE_IN_MEMORY);
+    }
+  }
+
+  for (auto& s : *spec->mutable_stages()) {
+    if (!s.has_plugin()) {
+      s.set_plugin(StagePluginName(s));
+    }
+    if (s.has_input_queue()) {
+      FoldQueue(s.input_queue(), s.mutable_input_queues());
+      s.clear_input_queue();
+    }
+    if (s.has_output_queue()) {
+      FoldQueue(s.output_queue(), s.mutable_output_queues());
+      s.clear_output_queue();
+    }
+  }
+}
+
+bool ReadFlowSpecBinary(const std::string& path, flowpipe::v1::FlowSpec* spec,
+                        std::string* error) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    *error = "failed to open " + path;
+    return false;
+  }
+  const std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  if (!spec->ParseFromString(bytes)) {
+    *error = "not a binary FlowSpec: " + path;
+    return false;
+  }
+  return true;
+}
+
+bool WriteFlowSpecBinary(const flowpipe::v1::FlowSpec& spec, const std::string& path,
+                         std::string* error) {
+  std::string bytes;
+  {
+    google::protobuf::io::StringOutputStream raw(&bytes);
+    google::protobuf::io::CodedOutputStream coded(&raw);
+    coded.SetSerializationDeterministic(true);
+    if (!spec.SerializeToCodedStream(&coded)) {
+      *error = "failed to serialize flow spec";
+      return false;
+    }
+  }
+
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  if (!out || !out.write(bytes.data(), static_cast<std::streamsize>(bytes.size())) ||
+      !out.flush()) {
+    *error = "failed to write " + path;
+    return false;
+  }
+  return true;
+}
+
+}  // namespace flowpipe
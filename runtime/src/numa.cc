@@ -0,0 +1,123 @@
+#include "flowpipe/numa.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <new>
+
+#ifdef __linux__
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "flowpipe/cpu_resources.h"
+#include "flowpipe/cpu_topology.h"
+#include "flowpipe/observability/logging_runtime.h"
+
+namespace flowpipe {
+
+namespace {
+
+#ifdef __linux__
+// Node masks passed to the kernel; large enough for any realistic host.
+constexpr unsigned long kMaxNodes = 1024;
+constexpr size_t kMaskWords = kMaxNodes / (8 * sizeof(unsigned long));
+
+struct NodeMask {
+  unsigned long words[kMaskWords] = {};
+
+  explicit NodeMask(uint32_t node) {
+    words[node / (8 * sizeof(unsigned long))] = 1UL << (node % (8 * sizeof(unsigned long)));
+  }
+};
+#endif
+
+}  // namespace
+
+uint32_t NumaNodeCount(const std::string& sysfs_node_root) {
+  std::ifstream in(std::filesystem::path(sysfs_node_root) / "possible");
+  std::string list;
+  if (!std::getline(in, list)) {
+    return 1;
+  }
+  const auto nodes = ParseCpuList(list);
+  return nodes.empty() ? 1 : nodes.back() + 1;
+}
+
+std::vector<uint32_t> NumaNodeCpus(uint32_t node, const std::string& sysfs_node_root) {
+  std::ifstream in(std::filesystem::path(sysfs_node_root) / ("node" + std::to_string(node)) /
+                   "cpulist");
+  std::string list;
+  if (!std::getline(in, list)) {
+    return {};
+  }
+  return ParseCpuList(list);
+}
+
+std::optional<uint32_t> NumaNodeOfCpus(const std::vector<uint32_t>& cpus) {
+  if (cpus.empty()) {
+    return std::nullopt;
+  }
+  const auto topology = CpuTopology::Detect(cpus);
+  if (topology.numa_node_count() != 1) {
+    return std::nullopt;
+  }
+  return topology.cpus().front().numa_node;
+}
+
+bool PreferThreadMemoryNode(uint32_t node) {
+#ifdef __linux__
+  if (node >= kMaxNodes) {
+    return false;
+  }
+  const NodeMask mask(node);
+  return syscall(SYS_set_mempolicy, MPOL_PREFERRED, mask.words, kMaxNodes) == 0;
+#else
+  (void)node;
+  return false;
+#endif
+}
+
+void* NumaMemoryResource::do_allocate(size_t bytes, size_t alignment) {
+#ifdef __linux__
+  const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  if (alignment > page) {
+    throw std::bad_alloc();
+  }
+  const size_t length = std::max<size_t>((bytes + page - 1) / page * page, page);
+  void* p = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED) {
+    throw std::bad_alloc();
+  }
+  if (node_ < kMaxNodes) {
+    const NodeMask mask(node_);
+    if (syscall(SYS_mbind, p, length, MPOL_PREFERRED, mask.words, kMaxNodes, 0) != 0) {
+      FP_LOG_DEBUG_FMT("mbind to NUMA node {} failed; memory stays unbound", node_);
+    }
+  }
+  return p;
+#else
+  (void)alignment;
+  return ::operator new(bytes);
+#endif
+}
+
+void NumaMemoryResource::do_deallocate(void* p, size_t bytes, size_t alignment) {
+#ifdef __linux__
+  (void)alignment;
+  const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  munmap(p, std::max<size_t>((bytes + page - 1) / page * page, page));
+#else
+  (void)bytes;
+  (void)alignment;
+  ::operator delete(p);
+#endif
+}
+
+bool NumaMemoryResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+  return this == &other;
+}
+
+}  // namespace flowpipe
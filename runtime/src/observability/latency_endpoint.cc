@@ -0,0 +1,150 @@
+#include "flowpipe/observability/latency_endpoint.h"
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <iterator>
+
+#include <fmt/format.h>
+
+#include "flowpipe/internal/socket_util.h"
+#include "flowpipe/observability/logging_runtime.h"
+
+namespace flowpipe::observability {
+
+namespace {
+
+void AppendLine(std::string& out, const char* kind, const MetricLabels& labels,
+                const HistogramSnapshot& histogram) {
+  if (histogram.count == 0) {
+    return;
+  }
+  auto it = std::back_inserter(out);
+  fmt::format_to(it, "{}", kind);
+  for (const auto& [key, value] : labels) {
+    fmt::format_to(it, " {}={}", key, value);
+  }
+  fmt::format_to(it, " count={} mean={} p50={} p90={} p99={} p999={} max={}\n", histogram.count,
+                 histogram.sum / histogram.count, histogram.ValueAtQuantile(0.5),
+                 histogram.ValueAtQuantile(0.9), histogram.ValueAtQuantile(0.99),
+                 histogram.ValueAtQuantile(0.999), histogram.Max());
+}
+
+}  // namespace
+
+std::string FormatLatencyReport(const std::vector<StageTotals>& stages,
+                                const std::vector<QueueTotals>& queues) {
+  std::string out = "# flowpipe latency snapshot (ns)\n";
+  for (const auto& s : stages) {
+    AppendLine(out, "stage_latency", s.labels, s.latency);
+  }
+  for (const auto& q : queues) {
+    AppendLine(out, "queue_dwell", q.labels, q.dwell);
+  }
+  for (const auto& s : stages) {
+    AppendLine(out, "end_to_end", s.labels, s.end_to_end);
+  }
+  return out;
+}
+
+std::string LatencyReport() {
+  auto& metrics = RuntimeMetrics::Get();
+  // Collect under the registry lock, format outside it.
+  const auto stages = metrics.CollectStages();
+  const auto queues = metrics.CollectQueues();
+  return FormatLatencyReport(stages, queues);
+}
+
+LatencyEndpoint::~LatencyEndpoint() {
+  Stop();
+}
+
+bool LatencyEndpoint::Start(const std::string& path) {
+  Stop();
+
+  sockaddr_un addr{};
+  addr.sun_family = AF_UNIX;
+  if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+    FP_LOG_WARN_FMT("histogram socket: invalid path '{}'", path);
+    return false;
+  }
+  std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+
+  // A socket left behind by an earlier run would make bind() fail.
+  struct stat st {};
+  if (lstat(path.c_str(), &st) == 0 && S_ISSOCK(st.st_mode)) {
+    unlink(path.c_str());
+  }
+
+  listen_fd_ = detail::OpenStreamSocket(AF_UNIX);
+  if (listen_fd_ < 0 || bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+      listen(listen_fd_, 8) != 0 || pipe(wake_pipe_) != 0) {
+    FP_LOG_WARN_FMT("histogram socket: cannot listen on '{}': {}", path, std::strerror(errno));
+    Stop();
+    return false;
+  }
+  detail::SetCloseOnExec(wake_pipe_[0]);
+  detail::SetCloseOnExec(wake_pipe_[1]);
+
+  path_ = path;
+  thread_ = std::thread([this] { Serve(); });
+  FP_LOG_INFO_FMT("histogram socket: serving latency snapshots on '{}'", path_);
+  return true;
+}
+
+void LatencyEndpoint::Stop() {
+  if (thread_.joinable()) {
+    const char byte = 0;
+    [[maybe_unused]] const auto n = write(wake_pipe_[1], &byte, 1);
+    thread_.join();
+  }
+  for (int* fd : {&listen_fd_, &wake_pipe_[0], &wake_pipe_[1]}) {
+    if (*fd >= 0) {
+      close(*fd);
+      *fd = -1;
+    }
+  }
+  if (!path_.empty()) {
+    unlink(path_.c_str());
+    path_.clear();
+  }
+}
+
+void LatencyEndpoint::Serve() {
+  pollfd fds[2] = {{listen_fd_, POLLIN, 0}, {wake_pipe_[0], POLLIN, 0}};
+  while (true) {
+    if (poll(fds, 2, -1) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      FP_LOG_WARN_FMT("histogram socket: poll failed: {}", std::strerror(errno));
+      return;
+    }
+    if (fds[1].revents != 0) {
+      return;
+    }
+    if ((fds[0].revents & POLLIN) == 0) {
+      continue;
+    }
+
+    const int client = detail::AcceptClient(listen_fd_);
+    if (client < 0) {
+      continue;
+    }
+    // A client that stops reading only stalls this thread, and not for long.
+    const timeval send_timeout{1, 0};
+    setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &send_timeout, sizeof(send_timeout));
+    if (!detail::SendAll(client, LatencyReport())) {
+      FP_LOG_DEBUG_FMT("histogram socket: client went away: {}", std::strerror(errno));
+    }
+    close(client);
+  }
+}
+
+}  // namespace flowpipe::observability
@@ -1,5 +1,7 @@
 #include "flowpipe/observability/local_logging.h"
 
+#include "flowpipe/observability/logging.h"
+
 #include <spdlog/sinks/stdout_color_sinks.h>
 #include <spdlog/spdlog.h>
 
@@ -15,8 +17,9 @@ void InitLocalLogging(bool debug) {
   // Timestamp + level + message
   logger->set_pattern("[%Y-%m-%d %H:%M:%S.%e] [%^%l%$] %v");
 
-  // Set verbosity
+  // Set verbosity; the FP_LOG_* macros skip disabled levels up front
   logger->set_level(debug ? spdlog::level::debug : spdlog::level::info);
+  SetLogLevel(debug ? LogLevel::Debug : LogLevel::Info);
 
   // Make this the default logger
   spdlog::set_default_logger(logger);
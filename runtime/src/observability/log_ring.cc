@@ -0,0 +1,60 @@
+#include "flowpipe/observability/log_ring.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace flowpipe::observability {
+
+LogRing::LogRing(size_t capacity)
+    : mask_(std::bit_ceil(std::max<size_t>(capacity, 2)) - 1),
+      slots_(std::make_unique<Slot[]>(mask_ + 1)) {
+  for (size_t i = 0; i <= mask_; ++i) {
+    slots_[i].seq.store(i, std::memory_order_relaxed);
+  }
+}
+
+bool LogRing::TryPush(LogLevel level, std::string_view message, const char* file, int line,
+                      std::chrono::system_clock::time_point time) {
+  // Allocate before claiming a slot, so the claimed slot is published
+  // promptly and the consumer is never held up by the allocator.
+  std::unique_ptr<char[]> overflow;
+  if (message.size() > LogRecord::kInlineBytes) {
+    overflow = std::make_unique_for_overwrite<char[]>(message.size());
+  }
+
+  uint64_t pos = head_.load(std::memory_order_relaxed);
+  Slot* slot = nullptr;
+  while (true) {
+    slot = &slots_[pos & mask_];
+    const uint64_t seq = slot->seq.load(std::memory_order_acquire);
+    const auto diff = static_cast<int64_t>(seq - pos);
+    if (diff == 0) {
+      if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    } else {
+      pos = head_.load(std::memory_order_relaxed);
+    }
+  }
+
+  LogRecord& record = slot->record;
+  record.time = time;
+  record.file = file;
+  record.line = line;
+  record.level = level;
+  record.size = static_cast<uint32_t>(message.size());
+  if (overflow) {
+    std::memcpy(overflow.get(), message.data(), message.size());
+    record.overflow = std::move(overflow);
+  } else {
+    std::memcpy(record.inline_text, message.data(), message.size());
+  }
+  slot->seq.store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+}  // namespace flowpipe::observability
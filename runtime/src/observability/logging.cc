@@ -1,8 +1,21 @@
 #include "flowpipe/observability/logging.h"
 
+#include <chrono>
+#include <condition_variable>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+#include <fmt/format.h>
+
 // Local logging (spdlog)
 #include <spdlog/spdlog.h>
 
+#include "flowpipe/observability/log_ring.h"
+#include "flowpipe/observability/logging_runtime.h"
+
 #if FLOWPIPE_ENABLE_OTEL
 
 // ---- OpenTelemetry: Logs (API)
@@ -13,17 +26,28 @@
 
 // ---- OpenTelemetry: Common
 #include <opentelemetry/common/attribute_value.h>
+#include <opentelemetry/common/timestamp.h>
 
 #endif  // FLOWPIPE_ENABLE_OTEL
 
 namespace flowpipe::observability {
 
+namespace detail {
+std::atomic<uint8_t> g_min_log_level{static_cast<uint8_t>(LogLevel::Info)};
+}  // namespace detail
+
+namespace {
+
+// How long the drain thread sleeps when the ring is empty. Producers never
+// wake it, so this bounds how late an async record shows up.
+constexpr auto kDrainInterval = std::chrono::milliseconds(10);
+
 #if FLOWPIPE_ENABLE_OTEL
 
 // ------------------------------------------------------------
 // Severity mapping (runtime → OTEL)
 // ------------------------------------------------------------
-static opentelemetry::logs::Severity ToOtelSeverity(LogLevel level) {
+opentelemetry::logs::Severity ToOtelSeverity(LogLevel level) {
   using S = opentelemetry::logs::Severity;
   switch (level) {
     case LogLevel::Debug:
@@ -40,59 +64,234 @@ static opentelemetry::logs::Severity ToOtelSeverity(LogLevel level) {
   return S::kInfo;
 }
 
+using OtelLogger = opentelemetry::nostd::shared_ptr<opentelemetry::logs::Logger>;
+
+OtelLogger GetOtelLogger() {
+  auto provider = opentelemetry::logs::Provider::GetLoggerProvider();
+  if (!provider) {
+    return {};
+  }
+  return provider->GetLogger("flowpipe.runtime");
+}
+
 #endif  // FLOWPIPE_ENABLE_OTEL
 
-// ------------------------------------------------------------
-// Emit log record (runtime fan-out point)
-// ------------------------------------------------------------
-void Log(LogLevel level, const std::string& message, const char* file, int line) {
-  // ----------------------------------------------------------
-  // 1) Local logging (always on)
-  // ----------------------------------------------------------
+spdlog::level::level_enum ToSpdlogLevel(LogLevel level) {
   switch (level) {
     case LogLevel::Debug:
-      spdlog::debug(message);
-      break;
+      return spdlog::level::debug;
     case LogLevel::Info:
-      spdlog::info(message);
-      break;
+      return spdlog::level::info;
     case LogLevel::Warn:
-      spdlog::warn(message);
-      break;
+      return spdlog::level::warn;
     case LogLevel::Error:
-      spdlog::error(message);
-      break;
+      return spdlog::level::err;
     case LogLevel::Fatal:
-      spdlog::critical(message);
-      break;
+      return spdlog::level::critical;
   }
+  return spdlog::level::info;
+}
 
+// ------------------------------------------------------------
+// Writers
+// ------------------------------------------------------------
+// Destinations resolved once per batch of records rather than per record.
+struct Writers {
+  std::shared_ptr<spdlog::logger> local = spdlog::default_logger();
 #if FLOWPIPE_ENABLE_OTEL
-  // ----------------------------------------------------------
-  // 2) OTEL logging (optional)
-  // ----------------------------------------------------------
-  auto provider = opentelemetry::logs::Provider::GetLoggerProvider();
-  if (!provider)
-    return;
+  OtelLogger otel = GetOtelLogger();
+#endif
 
-  auto logger = provider->GetLogger("flowpipe.runtime");
-  if (!logger)
-    return;
+  void Write(LogLevel level, std::string_view message, const char* file, int line,
+             std::chrono::system_clock::time_point time) const {
+    // ----------------------------------------------------------
+    // 1) Local logging (always on)
+    // ----------------------------------------------------------
+    if (local) {
+      local->log(time, spdlog::source_loc{}, ToSpdlogLevel(level),
+                 spdlog::string_view_t(message.data(), message.size()));
+    }
 
-  auto record = logger->CreateLogRecord();
-  if (!record)
-    return;
+#if FLOWPIPE_ENABLE_OTEL
+    // ----------------------------------------------------------
+    // 2) OTEL logging (optional)
+    // ----------------------------------------------------------
+    if (!otel) {
+      return;
+    }
 
-  using opentelemetry::common::AttributeValue;
+    auto record = otel->CreateLogRecord();
+    if (!record) {
+      return;
+    }
 
-  // __FILE__ is always non-null and __LINE__ is always > 0 at macro call sites,
-  // so both attributes are unconditionally available.
-  logger->EmitLogRecord(std::move(record), ToOtelSeverity(level), message,
+    using opentelemetry::common::AttributeValue;
+
+    // __FILE__ is always non-null and __LINE__ is always > 0 at macro call
+    // sites; direct Log() calls may omit them.
+    otel->EmitLogRecord(std::move(record), ToOtelSeverity(level),
+                        opentelemetry::nostd::string_view(message.data(), message.size()),
+                        opentelemetry::common::SystemTimestamp(time),
                         std::initializer_list<std::pair<std::string, AttributeValue>>{
-                            {"code.filepath", AttributeValue{file}},
+                            {"code.filepath", AttributeValue{file ? file : ""}},
                             {"code.lineno", AttributeValue{line}},
                         });
+#else
+    (void)file;
+    (void)line;
 #endif  // FLOWPIPE_ENABLE_OTEL
+  }
+};
+
+// ------------------------------------------------------------
+// Async state
+// ------------------------------------------------------------
+struct AsyncLogging {
+  // Allocated once and never freed before exit: a producer may still hold
+  // the pointer while async logging is being stopped.
+  std::unique_ptr<LogRing> owned;
+  std::atomic<LogRing*> ring{nullptr};
+  std::atomic<LogRing*> active{nullptr};  // ring while async logging is on
+
+  std::mutex drain_mutex;  // one consumer at a time
+  uint64_t reported_drops = 0;
+
+  std::mutex wake_mutex;
+  std::condition_variable wake;
+  bool stop = false;
+  std::thread drainer;
+
+  // Touch spdlog's registry first so it is destroyed after us and the
+  // final flush at exit still has a logger.
+  AsyncLogging() {
+    spdlog::default_logger_raw();
+  }
+
+  ~AsyncLogging() {
+    StopAsyncLogging();
+  }
+};
+
+AsyncLogging& Async() {
+  static AsyncLogging async;
+  return async;
+}
+
+// Writes every queued record. Caller holds drain_mutex.
+void DrainLocked(AsyncLogging& async) {
+  LogRing* ring = async.ring.load(std::memory_order_acquire);
+  if (ring == nullptr) {
+    return;
+  }
+
+  std::optional<Writers> writers;  // resolved only if there is work
+  ring->Drain([&writers](const LogRecord& r) {
+    if (!writers) {
+      writers.emplace();
+    }
+    writers->Write(r.level, r.text(), r.file, r.line, r.time);
+  });
+
+  const uint64_t dropped = ring->dropped();
+  if (dropped != async.reported_drops) {
+    if (!writers) {
+      writers.emplace();
+    }
+    writers->Write(LogLevel::Warn,
+                  fmt::format("log ring full: dropped {} records ({} in total)",
+                              dropped - async.reported_drops, dropped),
+                  __FILE__, __LINE__, std::chrono::system_clock::now());
+    async.reported_drops = dropped;
+  }
+}
+
+void DrainLoop(AsyncLogging& async) {
+  std::unique_lock<std::mutex> lock(async.wake_mutex);
+  while (!async.stop) {
+    lock.unlock();
+    {
+      std::lock_guard<std::mutex> drain(async.drain_mutex);
+      DrainLocked(async);
+    }
+    lock.lock();
+    async.wake.wait_for(lock, kDrainInterval, [&] { return async.stop; });
+  }
+}
+
+}  // namespace
+
+void SetLogLevel(LogLevel min_level) noexcept {
+  detail::g_min_log_level.store(static_cast<uint8_t>(min_level), std::memory_order_relaxed);
+}
+
+// ------------------------------------------------------------
+// Emit log record (runtime fan-out point)
+// ------------------------------------------------------------
+void Log(LogLevel level, std::string_view message, const char* file, int line) {
+  const auto now = std::chrono::system_clock::now();
+
+  if (LogRing* ring = Async().active.load(std::memory_order_acquire)) {
+    ring->TryPush(level, message, file, line, now);
+    // A fatal record is likely the last one; don't leave it in the ring.
+    if (level == LogLevel::Fatal) {
+      FlushLogs();
+    }
+    return;
+  }
+
+  Writers{}.Write(level, message, file, line, now);
+}
+
+void VLogFmt(LogLevel level, const char* file, int line, fmt::string_view fmt_str,
+             fmt::format_args args) {
+  fmt::memory_buffer buffer;
+  fmt::vformat_to(std::back_inserter(buffer), fmt_str, args);
+  Log(level, std::string_view(buffer.data(), buffer.size()), file, line);
+}
+
+void StartAsyncLogging(size_t ring_size) {
+  auto& async = Async();
+  std::lock_guard<std::mutex> drain(async.drain_mutex);
+  if (async.active.load(std::memory_order_relaxed) != nullptr) {
+    return;
+  }
+  if (!async.owned) {
+    async.owned = std::make_unique<LogRing>(ring_size);
+    async.ring.store(async.owned.get(), std::memory_order_release);
+  }
+  {
+    std::lock_guard<std::mutex> lock(async.wake_mutex);
+    async.stop = false;
+  }
+  async.drainer = std::thread(DrainLoop, std::ref(async));
+  async.active.store(async.owned.get(), std::memory_order_release);
+}
+
+void FlushLogs() {
+  auto& async = Async();
+  std::lock_guard<std::mutex> drain(async.drain_mutex);
+  DrainLocked(async);
+}
+
+void StopAsyncLogging() {
+  auto& async = Async();
+  if (async.active.exchange(nullptr, std::memory_order_acq_rel) == nullptr) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(async.wake_mutex);
+    async.stop = true;
+  }
+  async.wake.notify_all();
+  if (async.drainer.joinable()) {
+    async.drainer.join();
+  }
+  FlushLogs();
+}
+
+uint64_t DroppedLogRecords() noexcept {
+  const LogRing* ring = Async().ring.load(std::memory_order_acquire);
+  return ring ? ring->dropped() : 0;
 }
 
 }  // namespace flowpipe::observability
@@ -6,7 +6,11 @@
 
 #include <chrono>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
+
+#include "flowpipe/observability/runtime_metrics.h"
 
 // jemalloc
 #include <jemalloc/jemalloc.h>
@@ -47,6 +51,246 @@ static uint64_t JemallocStat(const char* name) {
   return value;
 }
 
+// ------------------------------------------------------------
+// Runtime metric folding
+// ------------------------------------------------------------
+using Int64Observer =
+    opentelemetry::nostd::shared_ptr<opentelemetry::metrics::ObserverResultT<int64_t>>;
+
+static Int64Observer AsInt64(opentelemetry::metrics::ObserverResult& observer) {
+  return opentelemetry::nostd::get<Int64Observer>(observer);
+}
+
+// Emits a folded histogram as cumulative `le` buckets plus a `+Inf` bucket,
+// the shape Prometheus uses for classic histograms.
+static void ObserveBuckets(const Int64Observer& observer, const MetricLabels& labels,
+                           const HistogramSnapshot& histogram) {
+  MetricLabels bucket_labels = labels;
+  bucket_labels.emplace_back("le", "");
+  std::string& le = bucket_labels.back().second;
+
+  for (const auto& [bound, cumulative] : histogram.CumulativeOctaves()) {
+    le = std::to_string(bound);
+    observer->Observe(static_cast<int64_t>(cumulative), bucket_labels);
+  }
+  le = "+Inf";
+  observer->Observe(static_cast<int64_t>(histogram.count), bucket_labels);
+}
+
+// Stage and queue totals shared by the runtime instruments. The metric
+// reader runs each instrument's callback once per collection: the first
+// callback of a collection folds the shards, the rest reuse that fold.
+class CollectionSnapshot {
+ public:
+  // Number of callbacks that read each fold.
+  void SetReaders(size_t readers) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    readers_ = readers;
+    pending_ = 0;
+  }
+
+  template <typename Fn>
+  void Read(Fn&& fn) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (pending_ == 0) {
+      auto& metrics = RuntimeMetrics::Get();
+      stages_ = metrics.stages_enabled() ? metrics.CollectStages() : std::vector<StageTotals>{};
+      queues_ = metrics.queues_enabled() ? metrics.CollectQueues() : std::vector<QueueTotals>{};
+      pending_ = readers_;
+    }
+    if (pending_ > 0) {
+      --pending_;
+    }
+    fn(stages_, queues_);
+  }
+
+ private:
+  std::mutex mutex_;
+  size_t readers_ = 0;
+  size_t pending_ = 0;
+  std::vector<StageTotals> stages_;
+  std::vector<QueueTotals> queues_;
+};
+
+static CollectionSnapshot& RuntimeSnapshot() {
+  static CollectionSnapshot snapshot;
+  return snapshot;
+}
+
+using InstrumentPtr =
+    opentelemetry::nostd::shared_ptr<opentelemetry::metrics::ObservableInstrument>;
+
+// Registers a callback that passes every stage series of the collection's
+// snapshot to `Observe`, a captureless lambda taking (out, totals).
+template <typename Observe>
+static void ObserveStages(const InstrumentPtr& instrument, Observe) {
+  instrument->AddCallback(
+      [](opentelemetry::metrics::ObserverResult observer, void* state) {
+        auto out = AsInt64(observer);
+        static_cast<CollectionSnapshot*>(state)->Read(
+            [&out](const std::vector<StageTotals>& stages, const std::vector<QueueTotals>&) {
+              for (const auto& s : stages) {
+                Observe{}(out, s);
+              }
+            });
+      },
+      &RuntimeSnapshot());
+}
+
+// Same, for every queue series.
+template <typename Observe>
+static void ObserveQueues(const InstrumentPtr& instrument, Observe) {
+  instrument->AddCallback(
+      [](opentelemetry::metrics::ObserverResult observer, void* state) {
+        auto out = AsInt64(observer);
+        static_cast<CollectionSnapshot*>(state)->Read(
+            [&out](const std::vector<StageTotals>&, const std::vector<QueueTotals>& queues) {
+              for (const auto& q : queues) {
+                Observe{}(out, q);
+              }
+            });
+      },
+      &RuntimeSnapshot());
+}
+
+static void RegisterRuntimeInstruments(opentelemetry::metrics::Meter& meter, OtelState& state) {
+  auto& instruments = state.runtime_instruments;
+
+  if (state.stage_metrics_enabled) {
+    auto processed = meter.CreateInt64ObservableCounter("flowpipe.stage.process.count",
+                                                        "Number of stage invocations");
+    ObserveStages(processed, [](const Int64Observer& out, const StageTotals& s) {
+      out->Observe(static_cast<int64_t>(s.processed), s.labels);
+    });
+
+    auto errors =
+        meter.CreateInt64ObservableCounter("flowpipe.stage.errors", "Number of stage errors");
+    ObserveStages(errors, [](const Int64Observer& out, const StageTotals& s) {
+      out->Observe(static_cast<int64_t>(s.errors), s.labels);
+    });
+
+    auto workers = meter.CreateInt64ObservableGauge("flowpipe.stage.workers",
+                                                    "Running workers of autoscaled stages");
+    ObserveStages(workers, [](const Int64Observer& out, const StageTotals& s) {
+      if (s.autoscaled()) {
+        out->Observe(static_cast<int64_t>(s.workers()), s.labels);
+      }
+    });
+
+    auto decisions = meter.CreateInt64ObservableCounter("flowpipe.stage.scaling.decisions",
+                                                        "Number of autoscaler decisions");
+    ObserveStages(decisions, [](const Int64Observer& out, const StageTotals& s) {
+      if (!s.autoscaled()) {
+        return;
+      }
+      MetricLabels labels = s.labels;
+      labels.emplace_back("direction", "up");
+      out->Observe(static_cast<int64_t>(s.scale_ups), labels);
+      labels.back().second = "down";
+      out->Observe(static_cast<int64_t>(s.scale_downs), labels);
+    });
+
+    auto cpus = meter.CreateInt64ObservableGauge("flowpipe.stage.cpu.assigned",
+                                                 "CPUs assigned to stages by automatic placement");
+    ObserveStages(cpus, [](const Int64Observer& out, const StageTotals& s) {
+      for (const auto& cpu : s.cpus) {
+        MetricLabels labels = s.labels;
+        labels.emplace_back("cpu", std::to_string(cpu.cpu));
+        labels.emplace_back("l3", std::to_string(cpu.l3));
+        labels.emplace_back("numa_node", std::to_string(cpu.numa_node));
+        out->Observe(1, labels);
+      }
+    });
+
+    instruments.insert(instruments.end(), {processed, errors, workers, decisions, cpus});
+
+    if (state.latency_histograms) {
+      auto buckets = meter.CreateInt64ObservableCounter(
+          "flowpipe.stage.latency_ns.bucket", "Stage processing latency (ns), cumulative buckets");
+      ObserveStages(buckets, [](const Int64Observer& out, const StageTotals& s) {
+        ObserveBuckets(out, s.labels, s.latency);
+      });
+
+      auto sum = meter.CreateInt64ObservableCounter("flowpipe.stage.latency_ns.sum",
+                                                    "Total stage processing latency (ns)");
+      ObserveStages(sum, [](const Int64Observer& out, const StageTotals& s) {
+        out->Observe(static_cast<int64_t>(s.latency.sum), s.labels);
+      });
+
+      auto e2e_buckets = meter.CreateInt64ObservableCounter(
+          "flowpipe.record.end_to_end_ns.bucket",
+          "Time from flow entry to sink completion (ns), cumulative buckets");
+      ObserveStages(e2e_buckets, [](const Int64Observer& out, const StageTotals& s) {
+        if (s.end_to_end.count > 0) {
+          ObserveBuckets(out, s.labels, s.end_to_end);
+        }
+      });
+
+      auto e2e_sum = meter.CreateInt64ObservableCounter(
+          "flowpipe.record.end_to_end_ns.sum", "Total flow entry to sink completion time (ns)");
+      ObserveStages(e2e_sum, [](const Int64Observer& out, const StageTotals& s) {
+        if (s.end_to_end.count > 0) {
+          out->Observe(static_cast<int64_t>(s.end_to_end.sum), s.labels);
+        }
+      });
+
+      instruments.insert(instruments.end(), {buckets, sum, e2e_buckets, e2e_sum});
+    }
+  }
+
+  if (state.queue_metrics_enabled) {
+    auto enqueued = meter.CreateInt64ObservableCounter("flowpipe.queue.enqueue.count",
+                                                       "Number of records enqueued to queue");
+    ObserveQueues(enqueued, [](const Int64Observer& out, const QueueTotals& q) {
+      out->Observe(static_cast<int64_t>(q.enqueued), q.labels);
+    });
+
+    auto dequeued = meter.CreateInt64ObservableCounter("flowpipe.queue.dequeue.count",
+                                                       "Number of records dequeued from queue");
+    ObserveQueues(dequeued, [](const Int64Observer& out, const QueueTotals& q) {
+      out->Observe(static_cast<int64_t>(q.dequeued), q.labels);
+    });
+
+    auto hops = meter.CreateInt64ObservableCounter(
+        "flowpipe.queue.cross_node.count",
+        "Records dequeued on a different NUMA node than they were produced on");
+    ObserveQueues(hops, [](const Int64Observer& out, const QueueTotals& q) {
+      if (q.cross_node > 0) {
+        out->Observe(static_cast<int64_t>(q.cross_node), q.labels);
+      }
+    });
+
+    auto bytes = meter.CreateInt64ObservableCounter("flowpipe.queue.cross_node.bytes",
+                                                    "Payload bytes read across NUMA nodes");
+    ObserveQueues(bytes, [](const Int64Observer& out, const QueueTotals& q) {
+      if (q.cross_node > 0) {
+        out->Observe(static_cast<int64_t>(q.cross_node_bytes), q.labels);
+      }
+    });
+
+    instruments.insert(instruments.end(), {enqueued, dequeued, hops, bytes});
+
+    if (state.latency_histograms) {
+      auto buckets = meter.CreateInt64ObservableCounter(
+          "flowpipe.queue.dwell_ns.bucket", "Time records spent in queue (ns), cumulative buckets");
+      ObserveQueues(buckets, [](const Int64Observer& out, const QueueTotals& q) {
+        ObserveBuckets(out, q.labels, q.dwell);
+      });
+
+      auto sum = meter.CreateInt64ObservableCounter("flowpipe.queue.dwell_ns.sum",
+                                                    "Total time records spent in queue (ns)");
+      ObserveQueues(sum, [](const Int64Observer& out, const QueueTotals& q) {
+        out->Observe(static_cast<int64_t>(q.dwell.sum), q.labels);
+      });
+
+      instruments.insert(instruments.end(), {buckets, sum});
+    }
+  }
+
+  // Every instrument above reads the snapshot once per collection.
+  RuntimeSnapshot().SetReaders(instruments.size());
+}
+
 // ------------------------------------------------------------
 // Periodic metric reader option mapping
 // ------------------------------------------------------------
@@ -153,6 +397,13 @@ void InitMetrics(const flowpipe::v1::ObservabilityConfig* cfg, const GlobalDefau
 
   opentelemetry::metrics::Provider::SetMeterProvider(api_provider);
 
+  // ----------------------------------------------------------
+  // Stage and queue metrics (sharded, folded on collection)
+  // ----------------------------------------------------------
+  RuntimeMetrics::Get().Configure(state.stage_metrics_enabled, state.queue_metrics_enabled,
+                                  state.latency_histograms);
+  RegisterRuntimeInstruments(*api_provider->GetMeter("flowpipe.runtime", "1.0.0"), state);
+
   // ----------------------------------------------------------
   // jemalloc observable metrics
   // ----------------------------------------------------------
@@ -7,14 +7,20 @@
 // Plugin-safe logging
 #include "flowpipe/observability/logging.h"
 
-#if FLOWPIPE_ENABLE_OTEL
+// Runtime logging (async ring)
 #include "flowpipe/observability/logging_runtime.h"
+
+#if FLOWPIPE_ENABLE_OTEL
 #include "flowpipe/observability/metrics.h"
 #include "flowpipe/observability/tracing.h"
 #endif
 
 namespace flowpipe::observability {
 
+namespace {
+constexpr uint32_t kDefaultLogRingSize = 4096;
+}  // namespace
+
 // ------------------------------------------------------------
 // InitFromProto
 // ------------------------------------------------------------
@@ -25,6 +31,10 @@ void InitFromProto(const flowpipe::v1::ObservabilityConfig* cfg) {
   // OTEL is disabled or not configured.
   InitLocalLogging(debug_intent);
 
+  // Stage and runtime log calls only queue a record from here on.
+  const uint32_t ring_size = cfg ? cfg->logging().async_ring_size() : 0;
+  StartAsyncLogging(ring_size > 0 ? ring_size : kDefaultLogRingSize);
+
 #if !FLOWPIPE_ENABLE_OTEL
   FP_LOG_DEBUG("observability: OTEL disabled at compile time");
   (void)cfg;
@@ -108,6 +118,9 @@ void InitFromProto(const flowpipe::v1::ObservabilityConfig* cfg) {
 // ShutdownObservability
 // ------------------------------------------------------------
 void ShutdownObservability() {
+  // Write out queued log records while the OTEL logger can still take them.
+  StopAsyncLogging();
+
 #if !FLOWPIPE_ENABLE_OTEL
   return;
 #else
@@ -131,6 +144,10 @@ void ShutdownObservability() {
   // ----------------------------------------------------------
   if (state.tracer_provider) {
     FP_LOG_DEBUG("observability: shutting down tracer provider");
+    state.stage_spans_enabled = false;
+    state.queue_spans_enabled = false;
+    state.record_spans_enabled = false;
+    state.tracer = opentelemetry::nostd::shared_ptr<opentelemetry::trace::Tracer>();
     state.tracer_provider->Shutdown();
     state.tracer_provider.reset();
   } else {
@@ -0,0 +1,400 @@
+#include "flowpipe/observability/prometheus_endpoint.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <string_view>
+
+#include <fmt/format.h>
+
+#if __has_include(<jemalloc/jemalloc.h>)
+#include <jemalloc/jemalloc.h>
+#define FLOWPIPE_HAVE_JEMALLOC_H 1
+#else
+#define FLOWPIPE_HAVE_JEMALLOC_H 0
+#endif
+
+#include "flowpipe/internal/socket_util.h"
+#include "flowpipe/observability/logging_runtime.h"
+
+namespace flowpipe::observability {
+
+namespace {
+
+// Requests larger than this are not scrapes.
+constexpr size_t kMaxRequestBytes = 8192;
+
+// Writes one metric family, emitting HELP and TYPE before its first sample
+// only, so families without series are left out entirely.
+class Family {
+ public:
+  Family(std::string& out, std::string_view name, std::string_view type, std::string_view help)
+      : out_(out), name_(name), type_(type), help_(help) {}
+
+  void Sample(const MetricLabels& labels, uint64_t value) {
+    Sample("", labels, nullptr, value);
+  }
+
+  void Histogram(const MetricLabels& labels, const HistogramSnapshot& histogram) {
+    for (const auto& [bound, cumulative] : histogram.CumulativeOctaves()) {
+      Sample("_bucket", labels, fmt::format("{}", bound).c_str(), cumulative);
+    }
+    Sample("_bucket", labels, "+Inf", histogram.count);
+    Sample("_sum", labels, nullptr, histogram.sum);
+    Sample("_count", labels, nullptr, histogram.count);
+  }
+
+ private:
+  void Sample(std::string_view suffix, const MetricLabels& labels, const char* le,
+              uint64_t value) {
+    auto it = std::back_inserter(out_);
+    if (!started_) {
+      fmt::format_to(it, "# HELP {} {}\n# TYPE {} {}\n", name_, help_, name_, type_);
+      started_ = true;
+    }
+    fmt::format_to(it, "{}{}", name_, suffix);
+    if (!labels.empty() || le != nullptr) {
+      char sep = '{';
+      for (const auto& [key, label_value] : labels) {
+        out_.push_back(sep);
+        AppendLabel(key, label_value);
+        sep = ',';
+      }
+      if (le != nullptr) {
+        out_.push_back(sep);
+        AppendLabel("le", le);
+      }
+      out_.push_back('}');
+    }
+    fmt::format_to(it, " {}\n", value);
+  }
+
+  void AppendLabel(std::string_view key, std::string_view value) {
+    out_.append(key);
+    out_.append("=\"");
+    for (const char c : value) {
+      switch (c) {
+        case '\\':
+          out_.append("\\\\");
+          break;
+        case '"':
+          out_.append("\\\"");
+          break;
+        case '\n':
+          out_.append("\\n");
+          break;
+        default:
+          out_.push_back(c);
+      }
+    }
+    out_.push_back('"');
+  }
+
+  std::string& out_;
+  std::string_view name_;
+  std::string_view type_;
+  std::string_view help_;
+  bool started_ = false;
+};
+
+void AppendJemallocGauges(std::string& out) {
+#if FLOWPIPE_HAVE_JEMALLOC_H
+  // jemalloc caches its stats until the epoch is bumped.
+  uint64_t epoch = 1;
+  size_t epoch_size = sizeof(epoch);
+  mallctl("epoch", &epoch, &epoch_size, &epoch, epoch_size);
+
+  struct Stat {
+    const char* ctl;
+    const char* name;
+    const char* help;
+  };
+  static constexpr Stat kStats[] = {
+      {"stats.allocated", "flowpipe_jemalloc_allocated_bytes", "jemalloc allocated bytes"},
+      {"stats.active", "flowpipe_jemalloc_active_bytes", "jemalloc active bytes"},
+      {"stats.resident", "flowpipe_jemalloc_resident_bytes", "jemalloc resident bytes"},
+      {"stats.mapped", "flowpipe_jemalloc_mapped_bytes", "jemalloc mapped bytes"},
+  };
+  for (const auto& stat : kStats) {
+    size_t value = 0;
+    size_t size = sizeof(value);
+    if (mallctl(stat.ctl, &value, &size, nullptr, 0) == 0) {
+      Family(out, stat.name, "gauge", stat.help).Sample({}, value);
+    }
+  }
+#else
+  (void)out;
+#endif
+}
+
+MetricLabels WithLabel(const MetricLabels& labels, const char* key, const char* value) {
+  MetricLabels out = labels;
+  out.emplace_back(key, value);
+  return out;
+}
+
+// Reads up to the end of the request head. Returns false on timeout, error
+// or an oversized request.
+bool ReadRequestHead(int fd, std::string& request) {
+  char buffer[1024];
+  while (request.find("\r\n\r\n") == std::string::npos) {
+    if (request.size() >= kMaxRequestBytes) {
+      return false;
+    }
+    const ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    request.append(buffer, static_cast<size_t>(n));
+  }
+  return true;
+}
+
+std::string HttpResponse(std::string_view status, std::string_view content_type,
+                         std::string_view body, bool with_body) {
+  return fmt::format(
+      "HTTP/1.1 {}\r\nContent-Type: {}\r\nContent-Length: {}\r\nConnection: close\r\n\r\n{}",
+      status, content_type, body.size(), with_body ? body : std::string_view{});
+}
+
+}  // namespace
+
+std::string FormatPrometheusMetrics(const std::vector<StageTotals>& stages,
+                                    const std::vector<QueueTotals>& queues, bool histograms) {
+  std::string out;
+
+  {
+    Family family(out, "flowpipe_stage_process_count_total", "counter",
+                  "Number of stage invocations");
+    for (const auto& s : stages) {
+      family.Sample(s.labels, s.processed);
+    }
+  }
+  {
+    Family family(out, "flowpipe_stage_errors_total", "counter", "Number of stage errors");
+    for (const auto& s : stages) {
+      family.Sample(s.labels, s.errors);
+    }
+  }
+  {
+    Family workers(out, "flowpipe_stage_workers", "gauge", "Running workers of autoscaled stages");
+    for (const auto& s : stages) {
+      if (s.autoscaled()) {
+        workers.Sample(s.labels, s.workers());
+      }
+    }
+    Family decisions(out, "flowpipe_stage_scaling_decisions_total", "counter",
+                     "Number of autoscaler decisions");
+    for (const auto& s : stages) {
+      if (s.autoscaled()) {
+        decisions.Sample(WithLabel(s.labels, "direction", "up"), s.scale_ups);
+        decisions.Sample(WithLabel(s.labels, "direction", "down"), s.scale_downs);
+      }
+    }
+  }
+  {
+    Family family(out, "flowpipe_stage_cpu_assigned", "gauge",
+                  "CPUs assigned to stages by automatic placement");
+    for (const auto& s : stages) {
+      for (const auto& cpu : s.cpus) {
+        MetricLabels labels = s.labels;
+        labels.emplace_back("cpu", std::to_string(cpu.cpu));
+        labels.emplace_back("l3", std::to_string(cpu.l3));
+        labels.emplace_back("numa_node", std::to_string(cpu.numa_node));
+        family.Sample(labels, 1);
+      }
+    }
+  }
+  if (histograms) {
+    Family latency(out, "flowpipe_stage_latency_ns", "histogram",
+                   "Stage processing latency (ns)");
+    for (const auto& s : stages) {
+      latency.Histogram(s.labels, s.latency);
+    }
+    Family end_to_end(out, "flowpipe_record_end_to_end_ns", "histogram",
+                      "Time from flow entry to sink completion (ns)");
+    for (const auto& s : stages) {
+      if (s.end_to_end.count > 0) {
+        end_to_end.Histogram(s.labels, s.end_to_end);
+      }
+    }
+  }
+
+  {
+    Family family(out, "flowpipe_queue_enqueue_count_total", "counter",
+                  "Number of records enqueued to queue");
+    for (const auto& q : queues) {
+      family.Sample(q.labels, q.enqueued);
+    }
+  }
+  {
+    Family family(out, "flowpipe_queue_dequeue_count_total", "counter",
+                  "Number of records dequeued from queue");
+    for (const auto& q : queues) {
+      family.Sample(q.labels, q.dequeued);
+    }
+  }
+  {
+    Family hops(out, "flowpipe_queue_cross_node_count_total", "counter",
+                "Records dequeued on a different NUMA node than they were produced on");
+    Family bytes(out, "flowpipe_queue_cross_node_bytes_total", "counter",
+                 "Payload bytes read across NUMA nodes");
+    for (const auto& q : queues) {
+      if (q.cross_node > 0) {
+        hops.Sample(q.labels, q.cross_node);
+      }
+    }
+    for (const auto& q : queues) {
+      if (q.cross_node > 0) {
+        bytes.Sample(q.labels, q.cross_node_bytes);
+      }
+    }
+  }
+  if (histograms) {
+    Family dwell(out, "flowpipe_queue_dwell_ns", "histogram",
+                 "Time records spent in queue (ns)");
+    for (const auto& q : queues) {
+      dwell.Histogram(q.labels, q.dwell);
+    }
+  }
+
+  return out;
+}
+
+std::string PrometheusScrape(bool jemalloc) {
+  auto& metrics = RuntimeMetrics::Get();
+  const auto stages = metrics.stages_enabled() ? metrics.CollectStages() : std::vector<StageTotals>{};
+  const auto queues = metrics.queues_enabled() ? metrics.CollectQueues() : std::vector<QueueTotals>{};
+  std::string out = FormatPrometheusMetrics(stages, queues, metrics.histograms_enabled());
+  if (jemalloc) {
+    AppendJemallocGauges(out);
+  }
+  return out;
+}
+
+PrometheusEndpoint::~PrometheusEndpoint() {
+  Stop();
+}
+
+bool PrometheusEndpoint::Start(uint16_t port, bool jemalloc) {
+  Stop();
+
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons(port);
+
+  listen_fd_ = detail::OpenStreamSocket(AF_INET);
+  const int reuse = 1;
+  socklen_t addr_len = sizeof(addr);
+  if (listen_fd_ < 0 ||
+      setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) != 0 ||
+      bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+      listen(listen_fd_, 16) != 0 ||
+      getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &addr_len) != 0 ||
+      pipe(wake_pipe_) != 0) {
+    FP_LOG_WARN_FMT("prometheus endpoint: cannot listen on 127.0.0.1:{}: {}", port,
+                    std::strerror(errno));
+    Stop();
+    return false;
+  }
+  detail::SetCloseOnExec(wake_pipe_[0]);
+  detail::SetCloseOnExec(wake_pipe_[1]);
+
+  jemalloc_ = jemalloc;
+  port_ = ntohs(addr.sin_port);
+  thread_ = std::thread([this] { Serve(); });
+  FP_LOG_INFO_FMT("prometheus endpoint: serving http://127.0.0.1:{}/metrics", port_);
+  return true;
+}
+
+void PrometheusEndpoint::Stop() {
+  if (thread_.joinable()) {
+    const char byte = 0;
+    [[maybe_unused]] const auto n = write(wake_pipe_[1], &byte, 1);
+    thread_.join();
+  }
+  for (int* fd : {&listen_fd_, &wake_pipe_[0], &wake_pipe_[1]}) {
+    if (*fd >= 0) {
+      close(*fd);
+      *fd = -1;
+    }
+  }
+  port_ = 0;
+}
+
+void PrometheusEndpoint::Serve() {
+  pollfd fds[2] = {{listen_fd_, POLLIN, 0}, {wake_pipe_[0], POLLIN, 0}};
+  while (true) {
+    if (poll(fds, 2, -1) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      FP_LOG_WARN_FMT("prometheus endpoint: poll failed: {}", std::strerror(errno));
+      return;
+    }
+    if (fds[1].revents != 0) {
+      return;
+    }
+    if ((fds[0].revents & POLLIN) == 0) {
+      continue;
+    }
+
+    const int client = detail::AcceptClient(listen_fd_);
+    if (client < 0) {
+      continue;
+    }
+    // Bounds how long a slow or stuck scraper can hold the serving thread.
+    const timeval timeout{1, 0};
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    Respond(client);
+    close(client);
+  }
+}
+
+void PrometheusEndpoint::Respond(int client) {
+  std::string request;
+  if (!ReadRequestHead(client, request)) {
+    FP_LOG_DEBUG("prometheus endpoint: dropped incomplete request");
+    return;
+  }
+
+  // Request line: METHOD SP TARGET SP VERSION
+  const std::string_view line(request.data(), request.find("\r\n"));
+  const size_t method_end = line.find(' ');
+  const size_t target_end = line.find(' ', method_end + 1);
+  const std::string_view method = line.substr(0, method_end);
+  std::string_view target = method_end == std::string_view::npos
+                                ? std::string_view{}
+                                : line.substr(method_end + 1, target_end - method_end - 1);
+  target = target.substr(0, target.find('?'));
+
+  constexpr std::string_view kText = "text/plain; charset=utf-8";
+  std::string response;
+  if (method != "GET" && method != "HEAD") {
+    response = HttpResponse("405 Method Not Allowed", kText, "method not allowed\n", true);
+  } else if (target != "/metrics") {
+    response = HttpResponse("404 Not Found", kText, "not found; scrape /metrics\n", true);
+  } else {
+    response = HttpResponse("200 OK", "text/plain; version=0.0.4; charset=utf-8",
+                            PrometheusScrape(jemalloc_), method == "GET");
+  }
+
+  if (!detail::SendAll(client, response)) {
+    FP_LOG_DEBUG_FMT("prometheus endpoint: scraper went away: {}", std::strerror(errno));
+  }
+}
+
+}  // namespace flowpipe::observability
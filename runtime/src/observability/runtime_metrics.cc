@@ -0,0 +1,252 @@
+#include "flowpipe/observability/runtime_metrics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+namespace flowpipe::observability {
+
+namespace {
+
+// Per-thread name -> series cache for the name-based lookups. Stage and
+// queue names are long-lived runtime strings, so the usual hit is a pointer
+// match; the name is still compared so a recycled pointer never resolves to
+// the wrong series, and a new pointer to a known name reuses its entry.
+struct NameCache {
+  struct Entry {
+    const void* key;
+    std::string name;
+    SeriesId id;
+  };
+  std::vector<Entry> entries;
+
+  const Entry* find(const void* key, const char* name, size_t len) {
+    auto same_name = [&](const Entry& e) {
+      return e.name.size() == len && std::memcmp(e.name.data(), name, len) == 0;
+    };
+    for (auto& e : entries) {
+      if (e.key == key && same_name(e)) {
+        return &e;
+      }
+    }
+    for (auto& e : entries) {
+      if (same_name(e)) {
+        e.key = key;
+        return &e;
+      }
+    }
+    return nullptr;
+  }
+};
+
+}  // namespace
+
+void HistogramSnapshot::Add(const LocalHistogram& histogram) noexcept {
+  for (size_t i = 0; i < LocalHistogram::kBuckets; ++i) {
+    const uint64_t n = histogram.bucket(i);
+    buckets[i] += n;
+    count += n;
+  }
+  sum += histogram.sum();
+}
+
+uint64_t HistogramSnapshot::ValueAtQuantile(double q) const noexcept {
+  if (count == 0) {
+    return 0;
+  }
+  const double clamped = std::clamp(q, 0.0, 1.0);
+  const auto rank =
+      std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(clamped * static_cast<double>(count))));
+
+  uint64_t seen = 0;
+  for (size_t i = 0; i < LocalHistogram::kBuckets; ++i) {
+    seen += buckets[i];
+    if (seen >= rank) {
+      return LocalHistogram::UpperBound(i);
+    }
+  }
+  return Max();
+}
+
+uint64_t HistogramSnapshot::Max() const noexcept {
+  for (size_t i = LocalHistogram::kBuckets; i > 0; --i) {
+    if (buckets[i - 1] > 0) {
+      return LocalHistogram::UpperBound(i - 1);
+    }
+  }
+  return 0;
+}
+
+std::vector<std::pair<uint64_t, uint64_t>> HistogramSnapshot::CumulativeOctaves() const {
+  std::vector<std::pair<uint64_t, uint64_t>> out;
+  out.reserve(kLastOctave - kFirstOctave + 1);
+  uint64_t cumulative = 0;
+  size_t i = 0;
+  // Bucket bounds never straddle a power of two, so each bucket falls wholly
+  // below or above every le.
+  for (unsigned octave = kFirstOctave; octave <= kLastOctave; ++octave) {
+    const uint64_t le = (uint64_t{1} << octave) - 1;
+    for (; i < LocalHistogram::kBuckets && LocalHistogram::UpperBound(i) <= le; ++i) {
+      cumulative += buckets[i];
+    }
+    out.emplace_back(le, cumulative);
+  }
+  return out;
+}
+
+RuntimeMetrics& RuntimeMetrics::Get() {
+  static RuntimeMetrics instance;
+  return instance;
+}
+
+template <typename Shard>
+SeriesId RuntimeMetrics::Register(SeriesSet<Shard>& set, MetricLabels labels) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto [it, inserted] = set.index.try_emplace(labels, static_cast<SeriesId>(set.series.size()));
+  if (inserted) {
+    set.series.push_back(Series<Shard>{.labels = std::move(labels), .shards = {}, .free = {}});
+  }
+  return it->second;
+}
+
+template <typename Shard>
+Shard& RuntimeMetrics::BindShard(ThreadShards<Shard>& owned, SeriesId id) {
+  Shard* shard = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& series = owned.set->series.at(id);
+    if (series.free.empty()) {
+      shard = &series.shards.emplace_back();
+    } else {
+      // The lock orders the previous owner's last writes before ours.
+      shard = series.free.back();
+      series.free.pop_back();
+    }
+  }
+  if (owned.bound.size() <= id) {
+    owned.bound.resize(id + 1, nullptr);
+  }
+  owned.bound[id] = shard;
+  return *shard;
+}
+
+template <typename Shard>
+RuntimeMetrics::ThreadShards<Shard>::~ThreadShards() {
+  auto& metrics = RuntimeMetrics::Get();
+  std::lock_guard<std::mutex> lock(metrics.mutex_);
+  for (size_t id = 0; id < bound.size(); ++id) {
+    if (bound[id]) {
+      set->series[id].free.push_back(bound[id]);
+    }
+  }
+}
+
+SeriesId RuntimeMetrics::RegisterStage(MetricLabels labels) {
+  return Register(stages_, std::move(labels));
+}
+
+SeriesId RuntimeMetrics::RegisterQueue(MetricLabels labels) {
+  return Register(queues_, std::move(labels));
+}
+
+StageShard& RuntimeMetrics::stage(SeriesId id) {
+  thread_local ThreadShards<StageShard> owned{.set = &stages_, .bound = {}};
+  if (id < owned.bound.size() && owned.bound[id]) {
+    return *owned.bound[id];
+  }
+  return BindShard(owned, id);
+}
+
+QueueShard& RuntimeMetrics::queue(SeriesId id) {
+  thread_local ThreadShards<QueueShard> owned{.set = &queues_, .bound = {}};
+  if (id < owned.bound.size() && owned.bound[id]) {
+    return *owned.bound[id];
+  }
+  return BindShard(owned, id);
+}
+
+StageShard& RuntimeMetrics::stage(const char* name) {
+  thread_local NameCache cache;
+  const size_t len = std::strlen(name);
+  if (const auto* entry = cache.find(name, name, len)) {
+    return stage(entry->id);
+  }
+  const SeriesId id = RegisterStage({{"stage", std::string(name, len)}});
+  cache.entries.push_back({name, std::string(name, len), id});
+  return stage(id);
+}
+
+QueueShard& RuntimeMetrics::queue(const std::string& name) {
+  thread_local NameCache cache;
+  if (const auto* entry = cache.find(&name, name.data(), name.size())) {
+    return queue(entry->id);
+  }
+  const SeriesId id = RegisterQueue({{"queue", name}});
+  cache.entries.push_back({&name, name, id});
+  return queue(id);
+}
+
+void RuntimeMetrics::AddStageCpu(SeriesId id, const CpuAssignment& cpu) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto& cpus = stage_cpus_[id];
+  if (std::find(cpus.begin(), cpus.end(), cpu) == cpus.end()) {
+    cpus.push_back(cpu);
+  }
+}
+
+std::vector<StageTotals> RuntimeMetrics::CollectStages() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<StageTotals> out;
+  out.reserve(stages_.series.size());
+  for (const auto& series : stages_.series) {
+    auto& totals = out.emplace_back();
+    totals.labels = series.labels;
+    for (const auto& shard : series.shards) {
+      totals.processed += shard.processed.value();
+      totals.errors += shard.errors.value();
+      totals.latency.Add(shard.latency);
+      totals.end_to_end.Add(shard.end_to_end);
+      totals.workers_started += shard.workers_started.value();
+      totals.workers_stopped += shard.workers_stopped.value();
+      totals.scale_ups += shard.scale_ups.value();
+      totals.scale_downs += shard.scale_downs.value();
+    }
+  }
+  for (const auto& [id, cpus] : stage_cpus_) {
+    out[id].cpus = cpus;
+  }
+  return out;
+}
+
+std::vector<QueueTotals> RuntimeMetrics::CollectQueues() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<QueueTotals> out;
+  out.reserve(queues_.series.size());
+  for (const auto& series : queues_.series) {
+    auto& totals = out.emplace_back();
+    totals.labels = series.labels;
+    for (const auto& shard : series.shards) {
+      totals.enqueued += shard.enqueued.value();
+      totals.dequeued += shard.dequeued.value();
+      totals.cross_node += shard.cross_node.value();
+      totals.cross_node_bytes += shard.cross_node_bytes.value();
+      totals.dwell.Add(shard.dwell);
+    }
+  }
+  return out;
+}
+
+size_t RuntimeMetrics::shard_count() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  size_t count = 0;
+  for (const auto& series : stages_.series) {
+    count += series.shards.size();
+  }
+  for (const auto& series : queues_.series) {
+    count += series.shards.size();
+  }
+  return count;
+}
+
+}  // namespace flowpipe::observability
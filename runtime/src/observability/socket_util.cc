@@ -0,0 +1,81 @@
+#include "flowpipe/internal/socket_util.h"
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+
+namespace flowpipe::observability::detail {
+
+namespace {
+
+// Linux suppresses SIGPIPE per send(); the BSDs and macOS per socket.
+#ifdef MSG_NOSIGNAL
+constexpr int kSendFlags = MSG_NOSIGNAL;
+#else
+constexpr int kSendFlags = 0;
+#endif
+
+bool PrepareSocket(int fd) {
+  if (!SetCloseOnExec(fd)) {
+    return false;
+  }
+#ifdef SO_NOSIGPIPE
+  const int on = 1;
+  if (setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on)) != 0) {
+    return false;
+  }
+#endif
+  return true;
+}
+
+int CloseOnError(int fd) {
+  const int saved = errno;
+  close(fd);
+  errno = saved;
+  return -1;
+}
+
+}  // namespace
+
+bool SetCloseOnExec(int fd) {
+  const int flags = fcntl(fd, F_GETFD);
+  return flags >= 0 && fcntl(fd, F_SETFD, flags | FD_CLOEXEC) == 0;
+}
+
+int OpenStreamSocket(int domain) {
+  const int fd = socket(domain, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return -1;
+  }
+  return SetCloseOnExec(fd) ? fd : CloseOnError(fd);
+}
+
+int AcceptClient(int listen_fd) {
+  int fd = -1;
+  do {
+    fd = accept(listen_fd, nullptr, nullptr);
+  } while (fd < 0 && errno == EINTR);
+  if (fd < 0) {
+    return -1;
+  }
+  return PrepareSocket(fd) ? fd : CloseOnError(fd);
+}
+
+bool SendAll(int fd, std::string_view data) {
+  size_t written = 0;
+  while (written < data.size()) {
+    const ssize_t n = send(fd, data.data() + written, data.size() - written, kSendFlags);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    written += static_cast<size_t>(n);
+  }
+  return true;
+}
+
+}  // namespace flowpipe::observability::detail
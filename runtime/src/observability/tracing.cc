@@ -1,8 +1,70 @@
 #include "flowpipe/observability/tracing.h"
 
+#include <atomic>
+#include <cstring>
+#include <random>
+
+#include "flowpipe/clock.h"
 #include "flowpipe/observability/logging.h"
 #include "flowpipe/observability/observability_state.h"
 
+namespace flowpipe::observability {
+
+// ------------------------------------------------------------
+// Thread-local id generation
+// ------------------------------------------------------------
+namespace {
+
+uint64_t SplitMix64(uint64_t& state) noexcept {
+  uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+uint64_t ProcessSeed() noexcept {
+  try {
+    std::random_device device;
+    return (static_cast<uint64_t>(device()) << 32) ^ device();
+  } catch (...) {
+    return MonotonicNowNs();
+  }
+}
+
+// Threads start from scrambled, distinct points so their sequences don't
+// line up with each other.
+uint64_t ThreadSeed() noexcept {
+  static const uint64_t process_seed = ProcessSeed();
+  static std::atomic<uint64_t> threads{0};
+  uint64_t seed =
+      process_seed ^ (threads.fetch_add(1, std::memory_order_relaxed) * 0xD1B54A32D192ED03ULL);
+  return SplitMix64(seed);
+}
+
+uint64_t NextRandom() noexcept {
+  thread_local uint64_t state = ThreadSeed();
+  return SplitMix64(state);
+}
+
+}  // namespace
+
+uint64_t NextSpanId() noexcept {
+  uint64_t id = 0;
+  while (id == 0) {
+    id = NextRandom();
+  }
+  return id;
+}
+
+void NextTraceId(uint8_t (&out)[16]) noexcept {
+  const uint64_t high = NextRandom();
+  const uint64_t low = NextSpanId();  // non-zero, so the id is too
+  std::memcpy(out, &high, sizeof(high));
+  std::memcpy(out + sizeof(high), &low, sizeof(low));
+}
+
+}  // namespace flowpipe::observability
+
 #if FLOWPIPE_ENABLE_OTEL
 
 #include <chrono>
@@ -10,7 +72,10 @@
 #include <string>
 
 // ---- OpenTelemetry: Tracing (SDK)
+#include <opentelemetry/sdk/resource/resource.h>
 #include <opentelemetry/sdk/trace/batch_span_processor_factory.h>
+#include <opentelemetry/sdk/trace/id_generator.h>
+#include <opentelemetry/sdk/trace/samplers/always_on_factory.h>
 #include <opentelemetry/sdk/trace/simple_processor_factory.h>
 #include <opentelemetry/sdk/trace/tracer_provider.h>
 #include <opentelemetry/sdk/trace/tracer_provider_factory.h>
@@ -27,6 +92,31 @@ namespace otlp = opentelemetry::exporter::otlp;
 
 namespace flowpipe::observability {
 
+// ------------------------------------------------------------
+// Id generator
+// ------------------------------------------------------------
+// The SDK's default generator shares one engine behind the provider; this
+// one draws from NextSpanId()/NextTraceId() on the calling thread.
+class ThreadLocalIdGenerator final : public trace_sdk::IdGenerator {
+ public:
+  ThreadLocalIdGenerator() : trace_sdk::IdGenerator(/*is_random=*/true) {}
+
+  opentelemetry::trace::SpanId GenerateSpanId() noexcept override {
+    uint8_t bytes[opentelemetry::trace::SpanId::kSize];
+    const uint64_t id = NextSpanId();
+    std::memcpy(bytes, &id, sizeof(bytes));
+    return opentelemetry::trace::SpanId(
+        opentelemetry::nostd::span<const uint8_t, opentelemetry::trace::SpanId::kSize>(bytes));
+  }
+
+  opentelemetry::trace::TraceId GenerateTraceId() noexcept override {
+    uint8_t bytes[opentelemetry::trace::TraceId::kSize];
+    NextTraceId(bytes);
+    return opentelemetry::trace::TraceId(
+        opentelemetry::nostd::span<const uint8_t, opentelemetry::trace::TraceId::kSize>(bytes));
+  }
+};
+
 // ------------------------------------------------------------
 // Batch processor option mapping
 // ------------------------------------------------------------
@@ -121,10 +211,21 @@ void InitTracing(const flowpipe::v1::ObservabilityConfig* cfg, const GlobalDefau
   // ----------------------------------------------------------
   // Provider (SDK → API)
   // ----------------------------------------------------------
-  state.tracer_provider = trace_sdk::TracerProviderFactory::Create(std::move(processor));
+  state.tracer_provider = trace_sdk::TracerProviderFactory::Create(
+      std::move(processor), opentelemetry::sdk::resource::Resource::Create({}),
+      trace_sdk::AlwaysOnSamplerFactory::Create(), std::make_unique<ThreadLocalIdGenerator>());
   std::shared_ptr<opentelemetry::trace::TracerProvider> api_provider = state.tracer_provider;
   opentelemetry::trace::Provider::SetTracerProvider(api_provider);
 
+  // Stages start spans from this tracer rather than looking one up per
+  // record; timed spans map runtime timestamps to wall time with the offset.
+  state.tracer = api_provider->GetTracer("flowpipe.runtime", "1.0.0");
+  state.system_offset_ns =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::system_clock::now().time_since_epoch())
+          .count() -
+      static_cast<int64_t>(MonotonicNowNs());
+
   // ----------------------------------------------------------
   // Cache runtime flags (mirrors metrics.cc pattern)
   // ----------------------------------------------------------
@@ -0,0 +1,327 @@
+#include "flowpipe/protobuf_config.h"
+
+#include <google/protobuf/descriptor.h>
+
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+
+namespace flowpipe {
+
+namespace {
+
+using google::protobuf::Descriptor;
+using google::protobuf::EnumValueDescriptor;
+using google::protobuf::FieldDescriptor;
+using google::protobuf::ListValue;
+using google::protobuf::Message;
+using google::protobuf::Reflection;
+using google::protobuf::Struct;
+using google::protobuf::Value;
+
+const char* KindName(const Value& value) {
+  switch (value.kind_case()) {
+    case Value::kNullValue:
+      return "null";
+    case Value::kNumberValue:
+      return "a number";
+    case Value::kStringValue:
+      return "a string";
+    case Value::kBoolValue:
+      return "a bool";
+    case Value::kStructValue:
+      return "an object";
+    case Value::kListValue:
+      return "a list";
+    default:
+      return "an empty value";
+  }
+}
+
+template <typename T>
+bool ToInteger(const Value& value, T* out) {
+  if (value.kind_case() != Value::kNumberValue) {
+    return false;
+  }
+  const double d = value.number_value();
+  if (!std::isfinite(d) || std::trunc(d) != d) {
+    return false;
+  }
+  // Both bounds are powers of two, so the comparisons are exact.
+  const double upper = std::numeric_limits<T>::is_signed
+                           ? -static_cast<double>(std::numeric_limits<T>::min())
+                           : static_cast<double>(std::numeric_limits<T>::max()) + 1.0;
+  if (d < static_cast<double>(std::numeric_limits<T>::min()) || d >= upper) {
+    return false;
+  }
+  *out = static_cast<T>(d);
+  return true;
+}
+
+// Walks a Struct into a message; the first error wins.
+class StructReader {
+ public:
+  explicit StructReader(std::string* error) : error_(error) {}
+
+  bool ReadObject(const Struct& object, Message* out, const std::string& path) {
+    const Descriptor* descriptor = out->GetDescriptor();
+    const Reflection* reflection = out->GetReflection();
+    for (const auto& [key, value] : object.fields()) {
+      const FieldDescriptor* field = FindField(descriptor, key);
+      const std::string field_path = path.empty() ? key : path + "." + key;
+      if (!field) {
+        return Fail(field_path, "no such field in " + descriptor->full_name());
+      }
+      if (value.kind_case() == Value::kNullValue && !IsValueMessage(field)) {
+        continue;  // null means "leave at default"
+      }
+      if (const auto* oneof = field->containing_oneof()) {
+        const FieldDescriptor* set = reflection->GetOneofFieldDescriptor(*out, oneof);
+        if (set && set != field) {
+          return Fail(field_path, "oneof '" + oneof->name() + "' already set by '" +
+                                      set->name() + "'");
+        }
+      }
+      if (!ReadField(value, out, field, field_path)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+ private:
+  static const FieldDescriptor* FindField(const Descriptor* descriptor, const std::string& key) {
+    if (const auto* field = descriptor->FindFieldByName(key)) {
+      return field;
+    }
+    for (int i = 0; i < descriptor->field_count(); ++i) {
+      if (descriptor->field(i)->json_name() == key) {
+        return descriptor->field(i);
+      }
+    }
+    return nullptr;
+  }
+
+  static bool IsValueMessage(const FieldDescriptor* field) {
+    return field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE &&
+           field->message_type()->full_name() == "google.protobuf.Value";
+  }
+
+  bool Fail(const std::string& path, const std::string& what) {
+    if (error_) {
+      *error_ = "field '" + path + "': " + what;
+    }
+    return false;
+  }
+
+  bool Mismatch(const std::string& path, const char* expected, const Value& value) {
+    return Fail(path, std::string("expected ") + expected + ", got " + KindName(value));
+  }
+
+  bool ReadField(const Value& value, Message* out, const FieldDescriptor* field,
+                 const std::string& path) {
+    if (field->is_map()) {
+      if (value.kind_case() != Value::kStructValue) {
+        return Mismatch(path, "an object", value);
+      }
+      const Reflection* reflection = out->GetReflection();
+      for (const auto& [key, entry_value] : value.struct_value().fields()) {
+        const std::string entry_path = path + "[" + key + "]";
+        Message* entry = reflection->AddMessage(out, field);
+        const FieldDescriptor* key_field = entry->GetDescriptor()->map_key();
+        const FieldDescriptor* value_field = entry->GetDescriptor()->map_value();
+        if (!ReadMapKey(key, entry, key_field, entry_path) ||
+            !ReadSingle(entry_value, entry, value_field, false, entry_path)) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    if (field->is_repeated()) {
+      if (value.kind_case() != Value::kListValue) {
+        return Mismatch(path, "a list", value);
+      }
+      const ListValue& list = value.list_value();
+      for (int i = 0; i < list.values_size(); ++i) {
+        if (!ReadSingle(list.values(i), out, field, true,
+                        path + "[" + std::to_string(i) + "]")) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    return ReadSingle(value, out, field, false, path);
+  }
+
+  bool ReadMapKey(const std::string& key, Message* entry, const FieldDescriptor* field,
+                  const std::string& path) {
+    const Reflection* reflection = entry->GetReflection();
+    if (field->cpp_type() == FieldDescriptor::CPPTYPE_STRING) {
+      reflection->SetString(entry, field, key);
+      return true;
+    }
+    if (field->cpp_type() == FieldDescriptor::CPPTYPE_BOOL) {
+      if (key != "true" && key != "false") {
+        return Fail(path, "map key is not a bool");
+      }
+      reflection->SetBool(entry, field, key == "true");
+      return true;
+    }
+    // Integer keys: parse through a number Value to share the range checks.
+    char* end = nullptr;
+    const double number = std::strtod(key.c_str(), &end);
+    if (key.empty() || *end != '\0') {
+      return Fail(path, "map key is not a number");
+    }
+    Value as_number;
+    as_number.set_number_value(number);
+    return ReadSingle(as_number, entry, field, false, path);
+  }
+
+  bool ReadSingle(const Value& value, Message* out, const FieldDescriptor* field, bool add,
+                  const std::string& path) {
+    const Reflection* reflection = out->GetReflection();
+
+#define FP_READ_INTEGER(CPPTYPE, TYPE, NAME)                                                \
+  case FieldDescriptor::CPPTYPE: {                                                          \
+    TYPE v{};                                                                               \
+    if (!ToInteger<TYPE>(value, &v)) {                                                      \
+      return Mismatch(path, "an integer in " #TYPE " range", value);                        \
+    }                                                                                       \
+    add ? reflection->Add##NAME(out, field, v) : reflection->Set##NAME(out, field, v);      \
+    return true;                                                                            \
+  }
+
+    switch (field->cpp_type()) {
+      FP_READ_INTEGER(CPPTYPE_INT32, int32_t, Int32)
+      FP_READ_INTEGER(CPPTYPE_INT64, int64_t, Int64)
+      FP_READ_INTEGER(CPPTYPE_UINT32, uint32_t, UInt32)
+      FP_READ_INTEGER(CPPTYPE_UINT64, uint64_t, UInt64)
+
+      case FieldDescriptor::CPPTYPE_DOUBLE:
+      case FieldDescriptor::CPPTYPE_FLOAT: {
+        if (value.kind_case() != Value::kNumberValue) {
+          return Mismatch(path, "a number", value);
+        }
+        const double d = value.number_value();
+        if (field->cpp_type() == FieldDescriptor::CPPTYPE_DOUBLE) {
+          add ? reflection->AddDouble(out, field, d) : reflection->SetDouble(out, field, d);
+          return true;
+        }
+        if (std::isfinite(d) && std::fabs(d) > FLT_MAX) {
+          return Fail(path, "number out of float range");
+        }
+        const auto f = static_cast<float>(d);
+        add ? reflection->AddFloat(out, field, f) : reflection->SetFloat(out, field, f);
+        return true;
+      }
+
+      case FieldDescriptor::CPPTYPE_BOOL:
+        if (value.kind_case() != Value::kBoolValue) {
+          return Mismatch(path, "a bool", value);
+        }
+        add ? reflection->AddBool(out, field, value.bool_value())
+            : reflection->SetBool(out, field, value.bool_value());
+        return true;
+
+      case FieldDescriptor::CPPTYPE_STRING:
+        if (field->type() == FieldDescriptor::TYPE_BYTES) {
+          return Fail(path, "bytes fields need the JSON mapping");
+        }
+        if (value.kind_case() != Value::kStringValue) {
+          return Mismatch(path, "a string", value);
+        }
+        add ? reflection->AddString(out, field, value.string_value())
+            : reflection->SetString(out, field, value.string_value());
+        return true;
+
+      case FieldDescriptor::CPPTYPE_ENUM: {
+        const EnumValueDescriptor* enum_value = nullptr;
+        if (value.kind_case() == Value::kStringValue) {
+          enum_value = field->enum_type()->FindValueByName(value.string_value());
+        } else if (int32_t number = 0; ToInteger<int32_t>(value, &number)) {
+          enum_value = field->enum_type()->FindValueByNumber(number);
+        } else {
+          return Mismatch(path, "an enum name or number", value);
+        }
+        if (!enum_value) {
+          return Fail(path, "no such value in " + field->enum_type()->full_name());
+        }
+        add ? reflection->AddEnum(out, field, enum_value)
+            : reflection->SetEnum(out, field, enum_value);
+        return true;
+      }
+
+      case FieldDescriptor::CPPTYPE_MESSAGE: {
+        Message* child =
+            add ? reflection->AddMessage(out, field) : reflection->MutableMessage(out, field);
+        return ReadMessageValue(value, child, path);
+      }
+    }
+#undef FP_READ_INTEGER
+
+    return Fail(path, "unsupported field type");
+  }
+
+  // A message-typed value: nested object, or one of the well-known types
+  // the JSON mapping treats specially.
+  bool ReadMessageValue(const Value& value, Message* out, const std::string& path) {
+    const Descriptor* descriptor = out->GetDescriptor();
+    const std::string& type = descriptor->full_name();
+
+    if (descriptor == Value::descriptor()) {
+      out->CopyFrom(value);
+      return true;
+    }
+    if (descriptor == Struct::descriptor()) {
+      if (value.kind_case() != Value::kStructValue) {
+        return Mismatch(path, "an object", value);
+      }
+      out->CopyFrom(value.struct_value());
+      return true;
+    }
+    if (descriptor == ListValue::descriptor()) {
+      if (value.kind_case() != Value::kListValue) {
+        return Mismatch(path, "a list", value);
+      }
+      out->CopyFrom(value.list_value());
+      return true;
+    }
+    if (type.rfind("google.protobuf.", 0) == 0) {
+      // Wrappers (Int32Value, StringValue, ...) hold their scalar in `value`.
+      const bool wrapper = descriptor->field_count() == 1 &&
+                           descriptor->field(0)->name() == "value" &&
+                           type.size() > 5 && type.compare(type.size() - 5, 5, "Value") == 0;
+      if (wrapper) {
+        return ReadSingle(value, out, descriptor->field(0), false, path);
+      }
+      return Fail(path, type + " needs the JSON mapping");
+    }
+
+    if (value.kind_case() != Value::kStructValue) {
+      return Mismatch(path, "an object", value);
+    }
+    return ReadObject(value.struct_value(), out, path);
+  }
+
+  std::string* error_;
+};
+
+}  // namespace
+
+bool StructToMessage(const google::protobuf::Struct& config, google::protobuf::Message* out,
+                     std::string* error) {
+  if (!out) {
+    if (error) {
+      *error = "config output pointer is null";
+    }
+    return false;
+  }
+  return StructReader(error).ReadObject(config, out, "");
+}
+
+}  // namespace flowpipe
@@ -1,12 +1,22 @@
 #include "flowpipe/runtime.h"
 
+#include <algorithm>
 #include <atomic>
+#include <cerrno>
 #include <chrono>
+#include <cstdint>
 #include <cstring>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <optional>
 #ifdef __linux__
 #include <pthread.h>
 #include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 #endif
 #include <sstream>
 #include <stdexcept>
@@ -16,10 +26,23 @@
 #include <unordered_set>
 #include <vector>
 
+#include "flowpipe/autoscaler.h"
 #include "flowpipe/bounded_queue.h"
+#include "flowpipe/clock.h"
+#include "flowpipe/cpu_resources.h"
+#include "flowpipe/cpu_topology.h"
+#include "flowpipe/flow_spec.h"
+#include "flowpipe/numa.h"
 #include "flowpipe/queue_runtime.h"
 #include "flowpipe/signal_handler.h"
 #include "flowpipe/stage_runner.h"
+#include "flowpipe/static_stage.h"
+#include "flowpipe/task_pool.h"
+
+// Observability
+#include "flowpipe/observability/latency_endpoint.h"
+#include "flowpipe/observability/prometheus_endpoint.h"
+#include "flowpipe/observability/runtime_metrics.h"
 
 // Logging
 #include "flowpipe/observability/logging_runtime.h"
@@ -112,6 +135,162 @@ void ApplyRealtimePriority(const std::string& stage_name, uint32_t worker_index,
 #endif
 }
 
+// SCHED_DEADLINE parameters of a stage, in nanoseconds as the kernel takes them.
+struct DeadlineParams {
+  uint64_t runtime_ns = 0;
+  uint64_t deadline_ns = 0;
+  uint64_t period_ns = 0;
+  std::optional<int> fallback_priority;
+};
+
+std::optional<DeadlineParams> ResolveDeadlineSchedule(const flowpipe::v1::StageSpec& stage) {
+  if (!stage.has_deadline()) {
+    return std::nullopt;
+  }
+
+  const auto& schedule = stage.deadline();
+  DeadlineParams params;
+  params.runtime_ns = schedule.runtime_us() * 1000;
+  params.period_ns = schedule.period_us() * 1000;
+  params.deadline_ns = schedule.deadline_us() > 0 ? schedule.deadline_us() * 1000
+                                                  : params.period_ns;
+  if (schedule.has_fallback_priority()) {
+    params.fallback_priority = static_cast<int>(schedule.fallback_priority());
+  }
+  return params;
+}
+
+#ifdef __linux__
+uint64_t ReadSchedSysctlUs(const char* name, uint64_t fallback) {
+  std::ifstream in(std::string("/proc/sys/kernel/") + name);
+  uint64_t value = 0;
+  return (in >> value) ? value : fallback;
+}
+#endif
+
+void ValidateDeadlineSchedule(const std::string& stage_name, const DeadlineParams& params,
+                              uint32_t workers, bool has_realtime_priority, bool pinned) {
+#ifdef __linux__
+  if (has_realtime_priority) {
+    FP_LOG_ERROR_FMT("stage '{}' sets both realtime_priority and deadline", stage_name);
+    throw std::runtime_error("realtime_priority and deadline are exclusive for stage: " +
+                             stage_name);
+  }
+
+  // The kernel rejects runtimes below 1024 ns and periods outside its sysctl range.
+  const uint64_t min_period_ns = ReadSchedSysctlUs("sched_deadline_period_min_us", 100) * 1000;
+  const uint64_t max_period_ns =
+      ReadSchedSysctlUs("sched_deadline_period_max_us", 1ULL << 22) * 1000;
+  if (params.runtime_ns < 1024 || params.runtime_ns > params.deadline_ns ||
+      params.deadline_ns > params.period_ns) {
+    FP_LOG_ERROR_FMT(
+        "deadline schedule configured for stage '{}' needs 1.024 us <= runtime <= deadline <= "
+        "period (runtime={} ns, deadline={} ns, period={} ns)",
+        stage_name, params.runtime_ns, params.deadline_ns, params.period_ns);
+    throw std::runtime_error("invalid deadline schedule for stage: " + stage_name);
+  }
+  if (params.period_ns < min_period_ns || params.period_ns > max_period_ns) {
+    FP_LOG_ERROR_FMT("deadline period configured for stage '{}' is {} us but valid range is {}-{}",
+                     stage_name, params.period_ns / 1000, min_period_ns / 1000,
+                     max_period_ns / 1000);
+    throw std::runtime_error("invalid deadline schedule for stage: " + stage_name);
+  }
+  if (params.fallback_priority.has_value()) {
+    ValidateRealtimePriority(stage_name, params.fallback_priority.value());
+  }
+
+  // Admission control caps deadline bandwidth at sched_rt_runtime_us /
+  // sched_rt_period_us of every CPU; report flows that cannot fit.
+  const double rt_share = static_cast<double>(ReadSchedSysctlUs("sched_rt_runtime_us", 950000)) /
+                          static_cast<double>(ReadSchedSysctlUs("sched_rt_period_us", 1000000));
+  const double bandwidth = static_cast<double>(workers) * static_cast<double>(params.runtime_ns) /
+                           static_cast<double>(params.period_ns);
+  const double capacity = rt_share * static_cast<double>(AvailableCpuCount());
+  if (bandwidth > capacity) {
+    FP_LOG_WARN_FMT(
+        "stage '{}' asks for {:.2f} CPUs of deadline bandwidth but at most {:.2f} can be "
+        "admitted; some workers will fall back",
+        stage_name, bandwidth, capacity);
+  }
+  if (pinned) {
+    FP_LOG_WARN_FMT(
+        "stage '{}' combines cpu pinning with a deadline schedule; the kernel refuses "
+        "SCHED_DEADLINE for restricted affinity unless the cpuset is an exclusive root domain",
+        stage_name);
+  }
+#else
+  (void)stage_name;
+  (void)params;
+  (void)workers;
+  (void)has_realtime_priority;
+  (void)pinned;
+#endif
+}
+
+#ifdef __linux__
+#ifndef SCHED_DEADLINE
+#define SCHED_DEADLINE 6
+#endif
+#ifndef SCHED_FLAG_RESET_ON_FORK
+#define SCHED_FLAG_RESET_ON_FORK 0x01
+#endif
+
+// struct sched_attr (SCHED_ATTR_SIZE_VER0); glibc did not wrap sched_setattr
+// until 2.41.
+struct SchedAttr {
+  uint32_t size;
+  uint32_t sched_policy;
+  uint64_t sched_flags;
+  int32_t sched_nice;
+  uint32_t sched_priority;
+  uint64_t sched_runtime;
+  uint64_t sched_deadline;
+  uint64_t sched_period;
+};
+#endif
+
+void ApplyDeadlineSchedule(const std::string& stage_name, uint32_t worker_index,
+                           const DeadlineParams& params) {
+#ifdef __linux__
+  SchedAttr attr{};
+  attr.size = sizeof(attr);
+  attr.sched_policy = SCHED_DEADLINE;
+  attr.sched_flags = SCHED_FLAG_RESET_ON_FORK;
+  attr.sched_runtime = params.runtime_ns;
+  attr.sched_deadline = params.deadline_ns;
+  attr.sched_period = params.period_ns;
+  if (syscall(SYS_sched_setattr, 0, &attr, 0) == 0) {
+    FP_LOG_INFO_FMT(
+        "stage '{}' worker {} set deadline schedule runtime={} us deadline={} us period={} us",
+        stage_name, worker_index, params.runtime_ns / 1000, params.deadline_ns / 1000,
+        params.period_ns / 1000);
+    return;
+  }
+
+  const int error = errno;
+  const char* hint = error == EPERM    ? " (needs CAP_SYS_NICE and an unrestricted cpu affinity)"
+                     : error == EBUSY  ? " (deadline bandwidth admission refused)"
+                     : error == EINVAL ? " (parameters rejected by the kernel)"
+                                       : "";
+  if (params.fallback_priority.has_value()) {
+    FP_LOG_WARN_FMT(
+        "stage '{}' worker {} failed to set deadline schedule: {}{}; falling back to "
+        "real-time priority {}",
+        stage_name, worker_index, std::strerror(error), hint, params.fallback_priority.value());
+    ApplyRealtimePriority(stage_name, worker_index, params.fallback_priority.value());
+    return;
+  }
+  FP_LOG_WARN_FMT(
+      "stage '{}' worker {} failed to set deadline schedule: {}{}; keeping default scheduling",
+      stage_name, worker_index, std::strerror(error), hint);
+#else
+  (void)worker_index;
+  (void)params;
+  FP_LOG_WARN_FMT("deadline schedule requested for stage '{}' but not supported on this platform",
+                  stage_name);
+#endif
+}
+
 void ValidateCpuPinning(const std::string& stage_name, const std::vector<uint32_t>& cpus) {
 #ifdef __linux__
   if (cpus.empty()) {
@@ -178,6 +357,655 @@ void ApplyCpuPinning(const std::string& stage_name, uint32_t worker_index,
 #endif
 }
 
+void ApplyMemoryNode(const std::string& stage_name, uint32_t worker_index, uint32_t node) {
+  if (!PreferThreadMemoryNode(node)) {
+    FP_LOG_WARN_FMT("stage '{}' worker {} failed to prefer NUMA node {} for memory: {}",
+                    stage_name, worker_index, node, std::strerror(errno));
+    return;
+  }
+  FP_LOG_DEBUG_FMT("stage '{}' worker {} allocates on NUMA node {}", stage_name, worker_index,
+                   node);
+}
+
+enum class StageKind {
+  kSource,
+  kTransform,
+  kFlatMap,
+  kSink,
+  kBatchSink,
+  kAsyncTransform,
+  kAsyncSink,
+};
+
+const char* StageKindLabel(StageKind kind) {
+  switch (kind) {
+    case StageKind::kSource:
+      return "source";
+    case StageKind::kTransform:
+      return "transform";
+    case StageKind::kFlatMap:
+      return "flat-map";
+    case StageKind::kSink:
+      return "sink";
+    case StageKind::kBatchSink:
+      return "batch sink";
+    case StageKind::kAsyncTransform:
+      return "async transform";
+    case StageKind::kAsyncSink:
+      return "async sink";
+  }
+  return "unknown";
+}
+
+// Async stages drive their own event loop and batch sinks wait on linger
+// deadlines, so both keep a dedicated thread: they are never fused, pooled
+// or autoscaled.
+bool NeedsDedicatedThread(StageKind kind) {
+  return kind == StageKind::kBatchSink || kind == StageKind::kAsyncTransform ||
+         kind == StageKind::kAsyncSink;
+}
+
+std::optional<StageKind> DetectStageKind(IStage* stage) {
+  if (dynamic_cast<ISourceStage*>(stage)) {
+    return StageKind::kSource;
+  }
+  if (dynamic_cast<ITransformStage*>(stage)) {
+    return StageKind::kTransform;
+  }
+  if (dynamic_cast<IFlatMapStage*>(stage)) {
+    return StageKind::kFlatMap;
+  }
+  if (dynamic_cast<ISinkStage*>(stage)) {
+    return StageKind::kSink;
+  }
+  if (dynamic_cast<IBatchSinkStage*>(stage)) {
+    return StageKind::kBatchSink;
+  }
+  if (dynamic_cast<IAsyncTransformStage*>(stage)) {
+    return StageKind::kAsyncTransform;
+  }
+  if (dynamic_cast<IAsyncSinkStage*>(stage)) {
+    return StageKind::kAsyncSink;
+  }
+  return std::nullopt;
+}
+
+void RunStageWorker(StageKind kind, IStage* stage, StageContext& ctx, const QueueList& inputs,
+                    const QueueList& outputs, StageMetrics* metrics, const BatchOptions& batch,
+                    const TimerOptions& timers) {
+  switch (kind) {
+    case StageKind::kSource:
+      RunSourceStage(dynamic_cast<ISourceStage*>(stage), ctx, outputs, metrics);
+      break;
+    case StageKind::kTransform:
+      RunTransformStage(dynamic_cast<ITransformStage*>(stage), ctx, inputs, outputs, metrics,
+                        timers);
+      break;
+    case StageKind::kFlatMap:
+      RunFlatMapStage(dynamic_cast<IFlatMapStage*>(stage), ctx, inputs, outputs, metrics,
+                      timers);
+      break;
+    case StageKind::kSink:
+      RunSinkStage(dynamic_cast<ISinkStage*>(stage), ctx, inputs, metrics, timers);
+      break;
+    case StageKind::kBatchSink:
+      RunBatchSinkStage(dynamic_cast<IBatchSinkStage*>(stage), ctx, inputs, metrics, batch,
+                        timers);
+      break;
+    case StageKind::kAsyncTransform:
+      RunAsyncTransformStage(dynamic_cast<IAsyncTransformStage*>(stage), ctx, inputs, outputs,
+                             metrics);
+      break;
+    case StageKind::kAsyncSink:
+      RunAsyncSinkStage(dynamic_cast<IAsyncSinkStage*>(stage), ctx, inputs, metrics);
+      break;
+  }
+}
+
+// Timer hooks need a worker loop that can block with a deadline.
+bool HasStageTimers(const flowpipe::v1::StageSpec& stage) {
+  return stage.tick_ms() > 0 || stage.idle_ms() > 0;
+}
+
+// Pooled tasks and async workers hand payloads over with try_push() and
+// never block. A fused consumer would run inline on such a worker and block
+// it on its own full outputs, so these producers keep a real queue.
+bool PushesWithoutBlocking(const flowpipe::v1::FlowSpec& spec,
+                           const flowpipe::v1::StageSpec& stage, StageKind kind, bool pooled) {
+  if (kind == StageKind::kAsyncTransform) {
+    return true;
+  }
+  if (!pooled || NeedsDedicatedThread(kind) || HasStageTimers(stage) ||
+      ResolveRealtimePriority(stage).has_value() || stage.has_deadline()) {
+    return false;
+  }
+  const auto pinning = ResolveCpuPinning(spec, stage.name());
+  return !pinning.has_value() || pinning->empty();
+}
+
+// Worker bounds of an autoscaled stage.
+struct ThreadBounds {
+  uint32_t min = 0;
+  uint32_t max = 0;
+};
+
+// Returns nullopt when the stage runs a fixed number of workers.
+std::optional<ThreadBounds> ResolveThreadBounds(const flowpipe::v1::StageSpec& stage) {
+  if (!stage.has_min_threads() && !stage.has_max_threads()) {
+    return std::nullopt;
+  }
+
+  ThreadBounds bounds;
+  bounds.min = stage.has_min_threads() ? stage.min_threads() : stage.threads();
+  bounds.max = stage.has_max_threads() ? stage.max_threads() : stage.threads();
+  if (bounds.min < 1 || bounds.min > stage.threads() || stage.threads() > bounds.max) {
+    FP_LOG_ERROR_FMT(
+        "invalid stage '{}': autoscaling needs 1 <= min_threads ({}) <= threads ({}) <= "
+        "max_threads ({})",
+        stage.name(), bounds.min, stage.threads(), bounds.max);
+    throw std::runtime_error("invalid autoscaling bounds for stage: " + stage.name());
+  }
+
+  if (bounds.min == bounds.max) {
+    return std::nullopt;
+  }
+  return bounds;
+}
+
+// SIGUSR1 handler body, run on the supervisor thread.
+void LogLatencySnapshot() {
+  if (!observability::RuntimeMetrics::Get().histograms_enabled()) {
+    FP_LOG_WARN(
+        "latency snapshot requested, but histograms are not recorded; enable metrics or set "
+        "observability.metrics.histogram_socket");
+    return;
+  }
+  FP_LOG_INFO_FMT("latency snapshot requested:\n{}", observability::LatencyReport());
+}
+
+// Serves the scrape endpoint when a port is configured. The endpoint reads
+// RuntimeMetrics directly, so the sections the config asks for are recorded
+// even when no OTLP exporter turned them on.
+void StartPrometheusEndpoint(const flowpipe::v1::ObservabilityConfig::MetricsConfig& cfg,
+                             observability::PrometheusEndpoint& endpoint) {
+  if (cfg.prometheus_port() == 0) {
+    return;
+  }
+  if (cfg.prometheus_port() > UINT16_MAX) {
+    FP_LOG_WARN_FMT("prometheus endpoint: invalid port {}; not serving", cfg.prometheus_port());
+    return;
+  }
+
+  auto& metrics = observability::RuntimeMetrics::Get();
+  metrics.Configure(
+      metrics.stages_enabled() || !cfg.stage_metrics_disabled(),
+      metrics.queues_enabled() || !cfg.queue_metrics_disabled(),
+      metrics.histograms_enabled() || (!cfg.latency_histograms_disabled() && !cfg.counters_only()));
+  endpoint.Start(static_cast<uint16_t>(cfg.prometheus_port()),
+                 !cfg.counters_only() && !cfg.jemalloc_metrics_disabled());
+}
+
+SamplingOptions ResolveSampling(const flowpipe::v1::FlowSpec& spec) {
+  SamplingOptions sampling;
+  if (!spec.has_observability() || !spec.observability().has_sampling()) {
+    return sampling;
+  }
+
+  const auto& settings = spec.observability().sampling();
+  sampling.one_in = std::max<uint32_t>(1, settings.one_in());
+  sampling.max_per_second = settings.max_per_second();
+  if (sampling.one_in > 1 || sampling.max_per_second > 0) {
+    FP_LOG_INFO_FMT("observability sampling: 1 in {} records, max {}/s per worker (0 = no cap)",
+                    sampling.one_in, sampling.max_per_second);
+  }
+  return sampling;
+}
+
+AutoscalePolicy ResolveAutoscalePolicy(const flowpipe::v1::FlowSpec& spec) {
+  AutoscalePolicy policy;
+  if (!spec.has_execution() || !spec.execution().has_autoscale()) {
+    return policy;
+  }
+
+  const auto& settings = spec.execution().autoscale();
+  if (settings.interval_ms() > 0) {
+    policy.interval = std::chrono::milliseconds(settings.interval_ms());
+  }
+  if (settings.has_scale_up_occupancy()) {
+    policy.scale_up_occupancy = settings.scale_up_occupancy();
+  }
+  if (settings.has_scale_down_occupancy()) {
+    policy.scale_down_occupancy = settings.scale_down_occupancy();
+  }
+  if (settings.has_scale_up_dwell_ms()) {
+    policy.scale_up_dwell = std::chrono::milliseconds(settings.scale_up_dwell_ms());
+  }
+  if (settings.has_scale_up_samples()) {
+    policy.scale_up_samples = settings.scale_up_samples();
+  }
+  if (settings.has_scale_down_samples()) {
+    policy.scale_down_samples = settings.scale_down_samples();
+  }
+  if (settings.has_cooldown_ms()) {
+    policy.cooldown = std::chrono::milliseconds(settings.cooldown_ms());
+  }
+
+  // The gap between the two thresholds is the hysteresis band.
+  if (policy.scale_down_occupancy < 0.0 || policy.scale_up_occupancy > 1.0 ||
+      policy.scale_down_occupancy >= policy.scale_up_occupancy) {
+    FP_LOG_ERROR_FMT(
+        "invalid autoscale policy: needs 0 <= scale_down_occupancy ({}) < "
+        "scale_up_occupancy ({}) <= 1",
+        policy.scale_down_occupancy, policy.scale_up_occupancy);
+    throw std::runtime_error("invalid autoscale policy occupancy thresholds");
+  }
+
+  return policy;
+}
+
+// Queue names for one side of a stage: the singular field first, then the
+// repeated list, in spec order. ValidateFlowSpec has checked them.
+std::vector<std::string> ResolveStageQueues(
+    const std::optional<std::string>& single,
+    const google::protobuf::RepeatedPtrField<std::string>& extra) {
+  std::vector<std::string> names;
+  names.reserve((single ? 1 : 0) + extra.size());
+  if (single) {
+    names.push_back(*single);
+  }
+  names.insert(names.end(), extra.begin(), extra.end());
+  return names;
+}
+
+// Operator fusion plan: fused queue name -> index of its consumer stage.
+//
+// An edge is fused when fusion is enabled for the queue (or the flow), the
+// queue has exactly one producer and one consumer stage, both run a single
+// thread without autoscaling, and the consumer reads no other queue and has
+// no CPU pinning, realtime priority or deadline schedule of its own (it runs
+// on the producer's thread).
+std::unordered_map<std::string, int> PlanStageFusion(
+    const flowpipe::v1::FlowSpec& spec, const std::vector<std::vector<std::string>>& stage_inputs,
+    const std::vector<std::vector<std::string>>& stage_outputs,
+    const std::vector<std::optional<ThreadBounds>>& stage_bounds) {
+  const bool flow_default = spec.has_execution() && spec.execution().fuse_stages();
+
+  std::unordered_map<std::string, std::vector<int>> producers;
+  std::unordered_map<std::string, std::vector<int>> consumers;
+  for (int i = 0; i < spec.stages_size(); ++i) {
+    for (const auto& name : stage_outputs[i]) {
+      producers[name].push_back(i);
+    }
+    for (const auto& name : stage_inputs[i]) {
+      consumers[name].push_back(i);
+    }
+  }
+
+  std::unordered_map<std::string, int> fused;
+  std::unordered_map<int, int> fused_producer;  // consumer stage -> producer stage
+
+  for (const auto& q : spec.queues()) {
+    const bool enabled = q.has_fuse() ? q.fuse() : flow_default;
+    if (!enabled) {
+      continue;
+    }
+
+    const auto& queue_producers = producers[q.name()];
+    const auto& queue_consumers = consumers[q.name()];
+    if (queue_producers.size() != 1 || queue_consumers.size() != 1) {
+      FP_LOG_DEBUG_FMT("queue '{}' not fused: needs one producer and one consumer stage",
+                       q.name());
+      continue;
+    }
+
+    const int producer = queue_producers.front();
+    const int consumer = queue_consumers.front();
+    const auto& producer_spec = spec.stages(producer);
+    const auto& consumer_spec = spec.stages(consumer);
+    if (producer == consumer || producer_spec.threads() != 1 || consumer_spec.threads() != 1) {
+      FP_LOG_DEBUG_FMT("queue '{}' not fused: producer and consumer must be distinct stages "
+                       "with threads = 1",
+                       q.name());
+      continue;
+    }
+    if (stage_bounds[producer].has_value() || stage_bounds[consumer].has_value()) {
+      FP_LOG_DEBUG_FMT("queue '{}' not fused: autoscaled stages keep their own threads",
+                       q.name());
+      continue;
+    }
+    if (stage_inputs[consumer].size() != 1) {
+      FP_LOG_DEBUG_FMT("queue '{}' not fused: stage '{}' reads other queues", q.name(),
+                       consumer_spec.name());
+      continue;
+    }
+    if (HasStageTimers(consumer_spec)) {
+      FP_LOG_DEBUG_FMT("queue '{}' not fused: stage '{}' has timer hooks", q.name(),
+                       consumer_spec.name());
+      continue;
+    }
+    if (ResolveCpuPinning(spec, consumer_spec.name()).has_value() ||
+        ResolveRealtimePriority(consumer_spec).has_value() || consumer_spec.has_numa_node() ||
+        consumer_spec.has_deadline()) {
+      FP_LOG_DEBUG_FMT("queue '{}' not fused: stage '{}' has its own thread placement", q.name(),
+                       consumer_spec.name());
+      continue;
+    }
+
+    // Fusing every edge of a cycle would leave it without a thread.
+    bool cycle = false;
+    for (auto it = fused_producer.find(producer); it != fused_producer.end();
+         it = fused_producer.find(it->second)) {
+      if (it->second == consumer) {
+        cycle = true;
+        break;
+      }
+    }
+    if (cycle) {
+      FP_LOG_WARN_FMT("queue '{}' not fused: it closes a cycle of fused stages", q.name());
+      continue;
+    }
+
+    fused.emplace(q.name(), consumer);
+    fused_producer.emplace(consumer, producer);
+  }
+
+  return fused;
+}
+
+// Stage whose thread runs each stage: itself, or for a fused consumer the
+// producer it was fused into.
+std::vector<int> ResolveThreadOwners(const std::vector<std::vector<std::string>>& stage_inputs,
+                                     const std::vector<std::vector<std::string>>& stage_outputs,
+                                     const std::unordered_set<int>& fused_consumers) {
+  std::unordered_map<std::string, int> producer_of;
+  for (int i = 0; i < static_cast<int>(stage_outputs.size()); ++i) {
+    for (const auto& name : stage_outputs[i]) {
+      producer_of.emplace(name, i);
+    }
+  }
+  std::vector<int> owners(stage_inputs.size());
+  for (int i = 0; i < static_cast<int>(owners.size()); ++i) {
+    int stage = i;
+    while (fused_consumers.count(stage) > 0) {
+      stage = producer_of.at(stage_inputs[stage].front());
+    }
+    owners[i] = stage;
+  }
+  return owners;
+}
+
+bool AutoCpuPlacementEnabled(const flowpipe::v1::FlowSpec& spec) {
+  return spec.has_kubernetes() && spec.kubernetes().has_cpu_placement() &&
+         spec.kubernetes().cpu_placement().mode() == flowpipe::v1::CPU_PLACEMENT_MODE_AUTO;
+}
+
+// Automatic CPU placement for the stages that run on threads of their own
+// and have no cpu_pinning entry. A fused consumer runs on its producer's
+// thread, so its edges count as the producer's. Returns CPUs by stage name.
+std::unordered_map<std::string, std::vector<uint32_t>> PlanAutoCpuPlacement(
+    const flowpipe::v1::FlowSpec& spec, const std::vector<std::vector<std::string>>& stage_inputs,
+    const std::vector<std::vector<std::string>>& stage_outputs,
+    const std::vector<std::optional<ThreadBounds>>& stage_bounds,
+    const std::unordered_set<int>& fused_consumers, const std::vector<int>& thread_owners,
+    const std::unordered_map<std::string, std::unique_ptr<StageMetrics>>& stage_metrics) {
+  const auto& placement = spec.kubernetes().cpu_placement();
+  const std::unordered_set<std::string> hot_stages(placement.hot_stages().begin(),
+                                                   placement.hot_stages().end());
+
+  // CPUs claimed by cpu_pinning are not handed out again.
+  std::vector<uint32_t> usable = UsableCpus();
+  std::unordered_set<uint32_t> pinned;
+  for (const auto& [stage_name, cpu_set] : spec.kubernetes().cpu_pinning()) {
+    pinned.insert(cpu_set.cpu().begin(), cpu_set.cpu().end());
+  }
+  usable.erase(std::remove_if(usable.begin(), usable.end(),
+                              [&pinned](uint32_t cpu) { return pinned.count(cpu) > 0; }),
+               usable.end());
+
+  const auto topology = CpuTopology::Detect(usable);
+  FP_LOG_INFO_FMT(
+      "cpu placement: {} usable cpus ({}) in {} cores, {} L3 domains, {} NUMA nodes",
+      usable.size(), FormatCpuList(usable), topology.core_count(), topology.l3_count(),
+      topology.numa_node_count());
+  if (usable.empty()) {
+    FP_LOG_WARN_FMT("cpu placement: no usable cpus left; stages are not placed");
+    return {};
+  }
+
+  std::unordered_map<std::string, std::vector<int>> producers;
+  for (int i = 0; i < static_cast<int>(stage_outputs.size()); ++i) {
+    for (const auto& name : stage_outputs[i]) {
+      producers[name].push_back(i);
+    }
+  }
+
+  std::vector<PlacementRequest> requests;
+  std::unordered_map<int, size_t> request_index;
+  for (int i = 0; i < spec.stages_size(); ++i) {
+    const auto& stage = spec.stages(i);
+    // SCHED_DEADLINE needs an unrestricted affinity mask.
+    if (fused_consumers.count(i) > 0 || stage.has_numa_node() || stage.has_deadline() ||
+        spec.kubernetes().cpu_pinning().count(stage.name()) > 0) {
+      continue;
+    }
+    PlacementRequest request;
+    request.stage = stage.name();
+    request.workers = stage_bounds[i] ? stage_bounds[i]->max : stage.threads();
+    request.hot = hot_stages.empty() || hot_stages.count(stage.name()) > 0;
+    request_index.emplace(i, requests.size());
+    requests.push_back(std::move(request));
+  }
+
+  std::vector<std::pair<size_t, size_t>> edges;
+  for (int consumer = 0; consumer < static_cast<int>(stage_inputs.size()); ++consumer) {
+    for (const auto& name : stage_inputs[consumer]) {
+      auto it = producers.find(name);
+      if (it == producers.end()) {
+        continue;
+      }
+      for (const int producer : it->second) {
+        const auto from = request_index.find(thread_owners[producer]);
+        const auto to = request_index.find(thread_owners[consumer]);
+        if (from != request_index.end() && to != request_index.end() && from != to) {
+          edges.emplace_back(from->second, to->second);
+        }
+      }
+    }
+  }
+
+  std::unordered_map<std::string, std::vector<uint32_t>> cpus_by_stage;
+  for (const auto& planned : PlanCpuPlacement(topology, requests, edges)) {
+    std::unordered_set<uint32_t> l3_domains;
+    std::unordered_set<uint32_t> numa_nodes;
+    for (const auto cpu : planned.cpus) {
+      if (const auto* info = topology.find(cpu)) {
+        l3_domains.insert(info->l3);
+        numa_nodes.insert(info->numa_node);
+        stage_metrics.at(planned.stage)->RecordStageCpu(planned.stage.c_str(), cpu, info->l3,
+                                                        info->numa_node);
+      }
+    }
+    FP_LOG_INFO_FMT("cpu placement: stage '{}' -> cpus {} ({} L3 domains, {} NUMA nodes){}{}",
+                    planned.stage, FormatCpuList(planned.cpus), l3_domains.size(),
+                    numa_nodes.size(), planned.shares_smt ? ", shares SMT siblings" : "",
+                    planned.oversubscribed ? ", oversubscribed" : "");
+    if (planned.oversubscribed) {
+      FP_LOG_WARN_FMT("cpu placement: stage '{}' has more workers than cpus left for it",
+                      planned.stage);
+    }
+    cpus_by_stage.emplace(planned.stage, planned.cpus);
+  }
+  return cpus_by_stage;
+}
+
+void ValidateNumaNode(const char* kind, const std::string& name, uint32_t node,
+                      uint32_t node_count) {
+  if (node >= node_count) {
+    FP_LOG_ERROR_FMT("{} '{}' numa_node {} is out of range (host has {} NUMA nodes)", kind, name,
+                     node, node_count);
+    throw std::runtime_error(std::string("invalid numa_node for ") + kind + ": " + name);
+  }
+}
+
+// NUMA node of every stage: StageSpec.numa_node, else the node of its CPU
+// pinning when all its CPUs are on one node. Fused consumers share their
+// producer's node.
+std::vector<std::optional<uint32_t>> ResolveStageNumaNodes(
+    const flowpipe::v1::FlowSpec& spec,
+    const std::unordered_map<std::string, std::vector<uint32_t>>& auto_pinning,
+    const std::vector<int>& thread_owners, uint32_t node_count) {
+  std::vector<std::optional<uint32_t>> nodes(spec.stages_size());
+  for (int i = 0; i < spec.stages_size(); ++i) {
+    const auto& stage = spec.stages(i);
+    if (stage.has_numa_node()) {
+      ValidateNumaNode("stage", stage.name(), stage.numa_node(), node_count);
+      nodes[i] = stage.numa_node();
+      continue;
+    }
+    if (node_count < 2) {
+      continue;
+    }
+    auto cpus = ResolveCpuPinning(spec, stage.name());
+    if (!cpus.has_value()) {
+      const auto placed = auto_pinning.find(stage.name());
+      if (placed != auto_pinning.end()) {
+        cpus = placed->second;
+      }
+    }
+    if (cpus.has_value()) {
+      nodes[i] = NumaNodeOfCpus(*cpus);
+    }
+  }
+  for (int i = 0; i < spec.stages_size(); ++i) {
+    if (thread_owners[i] != i) {
+      nodes[i] = nodes[thread_owners[i]];
+    }
+  }
+  return nodes;
+}
+
+// The node shared by every stage in `stages`, if any.
+std::optional<uint32_t> CommonNumaNode(const std::vector<int>& stages,
+                                       const std::vector<std::optional<uint32_t>>& stage_nodes) {
+  std::optional<uint32_t> common;
+  for (const int stage : stages) {
+    if (!stage_nodes[stage].has_value() || (common && *common != *stage_nodes[stage])) {
+      return std::nullopt;
+    }
+    common = stage_nodes[stage];
+  }
+  return common;
+}
+
+// Creates `threads` configured instances of every stage on up to
+// `parallelism` threads and logs when each stage became ready. The first
+// instance of every stage is constructed and configured (loading plugins as
+// needed); the other workers are cloned from it when the stage supports
+// ConfigurableStage::clone() and built the same way otherwise. A prototype
+// is cloned by one builder at a time, so clone() needs no locking. Instances
+// stay owned by the registry, so the ones already built are released by its
+// shutdown() if a later one fails; the first failure is rethrown once every
+// builder has stopped.
+std::vector<std::vector<IStage*>> BuildStageInstances(StageRegistry& registry,
+                                                      const flowpipe::v1::FlowSpec& spec,
+                                                      size_t parallelism) {
+  using Clock = std::chrono::steady_clock;
+  struct Job {
+    int stage_index;
+    uint32_t worker;
+  };
+  std::vector<Job> prototypes;
+  std::vector<Job> replicas;
+  std::vector<std::vector<IStage*>> instances(spec.stages_size());
+  for (int i = 0; i < spec.stages_size(); ++i) {
+    instances[i].resize(spec.stages(i).threads(), nullptr);
+    prototypes.push_back(Job{i, 0});
+    for (uint32_t w = 1; w < spec.stages(i).threads(); ++w) {
+      replicas.push_back(Job{i, w});
+    }
+  }
+
+  const auto started = Clock::now();
+  std::vector<Clock::duration> busy(spec.stages_size(), Clock::duration::zero());
+  std::vector<Clock::time_point> ready(spec.stages_size(), started);
+  std::vector<uint32_t> cloned(spec.stages_size(), 0);
+  std::vector<std::mutex> clone_mutexes(spec.stages_size());  // one per prototype
+  std::mutex mutex;  // guards busy, ready, cloned and error
+  std::exception_ptr error;
+  size_t builders = 1;
+
+  auto run_jobs = [&](const std::vector<Job>& jobs) {
+    std::atomic<size_t> next{0};
+    auto build = [&]() {
+      for (size_t j = next.fetch_add(1); j < jobs.size(); j = next.fetch_add(1)) {
+        const auto& job = jobs[j];
+        const auto& stage_spec = spec.stages(job.stage_index);
+        auto& slot = instances[job.stage_index][job.worker];
+        const auto begin = Clock::now();
+        bool is_clone = false;
+        try {
+          if (job.worker > 0) {
+            std::lock_guard<std::mutex> clone_lock(clone_mutexes[job.stage_index]);
+            slot = registry.clone_stage(instances[job.stage_index].front());
+            is_clone = slot != nullptr;
+          }
+          if (!slot) {
+            slot = registry.create_stage(StagePluginName(stage_spec), &stage_spec.config());
+          }
+        } catch (...) {
+          std::lock_guard<std::mutex> lock(mutex);
+          if (!error) {
+            error = std::current_exception();
+          }
+          next.store(jobs.size());
+          return;
+        }
+        const auto end = Clock::now();
+        std::lock_guard<std::mutex> lock(mutex);
+        busy[job.stage_index] += end - begin;
+        ready[job.stage_index] = std::max(ready[job.stage_index], end);
+        cloned[job.stage_index] += is_clone ? 1 : 0;
+      }
+    };
+
+    const size_t wanted = std::max<size_t>(1, std::min(parallelism, jobs.size()));
+    std::vector<std::thread> threads;
+    threads.reserve(wanted - 1);
+    try {
+      for (size_t t = 1; t < wanted; ++t) {
+        threads.emplace_back(build);
+      }
+    } catch (...) {
+      // Fewer builders than planned; the calling thread still drains the jobs.
+    }
+    build();
+    for (auto& t : threads) {
+      t.join();
+    }
+    builders = std::max(builders, threads.size() + 1);
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  };
+
+  run_jobs(prototypes);
+  run_jobs(replicas);
+
+  using std::chrono::duration_cast;
+  using std::chrono::milliseconds;
+  for (int i = 0; i < spec.stages_size(); ++i) {
+    FP_LOG_INFO_FMT(
+        "startup: stage '{}' {} instance(s) ready at +{} ms ({} ms constructing, {} cloned)",
+        spec.stages(i).name(), instances[i].size(),
+        duration_cast<milliseconds>(ready[i] - started).count(),
+        duration_cast<milliseconds>(busy[i]).count(), cloned[i]);
+  }
+  FP_LOG_INFO_FMT("startup: built {} stage instances in {} ms on {} thread(s)",
+                  prototypes.size() + replicas.size(),
+                  duration_cast<milliseconds>(Clock::now() - started).count(), builders);
+  return instances;
+}
+
 }  // namespace
 
 Runtime::Runtime() = default;
@@ -185,9 +1013,14 @@ Runtime::Runtime() = default;
 int Runtime::run(const flowpipe::v1::FlowSpec& spec) {
   FP_LOG_INFO_FMT("runtime starting: {} stages, {} queues", spec.stages_size(), spec.queues_size());
 
+  // Queue capacities and types, stage names and thread counts, and the
+  // queues every stage lists; the checks that need plugins come later.
+  ValidateFlowSpec(spec);
+
   // Shared stop flag toggled by the signal handler for coordinated shutdown.
+  // Requesting stop wakes the supervisor loop below.
   std::atomic<bool> stop_flag{false};
-  StopToken stop{&stop_flag};
+  StopToken stop{&stop_flag, &SignalHandler::notify};
   const bool auto_shutdown =
       spec.has_execution() && spec.execution().mode() == flowpipe::v1::EXECUTION_MODE_JOB;
   std::atomic<size_t> active_workers{0};
@@ -198,24 +1031,8 @@ int Runtime::run(const flowpipe::v1::FlowSpec& spec) {
   std::unordered_map<std::string, std::shared_ptr<QueueRuntime>> queues;
 
   for (const auto& q : spec.queues()) {
-    // Validate queue configuration before allocating runtime structures.
     FP_LOG_DEBUG_FMT("configuring queue '{}' capacity={}", q.name(), q.capacity());
 
-    if (q.capacity() == 0) {
-      FP_LOG_ERROR_FMT("invalid queue '{}': capacity must be > 0", q.name());
-      throw std::runtime_error("queue capacity must be > 0: " + q.name());
-    }
-
-    if (q.has_schema() && q.schema().schema_id().empty()) {
-      FP_LOG_ERROR_FMT("invalid queue '{}': schema_id is required when schema is set", q.name());
-      throw std::runtime_error("queue schema_id is required: " + q.name());
-    }
-
-    if (queues.find(q.name()) != queues.end()) {
-      FP_LOG_ERROR_FMT("duplicate queue name '{}'", q.name());
-      throw std::runtime_error("duplicate queue name: " + q.name());
-    }
-
     auto qr = std::make_shared<QueueRuntime>();
     qr->name = q.name();
     qr->capacity = q.capacity();
@@ -223,18 +1040,8 @@ int Runtime::run(const flowpipe::v1::FlowSpec& spec) {
       qr->schema_id = q.schema().schema_id();
     }
 
-    auto queue_type = q.type();
-    if (queue_type == flowpipe::v1::QUEUE_TYPE_UNSPECIFIED) {
-      queue_type = flowpipe::v1::QUEUE_TYPE_IN_MEMORY;
-    }
-
-    if (queue_type != flowpipe::v1::QUEUE_TYPE_IN_MEMORY) {
-      FP_LOG_ERROR_FMT("unsupported queue type {} for queue '{}'", static_cast<int>(queue_type),
-                       q.name());
-      throw std::runtime_error("unsupported queue type for queue: " + q.name());
-    }
-
     qr->queue = std::make_shared<BoundedQueue<Payload>>(q.capacity());
+    qr->metrics_id = StageMetrics::BindQueue(spec.name(), qr->name);
 
     queues.emplace(qr->name, std::move(qr));
   }
@@ -253,21 +1060,96 @@ int Runtime::run(const flowpipe::v1::FlowSpec& spec) {
   // ------------------------------------------------------------
   // Shared context + metrics
   // ------------------------------------------------------------
-  // Runtime-owned context and metrics facade shared by all stage workers.
+  // Runtime-owned context shared by all stage workers. Workers, the
+  // autoscaler and CPU placement record through the stage's pre-bound
+  // metrics handle.
   StageContext ctx{stop};
-  StageMetrics metrics;
+  std::unordered_map<std::string, std::unique_ptr<StageMetrics>> stage_metrics;
+  const SamplingOptions sampling = ResolveSampling(spec);
+  for (const auto& s : spec.stages()) {
+    stage_metrics.try_emplace(s.name(),
+                              std::make_unique<StageMetrics>(spec.name(), s.name(), sampling));
+  }
+
+  // Hot-path timestamps (enqueue_ts_ns, stage latency) come from the TSC
+  // when requested and usable; EnableTscClock() logs why when it is not.
+  const bool tsc_clock = spec.has_execution() &&
+                         spec.execution().clock_source() == flowpipe::v1::CLOCK_SOURCE_TSC &&
+                         EnableTscClock();
+
+  // In-process latency quantiles: served on the histogram socket when one is
+  // configured, and logged on SIGUSR1 either way.
+  observability::LatencyEndpoint latency_endpoint;
+  if (spec.has_observability() && !spec.observability().metrics().histogram_socket().empty()) {
+    observability::RuntimeMetrics::Get().Configure(true, true, true);
+    latency_endpoint.Start(spec.observability().metrics().histogram_socket());
+  }
+
+  observability::PrometheusEndpoint prometheus_endpoint;
+  if (spec.has_observability()) {
+    StartPrometheusEndpoint(spec.observability().metrics(), prometheus_endpoint);
+  }
 
   std::vector<std::thread> threads;
+  std::unique_ptr<TaskPool> pool;
+  std::vector<std::unique_ptr<ScaledStage>> scaled_stages;
+  std::unique_ptr<Autoscaler> autoscaler;
   std::unordered_map<std::string, std::shared_ptr<std::atomic<uint32_t>>> queue_producer_workers;
 
-  auto join_workers = [&threads]() {
+  auto join_workers = [&threads, &pool, &scaled_stages, &autoscaler]() {
+    // Stop scaling first so no worker is added while we join.
+    if (autoscaler) {
+      autoscaler->Stop();
+    }
     for (auto& t : threads) {
       if (t.joinable()) {
         t.join();
       }
     }
+    for (auto& scaled : scaled_stages) {
+      scaled->Join();
+    }
+    if (pool) {
+      pool->Shutdown();
+    }
   };
 
+  // Consumer stages that run inline on their producer's thread, keyed by
+  // the fused input queue name.
+  struct FusedStage {
+    std::string name;
+    IStage* stage = nullptr;
+    QueueList outputs;
+    std::vector<std::shared_ptr<QueueRuntime>> out_queues;
+    std::vector<std::shared_ptr<std::atomic<uint32_t>>> out_producers;
+  };
+  std::unordered_map<std::string, std::unique_ptr<FusedStage>> fused_stages;
+
+  // Closes each output whose last producer has exited. A fused consumer
+  // finishes with its producer, so it releases its own outputs in turn.
+  std::function<void(const std::string&, const std::vector<std::shared_ptr<QueueRuntime>>&,
+                     const std::vector<std::shared_ptr<std::atomic<uint32_t>>>&)>
+      release_outputs = [&](const std::string& stage_name,
+                            const std::vector<std::shared_ptr<QueueRuntime>>& out_queues,
+                            const std::vector<std::shared_ptr<std::atomic<uint32_t>>>&
+                                out_producers) {
+        for (size_t o = 0; o < out_queues.size(); ++o) {
+          if (out_producers[o]->fetch_sub(1) != 1) {
+            continue;
+          }
+          FP_LOG_DEBUG_FMT("stage '{}' closing shared output queue '{}'", stage_name,
+                           out_queues[o]->name);
+          out_queues[o]->queue->close();
+
+          auto fused_it = fused_stages.find(out_queues[o]->name);
+          if (fused_it != fused_stages.end()) {
+            auto& fused_stage = *fused_it->second;
+            release_outputs(fused_stage.name, fused_stage.out_queues, fused_stage.out_producers);
+            registry_.destroy_stage(fused_stage.stage);
+          }
+        }
+      };
+
   auto close_runtime_queues = [&runtime_queues]() {
     for (const auto& queue : runtime_queues) {
       queue->close();
@@ -278,31 +1160,240 @@ int Runtime::run(const flowpipe::v1::FlowSpec& spec) {
   // Wire stages (runtime owns execution)
   // ------------------------------------------------------------
   try {
+    std::vector<std::vector<std::string>> stage_inputs;
+    std::vector<std::vector<std::string>> stage_outputs;
+    std::vector<std::optional<ThreadBounds>> stage_bounds;
     for (const auto& stage_spec : spec.stages()) {
-      if (!stage_spec.has_output_queue()) {
+      stage_bounds.push_back(ResolveThreadBounds(stage_spec));
+      stage_inputs.push_back(ResolveStageQueues(
+          stage_spec.has_input_queue() ? std::optional<std::string>(stage_spec.input_queue())
+                                       : std::nullopt,
+          stage_spec.input_queues()));
+      stage_outputs.push_back(ResolveStageQueues(
+          stage_spec.has_output_queue() ? std::optional<std::string>(stage_spec.output_queue())
+                                        : std::nullopt,
+          stage_spec.output_queues()));
+
+      for (const auto& output : stage_outputs.back()) {
+        auto& producer_count = queue_producer_workers[output];
+        if (!producer_count) {
+          producer_count = std::make_shared<std::atomic<uint32_t>>(0);
+        }
+        // An autoscaled stage releases its outputs once, when its last worker exits.
+        producer_count->fetch_add(stage_bounds.back() ? 1 : stage_spec.threads());
+      }
+    }
+
+    auto lookup_queues = [&queues](const std::vector<std::string>& names) {
+      std::vector<std::shared_ptr<QueueRuntime>> resolved;
+      resolved.reserve(names.size());
+      for (const auto& name : names) {
+        resolved.push_back(queues.at(name));
+      }
+      return resolved;
+    };
+
+    // Detects the stage interface and checks it against the queue wiring.
+    // Destroys the stage before throwing.
+    auto checked_stage_kind = [this](IStage* stage, const std::string& stage_name,
+                                     bool has_input, bool has_output) {
+      const auto detected = DetectStageKind(stage);
+      if (!detected.has_value()) {
+        FP_LOG_ERROR_FMT("stage '{}' does not implement a valid interface", stage_name);
+        registry_.destroy_stage(stage);
+        throw std::runtime_error("stage does not implement a valid interface: " + stage_name);
+      }
+      const StageKind kind = detected.value();
+      const char* kind_label = StageKindLabel(kind);
+
+      const bool wants_input = kind != StageKind::kSource;
+      const bool wants_output = kind != StageKind::kSink && kind != StageKind::kBatchSink &&
+                                kind != StageKind::kAsyncSink;
+      if (has_input != wants_input || has_output != wants_output) {
+        FP_LOG_ERROR_FMT("invalid {} stage wiring for '{}'", kind_label, stage_name);
+        registry_.destroy_stage(stage);
+        throw std::runtime_error(std::string("invalid ") + kind_label +
+                                 " stage wiring: " + stage_name);
+      }
+#ifndef __linux__
+      // The async runners' event loop is epoll-based.
+      if (kind == StageKind::kAsyncTransform || kind == StageKind::kAsyncSink) {
+        FP_LOG_ERROR_FMT("{} stage '{}' is not supported on this platform", kind_label,
+                         stage_name);
+        registry_.destroy_stage(stage);
+        throw std::runtime_error(std::string(kind_label) + " stage needs Linux: " + stage_name);
+      }
+#endif
+      return kind;
+    };
+
+    std::unordered_set<int> fused_consumers;
+    const AutoscalePolicy autoscale_policy = ResolveAutoscalePolicy(spec);
+
+    if (spec.has_execution() && spec.execution().executor() == flowpipe::v1::EXECUTOR_MODE_POOL) {
+      const size_t pool_threads = spec.execution().pool_threads() > 0
+                                      ? spec.execution().pool_threads()
+                                      : AvailableCpuCount();
+      pool = std::make_unique<TaskPool>(pool_threads);
+    }
+
+    const auto stage_instances = BuildStageInstances(registry_, spec, AvailableCpuCount());
+
+    const auto fusion = PlanStageFusion(spec, stage_inputs, stage_outputs, stage_bounds);
+    for (const auto& [queue_name, consumer] : fusion) {
+      const auto& s = spec.stages(consumer);
+      auto fused_stage = std::make_unique<FusedStage>();
+      fused_stage->name = s.name();
+      fused_stage->out_queues = lookup_queues(stage_outputs[consumer]);
+      for (const auto& q : fused_stage->out_queues) {
+        fused_stage->outputs.push_back(q.get());
+        fused_stage->out_producers.push_back(queue_producer_workers.at(q->name));
+      }
+
+      fused_stage->stage = stage_instances[consumer].front();
+      const StageKind kind =
+          checked_stage_kind(fused_stage->stage, s.name(), true, !stage_outputs[consumer].empty());
+      if (NeedsDedicatedThread(kind)) {
+        // The instance is reused when the stage gets its own thread below.
+        FP_LOG_INFO_FMT("queue '{}' not fused: {} stage '{}' needs its own thread", queue_name,
+                        StageKindLabel(kind), s.name());
+        continue;
+      }
+
+      int producer = 0;
+      while (std::find(stage_outputs[producer].begin(), stage_outputs[producer].end(),
+                       queue_name) == stage_outputs[producer].end()) {
+        ++producer;
+      }
+      const auto producer_kind = DetectStageKind(stage_instances[producer].front());
+      if (producer_kind.has_value() &&
+          PushesWithoutBlocking(spec, spec.stages(producer), producer_kind.value(),
+                                pool != nullptr)) {
+        FP_LOG_INFO_FMT("queue '{}' not fused: {} stage '{}' must not block on its consumer",
+                        queue_name, StageKindLabel(producer_kind.value()),
+                        spec.stages(producer).name());
         continue;
       }
 
-      auto& producer_count = queue_producer_workers[stage_spec.output_queue()];
-      if (!producer_count) {
-        producer_count = std::make_shared<std::atomic<uint32_t>>(0);
+      auto& input = *queues.at(queue_name);
+      input.queue =
+          MakeFusedQueue(fused_stage->stage, ctx, input, fused_stage->outputs,
+                         stage_metrics.at(s.name()).get());
+
+      FP_LOG_INFO_FMT("fused stage '{}' into its producer over queue '{}'", s.name(), queue_name);
+      fused_stages.emplace(queue_name, std::move(fused_stage));
+      fused_consumers.insert(consumer);
+    }
+
+    if (!fusion.empty()) {
+      runtime_queues.clear();
+      for (const auto& kv : queues) {
+        runtime_queues.push_back(kv.second->queue);
       }
-      producer_count->fetch_add(stage_spec.threads());
     }
 
-    for (const auto& s : spec.stages()) {
+    const auto thread_owners = ResolveThreadOwners(stage_inputs, stage_outputs, fused_consumers);
+    std::unordered_map<std::string, std::vector<uint32_t>> auto_pinning;
+    if (AutoCpuPlacementEnabled(spec)) {
+      if (pool) {
+        FP_LOG_WARN_FMT("cpu placement: automatic placement ignored with the pooled executor");
+      } else {
+        auto_pinning = PlanAutoCpuPlacement(spec, stage_inputs, stage_outputs, stage_bounds,
+                                            fused_consumers, thread_owners, stage_metrics);
+      }
+    }
+
+    // ------------------------------------------------------------
+    // NUMA binding: queue slots live on the node that reads them, and
+    // workers prefer their stage's node for everything they allocate.
+    // ------------------------------------------------------------
+    const uint32_t numa_node_count = NumaNodeCount();
+    const auto stage_nodes =
+        ResolveStageNumaNodes(spec, auto_pinning, thread_owners, numa_node_count);
+    {
+      std::unordered_map<std::string, std::vector<int>> queue_producers;
+      std::unordered_map<std::string, std::vector<int>> queue_consumers;
+      for (int i = 0; i < spec.stages_size(); ++i) {
+        for (const auto& name : stage_outputs[i]) {
+          queue_producers[name].push_back(i);
+        }
+        for (const auto& name : stage_inputs[i]) {
+          queue_consumers[name].push_back(i);
+        }
+      }
+
+      bool rebound = false;
+      for (const auto& q : spec.queues()) {
+        auto& qr = *queues.at(q.name());
+        const auto producer_node = CommonNumaNode(queue_producers[q.name()], stage_nodes);
+        const auto consumer_node = CommonNumaNode(queue_consumers[q.name()], stage_nodes);
+
+        std::optional<uint32_t> node = consumer_node ? consumer_node : producer_node;
+        if (q.has_numa_node()) {
+          ValidateNumaNode("queue", q.name(), q.numa_node(), numa_node_count);
+          node = q.numa_node();
+        }
+        // A fused queue has no storage of its own.
+        if (node.has_value() && fused_stages.count(q.name()) == 0) {
+          qr.queue = std::make_shared<BoundedQueue<Payload>>(
+              q.capacity(), std::make_shared<NumaMemoryResource>(*node));
+          qr.numa_node = node;
+          rebound = true;
+          FP_LOG_INFO_FMT("queue '{}' storage bound to NUMA node {}", q.name(), *node);
+        }
+
+        if (producer_node && consumer_node && *producer_node != *consumer_node &&
+            fused_stages.count(q.name()) == 0) {
+          qr.cross_node = true;
+          FP_LOG_WARN_FMT("queue '{}' crosses NUMA nodes: produced on node {}, consumed on node {}",
+                          q.name(), *producer_node, *consumer_node);
+        }
+      }
+
+      if (rebound) {
+        runtime_queues.clear();
+        for (const auto& kv : queues) {
+          runtime_queues.push_back(kv.second->queue);
+        }
+      }
+    }
+
+    for (int stage_index = 0; stage_index < spec.stages_size(); ++stage_index) {
+      const auto& s = spec.stages(stage_index);
       const std::string stage_name = s.name();
+      StageMetrics* const bound_metrics = stage_metrics.at(stage_name).get();
       FP_LOG_INFO_FMT("initializing stage '{}' type={} threads={}", stage_name, s.type(),
                       s.threads());
 
-      if (s.threads() < 1) {
-        FP_LOG_ERROR_FMT("invalid stage '{}': threads must be >= 1", s.name());
-        throw std::runtime_error("stage threads must be >= 1: " + s.name());
+      if (fused_consumers.count(stage_index) > 0) {
+        continue;
       }
 
-      const bool has_input = s.has_input_queue();
-      const bool has_output = s.has_output_queue();
-      const auto stage_pinning = ResolveCpuPinning(spec, stage_name);
+      const auto& input_names = stage_inputs[stage_index];
+      const auto& output_names = stage_outputs[stage_index];
+      const bool has_input = !input_names.empty();
+      const bool has_output = !output_names.empty();
+      auto stage_pinning = ResolveCpuPinning(spec, stage_name);
+      if (!stage_pinning.has_value()) {
+        const auto placed = auto_pinning.find(stage_name);
+        if (placed != auto_pinning.end()) {
+          stage_pinning = placed->second;
+        }
+      }
+      const auto numa_node = stage_nodes[stage_index];
+      if (!stage_pinning.has_value() && s.has_numa_node()) {
+        // A declared node without CPUs of its own runs on the node's CPUs.
+        const auto usable = UsableCpus();
+        std::vector<uint32_t> node_cpus;
+        for (const auto cpu : NumaNodeCpus(s.numa_node())) {
+          if (std::binary_search(usable.begin(), usable.end(), cpu)) {
+            node_cpus.push_back(cpu);
+          }
+        }
+        if (!node_cpus.empty()) {
+          stage_pinning = std::move(node_cpus);
+        }
+      }
       std::vector<uint32_t> pinning_cpus;
       if (stage_pinning.has_value()) {
         pinning_cpus = stage_pinning.value();
@@ -317,210 +1408,244 @@ int Runtime::run(const flowpipe::v1::FlowSpec& spec) {
       if (realtime_priority.has_value()) {
         ValidateRealtimePriority(stage_name, realtime_priority.value());
       }
-      const bool should_set_realtime = realtime_priority.has_value();
-
-      // Resolve plugin name: explicit plugin wins, otherwise default to type-based naming.
-      const std::string plugin_name = s.has_plugin() ? s.plugin() : "libstage_" + s.type() + ".so";
-      IStage* stage = registry_.create_stage(plugin_name, &s.config());
-      enum class StageKind { kSource, kTransform, kSink };
-      StageKind kind;
-
-      // ----------------------------
-      // Source stage
-      // ----------------------------
-      if (dynamic_cast<ISourceStage*>(stage)) {
-        kind = StageKind::kSource;
-        FP_LOG_DEBUG_FMT("stage '{}' detected as SOURCE", stage_name);
-
-        if (has_input || !has_output) {
-          FP_LOG_ERROR_FMT("invalid source stage wiring for '{}'", stage_name);
-          registry_.destroy_stage(stage);
-          throw std::runtime_error("invalid source stage wiring: " + stage_name);
-        }
-
-      } else if (dynamic_cast<ITransformStage*>(stage)) {
-        kind = StageKind::kTransform;
-        FP_LOG_DEBUG_FMT("stage '{}' detected as TRANSFORM", stage_name);
+      const auto deadline_schedule = ResolveDeadlineSchedule(s);
+      if (deadline_schedule.has_value()) {
+        const uint32_t max_workers = stage_bounds[stage_index] ? stage_bounds[stage_index]->max
+                                                               : s.threads();
+        ValidateDeadlineSchedule(stage_name, deadline_schedule.value(), max_workers,
+                                 realtime_priority.has_value(), should_pin);
+      }
+      const bool should_set_realtime =
+          realtime_priority.has_value() || deadline_schedule.has_value();
+
+      const std::string plugin_name = StagePluginName(s);
+      IStage* stage = stage_instances[stage_index].front();
+
+      const StageKind kind = checked_stage_kind(stage, stage_name, has_input, has_output);
+      const char* kind_label = StageKindLabel(kind);
+      FP_LOG_DEBUG_FMT("stage '{}' detected as {} (inputs={}, outputs={})", stage_name,
+                       kind_label, input_names.size(), output_names.size());
+
+      // Stages linked into the binary run a loop specialized on their class;
+      // pooled, fused and autoscaled workers keep the generic runners.
+      StaticRunFn static_run = nullptr;
+      if (const StaticStage* linked = FindStaticStage(plugin_name);
+          linked && (kind == StageKind::kSource || kind == StageKind::kTransform ||
+                     kind == StageKind::kFlatMap || kind == StageKind::kSink)) {
+        static_run = linked->run;
+      }
 
-        if (!has_input || !has_output) {
-          FP_LOG_ERROR_FMT("invalid transform stage wiring for '{}'", stage_name);
-          registry_.destroy_stage(stage);
-          throw std::runtime_error("invalid transform stage wiring: " + stage_name);
+      BatchOptions batch;
+      if (s.has_batch_size() || s.has_linger_ms()) {
+        if (kind != StageKind::kBatchSink) {
+          FP_LOG_WARN_FMT("stage '{}' is a {} stage; batch_size/linger_ms ignored", stage_name,
+                          kind_label);
         }
-      } else if (dynamic_cast<ISinkStage*>(stage)) {
-        kind = StageKind::kSink;
-        FP_LOG_DEBUG_FMT("stage '{}' detected as SINK", stage_name);
-
-        if (!has_input || has_output) {
-          FP_LOG_ERROR_FMT("invalid sink stage wiring for '{}'", stage_name);
-          registry_.destroy_stage(stage);
-          throw std::runtime_error("invalid sink stage wiring: " + stage_name);
+        if (s.batch_size() > 0) {
+          batch.max_size = s.batch_size();
         }
-      } else {
-        FP_LOG_ERROR_FMT("stage '{}' does not implement a valid interface", stage_name);
-        registry_.destroy_stage(stage);
-        throw std::runtime_error("stage does not implement a valid interface: " + stage_name);
+        batch.linger = std::chrono::milliseconds(s.linger_ms());
       }
 
-      std::vector<IStage*> worker_stages;
-      worker_stages.reserve(s.threads());
-      worker_stages.push_back(stage);
+      TimerOptions timers;
+      timers.tick = std::chrono::milliseconds(s.tick_ms());
+      timers.idle = std::chrono::milliseconds(s.idle_ms());
+      const bool timers_unsupported = kind == StageKind::kSource ||
+                                      kind == StageKind::kAsyncTransform ||
+                                      kind == StageKind::kAsyncSink;
+      if (HasStageTimers(s) && timers_unsupported) {
+        FP_LOG_WARN_FMT("stage '{}' is a {} stage; tick_ms/idle_ms ignored", stage_name,
+                        kind_label);
+      }
 
+      std::vector<std::shared_ptr<QueueRuntime>> in_queues;
+      std::vector<std::shared_ptr<QueueRuntime>> out_queues;
       try {
-        for (uint32_t i = 1; i < s.threads(); ++i) {
-          worker_stages.push_back(registry_.create_stage(plugin_name, &s.config()));
-        }
+        in_queues = lookup_queues(input_names);
+        out_queues = lookup_queues(output_names);
       } catch (...) {
-        for (auto* worker_stage : worker_stages) {
-          registry_.destroy_stage(worker_stage);
-        }
+        registry_.destroy_stage(stage);
         throw;
       }
 
-      if (kind == StageKind::kSource) {
-        auto out = queues.at(s.output_queue());
-        auto queue_remaining_producers = queue_producer_workers.at(s.output_queue());
-        for (uint32_t i = 0; i < worker_stages.size(); ++i) {
-          auto* worker_stage = worker_stages[i];
-          auto* src = dynamic_cast<ISourceStage*>(worker_stage);
-          if (!src) {
-            FP_LOG_ERROR_FMT("source worker stage '{}' does not implement source interface",
-                             stage_name);
-            throw std::runtime_error("worker stage is not a source: " + stage_name);
-          }
+      std::vector<std::shared_ptr<std::atomic<uint32_t>>> out_producers;
+      out_producers.reserve(output_names.size());
+      for (const auto& name : output_names) {
+        out_producers.push_back(queue_producer_workers.at(name));
+      }
 
-          active_workers.fetch_add(1);
-          try {
-            threads.emplace_back([&, src, worker_stage, out, i, stage_name, should_pin,
-                                  pinning_cpus, should_set_realtime, realtime_priority,
-                                  queue_remaining_producers]() {
-              if (should_pin) {
-                ApplyCpuPinning(stage_name, i, pinning_cpus);
-              }
-              if (should_set_realtime) {
-                ApplyRealtimePriority(stage_name, i, realtime_priority.value());
-              }
-              FP_LOG_DEBUG_FMT("stage '{}' source worker {} started", stage_name, i);
-
-              RunSourceStage(src, ctx, *out, &metrics);
-
-              if (queue_remaining_producers->fetch_sub(1) == 1) {
-                FP_LOG_DEBUG_FMT("stage '{}' source worker {} closing shared output queue",
-                                 stage_name, i);
-                out->queue->close();
-              }
-
-              registry_.destroy_stage(worker_stage);
-
-              FP_LOG_DEBUG_FMT("stage '{}' source worker {} stopped", stage_name, i);
-              if (auto_shutdown) {
-                if (active_workers.fetch_sub(1) == 1) {
-                  stop.request_stop();
-                }
-              } else {
-                active_workers.fetch_sub(1);
-              }
-            });
-          } catch (...) {
-            active_workers.fetch_sub(1);
-            throw;
+      std::vector<IStage*> worker_stages = stage_instances[stage_index];
+
+      QueueList inputs;
+      for (const auto& q : in_queues) {
+        inputs.push_back(q.get());
+      }
+      QueueList outputs;
+      for (const auto& q : out_queues) {
+        outputs.push_back(q.get());
+      }
+
+      const auto& bounds = stage_bounds[stage_index];
+      if (bounds.has_value()) {
+        if (kind == StageKind::kSource || NeedsDedicatedThread(kind)) {
+          FP_LOG_ERROR_FMT("stage '{}' cannot autoscale: {} stages are not supported",
+                           stage_name, kind_label);
+          for (auto* worker_stage : worker_stages) {
+            registry_.destroy_stage(worker_stage);
           }
+          throw std::runtime_error(std::string("autoscaling is not supported for ") +
+                                   kind_label + " stage: " + stage_name);
         }
-      } else if (kind == StageKind::kTransform) {
-        auto in = queues.at(s.input_queue());
-        auto out = queues.at(s.output_queue());
-        auto queue_remaining_producers = queue_producer_workers.at(s.output_queue());
-        for (uint32_t i = 0; i < worker_stages.size(); ++i) {
-          auto* worker_stage = worker_stages[i];
-          auto* xf = dynamic_cast<ITransformStage*>(worker_stage);
-          if (!xf) {
-            FP_LOG_ERROR_FMT("transform worker stage '{}' does not implement transform interface",
-                             stage_name);
-            throw std::runtime_error("worker stage is not a transform: " + stage_name);
+        for (auto* worker_stage : worker_stages) {
+          if (DetectStageKind(worker_stage) != kind) {
+            FP_LOG_ERROR_FMT("{} worker stage '{}' does not implement {} interface", kind_label,
+                             stage_name, kind_label);
+            throw std::runtime_error(std::string("worker stage is not a ") + kind_label + ": " +
+                                     stage_name);
           }
+        }
 
-          active_workers.fetch_add(1);
-          try {
-            threads.emplace_back([&, xf, worker_stage, in, out, i, stage_name, should_pin,
-                                  pinning_cpus, should_set_realtime, realtime_priority,
-                                  queue_remaining_producers]() {
-              if (should_pin) {
-                ApplyCpuPinning(stage_name, i, pinning_cpus);
-              }
-              if (should_set_realtime) {
-                ApplyRealtimePriority(stage_name, i, realtime_priority.value());
-              }
-              FP_LOG_DEBUG_FMT("stage '{}' transform worker {} started", stage_name, i);
-
-              RunTransformStage(xf, ctx, *in, *out, &metrics);
-
-              if (queue_remaining_producers->fetch_sub(1) == 1) {
-                FP_LOG_DEBUG_FMT("stage '{}' transform worker {} closing shared output queue",
-                                 stage_name, i);
-                out->queue->close();
-              }
-
-              registry_.destroy_stage(worker_stage);
-
-              FP_LOG_DEBUG_FMT("stage '{}' transform worker {} stopped", stage_name, i);
-              if (auto_shutdown) {
-                if (active_workers.fetch_sub(1) == 1) {
-                  stop.request_stop();
-                }
-              } else {
-                active_workers.fetch_sub(1);
-              }
-            });
-          } catch (...) {
-            active_workers.fetch_sub(1);
-            throw;
+        ScaledStage::Hooks hooks;
+        hooks.create = [this, plugin_name, config = &s.config(), kind, kind_label,
+                        stage_name]() {
+          IStage* added = registry_.create_stage(plugin_name, config);
+          if (DetectStageKind(added) != kind) {
+            registry_.destroy_stage(added);
+            throw std::runtime_error(std::string("worker stage is not a ") + kind_label + ": " +
+                                     stage_name);
           }
-        }
-      } else if (kind == StageKind::kSink) {
-        auto in = queues.at(s.input_queue());
-        for (uint32_t i = 0; i < worker_stages.size(); ++i) {
-          auto* worker_stage = worker_stages[i];
-          auto* sink = dynamic_cast<ISinkStage*>(worker_stage);
-          if (!sink) {
-            FP_LOG_ERROR_FMT("sink worker stage '{}' does not implement sink interface",
-                             stage_name);
-            throw std::runtime_error("worker stage is not a sink: " + stage_name);
+          return added;
+        };
+        hooks.run = [&ctx, inputs, outputs, stage_name, should_pin, pinning_cpus, numa_node,
+                     should_set_realtime, realtime_priority, deadline_schedule, timers](
+                        IStage* worker_stage, uint32_t i, const std::atomic<bool>& retire,
+                        StageMetrics* worker_metrics) {
+          if (should_pin) {
+            ApplyCpuPinning(stage_name, i, pinning_cpus);
           }
+          if (numa_node.has_value()) {
+            ApplyMemoryNode(stage_name, i, *numa_node);
+          }
+          if (deadline_schedule.has_value()) {
+            ApplyDeadlineSchedule(stage_name, i, deadline_schedule.value());
+          } else if (should_set_realtime) {
+            ApplyRealtimePriority(stage_name, i, realtime_priority.value());
+          }
+          RunRetirableWorker(worker_stage, ctx, inputs, outputs, worker_metrics, retire, timers);
+        };
+        hooks.destroy = [this](IStage* worker_stage) { registry_.destroy_stage(worker_stage); };
+        hooks.finished = [&, out_queues, out_producers, stage_name]() {
+          release_outputs(stage_name, out_queues, out_producers);
+          FP_LOG_DEBUG_FMT("autoscaled stage '{}' stopped", stage_name);
+          if (active_workers.fetch_sub(1) == 1 && auto_shutdown) {
+            stop.request_stop();
+          }
+        };
+
+        if (pool) {
+          FP_LOG_INFO_FMT("stage '{}' keeps dedicated threads", stage_name);
+        }
 
-          active_workers.fetch_add(1);
-          try {
-            threads.emplace_back([&, sink, worker_stage, in, i, stage_name, should_pin,
-                                  pinning_cpus, should_set_realtime, realtime_priority]() {
-              if (should_pin) {
-                ApplyCpuPinning(stage_name, i, pinning_cpus);
-              }
-              if (should_set_realtime) {
-                ApplyRealtimePriority(stage_name, i, realtime_priority.value());
-              }
-              FP_LOG_DEBUG_FMT("stage '{}' sink worker {} started", stage_name, i);
-
-              RunSinkStage(sink, ctx, *in, &metrics);
-
-              registry_.destroy_stage(worker_stage);
-
-              FP_LOG_DEBUG_FMT("stage '{}' sink worker {} stopped", stage_name, i);
-              if (auto_shutdown) {
-                if (active_workers.fetch_sub(1) == 1) {
-                  stop.request_stop();
-                }
-              } else {
-                active_workers.fetch_sub(1);
-              }
-            });
-          } catch (...) {
+        // The whole stage counts as one active worker until its last thread exits.
+        active_workers.fetch_add(1);
+        scaled_stages.push_back(std::make_unique<ScaledStage>(
+            stage_name, inputs, bounds->min, bounds->max, autoscale_policy, bound_metrics,
+            std::move(hooks)));
+        scaled_stages.back()->Start(worker_stages);
+        continue;
+      }
+
+      // Pinned, realtime and deadline stages keep dedicated threads so their
+      // placement holds; timer hooks need a worker that can block with a deadline.
+      const bool pooled = pool && !should_pin && !should_set_realtime &&
+                          !NeedsDedicatedThread(kind) && !HasStageTimers(s);
+      if (pool && !pooled) {
+        FP_LOG_INFO_FMT("stage '{}' keeps dedicated threads", stage_name);
+      }
+
+      for (uint32_t i = 0; i < worker_stages.size(); ++i) {
+        auto* worker_stage = worker_stages[i];
+        if (DetectStageKind(worker_stage) != kind) {
+          FP_LOG_ERROR_FMT("{} worker stage '{}' does not implement {} interface", kind_label,
+                           stage_name, kind_label);
+          throw std::runtime_error(std::string("worker stage is not a ") + kind_label + ": " +
+                                   stage_name);
+        }
+
+        auto finish_worker = [&, kind_label, worker_stage, out_queues, out_producers, i,
+                              stage_name]() {
+          // The last producer of each output closes it so consumers drain and exit.
+          release_outputs(stage_name, out_queues, out_producers);
+
+          registry_.destroy_stage(worker_stage);
+
+          FP_LOG_DEBUG_FMT("stage '{}' {} worker {} stopped", stage_name, kind_label, i);
+          if (auto_shutdown) {
+            if (active_workers.fetch_sub(1) == 1) {
+              stop.request_stop();
+            }
+          } else {
             active_workers.fetch_sub(1);
-            throw;
           }
+        };
+
+        active_workers.fetch_add(1);
+        try {
+          if (pooled) {
+            pool->Submit(MakeStageTask(worker_stage, ctx, inputs, outputs, bound_metrics),
+                         std::move(finish_worker));
+            FP_LOG_DEBUG_FMT("stage '{}' {} worker {} submitted to pool", stage_name, kind_label,
+                             i);
+            continue;
+          }
+
+          threads.emplace_back([&, kind, kind_label, worker_stage, inputs, outputs, i,
+                                stage_name, should_pin, pinning_cpus, numa_node,
+                                should_set_realtime, realtime_priority, deadline_schedule,
+                                batch, timers, static_run, bound_metrics, finish_worker]() {
+            if (should_pin) {
+              ApplyCpuPinning(stage_name, i, pinning_cpus);
+            }
+            if (numa_node.has_value()) {
+              ApplyMemoryNode(stage_name, i, *numa_node);
+            }
+            if (deadline_schedule.has_value()) {
+              ApplyDeadlineSchedule(stage_name, i, deadline_schedule.value());
+            } else if (should_set_realtime) {
+              ApplyRealtimePriority(stage_name, i, realtime_priority.value());
+            }
+            FP_LOG_DEBUG_FMT("stage '{}' {} worker {} started", stage_name, kind_label, i);
+
+            if (static_run) {
+              static_run(worker_stage, ctx, inputs, outputs, bound_metrics, timers);
+            } else {
+              RunStageWorker(kind, worker_stage, ctx, inputs, outputs, bound_metrics, batch,
+                             timers);
+            }
+
+            finish_worker();
+          });
+        } catch (...) {
+          active_workers.fetch_sub(1);
+          throw;
         }
       }
     }
 
-    FP_LOG_INFO_FMT("runtime started {} worker threads", threads.size());
+    if (!scaled_stages.empty()) {
+      autoscaler = std::make_unique<Autoscaler>(autoscale_policy.interval);
+      for (auto& scaled : scaled_stages) {
+        autoscaler->Add(scaled.get());
+      }
+      autoscaler->Start();
+    }
+
+    if (pool) {
+      FP_LOG_INFO_FMT("runtime started {} dedicated worker threads and a {}-thread task pool",
+                      threads.size(), pool->size());
+    } else {
+      FP_LOG_INFO_FMT("runtime started {} worker threads", threads.size());
+    }
 
     if (auto_shutdown && active_workers.load() == 0) {
       stop.request_stop();
@@ -530,12 +1655,18 @@ int Runtime::run(const flowpipe::v1::FlowSpec& spec) {
     // Join
     // ------------------------------------------------------------
     while (!stop.stop_requested()) {
-      // Relay any OS signal (SIGINT/SIGTERM) received since the last iteration
+      // Relay any OS signal (SIGINT/SIGTERM) received since the last wakeup
       // to the stop flag. This is the only place where the sig_atomic_t flag
       // written by the signal handler is bridged to the atomic<bool> stop flag,
       // keeping the signal handler itself async-signal-safe.
-      SignalHandler::relay();
-      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+      if (SignalHandler::relay()) {
+        break;
+      }
+      if (SignalHandler::take_dump_request()) {
+        LogLatencySnapshot();
+      }
+      // Sleeps until a signal arrives or a worker requests stop.
+      SignalHandler::wait();
     }
 
     close_runtime_queues();
@@ -544,10 +1675,17 @@ int Runtime::run(const flowpipe::v1::FlowSpec& spec) {
     stop.request_stop();
     close_runtime_queues();
     join_workers();
+    if (tsc_clock) {
+      DisableTscClock();
+    }
     registry_.shutdown();
     throw;
   }
 
+  if (tsc_clock) {
+    DisableTscClock();
+  }
+
   FP_LOG_INFO("runtime shutting down");
 
   registry_.shutdown();
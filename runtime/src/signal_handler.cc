@@ -1,25 +1,55 @@
 #include "flowpipe/signal_handler.h"
 
+#include <cerrno>
+#include <chrono>
 #include <csignal>
+#include <cstdint>
+#include <thread>
+
+#ifdef __linux__
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
 
 namespace flowpipe {
 
 // Written only from the signal handler using async-signal-safe assignment.
 static volatile sig_atomic_t g_signaled = 0;
+static volatile sig_atomic_t g_dump_requested = 0;
 
 // Pointer to the runtime stop flag, set once from the main thread before any
 // signal can be delivered.
 static std::atomic<bool>* g_stop_flag = nullptr;
 
+// Blocking eventfd the main thread sleeps on; -1 when unavailable. Created
+// once and kept for the lifetime of the process.
+static int g_wake_fd = -1;
+
 static void handle_signal(int) {
   // Only sig_atomic_t assignment is guaranteed async-signal-safe by POSIX.
-  // The actual atomic<bool> store is done from the main thread via relay().
+  // The actual atomic<bool> store is done from the main thread via relay();
+  // notify() only calls write(), which is async-signal-safe as well.
   g_signaled = 1;
+  SignalHandler::notify();
+}
+
+static void handle_dump_signal(int) {
+  g_dump_requested = 1;
+  SignalHandler::notify();
 }
 
 void SignalHandler::install(std::atomic<bool>& stop_flag) {
   g_stop_flag = &stop_flag;
 
+#ifdef __linux__
+  // A signalfd would need SIGINT/SIGTERM blocked in every thread, including
+  // ones plugins or exporters started before us; the handler writes to an
+  // eventfd instead.
+  if (g_wake_fd < 0) {
+    g_wake_fd = eventfd(0, EFD_CLOEXEC);
+  }
+#endif
+
   struct sigaction sa {};
   sa.sa_handler = handle_signal;
   sigemptyset(&sa.sa_mask);
@@ -27,6 +57,9 @@ void SignalHandler::install(std::atomic<bool>& stop_flag) {
   sa.sa_flags = SA_RESTART;
   sigaction(SIGINT, &sa, nullptr);
   sigaction(SIGTERM, &sa, nullptr);
+
+  sa.sa_handler = handle_dump_signal;
+  sigaction(SIGUSR1, &sa, nullptr);
 }
 
 bool SignalHandler::relay() noexcept {
@@ -37,4 +70,35 @@ bool SignalHandler::relay() noexcept {
   return false;
 }
 
+bool SignalHandler::take_dump_request() noexcept {
+  if (!g_dump_requested) {
+    return false;
+  }
+  g_dump_requested = 0;
+  return true;
+}
+
+void SignalHandler::notify() noexcept {
+#ifdef __linux__
+  if (g_wake_fd >= 0) {
+    const int saved_errno = errno;
+    const uint64_t one = 1;
+    [[maybe_unused]] const auto written = write(g_wake_fd, &one, sizeof(one));
+    errno = saved_errno;
+  }
+#endif
+}
+
+void SignalHandler::wait() noexcept {
+#ifdef __linux__
+  if (g_wake_fd >= 0) {
+    uint64_t count = 0;
+    while (read(g_wake_fd, &count, sizeof(count)) < 0 && errno == EINTR) {
+    }
+    return;
+  }
+#endif
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+}
+
 }  // namespace flowpipe
@@ -6,11 +6,23 @@
 #include <sstream>
 #include <stdexcept>
 
+#include "flowpipe/static_stage.h"
+
 namespace flowpipe {
 
 StageFactory::StageFactory(std::string plugin_dir) : plugin_dir_(std::move(plugin_dir)) {}
 
 LoadedPlugin StageFactory::load(const std::string& plugin_name) {
+  // Stages linked into the binary win over a plugin file of the same name.
+  if (const StaticStage* stage = FindStaticStage(plugin_name)) {
+    return LoadedPlugin{
+        .handle = nullptr,
+        .create = stage->create,
+        .destroy = stage->destroy,
+        .path = std::string("static:") + stage->type,
+    };
+  }
+
   std::string path = resolve_path(plugin_name);
 
   dlerror();  // clear any previous error
@@ -1,145 +1,186 @@
 #include "flowpipe/stage_metrics.h"
 
-#include "flowpipe/observability/metrics.h"
-#include "flowpipe/observability/observability_state.h"
+#include "flowpipe/clock.h"
+#include "flowpipe/observability/runtime_metrics.h"
 #include "flowpipe/payload.h"
 #include "flowpipe/queue_runtime.h"
 
-#if FLOWPIPE_ENABLE_OTEL
-#include <opentelemetry/context/runtime_context.h>
-#include <opentelemetry/metrics/provider.h>
+namespace flowpipe {
 
-#include <chrono>
-#endif
+namespace {
 
-namespace flowpipe {
+observability::MetricLabels SeriesLabels(const std::string& flow_name, const char* key,
+                                         const std::string& name) {
+  observability::MetricLabels labels;
+  if (!flow_name.empty()) {
+    labels.emplace_back("flow", flow_name);
+  }
+  labels.emplace_back(key, name);
+  return labels;
+}
 
-#if FLOWPIPE_ENABLE_OTEL
+observability::QueueShard& QueueShardFor(observability::RuntimeMetrics& metrics,
+                                         const QueueRuntime& queue) {
+  return queue.metrics_id != UINT32_MAX ? metrics.queue(queue.metrics_id)
+                                        : metrics.queue(queue.name);
+}
 
-// Single meter instance shared by all Record* methods.
-static opentelemetry::nostd::shared_ptr<opentelemetry::metrics::Meter>& GetMeter() {
-  static auto meter =
-      opentelemetry::metrics::Provider::GetMeterProvider()->GetMeter("flowpipe.runtime", "1.0.0");
-  return meter;
+void CountDequeue(observability::QueueShard& shard, const QueueRuntime& queue,
+                  const Payload& payload) noexcept {
+  shard.dequeued.add();
+  if (queue.cross_node) {
+    shard.cross_node.add();
+    shard.cross_node_bytes.add(payload.size);
+  }
 }
 
-#endif  // FLOWPIPE_ENABLE_OTEL
+}  // namespace
+
+StageMetrics::StageMetrics(const std::string& flow_name, const std::string& stage_name,
+                           const SamplingOptions& sampling)
+    : stage_series_(observability::RuntimeMetrics::Get().RegisterStage(
+          SeriesLabels(flow_name, "stage", stage_name))),
+      sampling_(sampling) {}
+
+uint32_t StageMetrics::BindQueue(const std::string& flow_name, const std::string& queue_name) {
+  return observability::RuntimeMetrics::Get().RegisterQueue(
+      SeriesLabels(flow_name, "queue", queue_name));
+}
 
 // ------------------------------------------------------------
 // Queue metrics
 // ------------------------------------------------------------
+// Queue and stage records land in the calling thread's RuntimeMetrics shard;
+// exporters fold the shards when they collect.
 void StageMetrics::RecordQueueDequeue(const QueueRuntime& queue, const Payload& payload) noexcept {
-#if FLOWPIPE_ENABLE_OTEL
-  auto& state = observability::GetOtelState();
-  if (!state.queue_metrics_enabled) {
+  auto& metrics = observability::RuntimeMetrics::Get();
+  if (!metrics.queues_enabled()) {
     return;
   }
 
-  static const auto counter = GetMeter()->CreateUInt64Counter(
-      "flowpipe.queue.dequeue.count", "Number of records dequeued from queue");
-  static const auto dwell = GetMeter()->CreateUInt64Histogram("flowpipe.queue.dwell_ns",
-                                                              "Time records spent in queue (ns)");
-
-  const uint64_t now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
-                              std::chrono::steady_clock::now().time_since_epoch())
-                              .count();
-
-  const uint64_t dwell_ns =
-      payload.meta.enqueue_ts_ns > 0 ? now_ns - payload.meta.enqueue_ts_ns : 0;
+  auto& shard = QueueShardFor(metrics, queue);
+  CountDequeue(shard, queue, payload);
 
-  auto labels = std::initializer_list<
-      std::pair<opentelemetry::nostd::string_view, opentelemetry::common::AttributeValue>>{
-      {"queue", queue.name}};
-
-  auto ctx = opentelemetry::context::RuntimeContext::GetCurrent();
-
-  counter->Add(1, labels, ctx);
+  if (metrics.histograms_enabled() && payload.meta.enqueue_ts_ns > 0) {
+    const uint64_t now_ns = FastNowNs();
+    if (now_ns > payload.meta.enqueue_ts_ns) {
+      shard.dwell.record(now_ns - payload.meta.enqueue_ts_ns);
+    }
+  }
+}
 
-  if (state.latency_histograms && dwell_ns > 0) {
-    dwell->Record(dwell_ns, labels, ctx);
+void StageMetrics::CountQueueDequeue(const QueueRuntime& queue, const Payload& payload) noexcept {
+  auto& metrics = observability::RuntimeMetrics::Get();
+  if (!metrics.queues_enabled()) {
+    return;
   }
 
-#else
-  (void)queue;
-  (void)payload;
-#endif
+  CountDequeue(QueueShardFor(metrics, queue), queue, payload);
 }
 
 void StageMetrics::RecordQueueEnqueue(const QueueRuntime& queue) noexcept {
-#if FLOWPIPE_ENABLE_OTEL
-  auto& state = observability::GetOtelState();
-  if (!state.queue_metrics_enabled) {
+  auto& metrics = observability::RuntimeMetrics::Get();
+  if (!metrics.queues_enabled()) {
     return;
   }
 
-  static const auto counter = GetMeter()->CreateUInt64Counter(
-      "flowpipe.queue.enqueue.count", "Number of records enqueued to queue");
-
-  auto labels = std::initializer_list<
-      std::pair<opentelemetry::nostd::string_view, opentelemetry::common::AttributeValue>>{
-      {"queue", queue.name}};
-
-  auto ctx = opentelemetry::context::RuntimeContext::GetCurrent();
-  counter->Add(1, labels, ctx);
-
-#else
-  (void)queue;
-#endif
+  QueueShardFor(metrics, queue).enqueued.add();
 }
 
 // ------------------------------------------------------------
 // Stage metrics
 // ------------------------------------------------------------
 void StageMetrics::RecordStageLatency(const char* stage_name, uint64_t latency_ns) noexcept {
-#if FLOWPIPE_ENABLE_OTEL
-  auto& state = observability::GetOtelState();
-  if (!state.stage_metrics_enabled) {
+  auto& metrics = observability::RuntimeMetrics::Get();
+  if (!metrics.stages_enabled()) {
     return;
   }
 
-  static const auto counter = GetMeter()->CreateUInt64Counter("flowpipe.stage.process.count",
-                                                              "Number of stage invocations");
-  static const auto latency = GetMeter()->CreateUInt64Histogram("flowpipe.stage.latency_ns",
-                                                                "Stage processing latency (ns)");
+  auto& shard =
+      stage_series_ != kUnbound ? metrics.stage(stage_series_) : metrics.stage(stage_name);
+  shard.processed.add();
+
+  if (metrics.histograms_enabled()) {
+    shard.latency.record(latency_ns);
+  }
+}
+
+void StageMetrics::CountStageRecord(const char* stage_name) noexcept {
+  auto& metrics = observability::RuntimeMetrics::Get();
+  if (!metrics.stages_enabled()) {
+    return;
+  }
 
-  auto labels = std::initializer_list<
-      std::pair<opentelemetry::nostd::string_view, opentelemetry::common::AttributeValue>>{
-      {"stage", stage_name}};
+  auto& shard =
+      stage_series_ != kUnbound ? metrics.stage(stage_series_) : metrics.stage(stage_name);
+  shard.processed.add();
+}
 
-  auto ctx = opentelemetry::context::RuntimeContext::GetCurrent();
+void StageMetrics::RecordStageError(const char* stage_name) noexcept {
+  auto& metrics = observability::RuntimeMetrics::Get();
+  if (!metrics.stages_enabled()) {
+    return;
+  }
 
-  counter->Add(1, labels, ctx);
+  auto& shard =
+      stage_series_ != kUnbound ? metrics.stage(stage_series_) : metrics.stage(stage_name);
+  shard.errors.add();
+}
 
-  if (state.latency_histograms) {
-    latency->Record(latency_ns, labels, ctx);
+void StageMetrics::RecordEndToEndLatency(const char* stage_name, uint64_t latency_ns) noexcept {
+  auto& metrics = observability::RuntimeMetrics::Get();
+  if (!metrics.stages_enabled() || !metrics.histograms_enabled()) {
+    return;
   }
 
-#else
-  (void)stage_name;
-  (void)latency_ns;
-#endif
+  auto& shard =
+      stage_series_ != kUnbound ? metrics.stage(stage_series_) : metrics.stage(stage_name);
+  shard.end_to_end.record(latency_ns);
 }
 
-void StageMetrics::RecordStageError(const char* stage_name) noexcept {
-#if FLOWPIPE_ENABLE_OTEL
-  auto& state = observability::GetOtelState();
-  if (!state.stage_metrics_enabled) {
+// ------------------------------------------------------------
+// Autoscaling metrics
+// ------------------------------------------------------------
+void StageMetrics::RecordStageWorkers(const char* stage_name, int64_t delta) noexcept {
+  auto& metrics = observability::RuntimeMetrics::Get();
+  if (!metrics.stages_enabled()) {
     return;
   }
 
-  static const auto counter =
-      GetMeter()->CreateUInt64Counter("flowpipe.stage.errors", "Number of stage errors");
+  auto& shard =
+      stage_series_ != kUnbound ? metrics.stage(stage_series_) : metrics.stage(stage_name);
+  if (delta > 0) {
+    shard.workers_started.add(static_cast<uint64_t>(delta));
+  } else {
+    shard.workers_stopped.add(static_cast<uint64_t>(-delta));
+  }
+}
 
-  auto labels = std::initializer_list<
-      std::pair<opentelemetry::nostd::string_view, opentelemetry::common::AttributeValue>>{
-      {"stage", stage_name}};
+void StageMetrics::RecordStageScaling(const char* stage_name, bool scale_up) noexcept {
+  auto& metrics = observability::RuntimeMetrics::Get();
+  if (!metrics.stages_enabled()) {
+    return;
+  }
 
-  auto ctx = opentelemetry::context::RuntimeContext::GetCurrent();
-  counter->Add(1, labels, ctx);
+  auto& shard =
+      stage_series_ != kUnbound ? metrics.stage(stage_series_) : metrics.stage(stage_name);
+  (scale_up ? shard.scale_ups : shard.scale_downs).add();
+}
+
+// ------------------------------------------------------------
+// Placement metrics
+// ------------------------------------------------------------
+void StageMetrics::RecordStageCpu(const char* stage_name, uint32_t cpu, uint32_t l3,
+                                  uint32_t numa_node) noexcept {
+  auto& metrics = observability::RuntimeMetrics::Get();
+  if (!metrics.stages_enabled()) {
+    return;
+  }
 
-#else
-  (void)stage_name;
-#endif
+  const observability::SeriesId id = stage_series_ != kUnbound
+                                         ? stage_series_
+                                         : metrics.RegisterStage({{"stage", stage_name}});
+  metrics.AddStageCpu(id, {.cpu = cpu, .l3 = l3, .numa_node = numa_node});
 }
 
 }  // namespace flowpipe
@@ -18,17 +18,48 @@ StageRegistry::StageRegistry(std::unique_ptr<StageLoader> loader) : loader_(std:
   }
 }
 
+// Lets shutdown() proceed once the guarded call returns or throws. The
+// caller increments pending_creates_ under lifecycle_mutex_.
+class StageRegistry::PendingCreate {
+ public:
+  explicit PendingCreate(StageRegistry* registry) : registry_(registry) {}
+
+  ~PendingCreate() {
+    std::lock_guard<std::mutex> lock(registry_->lifecycle_mutex_);
+    if (--registry_->pending_creates_ == 0) {
+      registry_->creates_done_.notify_all();
+    }
+  }
+
+ private:
+  StageRegistry* registry_;
+};
+
 IStage* StageRegistry::create_stage(const std::string& plugin_name,
                                     const google::protobuf::Struct* config) {
-  std::lock_guard<std::mutex> lock(lifecycle_mutex_);
-
-  auto it = plugins_.find(plugin_name);
-  if (it == plugins_.end()) {
-    auto plugin = loader_->load(plugin_name);
-    it = plugins_.emplace(plugin_name, std::move(plugin)).first;
+  PluginSlot* slot = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(lifecycle_mutex_);
+    auto& entry = plugins_[plugin_name];
+    if (!entry) {
+      entry = std::make_unique<PluginSlot>();
+    }
+    slot = entry.get();
+    ++pending_creates_;
+  }
+  PendingCreate pending(this);
+
+  LoadedPlugin plugin;
+  {
+    std::lock_guard<std::mutex> load_lock(slot->load_mutex);
+    if (!slot->loaded) {
+      slot->plugin = loader_->load(plugin_name);
+      slot->loaded = true;
+    }
+    plugin = slot->plugin;
   }
 
-  IStage* stage = it->second.create();
+  IStage* stage = plugin.create();
   if (!stage) {
     throw std::runtime_error("plugin returned null stage");
   }
@@ -38,11 +69,12 @@ IStage* StageRegistry::create_stage(const std::string& plugin_name,
     const auto& cfg = config ? *config : empty;
 
     if (!configurable->configure(cfg)) {
-      it->second.destroy(stage);
+      plugin.destroy(stage);
       throw std::runtime_error("stage rejected configuration: " + plugin_name);
     }
   }
 
+  std::lock_guard<std::mutex> lock(lifecycle_mutex_);
   instances_.push_back(StageInstance{
       .plugin_name = plugin_name,
       .stage = stage,
@@ -51,13 +83,47 @@ IStage* StageRegistry::create_stage(const std::string& plugin_name,
   return stage;
 }
 
+IStage* StageRegistry::clone_stage(IStage* prototype) {
+  auto* configurable = dynamic_cast<ConfigurableStage*>(prototype);
+  if (!configurable) {
+    return nullptr;
+  }
+
+  std::string plugin_name;
+  {
+    std::lock_guard<std::mutex> lock(lifecycle_mutex_);
+    for (const auto& inst : instances_) {
+      if (inst.stage == prototype) {
+        plugin_name = inst.plugin_name;
+        break;
+      }
+    }
+    if (plugin_name.empty()) {
+      return nullptr;
+    }
+    ++pending_creates_;
+  }
+  PendingCreate pending(this);
+
+  IStage* stage = configurable->clone();
+  if (!stage) {
+    return nullptr;
+  }
+
+  std::lock_guard<std::mutex> lock(lifecycle_mutex_);
+  instances_.push_back(StageInstance{
+      .plugin_name = plugin_name,
+      .stage = stage,
+  });
+  return stage;
+}
+
 void StageRegistry::destroy_stage(IStage* stage) {
   std::lock_guard<std::mutex> lock(lifecycle_mutex_);
 
   for (auto it = instances_.begin(); it != instances_.end(); ++it) {
     if (it->stage == stage) {
-      auto& plugin = plugins_.at(it->plugin_name);
-      plugin.destroy(stage);
+      plugins_.at(it->plugin_name)->plugin.destroy(stage);
       instances_.erase(it);
       return;
     }
@@ -68,16 +134,18 @@ void StageRegistry::destroy_stage(IStage* stage) {
 // implicit call from ~StageRegistry() is always a safe no-op if the caller
 // already invoked shutdown() explicitly.
 void StageRegistry::shutdown() {
-  std::lock_guard<std::mutex> lock(lifecycle_mutex_);
+  std::unique_lock<std::mutex> lock(lifecycle_mutex_);
+  creates_done_.wait(lock, [this]() { return pending_creates_ == 0; });
 
   for (auto& inst : instances_) {
-    auto& plugin = plugins_.at(inst.plugin_name);
-    plugin.destroy(inst.stage);
+    plugins_.at(inst.plugin_name)->plugin.destroy(inst.stage);
   }
   instances_.clear();
 
   for (auto& kv : plugins_) {
-    loader_->unload(kv.second);
+    if (kv.second->loaded) {
+      loader_->unload(kv.second->plugin);
+    }
   }
   plugins_.clear();
 }
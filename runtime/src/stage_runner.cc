@@ -1,415 +1,794 @@
 #include "flowpipe/stage_runner.h"
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <coroutine>
 #include <cstring>
-
+#include <deque>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "flowpipe/event_loop.h"
+#include "flowpipe/internal/stage_steps.h"
 #include "flowpipe/observability/logging_runtime.h"
+#include "flowpipe/queue_wait_set.h"
 
-#if FLOWPIPE_ENABLE_OTEL
-#include <opentelemetry/trace/provider.h>
-#include <opentelemetry/trace/span_context.h>
-#include <opentelemetry/trace/span_id.h>
-#include <opentelemetry/trace/trace_id.h>
+namespace flowpipe {
 
-#include "flowpipe/observability/observability_state.h"
-#endif
+// Input/output sets, steps and loops live in stage_steps.h.
+using namespace detail;
 
-namespace flowpipe {
+namespace {
 
 // ------------------------------------------------------------
-// Time helper (monotonic, nanoseconds)
+// Batch sink
 // ------------------------------------------------------------
-static inline uint64_t now_ns() noexcept {
-  return std::chrono::duration_cast<std::chrono::nanoseconds>(
-             std::chrono::steady_clock::now().time_since_epoch())
-      .count();
-}
-
-static inline bool ValidateInputSchema(const QueueRuntime& queue, const Payload& payload,
-                                       const char* stage_name) {
-  if (queue.schema_id.empty()) {
-    return true;
+// Gathers payloads from the inputs and hands them to the stage in groups of
+// up to max_size. After the first payload of a batch the runner waits at
+// most `linger` for the rest; a zero linger takes only what is already
+// queued. Whatever was gathered is delivered before the runner exits.
+class BatchSinkRunner {
+ public:
+  BatchSinkRunner(IBatchSinkStage* stage, StageContext& ctx, const QueueList& inputs,
+                  StageMetrics* metrics, const BatchOptions& options,
+                  const TimerOptions& timer_options)
+      : stage_(stage),
+        ctx_(ctx),
+        inputs_(inputs),
+        metrics_(metrics),
+        sampler_(SamplingFor(metrics)),
+        options_(options),
+        stage_name_(stage->name()),
+        timers_(stage, timer_options, ctx, metrics, stage_name_) {
+    if (options_.max_size == 0) {
+      options_.max_size = 1;
+    }
+    batch_.reserve(options_.max_size);
   }
 
-  if (payload.meta.schema_id.empty()) {
-    FP_LOG_ERROR_FMT("stage '{}' received payload without schema_id on queue '{}'", stage_name,
-                     queue.name);
-    return false;
-  }
+  void Run() {
+    FP_LOG_DEBUG_FMT("batch sink stage '{}' runner started (batch_size={}, linger_ms={})",
+                     stage_name_, options_.max_size, options_.linger.count());
+
+    InputSet in(inputs_);
+
+    while (!ctx_.stop.stop_requested()) {
+      QueueRuntime* input = nullptr;
+      auto first = PopOrTimeout(in, ctx_.stop, input, timers_);
+      if (!first.has_value() && timers_.enabled() && !ctx_.stop.stop_requested() &&
+          !in.Drained()) {
+        if (!timers_.Fire(StageTimers::Clock::now())) {
+          in.CloseAll();
+          break;
+        }
+        continue;
+      }
+      if (!first.has_value()) {
+        FP_LOG_DEBUG_FMT("batch sink stage '{}' input queue closed or stop requested",
+                         stage_name_);
+        break;
+      }
+      Accept(*input, std::move(*first));
+
+      const auto deadline = std::chrono::steady_clock::now() + options_.linger;
+      while (batch_.size() < options_.max_size) {
+        std::optional<Payload> item;
+        if (options_.linger.count() > 0) {
+          item = in.PopUntil(ctx_.stop, input, deadline);
+        } else {
+          bool drained = false;
+          item = in.TryPop(input, drained);
+        }
+        if (!item.has_value()) {
+          break;
+        }
+        Accept(*input, std::move(*item));
+      }
 
-  if (payload.meta.schema_id != queue.schema_id) {
-    FP_LOG_ERROR_FMT(
-        "stage '{}' received payload with schema_id '{}' on queue '{}' (expected '{}')", stage_name,
-        payload.meta.schema_id, queue.name, queue.schema_id);
-    return false;
-  }
+      if (!Flush()) {
+        in.CloseAll();  // wake peer workers blocked on pop()
+        break;
+      }
 
-  return true;
-}
+      if (timers_.enabled()) {
+        const auto now = StageTimers::Clock::now();
+        timers_.Activity(now);
+        if (!timers_.Fire(now)) {
+          in.CloseAll();
+          break;
+        }
+      }
+    }
 
-static inline bool ApplyOutputSchema(const QueueRuntime& queue, Payload& payload,
-                                     const char* stage_name) {
-  if (queue.schema_id.empty()) {
-    return true;
+    FP_LOG_DEBUG_FMT("batch sink stage '{}' runner exiting", stage_name_);
   }
 
-  if (payload.meta.schema_id.empty()) {
-    payload.meta.schema_id = queue.schema_id;
-    return true;
-  }
+ private:
+  void Accept(const QueueRuntime& input, Payload payload) {
+    const bool sampled = sampler_.Sample();
+    RecordDequeue(metrics_, input, payload, sampled);
 
-  if (payload.meta.schema_id != queue.schema_id) {
-    FP_LOG_ERROR_FMT(
-        "stage '{}' produced payload with schema_id '{}' for queue '{}' (expected "
-        "'{}')",
-        stage_name, payload.meta.schema_id, queue.name, queue.schema_id);
-    return false;
+    if (!ValidateInputSchema(input, payload, stage_name_.c_str())) {
+      if (metrics_) {
+        metrics_->RecordStageError(stage_name_.c_str());
+      }
+      return;
+    }
+    if (sampled) {
+      sampled_.push_back(batch_.size());
+    }
+    batch_.push_back(std::move(payload));
   }
 
-  return true;
-}
+  // Returns false if the stage threw; global stop is already requested.
+  bool Flush() {
+    if (batch_.empty()) {
+      return true;
+    }
 
 #if FLOWPIPE_ENABLE_OTEL
+    // One span per batch, parented by its first payload.
+    opentelemetry::nostd::shared_ptr<opentelemetry::trace::Span> span;
+    std::unique_ptr<opentelemetry::trace::Scope> scope;
 
-static inline bool StageSpansEnabled() noexcept {
-  return flowpipe::observability::GetOtelState().stage_spans_enabled;
-}
+    // No queue-wait spans here: Accept() takes no timestamp of its own, and
+    // the batch start would fold the linger into the wait.
+    if (StageSpansEnabled()) {
+      const auto& tracer = GetTracer();
+      auto parent_ctx = SpanContextFromPayload(batch_.front().meta);
 
-static opentelemetry::nostd::shared_ptr<opentelemetry::trace::Tracer> GetTracer() {
-  auto provider = opentelemetry::trace::Provider::GetTracerProvider();
-  return provider->GetTracer("flowpipe.runtime", "1.0.0");
-}
+      opentelemetry::trace::StartSpanOptions opts;
+      if (parent_ctx.IsValid()) {
+        opts.parent = parent_ctx;
+      }
+
+      span = tracer->StartSpan(stage_name_, opts);
+      span->SetAttribute("flowpipe.batch.size", static_cast<uint64_t>(batch_.size()));
+      scope = std::make_unique<opentelemetry::trace::Scope>(tracer->WithActiveSpan(span));
+    }
+#endif
+
+    bool ok = true;
+    const uint64_t start_ns = now_ns();
+    try {
+      stage_->consume_batch(ctx_, std::span<const Payload>(batch_));
+    } catch (const std::exception& ex) {
+      FP_LOG_ERROR_FMT("batch sink stage '{}' threw exception: {}", stage_name_, ex.what());
+      ok = false;
+    } catch (...) {
+      FP_LOG_ERROR_FMT("batch sink stage '{}' threw unknown exception", stage_name_);
+      ok = false;
+    }
+    const uint64_t end_ns = now_ns();
 
-// Build a parent span context from PayloadMeta (if present)
-static opentelemetry::trace::SpanContext SpanContextFromPayload(const PayloadMeta& meta) {
-  if (!meta.has_trace()) {
-    return opentelemetry::trace::SpanContext::GetInvalid();
+#if FLOWPIPE_ENABLE_OTEL
+    if (span) {
+      span->End();
+    }
+#endif
+
+    if (ok) {
+      for (const size_t index : sampled_) {
+        RecordEndToEnd(metrics_, stage_name_, batch_[index].meta, end_ns);
+#if FLOWPIPE_ENABLE_OTEL
+        RecordSpan(stage_name_, batch_[index].meta, end_ns);
+#endif
+      }
+    }
+    batch_.clear();
+    sampled_.clear();
+
+    if (!ok) {
+      if (metrics_) {
+        metrics_->RecordStageError(stage_name_.c_str());
+      }
+      ctx_.request_stop();
+      return false;
+    }
+
+    if (metrics_) {
+      metrics_->RecordStageLatency(stage_name_.c_str(), end_ns - start_ns);
+    }
+    return true;
   }
 
-  opentelemetry::trace::TraceId trace_id{
-      opentelemetry::nostd::span<const uint8_t, PayloadMeta::trace_id_size>(meta.trace_id)};
+  IBatchSinkStage* stage_;
+  StageContext& ctx_;
+  const QueueList& inputs_;
+  StageMetrics* metrics_;
+  RecordSampler sampler_;
+  BatchOptions options_;
+  const std::string stage_name_;
+  StageTimers timers_;
+  std::vector<Payload> batch_;
+  std::vector<size_t> sampled_;  // batch_ indices of sampled payloads
+};
 
-  opentelemetry::trace::SpanId span_id{
-      opentelemetry::nostd::span<const uint8_t, PayloadMeta::span_id_size>(meta.span_id)};
+// ------------------------------------------------------------
+// Fused edge
+// ------------------------------------------------------------
+// Stands in for the BoundedQueue between a producer and its sole consumer:
+// push() runs the consumer step directly on the producer's thread. Nothing
+// ever pops from it, so pop()/try_pop() report an empty queue.
+template <typename Step>
+class FusedQueue final : public IQueue<Payload> {
+ public:
+  template <typename... Args>
+  explicit FusedQueue(QueueRuntime& input, Args&&... args)
+      : input_(input), step_(std::forward<Args>(args)...) {}
+
+  bool push(Payload item, const StopToken& stop) override {
+    if (closed_.load(std::memory_order_acquire) || stop.stop_requested()) {
+      return false;
+    }
 
-  opentelemetry::trace::TraceFlags flags{static_cast<uint8_t>(meta.flags & 0xFF)};
+    const StepResult result = step_.Process(input_, item);
+    if (result == StepResult::kContinue) {
+      return true;
+    }
 
-  return opentelemetry::trace::SpanContext{trace_id, span_id, flags, /*is_remote=*/true};
-}
+    FP_LOG_DEBUG_FMT("fused {} stage '{}' finished", Step::kKind, step_.name());
+    closed_.store(true, std::memory_order_release);
+    return result != StepResult::kFailed;
+  }
 
-// Write child span context back into payload metadata
-static inline void WriteSpanToPayload(const opentelemetry::trace::SpanContext& ctx,
-                                      PayloadMeta& meta) noexcept {
-  if (!ctx.IsValid()) {
-    std::memset(meta.trace_id, 0, PayloadMeta::trace_id_size);
-    std::memset(meta.span_id, 0, PayloadMeta::span_id_size);
-    meta.flags = 0;
-    return;
+  std::optional<Payload> pop(const StopToken&) override {
+    return std::nullopt;
   }
 
-  ctx.trace_id().CopyBytesTo(
-      opentelemetry::nostd::span<uint8_t, PayloadMeta::trace_id_size>(meta.trace_id));
+  std::optional<Payload> pop_for(std::chrono::nanoseconds, const StopToken&) override {
+    return std::nullopt;
+  }
 
-  ctx.span_id().CopyBytesTo(
-      opentelemetry::nostd::span<uint8_t, PayloadMeta::span_id_size>(meta.span_id));
+  // The consumer runs inline, so a fused queue is never full. Producers that
+  // must not block (pooled tasks, async workers) are never fused, so only
+  // blocking workers get here.
+  TryPushResult try_push(Payload& item) override {
+    if (closed_.load(std::memory_order_acquire)) {
+      return TryPushResult::kClosed;
+    }
+    return push(std::move(item), StopToken{}) ? TryPushResult::kPushed : TryPushResult::kClosed;
+  }
 
-  meta.flags = ctx.trace_flags().flags();
-}
+  void close() override {
+    closed_.store(true, std::memory_order_release);
+  }
+
+  std::optional<Payload> try_pop() override {
+    return std::nullopt;
+  }
 
-#endif  // FLOWPIPE_ENABLE_OTEL
+  bool drained() const override {
+    return closed_.load(std::memory_order_acquire);
+  }
+
+  std::size_t size() const override {
+    return 0;
+  }
+
+  void wake_all() override {}
+
+  void add_observer(QueueObserver*) override {}
+  void remove_observer(QueueObserver*) override {}
+
+ private:
+  QueueRuntime& input_;
+  Step step_;
+  std::atomic<bool> closed_{false};
+};
 
 // ------------------------------------------------------------
-// Source stage runner
+// Pooled tasks
 // ------------------------------------------------------------
-void RunSourceStage(ISourceStage* stage, StageContext& ctx, QueueRuntime& output,
-                    StageMetrics* metrics) {
-  const std::string stage_name = stage->name();
-  FP_LOG_DEBUG_FMT("source stage '{}' runner started", stage_name);
+// Payloads handled per slice before a ready task goes back to the pool, so
+// one busy stage cannot monopolize a pool thread.
+constexpr int kTaskSliceBudget = 64;
+
+class SourceTask final : public StageTask {
+ public:
+  SourceTask(ISourceStage* stage, StageContext& ctx, QueueList outputs, StageMetrics* metrics)
+      : ctx_(ctx), outputs_(std::move(outputs)), step_(stage, ctx, outputs_, metrics) {
+    step_.outputs()->SetDeferred(&deferred_);
+  }
 
-  while (!ctx.stop.stop_requested()) {
-    Payload payload;
+  Status RunSlice() override {
+    auto* out = step_.outputs();
+    if (!out->FlushDeferred()) {
+      return Status::kBlocked;
+    }
 
-    const uint64_t start_ns = now_ns();
-    bool produced = false;
-    try {
-      produced = stage->produce(ctx, payload);
-    } catch (const std::exception& ex) {
-      FP_LOG_ERROR_FMT("source stage '{}' threw exception: {}", stage_name, ex.what());
-      if (metrics) {
-        metrics->RecordStageError(stage_name.c_str());
+    for (int n = 0; n < kTaskSliceBudget; ++n) {
+      if (ctx_.stop.stop_requested() || out->done()) {
+        return Status::kDone;
       }
-      ctx.request_stop();
-      break;
-    } catch (...) {
-      FP_LOG_ERROR_FMT("source stage '{}' threw unknown exception", stage_name);
-      if (metrics) {
-        metrics->RecordStageError(stage_name.c_str());
+      if (step_.Produce() != StepResult::kContinue) {
+        return Status::kDone;
+      }
+      if (out->has_deferred()) {
+        return Status::kBlocked;
       }
-      ctx.request_stop();
-      break;
     }
-    const uint64_t end_ns = now_ns();
-
-#if FLOWPIPE_ENABLE_OTEL
-    // Create the span AFTER produce() so we can use the trace context that
-    // produce() extracted from the incoming message (e.g. W3C traceparent from
-    // NATS headers) as the parent.  Creating the span before produce() would
-    // start it with no parent and WriteSpanToPayload would overwrite the
-    // incoming context, breaking the link to the gateway/client trace.
-    if (StageSpansEnabled() && produced) {
-      auto tracer = GetTracer();
-      auto parent_ctx = SpanContextFromPayload(payload.meta);
+    return Status::kReady;
+  }
 
-      opentelemetry::trace::StartSpanOptions opts;
-      if (parent_ctx.IsValid()) {
-        opts.parent = parent_ctx;
-      }
+  QueueList queues() const override {
+    return outputs_;
+  }
 
-      auto span = tracer->StartSpan(stage_name, opts);
-      WriteSpanToPayload(span->GetContext(), payload.meta);
-      span->End();
+ private:
+  StageContext& ctx_;
+  const QueueList outputs_;
+  std::deque<std::pair<size_t, Payload>> deferred_;
+  SourceStep step_;
+};
+
+template <typename Step>
+class ConsumerTask final : public StageTask {
+ public:
+  template <typename StageT>
+  ConsumerTask(StageT* stage, StageContext& ctx, QueueList inputs, QueueList outputs,
+               StageMetrics* metrics)
+      : ctx_(ctx),
+        inputs_(std::move(inputs)),
+        outputs_(std::move(outputs)),
+        in_(inputs_, /*blocking=*/false),
+        step_(stage, ctx, outputs_, metrics) {
+    if (auto* out = step_.outputs()) {
+      out->SetDeferred(&deferred_);
     }
-#endif
+  }
 
-    if (!produced) {
-      FP_LOG_DEBUG_FMT("source stage '{}' returned no payload (terminating)", stage_name);
-      break;
+  Status RunSlice() override {
+    auto* out = step_.outputs();
+    if (out && !out->FlushDeferred()) {
+      return Status::kBlocked;
     }
 
-    if (!ApplyOutputSchema(output, payload, stage_name.c_str())) {
-      if (metrics) {
-        metrics->RecordStageError(stage_name.c_str());
+    for (int n = 0; n < kTaskSliceBudget; ++n) {
+      if (ctx_.stop.stop_requested() || (out && out->done())) {
+        return Status::kDone;
       }
-      continue;
-    }
 
-    if (metrics) {
-      metrics->RecordStageLatency(stage_name.c_str(), end_ns - start_ns);
-    }
+      QueueRuntime* input = nullptr;
+      bool drained = false;
+      auto item = in_.TryPop(input, drained);
+      if (!item.has_value()) {
+        if (drained) {
+          FP_LOG_DEBUG_FMT("{} stage '{}' input queue closed", Step::kKind, step_.name());
+          return Status::kDone;
+        }
+        return Status::kBlocked;
+      }
 
-    payload.meta.enqueue_ts_ns = now_ns();
-    if (!output.queue->push(std::move(payload), ctx.stop)) {
-      FP_LOG_DEBUG_FMT("source stage '{}' output queue closed or stop requested", stage_name);
-      break;
+      const StepResult result = step_.Process(*input, *item);
+      if (result == StepResult::kFailed) {
+        in_.CloseAll();
+        return Status::kDone;
+      }
+      if (result == StepResult::kOutputDone) {
+        return Status::kDone;
+      }
+      if (out && out->has_deferred()) {
+        return Status::kBlocked;
+      }
     }
+    return Status::kReady;
+  }
 
-    if (metrics) {
-      metrics->RecordQueueEnqueue(output);
-    }
+  QueueList queues() const override {
+    QueueList all = inputs_;
+    all.insert(all.end(), outputs_.begin(), outputs_.end());
+    return all;
   }
 
-  FP_LOG_DEBUG_FMT("source stage '{}' runner exiting", stage_name);
-}
+ private:
+  StageContext& ctx_;
+  const QueueList inputs_;
+  const QueueList outputs_;
+  InputSet in_;
+  std::deque<std::pair<size_t, Payload>> deferred_;
+  Step step_;
+};
 
 // ------------------------------------------------------------
-// Transform stage runner
+// Async stages
 // ------------------------------------------------------------
-void RunTransformStage(ITransformStage* stage, StageContext& ctx, QueueRuntime& input,
-                       QueueRuntime& output, StageMetrics* metrics) {
-  const std::string stage_name = stage->name();
-  FP_LOG_DEBUG_FMT("transform stage '{}' runner started", stage_name);
-
-  while (!ctx.stop.stop_requested()) {
-    auto item = input.queue->pop(ctx.stop);
-    if (!item.has_value()) {
-      if (ctx.stop.stop_requested()) {
-        FP_LOG_DEBUG_FMT("transform stage '{}' stop requested", stage_name);
-      } else {
-        FP_LOG_DEBUG_FMT("transform stage '{}' input queue closed", stage_name);
-      }
-      break;
+// Wakes the worker's event loop when a watched queue changes, but only
+// while the loop is (about to be) asleep, so busy loops pay no syscalls.
+class LoopWaker final : public QueueObserver {
+ public:
+  explicit LoopWaker(EventLoop& loop) : loop_(loop) {}
+
+  void notify() noexcept override {
+    pending_.store(true);
+    if (sleeping_.load()) {
+      loop_.Wake();
     }
+  }
 
-    const Payload& in_payload = *item;
+  void Reset() noexcept {
+    pending_.store(false);
+  }
 
-    if (metrics) {
-      metrics->RecordQueueDequeue(input, in_payload);
+  // Blocks in the loop unless a queue changed since Reset().
+  void Sleep() {
+    sleeping_.store(true);
+    if (!pending_.load()) {
+      loop_.RunOnce(std::nullopt);
     }
+    sleeping_.store(false);
+  }
 
-    if (!ValidateInputSchema(input, in_payload, stage_name.c_str())) {
-      if (metrics) {
-        metrics->RecordStageError(stage_name.c_str());
+ private:
+  EventLoop& loop_;
+  std::atomic<bool> pending_{false};
+  std::atomic<bool> sleeping_{false};
+};
+
+template <typename Stage>
+class AsyncRunner {
+ public:
+  static constexpr bool kIsSink = std::is_base_of_v<IAsyncSinkStage, Stage>;
+  static constexpr const char* kKind = kIsSink ? "async sink" : "async transform";
+
+  // Coroutine owning one in-flight payload. Its frame is destroyed by the
+  // runner when it completes, or when the runner stops with it suspended.
+  struct Inflight {
+    struct promise_type {
+      AsyncRunner* runner = nullptr;
+
+      Inflight get_return_object() noexcept {
+        return Inflight{std::coroutine_handle<promise_type>::from_promise(*this)};
+      }
+      std::suspend_always initial_suspend() noexcept {
+        return {};
       }
-      continue;
+      struct FinalAwaiter {
+        bool await_ready() noexcept {
+          return false;
+        }
+        void await_suspend(std::coroutine_handle<promise_type> h) noexcept {
+          h.promise().runner->Finished(h);
+        }
+        void await_resume() noexcept {}
+      };
+      FinalAwaiter final_suspend() noexcept {
+        return {};
+      }
+      void return_void() noexcept {}
+      void unhandled_exception() noexcept {
+        std::terminate();  // bodies catch everything the stage throws
+      }
+    };
+
+    std::coroutine_handle<promise_type> handle;
+  };
+
+  AsyncRunner(Stage* stage, StageContext& ctx, const QueueList& inputs, const QueueList& outputs,
+              StageMetrics* metrics)
+      : stage_(stage),
+        ctx_(ctx),
+        inputs_(inputs),
+        metrics_(metrics),
+        sampler_(SamplingFor(metrics)),
+        stage_name_(stage->name()),
+        max_in_flight_(std::max<size_t>(1, stage->max_in_flight())),
+        out_(outputs, ctx, metrics, stage_name_),
+        waker_(loop_) {
+    out_.SetDeferred(&deferred_);
+    for (auto* queue : inputs) {
+      watched_.push_back(queue);
+    }
+    for (auto* queue : outputs) {
+      watched_.push_back(queue);
     }
+    for (auto* queue : watched_) {
+      queue->queue->add_observer(&waker_);
+    }
+  }
 
-#if FLOWPIPE_ENABLE_OTEL
-    opentelemetry::nostd::shared_ptr<opentelemetry::trace::Span> span;
-    std::unique_ptr<opentelemetry::trace::Scope> scope;
+  ~AsyncRunner() {
+    for (auto* queue : watched_) {
+      queue->queue->remove_observer(&waker_);
+    }
+  }
 
-    if (StageSpansEnabled()) {
-      auto tracer = GetTracer();
-      auto parent_ctx = SpanContextFromPayload(in_payload.meta);
+  AsyncRunner(const AsyncRunner&) = delete;
+  AsyncRunner& operator=(const AsyncRunner&) = delete;
 
-      opentelemetry::trace::StartSpanOptions opts;
-      if (parent_ctx.IsValid()) {
-        opts.parent = parent_ctx;
-      }
+  void Run() {
+    FP_LOG_DEBUG_FMT("{} stage '{}' runner started (max_in_flight={})", kKind, stage_name_,
+                     max_in_flight_);
 
-      span = tracer->StartSpan(stage_name, opts);
-      scope = std::make_unique<opentelemetry::trace::Scope>(tracer->WithActiveSpan(span));
-    }
-#endif
+    InputSet in(inputs_, /*blocking=*/false);
+    bool drained = false;
 
-    Payload out_payload;
-    out_payload.meta = in_payload.meta;
+    while (!ctx_.stop.stop_requested()) {
+      waker_.Reset();
 
-    const uint64_t start_ns = now_ns();
-    try {
-      stage->process(ctx, in_payload, out_payload);
-    } catch (const std::exception& ex) {
-      FP_LOG_ERROR_FMT("transform stage '{}' threw exception: {}", stage_name, ex.what());
-      if (metrics) {
-        metrics->RecordStageError(stage_name.c_str());
+      out_.FlushDeferred();
+      if (out_.done()) {
+        FP_LOG_DEBUG_FMT("{} stage '{}' output queue closed or stop requested", kKind,
+                         stage_name_);
+        break;
       }
-      ctx.request_stop();
-      input.queue->close();  // wake peer workers blocked on pop()
-#if FLOWPIPE_ENABLE_OTEL
-      if (span) {
-        span->End();
+
+      while (!failed_ && !drained && live_.size() < max_in_flight_ && !out_.has_deferred()) {
+        QueueRuntime* input = nullptr;
+        auto item = in.TryPop(input, drained);
+        if (!item.has_value()) {
+          break;
+        }
+        Start(input, std::move(*item));
       }
-#endif
-      break;
-    } catch (...) {
-      FP_LOG_ERROR_FMT("transform stage '{}' threw unknown exception", stage_name);
-      if (metrics) {
-        metrics->RecordStageError(stage_name.c_str());
+
+      if (failed_) {
+        in.CloseAll();  // wake peer workers blocked on pop()
+        break;
       }
-      ctx.request_stop();
-      input.queue->close();  // wake peer workers blocked on pop()
-#if FLOWPIPE_ENABLE_OTEL
-      if (span) {
-        span->End();
+      if (drained && live_.empty() && !out_.has_deferred()) {
+        FP_LOG_DEBUG_FMT("{} stage '{}' input queue closed", kKind, stage_name_);
+        break;
       }
-#endif
-      break;
-    }
-    const uint64_t end_ns = now_ns();
 
-#if FLOWPIPE_ENABLE_OTEL
-    if (span) {
-      WriteSpanToPayload(span->GetContext(), out_payload.meta);
-      span->End();
+      waker_.Sleep();
     }
-#endif
 
-    if (metrics) {
-      metrics->RecordStageLatency(stage_name.c_str(), end_ns - start_ns);
+    if (!live_.empty()) {
+      FP_LOG_DEBUG_FMT("{} stage '{}' abandoning {} in-flight payloads", kKind, stage_name_,
+                       live_.size());
     }
-
-    if (!ApplyOutputSchema(output, out_payload, stage_name.c_str())) {
-      if (metrics) {
-        metrics->RecordStageError(stage_name.c_str());
-      }
-      continue;
+    for (void* address : live_) {
+      std::coroutine_handle<typename Inflight::promise_type>::from_address(address).destroy();
     }
+    live_.clear();
 
-    out_payload.meta.enqueue_ts_ns = now_ns();
-    if (!output.queue->push(std::move(out_payload), ctx.stop)) {
-      FP_LOG_DEBUG_FMT("transform stage '{}' output queue closed or stop requested", stage_name);
-      break;
-    }
+    FP_LOG_DEBUG_FMT("{} stage '{}' runner exiting", kKind, stage_name_);
+  }
 
-    if (metrics) {
-      metrics->RecordQueueEnqueue(output);
-    }
+ private:
+  void Start(QueueRuntime* input, Payload payload) {
+    auto inflight = Process(input, std::move(payload));
+    inflight.handle.promise().runner = this;
+    live_.insert(inflight.handle.address());
+    inflight.handle.resume();
   }
 
-  FP_LOG_DEBUG_FMT("transform stage '{}' runner exiting", stage_name);
-}
+  void Finished(std::coroutine_handle<typename Inflight::promise_type> handle) noexcept {
+    live_.erase(handle.address());
+    handle.destroy();
+  }
 
-// ------------------------------------------------------------
-// Sink stage runner
-// ------------------------------------------------------------
-void RunSinkStage(ISinkStage* stage, StageContext& ctx, QueueRuntime& input,
-                  StageMetrics* metrics) {
-  const std::string stage_name = stage->name();
-  FP_LOG_DEBUG_FMT("sink stage '{}' runner started", stage_name);
-
-  while (!ctx.stop.stop_requested()) {
-    auto item = input.queue->pop(ctx.stop);
-    if (!item.has_value()) {
-      if (ctx.stop.stop_requested()) {
-        FP_LOG_DEBUG_FMT("sink stage '{}' stop requested", stage_name);
-      } else {
-        FP_LOG_DEBUG_FMT("sink stage '{}' input queue closed", stage_name);
-      }
-      break;
+  void RecordError() noexcept {
+    if (metrics_) {
+      metrics_->RecordStageError(stage_name_.c_str());
     }
+  }
 
-    const Payload& payload = *item;
+  Inflight Process(QueueRuntime* input, Payload payload) {
+    // Decided before the first suspension; the sampler is not touched again.
+    const bool sampled = sampler_.Sample();
+    RecordDequeue(metrics_, *input, payload, sampled);
 
-    if (metrics) {
-      metrics->RecordQueueDequeue(input, payload);
+    if (!ValidateInputSchema(*input, payload, stage_name_.c_str())) {
+      RecordError();
+      co_return;
     }
 
-    if (!ValidateInputSchema(input, payload, stage_name.c_str())) {
-      if (metrics) {
-        metrics->RecordStageError(stage_name.c_str());
-      }
-      continue;
-    }
+    // Also the dequeue time of the queue-wait span.
+    const uint64_t start_ns = sampled ? now_ns() : 0;
 
 #if FLOWPIPE_ENABLE_OTEL
+    // No Scope: the active span is thread-local and other coroutines run on
+    // this thread while this one is suspended.
     opentelemetry::nostd::shared_ptr<opentelemetry::trace::Span> span;
-    std::unique_ptr<opentelemetry::trace::Scope> scope;
-
-    if (StageSpansEnabled()) {
-      auto tracer = GetTracer();
-      auto parent_ctx = SpanContextFromPayload(payload.meta);
-
-      opentelemetry::trace::StartSpanOptions opts;
-      if (parent_ctx.IsValid()) {
-        opts.parent = parent_ctx;
+    if (sampled) {
+      auto parent_ctx = QueueWaitSpan(*input, payload.meta, start_ns);
+      if (StageSpansEnabled()) {
+        opentelemetry::trace::StartSpanOptions opts;
+        if (parent_ctx.IsValid()) {
+          opts.parent = parent_ctx;
+        }
+        span = GetTracer()->StartSpan(stage_name_, opts);
       }
-
-      span = tracer->StartSpan(stage_name, opts);
-      scope = std::make_unique<opentelemetry::trace::Scope>(tracer->WithActiveSpan(span));
     }
 #endif
 
-    const uint64_t start_ns = now_ns();
+    Payload out_payload;
+    out_payload.meta = payload.meta;
+
+    bool ok = false;
     try {
-      stage->consume(ctx, payload);
-    } catch (const std::exception& ex) {
-      FP_LOG_ERROR_FMT("sink stage '{}' threw exception: {}", stage_name, ex.what());
-      if (metrics) {
-        metrics->RecordStageError(stage_name.c_str());
-      }
-      ctx.request_stop();
-#if FLOWPIPE_ENABLE_OTEL
-      if (span) {
-        span->End();
+      if constexpr (kIsSink) {
+        co_await stage_->consume_async(ctx_, loop_, payload);
+      } else {
+        co_await stage_->process_async(ctx_, loop_, payload, out_payload);
       }
-#endif
-      break;
+      ok = true;
+    } catch (const std::exception& ex) {
+      FP_LOG_ERROR_FMT("{} stage '{}' threw exception: {}", kKind, stage_name_, ex.what());
     } catch (...) {
-      FP_LOG_ERROR_FMT("sink stage '{}' threw unknown exception", stage_name);
-      if (metrics) {
-        metrics->RecordStageError(stage_name.c_str());
-      }
-      ctx.request_stop();
-#if FLOWPIPE_ENABLE_OTEL
-      if (span) {
-        span->End();
-      }
-#endif
-      break;
+      FP_LOG_ERROR_FMT("{} stage '{}' threw unknown exception", kKind, stage_name_);
     }
-    const uint64_t end_ns = now_ns();
+    const uint64_t end_ns = sampled ? now_ns() : 0;
 
 #if FLOWPIPE_ENABLE_OTEL
     if (span) {
+      if constexpr (!kIsSink) {
+        WriteSpanToPayload(span->GetContext(), out_payload.meta);
+      }
       span->End();
     }
 #endif
 
-    if (metrics) {
-      metrics->RecordStageLatency(stage_name.c_str(), end_ns - start_ns);
+    if (!ok) {
+      RecordError();
+      ctx_.request_stop();
+      failed_ = true;
+      co_return;
+    }
+
+    RecordProcessed(metrics_, stage_name_, sampled, start_ns, end_ns);
+
+    if constexpr (kIsSink) {
+      if (sampled) {
+        RecordEndToEnd(metrics_, stage_name_, payload.meta, end_ns);
+#if FLOWPIPE_ENABLE_OTEL
+        RecordSpan(stage_name_, payload.meta, end_ns);
+#endif
+      }
+    } else {
+      out_.Broadcast(std::move(out_payload), sampled);
     }
   }
 
-  FP_LOG_DEBUG_FMT("sink stage '{}' runner exiting", stage_name);
+  Stage* stage_;
+  StageContext& ctx_;
+  const QueueList& inputs_;
+  StageMetrics* metrics_;
+  RecordSampler sampler_;
+  const std::string stage_name_;
+  const size_t max_in_flight_;
+  EventLoop loop_;
+  OutputSet out_;
+  std::deque<std::pair<size_t, Payload>> deferred_;
+  LoopWaker waker_;
+  QueueList watched_;
+  std::unordered_set<void*> live_;
+  bool failed_ = false;
+};
+
+}  // namespace
+
+// ------------------------------------------------------------
+// Source stage runner
+// ------------------------------------------------------------
+void RunSourceStage(ISourceStage* stage, StageContext& ctx, const QueueList& outputs,
+                    StageMetrics* metrics) {
+  SourceStep step(stage, ctx, outputs, metrics);
+  RunSourceLoop(step, ctx);
+}
+
+// ------------------------------------------------------------
+// Consumer stage runners
+// ------------------------------------------------------------
+void RunTransformStage(ITransformStage* stage, StageContext& ctx, const QueueList& inputs,
+                       const QueueList& outputs, StageMetrics* metrics,
+                       const TimerOptions& timer_options) {
+  TransformStep step(stage, ctx, outputs, metrics);
+  StageTimers timers(stage, timer_options, ctx, metrics, step.name());
+  RunInputLoop(step, inputs, ctx, timers);
+}
+
+void RunFlatMapStage(IFlatMapStage* stage, StageContext& ctx, const QueueList& inputs,
+                     const QueueList& outputs, StageMetrics* metrics,
+                     const TimerOptions& timer_options) {
+  FlatMapStep step(stage, ctx, outputs, metrics);
+  StageTimers timers(stage, timer_options, ctx, metrics, step.name());
+  RunInputLoop(step, inputs, ctx, timers);
+}
+
+void RunSinkStage(ISinkStage* stage, StageContext& ctx, const QueueList& inputs,
+                  StageMetrics* metrics, const TimerOptions& timer_options) {
+  SinkStep step(stage, ctx, metrics);
+  StageTimers timers(stage, timer_options, ctx, metrics, step.name());
+  RunInputLoop(step, inputs, ctx, timers);
+}
+
+void RunBatchSinkStage(IBatchSinkStage* stage, StageContext& ctx, const QueueList& inputs,
+                       StageMetrics* metrics, const BatchOptions& options,
+                       const TimerOptions& timer_options) {
+  BatchSinkRunner runner(stage, ctx, inputs, metrics, options, timer_options);
+  runner.Run();
+}
+
+void RunRetirableWorker(IStage* stage, StageContext& ctx, const QueueList& inputs,
+                        const QueueList& outputs, StageMetrics* metrics,
+                        const std::atomic<bool>& retire, const TimerOptions& timer_options) {
+  if (auto* transform = dynamic_cast<ITransformStage*>(stage)) {
+    TransformStep step(transform, ctx, outputs, metrics);
+    StageTimers timers(stage, timer_options, ctx, metrics, step.name());
+    RunInputLoop(step, inputs, ctx, timers, &retire);
+    return;
+  }
+  if (auto* flat_map = dynamic_cast<IFlatMapStage*>(stage)) {
+    FlatMapStep step(flat_map, ctx, outputs, metrics);
+    StageTimers timers(stage, timer_options, ctx, metrics, step.name());
+    RunInputLoop(step, inputs, ctx, timers, &retire);
+    return;
+  }
+  if (auto* sink = dynamic_cast<ISinkStage*>(stage)) {
+    SinkStep step(sink, ctx, metrics);
+    StageTimers timers(stage, timer_options, ctx, metrics, step.name());
+    RunInputLoop(step, inputs, ctx, timers, &retire);
+    return;
+  }
+  throw std::runtime_error("retirable worker is not a consumer stage: " + stage->name());
+}
+
+// ------------------------------------------------------------
+// Async stage runners
+// ------------------------------------------------------------
+void RunAsyncTransformStage(IAsyncTransformStage* stage, StageContext& ctx,
+                            const QueueList& inputs, const QueueList& outputs,
+                            StageMetrics* metrics) {
+  AsyncRunner<IAsyncTransformStage> runner(stage, ctx, inputs, outputs, metrics);
+  runner.Run();
+}
+
+void RunAsyncSinkStage(IAsyncSinkStage* stage, StageContext& ctx, const QueueList& inputs,
+                       StageMetrics* metrics) {
+  AsyncRunner<IAsyncSinkStage> runner(stage, ctx, inputs, {}, metrics);
+  runner.Run();
+}
+
+// ------------------------------------------------------------
+// Fused consumers
+// ------------------------------------------------------------
+std::shared_ptr<IQueue<Payload>> MakeFusedQueue(IStage* consumer, StageContext& ctx,
+                                                QueueRuntime& input, const QueueList& outputs,
+                                                StageMetrics* metrics) {
+  if (auto* transform = dynamic_cast<ITransformStage*>(consumer)) {
+    return std::make_shared<FusedQueue<TransformStep>>(input, transform, ctx, outputs, metrics);
+  }
+  if (auto* flat_map = dynamic_cast<IFlatMapStage*>(consumer)) {
+    return std::make_shared<FusedQueue<FlatMapStep>>(input, flat_map, ctx, outputs, metrics);
+  }
+  if (auto* sink = dynamic_cast<ISinkStage*>(consumer)) {
+    return std::make_shared<FusedQueue<SinkStep>>(input, sink, ctx, metrics);
+  }
+  throw std::runtime_error("fused stage is not a consumer: " + consumer->name());
+}
+
+// ------------------------------------------------------------
+// Pooled tasks
+// ------------------------------------------------------------
+std::unique_ptr<StageTask> MakeStageTask(IStage* stage, StageContext& ctx, QueueList inputs,
+                                         QueueList outputs, StageMetrics* metrics) {
+  if (auto* source = dynamic_cast<ISourceStage*>(stage)) {
+    return std::make_unique<SourceTask>(source, ctx, std::move(outputs), metrics);
+  }
+  if (auto* transform = dynamic_cast<ITransformStage*>(stage)) {
+    return std::make_unique<ConsumerTask<TransformStep>>(transform, ctx, std::move(inputs),
+                                                         std::move(outputs), metrics);
+  }
+  if (auto* flat_map = dynamic_cast<IFlatMapStage*>(stage)) {
+    return std::make_unique<ConsumerTask<FlatMapStep>>(flat_map, ctx, std::move(inputs),
+                                                       std::move(outputs), metrics);
+  }
+  if (auto* sink = dynamic_cast<ISinkStage*>(stage)) {
+    return std::make_unique<ConsumerTask<SinkStep>>(sink, ctx, std::move(inputs),
+                                                    std::move(outputs), metrics);
+  }
+  throw std::runtime_error("stage does not implement a valid interface: " + stage->name());
 }
 
 }  // namespace flowpipe
@@ -0,0 +1,55 @@
+#include "flowpipe/static_stage.h"
+
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+
+namespace flowpipe {
+
+namespace {
+
+constexpr std::string_view kPluginPrefix = "libstage_";
+constexpr std::string_view kPluginSuffix = ".so";
+
+// Constructed on first use: registrations run from other translation units'
+// static initializers, in no particular order.
+struct StaticStageTable {
+  std::mutex mutex;
+  std::unordered_map<std::string, StaticStage> stages;
+};
+
+StaticStageTable& Table() {
+  static StaticStageTable table;
+  return table;
+}
+
+}  // namespace
+
+bool RegisterStaticStage(const StaticStage& stage) {
+  if (!stage.type || !stage.create || !stage.destroy) {
+    return false;
+  }
+  auto& table = Table();
+  std::lock_guard<std::mutex> lock(table.mutex);
+  return table.stages.emplace(stage.type, stage).second;
+}
+
+const StaticStage* FindStaticStage(const std::string& plugin_name) {
+  std::string_view type = plugin_name;
+  if (type.find('/') != std::string_view::npos) {
+    return nullptr;
+  }
+  if (type.size() > kPluginPrefix.size() + kPluginSuffix.size() &&
+      type.substr(0, kPluginPrefix.size()) == kPluginPrefix &&
+      type.substr(type.size() - kPluginSuffix.size()) == kPluginSuffix) {
+    type = type.substr(kPluginPrefix.size(),
+                       type.size() - kPluginPrefix.size() - kPluginSuffix.size());
+  }
+
+  auto& table = Table();
+  std::lock_guard<std::mutex> lock(table.mutex);
+  auto it = table.stages.find(std::string(type));
+  return it == table.stages.end() ? nullptr : &it->second;
+}
+
+}  // namespace flowpipe
@@ -0,0 +1,211 @@
+#include "flowpipe/task_pool.h"
+
+#include <exception>
+#include <utility>
+
+#include "flowpipe/observability/logging_runtime.h"
+
+namespace flowpipe {
+
+namespace {
+
+// Pool and deque index of the calling thread, so tasks rescheduled from a
+// pool thread stay on that thread's deque (and its caches).
+thread_local const TaskPool* tls_pool = nullptr;
+thread_local size_t tls_worker = 0;
+
+}  // namespace
+
+// A submitted task plus its scheduling state. Doubles as the observer that
+// wakes the task when one of its queues changes.
+class TaskPool::Entry final : public QueueObserver {
+ public:
+  enum State : int { kQueued, kRunning, kParked, kDone };
+
+  Entry(TaskPool* pool, std::unique_ptr<StageTask> task, DoneCallback on_done)
+      : pool_(pool), task_(std::move(task)), queues_(task_->queues()), on_done_(std::move(on_done)) {}
+
+  void notify() noexcept override {
+    notified_.store(true);
+    int expected = kParked;
+    if (state_.compare_exchange_strong(expected, kQueued)) {
+      pool_->Schedule(this);
+    }
+  }
+
+  TaskPool* pool_;
+  std::unique_ptr<StageTask> task_;
+  const QueueList queues_;
+  DoneCallback on_done_;
+  std::atomic<int> state_{kQueued};
+  std::atomic<bool> notified_{false};
+};
+
+TaskPool::TaskPool(size_t threads) {
+  if (threads == 0) {
+    threads = 1;
+  }
+
+  workers_.reserve(threads);
+  for (size_t i = 0; i < threads; ++i) {
+    workers_.push_back(std::make_unique<Worker>());
+  }
+
+  threads_.reserve(threads);
+  for (size_t i = 0; i < threads; ++i) {
+    threads_.emplace_back([this, i]() { WorkerLoop(i); });
+  }
+
+  FP_LOG_INFO_FMT("task pool started with {} threads", threads);
+}
+
+TaskPool::~TaskPool() {
+  Shutdown();
+}
+
+void TaskPool::Submit(std::unique_ptr<StageTask> task, DoneCallback on_done) {
+  auto* entry = new Entry(this, std::move(task), std::move(on_done));
+  {
+    std::lock_guard lock(mu_);
+    ++live_tasks_;
+  }
+  for (auto* queue : entry->queues_) {
+    queue->queue->add_observer(entry);
+  }
+  Schedule(entry);
+}
+
+void TaskPool::Shutdown() {
+  {
+    std::unique_lock lock(mu_);
+    done_cv_.wait(lock, [this] { return live_tasks_ == 0; });
+    if (stopping_) {
+      return;
+    }
+    stopping_ = true;
+  }
+  work_cv_.notify_all();
+
+  for (auto& t : threads_) {
+    if (t.joinable()) {
+      t.join();
+    }
+  }
+}
+
+void TaskPool::Schedule(Entry* entry) {
+  const size_t target = tls_pool == this
+                            ? tls_worker
+                            : next_worker_.fetch_add(1, std::memory_order_relaxed) %
+                                  workers_.size();
+  {
+    std::lock_guard lock(workers_[target]->mu);
+    workers_[target]->tasks.push_back(entry);
+  }
+  {
+    std::lock_guard lock(mu_);
+    ++queued_;
+  }
+  work_cv_.notify_one();
+}
+
+TaskPool::Entry* TaskPool::Take(size_t self) {
+  // The caller reserved one scheduled entry, so this finds one quickly even
+  // when peers race for the same deques.
+  for (;;) {
+    {
+      auto& own = *workers_[self];
+      std::lock_guard lock(own.mu);
+      if (!own.tasks.empty()) {
+        Entry* entry = own.tasks.back();
+        own.tasks.pop_back();
+        return entry;
+      }
+    }
+
+    for (size_t n = 1; n < workers_.size(); ++n) {
+      auto& victim = *workers_[(self + n) % workers_.size()];
+      std::lock_guard lock(victim.mu);
+      if (!victim.tasks.empty()) {
+        Entry* entry = victim.tasks.front();
+        victim.tasks.pop_front();
+        return entry;
+      }
+    }
+    std::this_thread::yield();
+  }
+}
+
+void TaskPool::Run(Entry* entry) {
+  entry->state_.store(Entry::kRunning);
+  entry->notified_.store(false);
+
+  StageTask::Status status = StageTask::Status::kDone;
+  try {
+    status = entry->task_->RunSlice();
+  } catch (const std::exception& ex) {
+    FP_LOG_ERROR_FMT("pooled stage task threw exception: {}", ex.what());
+  } catch (...) {
+    FP_LOG_ERROR("pooled stage task threw unknown exception");
+  }
+
+  switch (status) {
+    case StageTask::Status::kReady:
+      entry->state_.store(Entry::kQueued);
+      Schedule(entry);
+      break;
+    case StageTask::Status::kBlocked: {
+      entry->state_.store(Entry::kParked);
+      // A queue may have changed after the slice gave up but before the
+      // task was marked parked; that notify() could not reschedule it.
+      if (entry->notified_.exchange(false)) {
+        int expected = Entry::kParked;
+        if (entry->state_.compare_exchange_strong(expected, Entry::kQueued)) {
+          Schedule(entry);
+        }
+      }
+      break;
+    }
+    case StageTask::Status::kDone:
+      Finish(entry);
+      break;
+  }
+}
+
+void TaskPool::Finish(Entry* entry) {
+  entry->state_.store(Entry::kDone);
+  // remove_observer() synchronizes with in-flight notify() calls.
+  for (auto* queue : entry->queues_) {
+    queue->queue->remove_observer(entry);
+  }
+
+  if (entry->on_done_) {
+    entry->on_done_();
+  }
+  delete entry;
+
+  {
+    std::lock_guard lock(mu_);
+    --live_tasks_;
+  }
+  done_cv_.notify_all();
+}
+
+void TaskPool::WorkerLoop(size_t self) {
+  tls_pool = this;
+  tls_worker = self;
+
+  for (;;) {
+    {
+      std::unique_lock lock(mu_);
+      work_cv_.wait(lock, [this] { return queued_ > 0 || stopping_; });
+      if (queued_ == 0) {
+        return;
+      }
+      --queued_;
+    }
+    Run(Take(self));
+  }
+}
+
+}  // namespace flowpipe
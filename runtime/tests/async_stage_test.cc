@@ -0,0 +1,204 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "flowpipe/async_stage.h"
+#include "flowpipe/bounded_queue.h"
+#include "flowpipe/event_loop.h"
+#include "flowpipe/payload.h"
+#include "flowpipe/queue_runtime.h"
+#include "flowpipe/stage_metrics.h"
+#include "flowpipe/stage_runner.h"
+#include "queue_runtime_helpers.h"
+
+namespace flowpipe {
+namespace {
+
+class CountingStageMetrics : public StageMetrics {
+ public:
+  void RecordQueueDequeue(const QueueRuntime&, const Payload&) noexcept override {
+    ++queue_dequeues;
+  }
+  void RecordQueueEnqueue(const QueueRuntime&) noexcept override {
+    ++queue_enqueues;
+  }
+  void RecordStageLatency(const char*, uint64_t) noexcept override {
+    ++latency_calls;
+  }
+  void RecordStageError(const char*) noexcept override {
+    ++error_calls;
+  }
+
+  int queue_dequeues = 0;
+  int queue_enqueues = 0;
+  int latency_calls = 0;
+  int error_calls = 0;
+};
+
+// Each payload "writes" for 20ms; tracks how many writes overlap.
+class SleepingSinkStage : public IAsyncSinkStage {
+ public:
+  std::string name() const override {
+    return "sleeping_sink";
+  }
+
+  Task consume_async(StageContext&, IoContext& io, const Payload& input) override {
+    ++in_flight;
+    peak_in_flight = std::max(peak_in_flight, in_flight);
+    co_await io.sleep_for(std::chrono::milliseconds(20));
+    seen.push_back(input.meta.flags);
+    --in_flight;
+  }
+
+  size_t max_in_flight() const override {
+    return 32;
+  }
+
+  int in_flight = 0;
+  int peak_in_flight = 0;
+  std::vector<uint32_t> seen;
+};
+
+class DoublingAsyncTransform : public IAsyncTransformStage {
+ public:
+  std::string name() const override {
+    return "doubling_async_transform";
+  }
+
+  Task process_async(StageContext&, IoContext& io, const Payload& input,
+                     Payload& output) override {
+    co_await io.sleep_for(std::chrono::milliseconds(1));
+    output.meta.flags = input.meta.flags * 2;
+  }
+};
+
+class ThrowingAsyncSink : public IAsyncSinkStage {
+ public:
+  std::string name() const override {
+    return "throwing_async_sink";
+  }
+
+  Task consume_async(StageContext&, IoContext& io, const Payload&) override {
+    co_await io.sleep_for(std::chrono::milliseconds(1));
+    throw std::runtime_error("async boom");
+  }
+};
+
+Task WaitReadable(IoContext& io, int fd, uint32_t& revents) {
+  revents = co_await io.readable(fd);
+}
+
+TEST(EventLoopTest, ResumesCoroutineWhenFdBecomesReadable) {
+  int fds[2];
+  ASSERT_EQ(pipe(fds), 0);
+
+  EventLoop loop;
+  uint32_t revents = 0;
+  auto task = WaitReadable(loop, fds[0], revents);
+
+  // Start the lazy task; it suspends waiting on the pipe.
+  task.await_suspend(std::noop_coroutine()).resume();
+  EXPECT_FALSE(task.await_ready());
+  loop.RunOnce(std::chrono::milliseconds(10));
+  EXPECT_FALSE(task.await_ready());
+
+  ASSERT_EQ(write(fds[1], "x", 1), 1);
+  loop.RunOnce(std::chrono::milliseconds(1000));
+  EXPECT_TRUE(task.await_ready());
+  EXPECT_NE(revents & kIoReadable, 0u);
+
+  close(fds[0]);
+  close(fds[1]);
+}
+
+TEST(RunAsyncSinkStageTest, KeepsManyPayloadsInFlight) {
+  auto input = MakeQueueRuntime("in", 64);
+
+  std::atomic<bool> stop_flag{false};
+  StageContext ctx{StopToken(&stop_flag)};
+
+  for (uint32_t i = 0; i < 64; ++i) {
+    Payload payload;
+    payload.meta.flags = i;
+    ASSERT_TRUE(input.queue->push(payload, ctx.stop));
+  }
+  input.queue->close();
+
+  SleepingSinkStage stage;
+  CountingStageMetrics metrics;
+
+  const auto start = std::chrono::steady_clock::now();
+  RunAsyncSinkStage(&stage, ctx, QueueList{&input}, &metrics);
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+
+  EXPECT_EQ(stage.seen.size(), 64u);
+  EXPECT_EQ(stage.peak_in_flight, 32);
+  // Sequential writes would take 64 * 20ms.
+  EXPECT_LT(elapsed, std::chrono::milliseconds(640));
+  EXPECT_EQ(metrics.queue_dequeues, 64);
+  EXPECT_EQ(metrics.latency_calls, 64);
+  EXPECT_EQ(metrics.error_calls, 0);
+}
+
+TEST(RunAsyncTransformStageTest, ForwardsOutputsAndRespectsBackpressure) {
+  auto input = MakeQueueRuntime("in", 16);
+  auto output = MakeQueueRuntime("out", 2);
+
+  std::atomic<bool> stop_flag{false};
+  StageContext ctx{StopToken(&stop_flag)};
+
+  for (uint32_t i = 0; i < 10; ++i) {
+    Payload payload;
+    payload.meta.flags = i;
+    ASSERT_TRUE(input.queue->push(payload, ctx.stop));
+  }
+  input.queue->close();
+
+  DoublingAsyncTransform stage;
+  CountingStageMetrics metrics;
+
+  std::thread worker([&]() {
+    RunAsyncTransformStage(&stage, ctx, QueueList{&input}, QueueList{&output}, &metrics);
+    output.queue->close();
+  });
+
+  uint32_t sum = 0;
+  int count = 0;
+  while (auto item = output.queue->pop(ctx.stop)) {
+    sum += item->meta.flags;
+    ++count;
+  }
+  worker.join();
+
+  EXPECT_EQ(count, 10);
+  EXPECT_EQ(sum, 90u);
+  EXPECT_EQ(metrics.queue_enqueues, 10);
+}
+
+TEST(RunAsyncSinkStageTest, ExceptionRequestsGlobalStop) {
+  auto input = MakeQueueRuntime("in", 4);
+
+  std::atomic<bool> stop_flag{false};
+  StageContext ctx{StopToken(&stop_flag)};
+
+  ASSERT_TRUE(input.queue->push(Payload{}, ctx.stop));
+  ASSERT_TRUE(input.queue->push(Payload{}, ctx.stop));
+
+  ThrowingAsyncSink stage;
+  CountingStageMetrics metrics;
+
+  RunAsyncSinkStage(&stage, ctx, QueueList{&input}, &metrics);
+
+  EXPECT_TRUE(stop_flag.load());
+  EXPECT_GE(metrics.error_calls, 1);
+}
+
+}  // namespace
+}  // namespace flowpipe
@@ -0,0 +1,213 @@
+#include "flowpipe/autoscaler.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "flowpipe/bounded_queue.h"
+#include "flowpipe/payload.h"
+#include "flowpipe/queue_runtime.h"
+#include "flowpipe/stage.h"
+#include "flowpipe/stage_runner.h"
+#include "queue_runtime_helpers.h"
+
+namespace flowpipe {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using std::chrono::milliseconds;
+
+AutoscalePolicy TestPolicy() {
+  AutoscalePolicy policy;
+  policy.scale_up_occupancy = 0.75;
+  policy.scale_down_occupancy = 0.10;
+  policy.scale_up_dwell = milliseconds(0);
+  policy.scale_up_samples = 2;
+  policy.scale_down_samples = 3;
+  policy.cooldown = milliseconds(1000);
+  return policy;
+}
+
+ScalingSample Occupancy(double occupancy) {
+  ScalingSample sample;
+  sample.occupancy = occupancy;
+  return sample;
+}
+
+TEST(ScalingControllerTest, NeedsConsecutiveSamplesToDecide) {
+  ScalingController controller(TestPolicy(), 1, 4);
+  const auto t0 = Clock::now();
+
+  EXPECT_EQ(controller.Observe(Occupancy(0.9), 1, t0), 0);
+  EXPECT_EQ(controller.Observe(Occupancy(0.5), 1, t0), 0);  // resets the busy run
+  EXPECT_EQ(controller.Observe(Occupancy(0.9), 1, t0), 0);
+  EXPECT_EQ(controller.Observe(Occupancy(0.9), 1, t0), 1);
+
+  const auto t1 = t0 + milliseconds(2000);
+  EXPECT_EQ(controller.Observe(Occupancy(0.0), 2, t1), 0);
+  EXPECT_EQ(controller.Observe(Occupancy(0.0), 2, t1), 0);
+  EXPECT_EQ(controller.Observe(Occupancy(0.0), 2, t1), -1);
+}
+
+TEST(ScalingControllerTest, HoldsInsideHysteresisBand) {
+  ScalingController controller(TestPolicy(), 1, 4);
+  const auto t0 = Clock::now();
+  for (int i = 0; i < 50; ++i) {
+    EXPECT_EQ(controller.Observe(Occupancy(0.4), 2, t0 + milliseconds(i * 500)), 0);
+  }
+}
+
+TEST(ScalingControllerTest, CooldownSpacesDecisions) {
+  ScalingController controller(TestPolicy(), 1, 4);
+  const auto t0 = Clock::now();
+
+  controller.Observe(Occupancy(1.0), 1, t0);
+  ASSERT_EQ(controller.Observe(Occupancy(1.0), 1, t0), 1);
+
+  EXPECT_EQ(controller.Observe(Occupancy(1.0), 2, t0 + milliseconds(100)), 0);
+  EXPECT_EQ(controller.Observe(Occupancy(1.0), 2, t0 + milliseconds(200)), 0);
+  EXPECT_EQ(controller.Observe(Occupancy(1.0), 2, t0 + milliseconds(1200)), 1);
+}
+
+TEST(ScalingControllerTest, StaysWithinBounds) {
+  ScalingController controller(TestPolicy(), 2, 3);
+  const auto t0 = Clock::now();
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(controller.Observe(Occupancy(1.0), 3, t0 + milliseconds(i * 2000)), 0);
+  }
+  for (int i = 10; i < 20; ++i) {
+    EXPECT_EQ(controller.Observe(Occupancy(0.0), 2, t0 + milliseconds(i * 2000)), 0);
+  }
+}
+
+TEST(ScalingControllerTest, DwellAloneCountsAsBusy) {
+  AutoscalePolicy policy = TestPolicy();
+  policy.scale_up_dwell = milliseconds(50);
+  ScalingController controller(policy, 1, 4);
+  const auto t0 = Clock::now();
+
+  ScalingSample slow;
+  slow.occupancy = 0.05;
+  slow.mean_dwell_ns = 80'000'000;
+  controller.Observe(slow, 1, t0);
+  EXPECT_EQ(controller.Observe(slow, 1, t0), 1);
+}
+
+class CountingSinkStage : public ISinkStage {
+ public:
+  CountingSinkStage(std::atomic<int>* consumed, milliseconds delay)
+      : consumed_(consumed), delay_(delay) {}
+
+  std::string name() const override {
+    return "counting_sink";
+  }
+
+  void consume(StageContext&, const Payload&) override {
+    std::this_thread::sleep_for(delay_);
+    consumed_->fetch_add(1);
+  }
+
+ private:
+  std::atomic<int>* consumed_;
+  milliseconds delay_;
+};
+
+TEST(RunRetirableWorkerTest, RetiredWorkerLeavesBlockedPopWithoutClosingInput) {
+  auto input = MakeQueueRuntime("in", 4);
+  std::atomic<bool> stop_flag{false};
+  StageContext ctx{StopToken{&stop_flag}};
+  std::atomic<int> consumed{0};
+  CountingSinkStage sink(&consumed, milliseconds(0));
+  std::atomic<bool> retire{false};
+
+  auto done = std::async(std::launch::async, [&] {
+    RunRetirableWorker(&sink, ctx, QueueList{&input}, {}, nullptr, retire);
+  });
+
+  ASSERT_TRUE(input.queue->push(Payload{}, ctx.stop));
+  while (consumed.load() < 1) {
+    std::this_thread::yield();
+  }
+
+  retire.store(true);
+  input.queue->wake_all();
+  ASSERT_EQ(done.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+
+  EXPECT_FALSE(stop_flag.load());
+  EXPECT_FALSE(input.queue->drained());
+  ASSERT_TRUE(input.queue->push(Payload{}, ctx.stop));
+  EXPECT_EQ(input.queue->size(), 1u);
+}
+
+TEST(ScaledStageTest, ScalesUpUnderBacklogAndDownWhenIdleWithoutLosingPayloads) {
+  constexpr int kPayloads = 60;
+  auto input = MakeQueueRuntime("in", 16);
+  std::atomic<bool> stop_flag{false};
+  StageContext ctx{StopToken{&stop_flag}};
+  std::atomic<int> consumed{0};
+  std::atomic<int> created{0};
+  std::promise<void> finished;
+
+  AutoscalePolicy policy = TestPolicy();
+  policy.scale_up_samples = 1;
+  policy.scale_down_samples = 1;
+  policy.cooldown = milliseconds(0);
+
+  ScaledStage::Hooks hooks;
+  hooks.create = [&]() -> IStage* {
+    created.fetch_add(1);
+    return new CountingSinkStage(&consumed, milliseconds(2));
+  };
+  hooks.run = [&](IStage* stage, uint32_t, const std::atomic<bool>& retire,
+                  StageMetrics* metrics) {
+    RunRetirableWorker(stage, ctx, QueueList{&input}, {}, metrics, retire);
+  };
+  hooks.destroy = [](IStage* stage) { delete stage; };
+  hooks.finished = [&]() { finished.set_value(); };
+
+  ScaledStage scaled("sink", QueueList{&input}, 1, 3, policy, nullptr, std::move(hooks));
+  scaled.Start({new CountingSinkStage(&consumed, milliseconds(2))});
+  EXPECT_EQ(scaled.active_workers(), 1u);
+
+  std::thread producer([&] {
+    for (int i = 0; i < kPayloads; ++i) {
+      ASSERT_TRUE(input.queue->push(Payload{}, ctx.stop));
+    }
+  });
+
+  // Wait for a backlog, then let the supervisor react to it.
+  while (input.queue->size() < 12 && consumed.load() < kPayloads) {
+    std::this_thread::sleep_for(milliseconds(1));
+  }
+  auto now = Clock::now();
+  scaled.Tick(now);
+  scaled.Tick(now);
+  EXPECT_EQ(scaled.active_workers(), 3u);
+  EXPECT_EQ(created.load(), 2);
+
+  producer.join();
+  while (consumed.load() < kPayloads) {
+    std::this_thread::sleep_for(milliseconds(1));
+  }
+
+  scaled.Tick(now);
+  scaled.Tick(now);
+  scaled.Tick(now);
+  EXPECT_EQ(scaled.active_workers(), 1u);
+
+  // The remaining worker still serves the queue.
+  ASSERT_TRUE(input.queue->push(Payload{}, ctx.stop));
+  input.queue->close();
+  ASSERT_EQ(finished.get_future().wait_for(std::chrono::seconds(5)), std::future_status::ready);
+  scaled.Join();
+  EXPECT_EQ(consumed.load(), kPayloads + 1);
+}
+
+}  // namespace
+}  // namespace flowpipe
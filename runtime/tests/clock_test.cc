@@ -0,0 +1,51 @@
+#include "flowpipe/clock.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+namespace flowpipe {
+namespace {
+
+TEST(ClockTest, FastNowFollowsMonotonicByDefault) {
+  ASSERT_FALSE(TscClockActive());
+  const uint64_t before = MonotonicNowNs();
+  const uint64_t fast = FastNowNs();
+  const uint64_t after = MonotonicNowNs();
+  EXPECT_LE(before, fast);
+  EXPECT_LE(fast, after);
+}
+
+TEST(ClockTest, TscClockTracksMonotonicAndSwitchesBack) {
+  if (!HasInvariantTsc()) {
+    EXPECT_FALSE(EnableTscClock());
+    EXPECT_FALSE(TscClockActive());
+    GTEST_SKIP() << "no invariant TSC on this CPU";
+  }
+
+  ASSERT_TRUE(EnableTscClock(std::chrono::milliseconds(10)));
+  EXPECT_TRUE(TscClockActive());
+  EXPECT_TRUE(EnableTscClock());  // already on
+
+  uint64_t previous = FastNowNs();
+  for (int i = 0; i < 5; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(15));  // spans drift checks
+    const uint64_t mono = MonotonicNowNs();
+    const uint64_t fast = FastNowNs();
+    EXPECT_GE(fast, previous);
+    // Calibration error stays well under a millisecond.
+    EXPECT_LT(fast > mono ? fast - mono : mono - fast, 1'000'000u);
+    previous = fast;
+  }
+
+  DisableTscClock();
+  EXPECT_FALSE(TscClockActive());
+  const uint64_t before = MonotonicNowNs();
+  const uint64_t fast = FastNowNs();
+  EXPECT_LE(before, fast);
+}
+
+}  // namespace
+}  // namespace flowpipe
@@ -0,0 +1,168 @@
+#include "flowpipe/cpu_topology.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "flowpipe/cpu_resources.h"
+#include "flowpipe/numa.h"
+
+namespace flowpipe {
+namespace {
+
+namespace fs = std::filesystem;
+
+// 2 L3 domains x 2 cores x 2 SMT threads; siblings are cpu n and n+4.
+CpuTopology TwoDomainTopology() {
+  std::vector<CpuInfo> cpus;
+  for (uint32_t cpu = 0; cpu < 8; ++cpu) {
+    const uint32_t core = cpu % 4;
+    CpuInfo info;
+    info.cpu = cpu;
+    info.core = core;
+    info.l3 = core < 2 ? 0 : 2;
+    info.numa_node = core < 2 ? 0 : 1;
+    cpus.push_back(info);
+  }
+  return CpuTopology(std::move(cpus));
+}
+
+uint32_t L3Of(const CpuTopology& topology, uint32_t cpu) {
+  return topology.find(cpu)->l3;
+}
+
+TEST(ParseCpuListTest, ParsesRangesAndSingles) {
+  EXPECT_EQ(ParseCpuList("0-3,8,10-11\n"), (std::vector<uint32_t>{0, 1, 2, 3, 8, 10, 11}));
+  EXPECT_EQ(ParseCpuList("5,1-2,2"), (std::vector<uint32_t>{1, 2, 5}));
+  EXPECT_TRUE(ParseCpuList("").empty());
+  EXPECT_EQ(ParseCpuList("x,4"), (std::vector<uint32_t>{4}));
+}
+
+class CpuTopologyDetectTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    root_ = fs::temp_directory_path() /
+            ("flowpipe_sysfs_" + std::to_string(reinterpret_cast<uintptr_t>(this)));
+    fs::remove_all(root_);
+  }
+
+  void TearDown() override {
+    fs::remove_all(root_);
+  }
+
+  void Write(const fs::path& relative, const std::string& content) {
+    const auto path = root_ / relative;
+    fs::create_directories(path.parent_path());
+    std::ofstream(path) << content << "\n";
+  }
+
+  fs::path root_;
+};
+
+TEST_F(CpuTopologyDetectTest, ReadsSiblingsCachesAndNodes) {
+  for (uint32_t cpu = 0; cpu < 4; ++cpu) {
+    const std::string dir = "cpu" + std::to_string(cpu);
+    Write(dir + "/topology/thread_siblings_list", cpu < 2 ? "0-1" : "2-3");
+    Write(dir + "/cache/index0/level", "1");
+    Write(dir + "/cache/index0/shared_cpu_list", std::to_string(cpu));
+    Write(dir + "/cache/index3/level", "3");
+    Write(dir + "/cache/index3/shared_cpu_list", cpu < 2 ? "0-1" : "2-3");
+    fs::create_directories(root_ / dir / (cpu < 2 ? "node0" : "node1"));
+  }
+
+  const auto topology = CpuTopology::Detect({0, 1, 2, 3}, root_.string());
+  ASSERT_EQ(topology.cpus().size(), 4u);
+  EXPECT_EQ(topology.core_count(), 2u);
+  EXPECT_EQ(topology.l3_count(), 2u);
+  EXPECT_EQ(topology.numa_node_count(), 2u);
+  EXPECT_EQ(topology.find(1)->core, 0u);
+  EXPECT_EQ(topology.find(3)->l3, 2u);
+  EXPECT_EQ(topology.find(3)->numa_node, 1u);
+  EXPECT_EQ(topology.find(7), nullptr);
+}
+
+TEST_F(CpuTopologyDetectTest, MissingSysfsTreatsEveryCpuAsOwnCore) {
+  const auto topology = CpuTopology::Detect({0, 1}, root_.string());
+  EXPECT_EQ(topology.core_count(), 2u);
+  EXPECT_EQ(topology.l3_count(), 1u);
+  EXPECT_EQ(topology.numa_node_count(), 1u);
+}
+
+TEST_F(CpuTopologyDetectTest, ReadsNumaNodesAndTheirCpus) {
+  Write("possible", "0-1");
+  Write("node0/cpulist", "0-3,8-11");
+  Write("node1/cpulist", "4-7,12-15");
+
+  EXPECT_EQ(NumaNodeCount(root_.string()), 2u);
+  EXPECT_EQ(NumaNodeCpus(1, root_.string()),
+            (std::vector<uint32_t>{4, 5, 6, 7, 12, 13, 14, 15}));
+  EXPECT_TRUE(NumaNodeCpus(2, root_.string()).empty());
+}
+
+TEST_F(CpuTopologyDetectTest, NumaNodeCountDefaultsToOne) {
+  EXPECT_EQ(NumaNodeCount(root_.string()), 1u);
+}
+
+TEST(PlanCpuPlacementTest, KeepsLinkedStagesInOneL3Domain) {
+  const auto topology = TwoDomainTopology();
+  const std::vector<PlacementRequest> stages{
+      {"source", 1, true}, {"sink", 1, true}, {"other_source", 1, true}, {"other_sink", 1, true}};
+  const auto plan = PlanCpuPlacement(topology, stages, {{0, 1}, {2, 3}});
+
+  ASSERT_EQ(plan.size(), 4u);
+  for (const auto& placement : plan) {
+    ASSERT_EQ(placement.cpus.size(), 1u) << placement.stage;
+    EXPECT_FALSE(placement.shares_smt) << placement.stage;
+    EXPECT_FALSE(placement.oversubscribed) << placement.stage;
+  }
+  EXPECT_EQ(L3Of(topology, plan[0].cpus[0]), L3Of(topology, plan[1].cpus[0]));
+  EXPECT_EQ(L3Of(topology, plan[2].cpus[0]), L3Of(topology, plan[3].cpus[0]));
+  EXPECT_NE(L3Of(topology, plan[0].cpus[0]), L3Of(topology, plan[2].cpus[0]));
+}
+
+TEST(PlanCpuPlacementTest, HotStagesDoNotShareCores) {
+  const auto topology = TwoDomainTopology();
+  const std::vector<PlacementRequest> stages{{"cold", 2, false}, {"hot", 2, true}};
+  const auto plan = PlanCpuPlacement(topology, stages, {{0, 1}});
+
+  std::vector<uint32_t> hot_cores;
+  for (const auto cpu : plan[1].cpus) {
+    hot_cores.push_back(topology.find(cpu)->core);
+  }
+  std::sort(hot_cores.begin(), hot_cores.end());
+  EXPECT_EQ(std::unique(hot_cores.begin(), hot_cores.end()), hot_cores.end());
+  for (const auto cpu : plan[0].cpus) {
+    EXPECT_EQ(std::count(hot_cores.begin(), hot_cores.end(), topology.find(cpu)->core), 0)
+        << "cold stage placed on a sibling of a hot core: cpu " << cpu;
+  }
+  // The cold stage packs both threads of one core.
+  ASSERT_EQ(plan[0].cpus.size(), 2u);
+  EXPECT_EQ(topology.find(plan[0].cpus[0])->core, topology.find(plan[0].cpus[1])->core);
+}
+
+TEST(PlanCpuPlacementTest, FallsBackToSiblingsThenSharesDomain) {
+  const auto topology = TwoDomainTopology();
+  const std::vector<PlacementRequest> stages{{"wide", 6, true}, {"late", 4, true}};
+  const auto plan = PlanCpuPlacement(topology, stages, {});
+
+  EXPECT_EQ(plan[0].cpus.size(), 6u);
+  EXPECT_TRUE(plan[0].shares_smt);
+  EXPECT_FALSE(plan[0].oversubscribed);
+
+  EXPECT_EQ(plan[1].cpus.size(), 2u);
+  EXPECT_TRUE(plan[1].oversubscribed);
+}
+
+TEST(PlanCpuPlacementTest, EmptyTopologyLeavesStagesUnplaced) {
+  const auto plan = PlanCpuPlacement(CpuTopology{}, {{"stage", 1, true}}, {});
+  ASSERT_EQ(plan.size(), 1u);
+  EXPECT_TRUE(plan[0].cpus.empty());
+}
+
+}  // namespace
+}  // namespace flowpipe
@@ -0,0 +1,158 @@
+#include "flowpipe/flow_spec.h"
+
+#include <google/protobuf/util/message_differencer.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+namespace flowpipe {
+namespace {
+
+namespace fs = std::filesystem;
+
+// source -> q1 -> sink, using the single-queue fields.
+v1::FlowSpec LinearFlow() {
+  v1::FlowSpec flow;
+  flow.set_name("linear");
+  auto* q = flow.add_queues();
+  q->set_name("q1");
+  q->set_capacity(8);
+
+  auto* source = flow.add_stages();
+  source->set_name("source");
+  source->set_type("noop_source");
+  source->set_threads(1);
+  source->set_output_queue("q1");
+  (*source->mutable_config()->mutable_fields())["max_messages"].set_number_value(3);
+
+  auto* sink = flow.add_stages();
+  sink->set_name("sink");
+  sink->set_type("stdout_sink");
+  sink->set_plugin("/opt/plugins/custom_sink.so");
+  sink->set_threads(2);
+  sink->set_input_queue("q1");
+  return flow;
+}
+
+TEST(FlowSpecTest, StagePluginNameDefaultsFromType) {
+  const auto flow = LinearFlow();
+  EXPECT_EQ(StagePluginName(flow.stages(0)), "libstage_noop_source.so");
+  EXPECT_EQ(StagePluginName(flow.stages(1)), "/opt/plugins/custom_sink.so");
+}
+
+TEST(FlowSpecTest, ValidFlowPasses) {
+  EXPECT_NO_THROW(ValidateFlowSpec(LinearFlow()));
+}
+
+TEST(FlowSpecTest, RejectsStructuralErrors) {
+  auto zero_capacity = LinearFlow();
+  zero_capacity.mutable_queues(0)->set_capacity(0);
+  EXPECT_THROW(ValidateFlowSpec(zero_capacity), std::runtime_error);
+
+  auto duplicate_queue = LinearFlow();
+  *duplicate_queue.add_queues() = duplicate_queue.queues(0);
+  EXPECT_THROW(ValidateFlowSpec(duplicate_queue), std::runtime_error);
+
+  auto duplicate_stage = LinearFlow();
+  duplicate_stage.mutable_stages(1)->set_name("source");
+  EXPECT_THROW(ValidateFlowSpec(duplicate_stage), std::runtime_error);
+
+  auto unknown_queue = LinearFlow();
+  unknown_queue.mutable_stages(1)->set_input_queue("missing");
+  EXPECT_THROW(ValidateFlowSpec(unknown_queue), std::runtime_error);
+
+  auto listed_twice = LinearFlow();
+  listed_twice.mutable_stages(1)->add_input_queues("q1");
+  EXPECT_THROW(ValidateFlowSpec(listed_twice), std::runtime_error);
+
+  auto no_threads = LinearFlow();
+  no_threads.mutable_stages(0)->set_threads(0);
+  EXPECT_THROW(ValidateFlowSpec(no_threads), std::runtime_error);
+}
+
+TEST(FlowSpecTest, NormalizeMakesDefaultsExplicitAndIsIdempotent) {
+  auto flow = LinearFlow();
+  flow.add_queues()->set_name("q2");
+  flow.mutable_queues(1)->set_capacity(4);
+  flow.mutable_stages(1)->add_input_queues("q2");
+
+  NormalizeFlowSpec(&flow);
+
+  EXPECT_EQ(flow.queues(0).type(), v1::QUEUE_TYPE_IN_MEMORY);
+  const auto& source = flow.stages(0);
+  EXPECT_EQ(source.plugin(), "libstage_noop_source.so");
+  EXPECT_FALSE(source.has_output_queue());
+  ASSERT_EQ(source.output_queues_size(), 1);
+  EXPECT_EQ(source.output_queues(0), "q1");
+
+  // The single queue goes first, as the runtime orders it.
+  const auto& sink = flow.stages(1);
+  EXPECT_EQ(sink.plugin(), "/opt/plugins/custom_sink.so");
+  EXPECT_FALSE(sink.has_input_queue());
+  ASSERT_EQ(sink.input_queues_size(), 2);
+  EXPECT_EQ(sink.input_queues(0), "q1");
+  EXPECT_EQ(sink.input_queues(1), "q2");
+
+  EXPECT_NO_THROW(ValidateFlowSpec(flow));
+  auto again = flow;
+  NormalizeFlowSpec(&again);
+  EXPECT_TRUE(google::protobuf::util::MessageDifferencer::Equals(flow, again));
+}
+
+class FlowSpecFileTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    dir_ = fs::temp_directory_path() /
+           ("flowpipe_flow_spec_" + std::to_string(reinterpret_cast<uintptr_t>(this)));
+    fs::create_directories(dir_);
+  }
+
+  void TearDown() override {
+    fs::remove_all(dir_);
+  }
+
+  fs::path dir_;
+};
+
+TEST_F(FlowSpecFileTest, BinaryRoundTripIsDeterministic) {
+  auto flow = LinearFlow();
+  auto& fields = *flow.mutable_stages(0)->mutable_config()->mutable_fields();
+  for (int i = 0; i < 64; ++i) {
+    fields["key_" + std::to_string(i)].set_string_value(std::to_string(i));
+  }
+  NormalizeFlowSpec(&flow);
+
+  const auto first = (dir_ / "a.pb").string();
+  const auto second = (dir_ / "b.pb").string();
+  std::string error;
+  ASSERT_TRUE(WriteFlowSpecBinary(flow, first, &error)) << error;
+
+  v1::FlowSpec loaded;
+  ASSERT_TRUE(ReadFlowSpecBinary(first, &loaded, &error)) << error;
+  EXPECT_TRUE(google::protobuf::util::MessageDifferencer::Equals(flow, loaded));
+
+  ASSERT_TRUE(WriteFlowSpecBinary(loaded, second, &error)) << error;
+  std::ifstream a(first, std::ios::binary);
+  std::ifstream b(second, std::ios::binary);
+  EXPECT_EQ(std::string(std::istreambuf_iterator<char>(a), {}),
+            std::string(std::istreambuf_iterator<char>(b), {}));
+}
+
+TEST_F(FlowSpecFileTest, ReadReportsMissingAndCorruptFiles) {
+  v1::FlowSpec flow;
+  std::string error;
+  EXPECT_FALSE(ReadFlowSpecBinary((dir_ / "missing.pb").string(), &flow, &error));
+  EXPECT_NE(error.find("failed to open"), std::string::npos);
+
+  const auto corrupt = (dir_ / "corrupt.pb").string();
+  std::ofstream(corrupt, std::ios::binary) << "\xff\xff\xff\xff not a protobuf";
+  EXPECT_FALSE(ReadFlowSpecBinary(corrupt, &flow, &error));
+  EXPECT_NE(error.find("not a binary FlowSpec"), std::string::npos);
+}
+
+}  // namespace
+}  // namespace flowpipe
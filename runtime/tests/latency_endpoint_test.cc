@@ -0,0 +1,97 @@
+#include "flowpipe/observability/latency_endpoint.h"
+
+#include <gtest/gtest.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace flowpipe::observability {
+namespace {
+
+namespace fs = std::filesystem;
+
+HistogramSnapshot Uniform(uint64_t count, uint64_t value) {
+  LocalHistogram histogram;
+  for (uint64_t i = 0; i < count; ++i) {
+    histogram.record(value);
+  }
+  HistogramSnapshot snapshot;
+  snapshot.Add(histogram);
+  return snapshot;
+}
+
+TEST(LatencyEndpointTest, ReportListsNonEmptyHistograms) {
+  StageTotals sink;
+  sink.labels = {{"flow", "etl"}, {"stage", "sink"}};
+  sink.latency = Uniform(4, 10);
+  sink.end_to_end = Uniform(2, 20);
+
+  StageTotals idle;
+  idle.labels = {{"flow", "etl"}, {"stage", "idle"}};
+
+  QueueTotals queue;
+  queue.labels = {{"flow", "etl"}, {"queue", "q1"}};
+  queue.dwell = Uniform(3, 7);
+
+  const std::string report = FormatLatencyReport({sink, idle}, {queue});
+  EXPECT_NE(report.find("stage_latency flow=etl stage=sink count=4 mean=10 p50=10 p90=10 "
+                        "p99=10 p999=10 max=10\n"),
+            std::string::npos)
+      << report;
+  EXPECT_NE(report.find("queue_dwell flow=etl queue=q1 count=3 mean=7"), std::string::npos);
+  EXPECT_NE(report.find("end_to_end flow=etl stage=sink count=2 mean=20"), std::string::npos);
+  EXPECT_EQ(report.find("stage=idle"), std::string::npos);
+}
+
+TEST(LatencyEndpointTest, ServesOneSnapshotPerConnection) {
+  const fs::path path = fs::temp_directory_path() /
+                        ("flowpipe_latency_" + std::to_string(::getpid()) + ".sock");
+
+  auto& metrics = RuntimeMetrics::Get();
+  metrics.Configure(true, true, true);
+  const SeriesId id = metrics.RegisterStage({{"stage", "served_stage"}});
+  metrics.stage(id).latency.record(1000);
+  metrics.Configure(false, false, false);
+
+  LatencyEndpoint endpoint;
+  ASSERT_TRUE(endpoint.Start(path.string()));
+  EXPECT_TRUE(fs::is_socket(path));
+
+  for (int round = 0; round < 2; ++round) {
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    ASSERT_GE(fd, 0);
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    ASSERT_EQ(connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+
+    std::string received;
+    char buffer[4096];
+    ssize_t n = 0;
+    while ((n = read(fd, buffer, sizeof(buffer))) > 0) {
+      received.append(buffer, static_cast<size_t>(n));
+    }
+    close(fd);
+    EXPECT_NE(received.find("stage_latency stage=served_stage count=1"), std::string::npos)
+        << received;
+  }
+
+  endpoint.Stop();
+  EXPECT_FALSE(fs::exists(path));
+}
+
+TEST(LatencyEndpointTest, StartFailsOnUnusablePath) {
+  LatencyEndpoint endpoint;
+  EXPECT_FALSE(endpoint.Start(""));
+  EXPECT_FALSE(endpoint.Start("/nonexistent-dir/flowpipe.sock"));
+  EXPECT_FALSE(endpoint.Start(std::string(200, 'x')));
+}
+
+}  // namespace
+}  // namespace flowpipe::observability
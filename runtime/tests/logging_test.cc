@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+#include <spdlog/sinks/ostream_sink.h>
+#include <spdlog/spdlog.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "flowpipe/observability/log_ring.h"
+#include "flowpipe/observability/logging.h"
+#include "flowpipe/observability/logging_runtime.h"
+
+namespace flowpipe::observability {
+namespace {
+
+const auto kTime = std::chrono::system_clock::time_point{};
+
+std::vector<std::string> DrainAll(LogRing& ring) {
+  std::vector<std::string> out;
+  ring.Drain([&](const LogRecord& r) { out.emplace_back(r.text()); });
+  return out;
+}
+
+TEST(LogRingTest, KeepsOrderAndDropsWhenFull) {
+  LogRing ring(3);
+  EXPECT_EQ(ring.capacity(), 4u);
+
+  for (int i = 0; i < 6; ++i) {
+    std::string message = "m";
+    message += std::to_string(i);
+    EXPECT_EQ(ring.TryPush(LogLevel::Info, message, __FILE__, __LINE__, kTime), i < 4);
+  }
+  EXPECT_EQ(ring.dropped(), 2u);
+  EXPECT_EQ(DrainAll(ring), (std::vector<std::string>{"m0", "m1", "m2", "m3"}));
+
+  // Drained slots are reusable.
+  EXPECT_TRUE(ring.TryPush(LogLevel::Warn, "again", "file.cc", 7, kTime));
+  ring.Drain([](const LogRecord& r) {
+    EXPECT_EQ(r.text(), "again");
+    EXPECT_EQ(r.level, LogLevel::Warn);
+    EXPECT_STREQ(r.file, "file.cc");
+    EXPECT_EQ(r.line, 7);
+  });
+  EXPECT_EQ(ring.dropped(), 2u);
+}
+
+TEST(LogRingTest, LongMessagesSpillToHeap) {
+  LogRing ring(2);
+  const std::string fits(LogRecord::kInlineBytes, 'a');
+  const std::string spills(LogRecord::kInlineBytes * 3, 'b');
+  ASSERT_TRUE(ring.TryPush(LogLevel::Info, fits, nullptr, 0, kTime));
+  ASSERT_TRUE(ring.TryPush(LogLevel::Info, spills, nullptr, 0, kTime));
+  EXPECT_EQ(DrainAll(ring), (std::vector<std::string>{fits, spills}));
+}
+
+TEST(LogRingTest, ConcurrentProducersLoseNothingButDrops) {
+  LogRing ring(64);
+  constexpr int kProducers = 4;
+  constexpr int kRecords = 5000;
+
+  std::atomic<int> finished{0};
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducers; ++p) {
+    producers.emplace_back([&ring, &finished, p] {
+      for (int i = 0; i < kRecords; ++i) {
+        ring.TryPush(LogLevel::Info, std::to_string(p) + ":" + std::to_string(i), nullptr, 0,
+                     kTime);
+      }
+      finished.fetch_add(1);
+    });
+  }
+
+  std::vector<int> last(kProducers, -1);
+  uint64_t delivered = 0;
+  auto consume = [&](const LogRecord& r) {
+    const std::string text(r.text());
+    const size_t colon = text.find(':');
+    const int p = std::stoi(text.substr(0, colon));
+    const int i = std::stoi(text.substr(colon + 1));
+    EXPECT_GT(i, last[p]);  // per-producer order is kept
+    last[p] = i;
+    ++delivered;
+  };
+  while (finished.load() < kProducers) {
+    ring.Drain(consume);
+  }
+  for (auto& t : producers) {
+    t.join();
+  }
+  ring.Drain(consume);
+
+  EXPECT_EQ(delivered + ring.dropped(), uint64_t{kProducers} * kRecords);
+}
+
+TEST(LoggingTest, DisabledLevelsDoNotEvaluateArguments) {
+  SetLogLevel(LogLevel::Info);
+  int evaluated = 0;
+  auto message = [&evaluated] {
+    ++evaluated;
+    return std::string("message");
+  };
+
+  FP_LOG_DEBUG(message());
+  FP_LOG_DEBUG_FMT("{}", message());
+  EXPECT_EQ(evaluated, 0);
+  EXPECT_FALSE(LogEnabled(LogLevel::Debug));
+  EXPECT_TRUE(LogEnabled(LogLevel::Warn));
+
+  SetLogLevel(LogLevel::Debug);
+  FP_LOG_DEBUG(message());
+  FP_LOG_DEBUG_FMT("{}", message());
+  EXPECT_EQ(evaluated, 2);
+  SetLogLevel(LogLevel::Info);
+}
+
+TEST(LoggingTest, AsyncRecordsReachSpdlogInOrderByStop) {
+  std::ostringstream out;
+  auto sink = std::make_shared<spdlog::sinks::ostream_sink_mt>(out);
+  auto logger = std::make_shared<spdlog::logger>("logging_test", sink);
+  logger->set_pattern("%l %v");
+  logger->set_level(spdlog::level::debug);
+  const auto previous = spdlog::default_logger();
+  spdlog::set_default_logger(logger);
+  SetLogLevel(LogLevel::Debug);
+
+  StartAsyncLogging(16);
+  FP_LOG_INFO("first");
+  FP_LOG_WARN_FMT("second {}", 2);
+  FP_LOG_DEBUG(std::string(LogRecord::kInlineBytes + 1, 'x'));
+  StopAsyncLogging();
+
+  const std::string expected =
+      "info first\nwarning second 2\ndebug " + std::string(LogRecord::kInlineBytes + 1, 'x') + "\n";
+  EXPECT_EQ(out.str(), expected);
+
+  // Synchronous again once stopped.
+  FP_LOG_ERROR("after");
+  EXPECT_EQ(out.str(), expected + "error after\n");
+
+  SetLogLevel(LogLevel::Info);
+  spdlog::set_default_logger(previous);
+}
+
+}  // namespace
+}  // namespace flowpipe::observability
@@ -0,0 +1,196 @@
+#include "flowpipe/observability/prometheus_endpoint.h"
+
+#include <arpa/inet.h>
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace flowpipe::observability {
+namespace {
+
+HistogramSnapshot Uniform(uint64_t count, uint64_t value) {
+  LocalHistogram histogram;
+  for (uint64_t i = 0; i < count; ++i) {
+    histogram.record(value);
+  }
+  HistogramSnapshot snapshot;
+  snapshot.Add(histogram);
+  return snapshot;
+}
+
+// Sends `request` to 127.0.0.1:`port` and returns the full response.
+std::string Exchange(uint16_t port, const std::string& request) {
+  const int fd = socket(AF_INET, SOCK_STREAM, 0);
+  EXPECT_GE(fd, 0);
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons(port);
+  EXPECT_EQ(connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+  EXPECT_EQ(write(fd, request.data(), request.size()), static_cast<ssize_t>(request.size()));
+
+  std::string received;
+  char buffer[4096];
+  ssize_t n = 0;
+  while ((n = read(fd, buffer, sizeof(buffer))) > 0) {
+    received.append(buffer, static_cast<size_t>(n));
+  }
+  close(fd);
+  return received;
+}
+
+TEST(PrometheusEndpointTest, FormatsCountersAndHistograms) {
+  StageTotals parse;
+  parse.labels = {{"flow", "etl"}, {"stage", "parse"}};
+  parse.processed = 12;
+  parse.errors = 1;
+  parse.latency = Uniform(3, 5);
+
+  QueueTotals queue;
+  queue.labels = {{"flow", "etl"}, {"queue", "q\"1"}};
+  queue.enqueued = 7;
+  queue.dequeued = 6;
+
+  const std::string text = FormatPrometheusMetrics({parse}, {queue}, true);
+  EXPECT_NE(text.find("# TYPE flowpipe_stage_process_count_total counter\n"
+                      "flowpipe_stage_process_count_total{flow=\"etl\",stage=\"parse\"} 12\n"),
+            std::string::npos)
+      << text;
+  EXPECT_NE(text.find("flowpipe_stage_errors_total{flow=\"etl\",stage=\"parse\"} 1\n"),
+            std::string::npos);
+  EXPECT_NE(text.find("# TYPE flowpipe_stage_latency_ns histogram\n"
+                      "flowpipe_stage_latency_ns_bucket{flow=\"etl\",stage=\"parse\",le=\"15\"} 3\n"
+                      "flowpipe_stage_latency_ns_bucket{flow=\"etl\",stage=\"parse\",le=\"31\"} 3\n"),
+            std::string::npos)
+      << text;
+  EXPECT_NE(
+      text.find(
+          "flowpipe_stage_latency_ns_bucket{flow=\"etl\",stage=\"parse\",le=\"68719476735\"} 3\n"
+          "flowpipe_stage_latency_ns_bucket{flow=\"etl\",stage=\"parse\",le=\"+Inf\"} 3\n"
+          "flowpipe_stage_latency_ns_sum{flow=\"etl\",stage=\"parse\"} 15\n"
+          "flowpipe_stage_latency_ns_count{flow=\"etl\",stage=\"parse\"} 3\n"),
+      std::string::npos)
+      << text;
+  EXPECT_NE(text.find("flowpipe_queue_enqueue_count_total{flow=\"etl\",queue=\"q\\\"1\"} 7\n"),
+            std::string::npos)
+      << text;
+
+  // Empty end-to-end and cross-node series are left out, families and all.
+  EXPECT_EQ(text.find("flowpipe_record_end_to_end_ns"), std::string::npos);
+  EXPECT_EQ(text.find("flowpipe_queue_cross_node"), std::string::npos);
+
+  const std::string counters_only = FormatPrometheusMetrics({parse}, {queue}, false);
+  EXPECT_EQ(counters_only.find("histogram"), std::string::npos);
+  EXPECT_NE(counters_only.find("flowpipe_stage_process_count_total"), std::string::npos);
+}
+
+// `sum by (le)` and histogram_quantile need the same buckets on every series.
+TEST(PrometheusEndpointTest, HistogramsShareOneLeLadder) {
+  StageTotals fast;
+  fast.labels = {{"stage", "fast"}};
+  fast.latency = Uniform(2, 20);
+  StageTotals slow;
+  slow.labels = {{"stage", "slow"}};
+  slow.latency = Uniform(2, 5'000'000);
+
+  const std::string text = FormatPrometheusMetrics({fast, slow}, {}, true);
+  auto le_values = [&text](const std::string& stage) {
+    const std::string prefix = "flowpipe_stage_latency_ns_bucket{stage=\"" + stage + "\",le=\"";
+    std::vector<std::string> les;
+    for (size_t pos = text.find(prefix); pos != std::string::npos;
+         pos = text.find(prefix, pos + 1)) {
+      const size_t start = pos + prefix.size();
+      les.push_back(text.substr(start, text.find('"', start) - start));
+    }
+    return les;
+  };
+  const auto fast_les = le_values("fast");
+  EXPECT_EQ(fast_les.size(),
+            HistogramSnapshot::kLastOctave - HistogramSnapshot::kFirstOctave + 2);
+  EXPECT_EQ(fast_les, le_values("slow"));
+
+  // Zero-count buckets are published too.
+  EXPECT_NE(text.find("flowpipe_stage_latency_ns_bucket{stage=\"slow\",le=\"15\"} 0\n"),
+            std::string::npos)
+      << text;
+}
+
+TEST(PrometheusEndpointTest, FormatsScalingAndPlacement) {
+  StageTotals scaled;
+  scaled.labels = {{"flow", "etl"}, {"stage", "sink"}};
+  scaled.workers_started = 5;
+  scaled.workers_stopped = 2;
+  scaled.scale_ups = 4;
+  scaled.cpus = {{.cpu = 6, .l3 = 4, .numa_node = 1}};
+  StageTotals fixed;
+  fixed.labels = {{"flow", "etl"}, {"stage", "parse"}};
+
+  const std::string text = FormatPrometheusMetrics({scaled, fixed}, {}, false);
+  EXPECT_NE(text.find("# TYPE flowpipe_stage_workers gauge\n"
+                      "flowpipe_stage_workers{flow=\"etl\",stage=\"sink\"} 3\n"),
+            std::string::npos)
+      << text;
+  EXPECT_NE(text.find("flowpipe_stage_scaling_decisions_total{flow=\"etl\",stage=\"sink\","
+                      "direction=\"up\"} 4\n"
+                      "flowpipe_stage_scaling_decisions_total{flow=\"etl\",stage=\"sink\","
+                      "direction=\"down\"} 0\n"),
+            std::string::npos)
+      << text;
+  EXPECT_NE(text.find("flowpipe_stage_cpu_assigned{flow=\"etl\",stage=\"sink\",cpu=\"6\","
+                      "l3=\"4\",numa_node=\"1\"} 1\n"),
+            std::string::npos)
+      << text;
+  // Stages the autoscaler never ran publish no worker or decision series.
+  EXPECT_EQ(text.find("stage=\"parse\",direction"), std::string::npos);
+  EXPECT_EQ(text.find("flowpipe_stage_workers{flow=\"etl\",stage=\"parse\"}"),
+            std::string::npos);
+}
+
+TEST(PrometheusEndpointTest, ServesMetricsPath) {
+  auto& metrics = RuntimeMetrics::Get();
+  metrics.Configure(true, true, false);
+  const SeriesId id = metrics.RegisterStage({{"stage", "scraped_stage"}});
+  metrics.stage(id).processed.add(3);
+
+  PrometheusEndpoint endpoint;
+  ASSERT_TRUE(endpoint.Start(0, false));
+  ASSERT_NE(endpoint.port(), 0);
+
+  const std::string ok = Exchange(endpoint.port(), "GET /metrics HTTP/1.1\r\nHost: x\r\n\r\n");
+  EXPECT_EQ(ok.rfind("HTTP/1.1 200 OK\r\n", 0), 0u) << ok;
+  EXPECT_NE(ok.find("Content-Type: text/plain; version=0.0.4"), std::string::npos);
+  EXPECT_NE(ok.find("flowpipe_stage_process_count_total{stage=\"scraped_stage\"} 3\n"),
+            std::string::npos)
+      << ok;
+
+  const std::string head = Exchange(endpoint.port(), "HEAD /metrics HTTP/1.1\r\n\r\n");
+  EXPECT_EQ(head.rfind("HTTP/1.1 200 OK\r\n", 0), 0u);
+  EXPECT_EQ(head.find("flowpipe_"), std::string::npos);
+
+  const std::string missing = Exchange(endpoint.port(), "GET / HTTP/1.1\r\n\r\n");
+  EXPECT_EQ(missing.rfind("HTTP/1.1 404", 0), 0u) << missing;
+
+  const std::string post = Exchange(endpoint.port(), "POST /metrics HTTP/1.1\r\n\r\n");
+  EXPECT_EQ(post.rfind("HTTP/1.1 405", 0), 0u) << post;
+
+  endpoint.Stop();
+  EXPECT_EQ(endpoint.port(), 0);
+  metrics.Configure(false, false, false);
+}
+
+TEST(PrometheusEndpointTest, StartFailsWhenPortIsTaken) {
+  PrometheusEndpoint first;
+  ASSERT_TRUE(first.Start(0, false));
+
+  PrometheusEndpoint second;
+  EXPECT_FALSE(second.Start(first.port(), false));
+  EXPECT_EQ(second.port(), 0);
+}
+
+}  // namespace
+}  // namespace flowpipe::observability
@@ -0,0 +1,95 @@
+#include "flowpipe/protobuf_config.h"
+
+#include <google/protobuf/struct.pb.h>
+#include <google/protobuf/util/json_util.h>
+#include <google/protobuf/util/message_differencer.h>
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "flowpipe/v1/flow.pb.h"
+
+namespace flowpipe {
+namespace {
+
+google::protobuf::Struct StructFromJson(const std::string& json) {
+  google::protobuf::Struct config;
+  EXPECT_TRUE(google::protobuf::util::JsonStringToMessage(json, &config).ok()) << json;
+  return config;
+}
+
+TEST(StructToMessageTest, MatchesJsonRoundTrip) {
+  const std::string json = R"({
+    "name": "flow",
+    "version": 7,
+    "labels": {"team": "ingest"},
+    "queues": [{"name": "q1", "capacity": 128, "type": "QUEUE_TYPE_IN_MEMORY"}],
+    "stages": [{
+      "name": "source",
+      "type": "noop_source",
+      "threads": 4,
+      "outputQueue": "q1",
+      "config": {"delay_ms": 1, "nested": {"list": [1, "two", null]}}
+    }],
+    "kubernetes": {"cpu_pinning": {"source": {"cpu": [0, 2]}}, "restart_policy": 1},
+    "execution": null
+  })";
+
+  const auto config = StructFromJson(json);
+  flowpipe::v1::FlowSpec direct;
+  std::string error;
+  ASSERT_TRUE(StructToMessage(config, &direct, &error)) << error;
+
+  flowpipe::v1::FlowSpec expected;
+  ASSERT_TRUE(google::protobuf::util::JsonStringToMessage(json, &expected).ok());
+  EXPECT_TRUE(google::protobuf::util::MessageDifferencer::Equals(direct, expected))
+      << direct.DebugString() << "\nvs\n"
+      << expected.DebugString();
+  EXPECT_FALSE(direct.has_execution());
+}
+
+TEST(StructToMessageTest, ReportsPathOfBadValues) {
+  flowpipe::v1::FlowSpec spec;
+  std::string error;
+
+  EXPECT_FALSE(StructToMessage(StructFromJson(R"({"stages": [{"threads": 1.5}]})"), &spec,
+                               &error));
+  EXPECT_EQ(error, "field 'stages[0].threads': expected an integer in uint32_t range, got a number");
+
+  spec.Clear();
+  EXPECT_FALSE(StructToMessage(StructFromJson(R"({"queues": [{"capacity": -1}]})"), &spec,
+                               &error));
+  EXPECT_NE(error.find("queues[0].capacity"), std::string::npos) << error;
+
+  spec.Clear();
+  EXPECT_FALSE(StructToMessage(StructFromJson(R"({"nme": "flow"})"), &spec, &error));
+  EXPECT_EQ(error, "field 'nme': no such field in flowpipe.v1.FlowSpec");
+
+  spec.Clear();
+  EXPECT_FALSE(StructToMessage(StructFromJson(R"({"queues": [{"type": "QUEUE_TYPE_NOPE"}]})"),
+                               &spec, &error));
+  EXPECT_EQ(error, "field 'queues[0].type': no such value in flowpipe.v1.QueueType");
+}
+
+TEST(ProtobufConfigParserTest, FallsBackToJsonForSpecialMappings) {
+  // Timestamp strings are left to the JSON parser.
+  const auto config = StructFromJson(R"({"last_updated": "2024-01-02T03:04:05Z"})");
+  flowpipe::v1::FlowStatus status;
+  std::string error;
+  EXPECT_FALSE(StructToMessage(config, &status, &error));
+
+  ASSERT_TRUE(ProtobufConfigParser<flowpipe::v1::FlowStatus>::Parse(config, &status, &error))
+      << error;
+  EXPECT_EQ(status.last_updated().seconds(), 1704164645);
+}
+
+TEST(ProtobufConfigParserTest, KeepsJsonErrorsForInvalidConfig) {
+  flowpipe::v1::FlowSpec spec;
+  std::string error;
+  EXPECT_FALSE(ProtobufConfigParser<flowpipe::v1::FlowSpec>::Parse(
+      StructFromJson(R"({"name": 3})"), &spec, &error));
+  EXPECT_FALSE(error.empty());
+}
+
+}  // namespace
+}  // namespace flowpipe
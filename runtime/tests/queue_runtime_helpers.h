@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "flowpipe/bounded_queue.h"
+#include "flowpipe/payload.h"
+#include "flowpipe/queue_runtime.h"
+
+namespace flowpipe {
+
+// A QueueRuntime over a BoundedQueue, as the runtime wires one from a
+// QueueSpec. Fields are set one by one so new QueueRuntime members keep
+// their defaults here.
+inline QueueRuntime MakeQueueRuntime(const std::string& name, uint32_t capacity,
+                                     std::string schema_id = {}) {
+  QueueRuntime runtime;
+  runtime.name = name;
+  runtime.capacity = capacity;
+  runtime.queue = std::make_shared<BoundedQueue<Payload>>(capacity);
+  runtime.schema_id = std::move(schema_id);
+  return runtime;
+}
+
+}  // namespace flowpipe
@@ -3,9 +3,12 @@
 #include <atomic>
 #include <chrono>
 #include <future>
+#include <memory>
+#include <memory_resource>
 #include <thread>
 
 #include "flowpipe/bounded_queue.h"
+#include "flowpipe/numa.h"
 #include "flowpipe/stop_token.h"
 
 namespace flowpipe {
@@ -96,5 +99,130 @@ TEST(BoundedQueueTest, PushAfterCloseReturnsFalse) {
   EXPECT_FALSE(queue.push(42, stop));
 }
 
+TEST(BoundedQueueTest, TryPopDoesNotBlock) {
+  std::atomic<bool> stop_flag{false};
+  StopToken stop{&stop_flag};
+  BoundedQueue<int> queue(2);
+
+  EXPECT_FALSE(queue.try_pop().has_value());
+  EXPECT_FALSE(queue.drained());
+
+  ASSERT_TRUE(queue.push(7, stop));
+  queue.close();
+  EXPECT_FALSE(queue.drained());
+
+  auto item = queue.try_pop();
+  ASSERT_TRUE(item.has_value());
+  EXPECT_EQ(*item, 7);
+  EXPECT_TRUE(queue.drained());
+}
+
+TEST(BoundedQueueTest, PopForTimesOutOnEmptyQueue) {
+  std::atomic<bool> stop_flag{false};
+  StopToken stop{&stop_flag};
+  BoundedQueue<int> queue(2);
+
+  const auto start = std::chrono::steady_clock::now();
+  EXPECT_FALSE(queue.pop_for(std::chrono::milliseconds(20), stop).has_value());
+  EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(20));
+  EXPECT_FALSE(queue.drained());
+}
+
+TEST(BoundedQueueTest, PopForReturnsItemPushedWhileWaiting) {
+  std::atomic<bool> stop_flag{false};
+  StopToken stop{&stop_flag};
+  BoundedQueue<int> queue(2);
+
+  auto waiting = std::async(std::launch::async,
+                            [&]() { return queue.pop_for(std::chrono::seconds(5), stop); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  ASSERT_TRUE(queue.push(9, stop));
+
+  ASSERT_EQ(waiting.wait_for(std::chrono::seconds(1)), std::future_status::ready);
+  auto item = waiting.get();
+  ASSERT_TRUE(item.has_value());
+  EXPECT_EQ(*item, 9);
+}
+
+class CountingObserver : public QueueObserver {
+ public:
+  void notify() noexcept override {
+    ++notifications;
+  }
+
+  std::atomic<int> notifications{0};
+};
+
+TEST(BoundedQueueTest, ObserversAreNotifiedOnPushPopAndClose) {
+  std::atomic<bool> stop_flag{false};
+  StopToken stop{&stop_flag};
+  BoundedQueue<int> queue(2);
+  CountingObserver observer;
+
+  queue.add_observer(&observer);
+  ASSERT_TRUE(queue.push(1, stop));
+  EXPECT_EQ(observer.notifications.load(), 1);
+  ASSERT_TRUE(queue.pop(stop).has_value());
+  EXPECT_EQ(observer.notifications.load(), 2);
+  queue.close();
+  EXPECT_EQ(observer.notifications.load(), 3);
+
+  queue.remove_observer(&observer);
+  EXPECT_FALSE(queue.push(2, stop));
+  EXPECT_EQ(observer.notifications.load(), 3);
+}
+
+// Counts upstream allocations so the test can tell the queue used it.
+class CountingResource : public std::pmr::memory_resource {
+ public:
+  int allocations = 0;
+
+ private:
+  void* do_allocate(size_t bytes, size_t alignment) override {
+    ++allocations;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+  void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+  }
+  bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+    return this == &other;
+  }
+};
+
+TEST(BoundedQueueTest, StorageComesFromUpstreamResource) {
+  std::atomic<bool> stop_flag{false};
+  StopToken stop{&stop_flag};
+  auto upstream = std::make_shared<CountingResource>();
+
+  BoundedQueue<int> queue(1024, upstream);
+  for (int round = 0; round < 3; ++round) {
+    for (int i = 0; i < 1000; ++i) {
+      ASSERT_TRUE(queue.push(i, stop));
+    }
+    for (int i = 0; i < 1000; ++i) {
+      auto item = queue.pop(stop);
+      ASSERT_TRUE(item.has_value());
+      EXPECT_EQ(*item, i);
+    }
+  }
+  EXPECT_GT(upstream->allocations, 0);
+}
+
+TEST(BoundedQueueTest, WorksOnNumaMemoryResource) {
+  std::atomic<bool> stop_flag{false};
+  StopToken stop{&stop_flag};
+
+  BoundedQueue<int> queue(4096, std::make_shared<NumaMemoryResource>(0));
+  for (int i = 0; i < 4096; ++i) {
+    ASSERT_TRUE(queue.push(i, stop));
+  }
+  for (int i = 0; i < 4096; ++i) {
+    auto item = queue.pop(stop);
+    ASSERT_TRUE(item.has_value());
+    EXPECT_EQ(*item, i);
+  }
+}
+
 }  // namespace
 }  // namespace flowpipe
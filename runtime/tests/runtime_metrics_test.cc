@@ -0,0 +1,327 @@
+#include "flowpipe/observability/runtime_metrics.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <latch>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "flowpipe/payload.h"
+#include "flowpipe/queue_runtime.h"
+#include "flowpipe/stage_metrics.h"
+#include "queue_runtime_helpers.h"
+
+namespace flowpipe::observability {
+namespace {
+
+template <typename Totals>
+const Totals* FindSeries(const std::vector<Totals>& all, const MetricLabels& labels) {
+  for (const auto& totals : all) {
+    if (totals.labels == labels) {
+      return &totals;
+    }
+  }
+  return nullptr;
+}
+
+const StageTotals* FindStage(const std::vector<StageTotals>& all, const std::string& name) {
+  return FindSeries(all, {{"stage", name}});
+}
+
+const QueueTotals* FindQueue(const std::vector<QueueTotals>& all, const std::string& name) {
+  return FindSeries(all, {{"queue", name}});
+}
+
+TEST(RuntimeMetricsTest, BucketsAreLogLinear) {
+  // Exact below 32, then 16 sub-buckets per power of two.
+  EXPECT_EQ(LocalHistogram::BucketOf(0), 0u);
+  EXPECT_EQ(LocalHistogram::BucketOf(31), 31u);
+  EXPECT_EQ(LocalHistogram::BucketOf(32), 32u);
+  EXPECT_EQ(LocalHistogram::BucketOf(33), 32u);
+  EXPECT_EQ(LocalHistogram::BucketOf(34), 33u);
+  EXPECT_EQ(LocalHistogram::BucketOf(64), 48u);
+  EXPECT_EQ(LocalHistogram::BucketOf(UINT64_MAX), LocalHistogram::kBuckets - 1);
+
+  for (size_t i = 0; i < LocalHistogram::kBuckets; ++i) {
+    const uint64_t lower = LocalHistogram::LowerBound(i);
+    const uint64_t upper = LocalHistogram::UpperBound(i);
+    EXPECT_EQ(LocalHistogram::BucketOf(lower), i);
+    EXPECT_EQ(LocalHistogram::BucketOf(upper), i);
+    if (i + 1 < LocalHistogram::kBuckets) {
+      EXPECT_EQ(LocalHistogram::LowerBound(i + 1), upper + 1);
+    }
+    // Relative bucket width stays within 1/16.
+    EXPECT_LE(upper - lower, lower / LocalHistogram::kSubBuckets);
+  }
+}
+
+TEST(RuntimeMetricsTest, QuantilesComeFromBucketUpperBounds) {
+  LocalHistogram histogram;
+  HistogramSnapshot empty;
+  EXPECT_EQ(empty.ValueAtQuantile(0.5), 0u);
+  EXPECT_EQ(empty.Max(), 0u);
+
+  for (uint64_t v = 1; v <= 1000; ++v) {
+    histogram.record(v * 1000);
+  }
+  HistogramSnapshot snapshot;
+  snapshot.Add(histogram);
+
+  EXPECT_EQ(snapshot.count, 1000u);
+  for (const double q : {0.5, 0.9, 0.99, 0.999}) {
+    const auto exact = static_cast<uint64_t>(q * 1000) * 1000;
+    const uint64_t value = snapshot.ValueAtQuantile(q);
+    EXPECT_GE(value, exact);
+    EXPECT_LE(value, exact + exact / LocalHistogram::kSubBuckets);
+  }
+  EXPECT_GE(snapshot.Max(), 1'000'000u);
+  EXPECT_EQ(snapshot.ValueAtQuantile(1.0), snapshot.Max());
+}
+
+TEST(RuntimeMetricsTest, CumulativeOctavesUseOneFixedLadder) {
+  constexpr size_t kRungs = HistogramSnapshot::kLastOctave - HistogramSnapshot::kFirstOctave + 1;
+  const auto empty = HistogramSnapshot{}.CumulativeOctaves();
+  ASSERT_EQ(empty.size(), kRungs);
+  EXPECT_EQ(empty.front(), (std::pair<uint64_t, uint64_t>{15, 0}));
+  EXPECT_EQ(empty.back(), (std::pair<uint64_t, uint64_t>{(uint64_t{1} << 36) - 1, 0}));
+
+  LocalHistogram histogram;
+  histogram.record(5);     // le=15
+  histogram.record(6);     // le=15
+  histogram.record(40);    // le=63
+  histogram.record(1000);  // le=1023
+  histogram.record(uint64_t{1} << 40);  // +Inf only
+  HistogramSnapshot snapshot;
+  snapshot.Add(histogram);
+
+  const auto octaves = snapshot.CumulativeOctaves();
+  ASSERT_EQ(octaves.size(), kRungs);
+  for (size_t i = 0; i < kRungs; ++i) {
+    // Same le ladder as the empty snapshot.
+    EXPECT_EQ(octaves[i].first, empty[i].first);
+  }
+  const std::vector<std::pair<uint64_t, uint64_t>> head = {
+      {15, 2}, {31, 2}, {63, 3}, {127, 3}, {255, 3}, {511, 3}, {1023, 4}, {2047, 4}};
+  EXPECT_EQ(std::vector(octaves.begin(), octaves.begin() + head.size()), head);
+  EXPECT_EQ(octaves.back().second, 4u);
+}
+
+TEST(RuntimeMetricsTest, ShardsArePaddedToCacheLines) {
+  EXPECT_EQ(alignof(StageShard), kCacheLineSize);
+  EXPECT_EQ(alignof(QueueShard), kCacheLineSize);
+  EXPECT_EQ(sizeof(StageShard) % kCacheLineSize, 0u);
+}
+
+TEST(RuntimeMetricsTest, CollectFoldsEveryThreadsShard) {
+  auto& metrics = RuntimeMetrics::Get();
+  const std::string stage = "fold_stage";
+  constexpr int kThreads = 4;
+  constexpr int kRecords = 1000;
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&] {
+      auto& shard = metrics.stage(stage.c_str());
+      for (int i = 0; i < kRecords; ++i) {
+        shard.processed.add();
+        shard.latency.record(100);
+      }
+      metrics.stage(stage.c_str()).errors.add();
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  const auto stages = metrics.CollectStages();
+  const auto* totals = FindStage(stages, stage);
+  ASSERT_NE(totals, nullptr);
+  EXPECT_EQ(totals->processed, uint64_t{kThreads * kRecords});
+  EXPECT_EQ(totals->errors, uint64_t{kThreads});
+  EXPECT_EQ(totals->latency.count, uint64_t{kThreads * kRecords});
+  EXPECT_EQ(totals->latency.sum, uint64_t{kThreads * kRecords * 100});
+  EXPECT_EQ(totals->latency.buckets[LocalHistogram::BucketOf(100)],
+            uint64_t{kThreads * kRecords});
+}
+
+// Workers that come and go (autoscaling) reuse the shards of exited threads
+// instead of adding new ones, and keep what those threads recorded.
+TEST(RuntimeMetricsTest, ExitedThreadsHandTheirShardsOn) {
+  auto& metrics = RuntimeMetrics::Get();
+  const SeriesId stage = metrics.RegisterStage({{"stage", "churn_stage"}});
+  const SeriesId queue = metrics.RegisterQueue({{"queue", "churn_queue"}});
+  constexpr int kRounds = 50;
+  constexpr int kThreads = 3;
+
+  // Every round has kThreads threads recording at once.
+  auto run_round = [&] {
+    std::latch recorded(kThreads);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+      threads.emplace_back([&] {
+        metrics.stage(stage).processed.add();
+        metrics.queue(queue).enqueued.add();
+        recorded.arrive_and_wait();
+      });
+    }
+    for (auto& t : threads) {
+      t.join();
+    }
+  };
+
+  run_round();
+  const size_t shards = metrics.shard_count();
+  for (int round = 1; round < kRounds; ++round) {
+    run_round();
+  }
+  EXPECT_EQ(metrics.shard_count(), shards);
+
+  const auto stages = metrics.CollectStages();
+  const auto* stage_totals = FindStage(stages, "churn_stage");
+  ASSERT_NE(stage_totals, nullptr);
+  EXPECT_EQ(stage_totals->processed, uint64_t{kRounds * kThreads});
+
+  const auto queues = metrics.CollectQueues();
+  const auto* queue_totals = FindQueue(queues, "churn_queue");
+  ASSERT_NE(queue_totals, nullptr);
+  EXPECT_EQ(queue_totals->enqueued, uint64_t{kRounds * kThreads});
+}
+
+TEST(RuntimeMetricsTest, CacheMatchesByNameNotJustPointer) {
+  auto& metrics = RuntimeMetrics::Get();
+
+  // Same buffer, different contents: must resolve to two series.
+  char name[] = "reuse_a";
+  StageShard& a = metrics.stage(name);
+  name[6] = 'b';
+  StageShard& b = metrics.stage(name);
+  EXPECT_NE(&a, &b);
+
+  // Different buffers, same contents: one series, one shard per thread.
+  const std::string copy = "reuse_a";
+  EXPECT_EQ(&metrics.stage(copy.c_str()), &a);
+}
+
+TEST(RuntimeMetricsTest, StageMetricsRecordsIntoShardsWhenConfigured) {
+  auto& metrics = RuntimeMetrics::Get();
+  StageMetrics recorder;
+
+  const std::string stage = "recorded_stage";
+  metrics.Configure(false, false, false);
+  recorder.RecordStageLatency(stage.c_str(), 10);
+  EXPECT_EQ(FindStage(metrics.CollectStages(), stage), nullptr);
+
+  metrics.Configure(true, true, true);
+  recorder.RecordStageLatency(stage.c_str(), 10);
+  recorder.RecordStageLatency(stage.c_str(), 30);
+  recorder.RecordStageError(stage.c_str());
+  recorder.RecordEndToEndLatency(stage.c_str(), 500);
+
+  auto queue = MakeQueueRuntime("recorded_queue", 4);
+  queue.cross_node = true;
+  Payload payload(AllocatePayloadBuffer(8), 8);
+  payload.meta.enqueue_ts_ns = 1;
+  recorder.RecordQueueEnqueue(queue);
+  recorder.RecordQueueDequeue(queue, payload);
+  metrics.Configure(false, false, false);
+
+  const auto stages = metrics.CollectStages();
+  const auto* s = FindStage(stages, stage);
+  ASSERT_NE(s, nullptr);
+  EXPECT_EQ(s->processed, 2u);
+  EXPECT_EQ(s->errors, 1u);
+  EXPECT_EQ(s->latency.count, 2u);
+  EXPECT_EQ(s->latency.sum, 40u);
+  EXPECT_EQ(s->end_to_end.count, 1u);
+  EXPECT_EQ(s->end_to_end.sum, 500u);
+
+  const auto queues = metrics.CollectQueues();
+  const auto* q = FindQueue(queues, "recorded_queue");
+  ASSERT_NE(q, nullptr);
+  EXPECT_EQ(q->enqueued, 1u);
+  EXPECT_EQ(q->dequeued, 1u);
+  EXPECT_EQ(q->cross_node, 1u);
+  EXPECT_EQ(q->cross_node_bytes, 8u);
+  EXPECT_EQ(q->dwell.count, 1u);
+}
+
+TEST(RuntimeMetricsTest, RegisteredSeriesAreDedupedByLabels) {
+  auto& metrics = RuntimeMetrics::Get();
+  const SeriesId a = metrics.RegisterStage({{"flow", "f"}, {"stage", "dedup"}});
+  EXPECT_EQ(metrics.RegisterStage({{"flow", "f"}, {"stage", "dedup"}}), a);
+  EXPECT_NE(metrics.RegisterStage({{"flow", "g"}, {"stage", "dedup"}}), a);
+
+  // The name-based lookup is the series labelled only with the name.
+  const SeriesId by_name = metrics.RegisterStage({{"stage", "dedup"}});
+  EXPECT_EQ(&metrics.stage("dedup"), &metrics.stage(by_name));
+  EXPECT_NE(&metrics.stage(a), &metrics.stage(by_name));
+}
+
+TEST(RuntimeMetricsTest, BoundStageMetricsRecordUnderPrecomputedLabels) {
+  auto& metrics = RuntimeMetrics::Get();
+  StageMetrics bound("etl", "bound_stage");
+
+  auto queue = MakeQueueRuntime("bound_queue", 4);
+  queue.metrics_id = StageMetrics::BindQueue("etl", queue.name);
+
+  metrics.Configure(true, true, false);
+  // The stage name argument is not consulted by a bound instance.
+  bound.RecordStageLatency("ignored", 5);
+  bound.RecordStageError("ignored");
+  bound.RecordQueueEnqueue(queue);
+  metrics.Configure(false, false, false);
+
+  const auto stages = metrics.CollectStages();
+  EXPECT_EQ(FindStage(stages, "ignored"), nullptr);
+  const auto* s = FindSeries(stages, {{"flow", "etl"}, {"stage", "bound_stage"}});
+  ASSERT_NE(s, nullptr);
+  EXPECT_EQ(s->processed, 1u);
+  EXPECT_EQ(s->errors, 1u);
+  EXPECT_EQ(s->latency.count, 0u);
+
+  const auto queues = metrics.CollectQueues();
+  EXPECT_EQ(FindQueue(queues, "bound_queue"), nullptr);
+  const auto* q = FindSeries(queues, {{"flow", "etl"}, {"queue", "bound_queue"}});
+  ASSERT_NE(q, nullptr);
+  EXPECT_EQ(q->enqueued, 1u);
+
+  // Without a flow name the flow label is left out.
+  StageMetrics unnamed_flow("", "bound_stage");
+  metrics.Configure(true, false, false);
+  unnamed_flow.RecordStageLatency("bound_stage", 1);
+  metrics.Configure(false, false, false);
+  EXPECT_NE(FindStage(metrics.CollectStages(), "bound_stage"), nullptr);
+}
+
+TEST(RuntimeMetricsTest, ScalingAndPlacementRecordUnderTheStageSeries) {
+  auto& metrics = RuntimeMetrics::Get();
+  StageMetrics bound("etl", "scaled_stage");
+
+  metrics.Configure(true, false, false);
+  bound.RecordStageWorkers("ignored", 1);
+  bound.RecordStageScaling("ignored", true);
+  bound.RecordStageWorkers("ignored", 1);
+  bound.RecordStageScaling("ignored", false);
+  bound.RecordStageWorkers("ignored", -1);
+  bound.RecordStageCpu("ignored", 3, 0, 0);
+  bound.RecordStageCpu("ignored", 5, 4, 1);
+  bound.RecordStageCpu("ignored", 3, 0, 0);
+  metrics.Configure(false, false, false);
+
+  const auto stages = metrics.CollectStages();
+  const auto* s = FindSeries(stages, {{"flow", "etl"}, {"stage", "scaled_stage"}});
+  ASSERT_NE(s, nullptr);
+  EXPECT_TRUE(s->autoscaled());
+  EXPECT_EQ(s->workers(), 1u);
+  EXPECT_EQ(s->scale_ups, 1u);
+  EXPECT_EQ(s->scale_downs, 1u);
+  const std::vector<CpuAssignment> cpus = {{.cpu = 3, .l3 = 0, .numa_node = 0},
+                                           {.cpu = 5, .l3 = 4, .numa_node = 1}};
+  EXPECT_EQ(s->cpus, cpus);
+}
+
+}  // namespace
+}  // namespace flowpipe::observability
@@ -3,8 +3,12 @@
 #include <google/protobuf/struct.pb.h>
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <string>
 #include <thread>
@@ -258,5 +262,145 @@ TEST(StageRegistryTest, ConcurrentCreateDestroyAndShutdownAreSynchronized) {
   g_atomic_destroy_counter = nullptr;
 }
 
+class CloningStage : public ConfigurableStage, public IStage {
+ public:
+  bool configure(const google::protobuf::Struct&) override {
+    table_ = std::make_shared<const std::vector<int>>(std::vector<int>{1, 2, 3});
+    return true;
+  }
+
+  IStage* clone() const override {
+    return new CloningStage(*this);
+  }
+
+  std::string name() const override {
+    return "cloning";
+  }
+
+  const std::vector<int>* table() const {
+    return table_.get();
+  }
+
+ private:
+  std::shared_ptr<const std::vector<int>> table_;
+};
+
+IStage* CreateCloningStage() {
+  return new CloningStage();
+}
+
+TEST(StageRegistryTest, ClonesShareStateAndAreDestroyedOnShutdown) {
+  std::atomic<int> destroy_count{0};
+  g_atomic_destroy_counter = &destroy_count;
+
+  auto loader = std::make_unique<ThreadSafeRecordingLoader>();
+  loader->loaded_plugin.create = &CreateCloningStage;
+  loader->loaded_plugin.destroy = &AtomicDestroyStageThunk;
+  auto* loader_ptr = loader.get();
+
+  {
+    StageRegistry registry(std::move(loader));
+    auto* prototype = static_cast<CloningStage*>(registry.create_stage("cloning", nullptr));
+    auto* clone = static_cast<CloningStage*>(registry.clone_stage(prototype));
+
+    ASSERT_NE(clone, nullptr);
+    EXPECT_NE(clone, prototype);
+    EXPECT_EQ(clone->table(), prototype->table());
+
+    // The prototype can go first; the clone keeps the shared state.
+    registry.destroy_stage(prototype);
+    EXPECT_EQ(destroy_count.load(), 1);
+    ASSERT_NE(clone->table(), nullptr);
+    EXPECT_EQ(clone->table()->size(), 3u);
+  }
+
+  EXPECT_EQ(destroy_count.load(), 2);
+  EXPECT_EQ(loader_ptr->load_calls.load(), 1);
+  g_atomic_destroy_counter = nullptr;
+}
+
+TEST(StageRegistryTest, CloneReturnsNullWithoutSupport) {
+  std::atomic<int> destroy_count{0};
+  g_atomic_destroy_counter = &destroy_count;
+
+  auto loader = std::make_unique<ThreadSafeRecordingLoader>();
+  loader->loaded_plugin.create = &CreateDummyStage;
+  loader->loaded_plugin.destroy = &AtomicDestroyStageThunk;
+
+  {
+    StageRegistry registry(std::move(loader));
+    IStage* stage = registry.create_stage("dummy", nullptr);
+    EXPECT_EQ(registry.clone_stage(stage), nullptr);
+
+    DummyStage untracked;
+    EXPECT_EQ(registry.clone_stage(&untracked), nullptr);
+  }
+
+  EXPECT_EQ(destroy_count.load(), 1);
+  g_atomic_destroy_counter = nullptr;
+}
+
+// configure() blocks until `kExpected` stages are configuring at once.
+struct ConfigureRendezvous {
+  static constexpr int kExpected = 2;
+  std::mutex mutex;
+  std::condition_variable cv;
+  int arrived = 0;
+  int peak = 0;
+};
+
+static ConfigureRendezvous* g_rendezvous = nullptr;
+
+class RendezvousStage : public ConfigurableStage, public IStage {
+ public:
+  bool configure(const google::protobuf::Struct&) override {
+    std::unique_lock<std::mutex> lock(g_rendezvous->mutex);
+    g_rendezvous->peak = std::max(g_rendezvous->peak, ++g_rendezvous->arrived);
+    g_rendezvous->cv.notify_all();
+    g_rendezvous->cv.wait_for(lock, std::chrono::seconds(2), []() {
+      return g_rendezvous->arrived >= ConfigureRendezvous::kExpected;
+    });
+    return true;
+  }
+
+  std::string name() const override {
+    return "rendezvous";
+  }
+};
+
+IStage* CreateRendezvousStage() {
+  return new RendezvousStage();
+}
+
+void DestroyRendezvousStage(IStage* stage) {
+  delete stage;
+}
+
+TEST(StageRegistryTest, ConfiguresStagesConcurrently) {
+  ConfigureRendezvous rendezvous;
+  g_rendezvous = &rendezvous;
+
+  auto loader = std::make_unique<ThreadSafeRecordingLoader>();
+  loader->loaded_plugin.create = &CreateRendezvousStage;
+  loader->loaded_plugin.destroy = &DestroyRendezvousStage;
+  auto* loader_ptr = loader.get();
+
+  {
+    StageRegistry registry(std::move(loader));
+    std::vector<std::thread> workers;
+    for (int i = 0; i < ConfigureRendezvous::kExpected; ++i) {
+      workers.emplace_back([&registry]() { registry.create_stage("rendezvous", nullptr); });
+    }
+    for (auto& worker : workers) {
+      worker.join();
+    }
+  }
+
+  EXPECT_EQ(rendezvous.peak, ConfigureRendezvous::kExpected);
+  EXPECT_EQ(loader_ptr->load_calls.load(), 1);
+  EXPECT_EQ(loader_ptr->unload_calls.load(), 1);
+  g_rendezvous = nullptr;
+}
+
 }  // namespace
 }  // namespace flowpipe
@@ -9,6 +9,7 @@
 #include <future>
 #include <memory>
 #include <mutex>
+#include <span>
 #include <stdexcept>
 #include <string>
 #include <thread>
@@ -16,16 +17,21 @@
 #include <vector>
 
 #include "flowpipe/bounded_queue.h"
+#include "flowpipe/clock.h"
 #include "flowpipe/payload.h"
 #include "flowpipe/queue_runtime.h"
 #include "flowpipe/stage.h"
 #include "flowpipe/stage_metrics.h"
+#include "queue_runtime_helpers.h"
 
 namespace flowpipe {
 namespace {
 
 class RecordingStageMetrics : public StageMetrics {
  public:
+  RecordingStageMetrics() = default;
+  explicit RecordingStageMetrics(const SamplingOptions& sampling) : StageMetrics(sampling) {}
+
   void RecordQueueDequeue(const QueueRuntime& queue, const Payload& payload) noexcept override {
     ++queue_dequeues;
     last_queue_name = queue.name;
@@ -46,11 +52,28 @@ class RecordingStageMetrics : public StageMetrics {
     ++error_calls;
   }
 
+  void CountQueueDequeue(const QueueRuntime&, const Payload&) noexcept override {
+    ++unsampled_dequeues;
+  }
+
+  void CountStageRecord(const char*) noexcept override {
+    ++unsampled_records;
+  }
+
+  void RecordEndToEndLatency(const char*, uint64_t latency_ns) noexcept override {
+    ++end_to_end_calls;
+    last_end_to_end = latency_ns;
+  }
+
   int queue_dequeues = 0;
+  int unsampled_dequeues = 0;
+  int unsampled_records = 0;
   int queue_enqueues = 0;
   int latency_calls = 0;
   int error_calls = 0;
+  int end_to_end_calls = 0;
   uint64_t last_latency = 0;
+  uint64_t last_end_to_end = 0;
   std::string last_queue_name;
   PayloadMeta last_dequeue_meta{};
 };
@@ -136,22 +159,14 @@ class ThrowingSinkStage : public ISinkStage {
   }
 };
 
-QueueRuntime MakeQueueRuntime(const std::string& name, uint32_t capacity,
-                              std::string schema_id = {}) {
-  return QueueRuntime{
-      .name = name,
-      .capacity = capacity,
-      .queue = std::make_shared<BoundedQueue<Payload>>(capacity),
-      .schema_id = std::move(schema_id),
-  };
-}
-
 TEST(RunSourceStageTest, EnqueuesPayloadsAndRecordsMetrics) {
   auto output = MakeQueueRuntime("out", 4);
   std::atomic<bool> stop_flag{false};
   StageContext ctx{StopToken(&stop_flag)};
 
   std::vector<Payload> payloads(2);
+  payloads[0].meta.trace_id[0] = 0xAA;
+  payloads[0].meta.span_id[0] = 0x11;
   FakeSourceStage stage(std::move(payloads));
   RecordingStageMetrics metrics;
 
@@ -170,6 +185,12 @@ TEST(RunSourceStageTest, EnqueuesPayloadsAndRecordsMetrics) {
   EXPECT_EQ(metrics.latency_calls, 2);
   EXPECT_GT(first->meta.enqueue_ts_ns, 0u);
   EXPECT_GT(second->meta.enqueue_ts_ns, 0u);
+  // The first enqueue is where records enter the flow.
+  EXPECT_EQ(first->meta.origin_ts_ns, first->meta.enqueue_ts_ns);
+  EXPECT_EQ(second->meta.origin_ts_ns, second->meta.enqueue_ts_ns);
+  // So is the span the record's whole-trip span hangs off.
+  EXPECT_EQ(first->meta.origin_span_id[0], 0x11);
+  EXPECT_EQ(second->meta.origin_span_id[0], 0);
 }
 
 TEST(RunSourceStageTest, AppliesQueueSchemaIdToPayloads) {
@@ -247,6 +268,8 @@ TEST(RunTransformStageTest, DequeuesTransformsAndRecordsMetrics) {
   input_payload.meta.trace_id[0] = 0xAA;
   input_payload.meta.flags = 3;
   input_payload.meta.enqueue_ts_ns = 123;
+  input_payload.meta.origin_ts_ns = 100;
+  input_payload.meta.origin_span_id[0] = 0x22;
 
   std::atomic<bool> stop_flag{false};
   StageContext ctx{StopToken(&stop_flag)};
@@ -272,10 +295,113 @@ TEST(RunTransformStageTest, DequeuesTransformsAndRecordsMetrics) {
   EXPECT_EQ(out_payload->meta.flags, 3u);
   EXPECT_EQ(out_payload->meta.trace_id[0], 0xAA);
   EXPECT_GT(out_payload->meta.enqueue_ts_ns, 0u);
+  EXPECT_EQ(out_payload->meta.origin_ts_ns, 100u);
+  EXPECT_EQ(out_payload->meta.origin_span_id[0], 0x22);
   ASSERT_EQ(stage.seen_inputs.size(), 1u);
   EXPECT_EQ(stage.seen_inputs.back().trace_id[0], 0xAA);
 }
 
+TEST(RunTransformStageTest, SamplesLatencyButCountsEveryRecord) {
+  auto input = MakeQueueRuntime("in", 8);
+  auto output = MakeQueueRuntime("out", 8);
+  std::atomic<bool> stop_flag{false};
+  StageContext ctx{StopToken(&stop_flag)};
+
+  for (int i = 0; i < 8; ++i) {
+    ASSERT_TRUE(input.queue->push(Payload{}, ctx.stop));
+  }
+  input.queue->close();
+
+  FakeTransformStage stage;
+  RecordingStageMetrics metrics(SamplingOptions{.one_in = 4});
+
+  RunTransformStage(&stage, ctx, input, output, &metrics);
+
+  EXPECT_EQ(stage.seen_inputs.size(), 8u);
+  EXPECT_EQ(metrics.queue_enqueues, 8);
+  EXPECT_EQ(metrics.queue_dequeues, 2);
+  EXPECT_EQ(metrics.unsampled_dequeues, 6);
+  EXPECT_EQ(metrics.latency_calls, 2);
+  EXPECT_EQ(metrics.unsampled_records, 6);
+}
+
+TEST(RunTransformStageTest, StampsEnqueueTimeOfSampledRecordsOnly) {
+  auto input = MakeQueueRuntime("in", 8);
+  auto output = MakeQueueRuntime("out", 8);
+  std::atomic<bool> stop_flag{false};
+  StageContext ctx{StopToken(&stop_flag)};
+
+  for (int i = 0; i < 8; ++i) {
+    Payload payload;
+    payload.meta.origin_ts_ns = 7;
+    payload.meta.enqueue_ts_ns = 123;
+    ASSERT_TRUE(input.queue->push(std::move(payload), ctx.stop));
+  }
+  input.queue->close();
+
+  FakeTransformStage stage;
+  RecordingStageMetrics metrics(SamplingOptions{.one_in = 4});
+
+  RunTransformStage(&stage, ctx, input, output, &metrics);
+
+  int stamped = 0;
+  for (int i = 0; i < 8; ++i) {
+    auto out = output.queue->try_pop();
+    ASSERT_TRUE(out.has_value());
+    EXPECT_EQ(out->meta.origin_ts_ns, 7u);
+    // Unsampled records drop the input queue's stamp rather than re-reading the clock.
+    EXPECT_NE(out->meta.enqueue_ts_ns, 123u);
+    stamped += out->meta.enqueue_ts_ns > 0 ? 1 : 0;
+  }
+  EXPECT_EQ(stamped, 2);
+}
+
+TEST(RunSinkStageTest, SamplingBudgetCapsSampledRecordsPerSecond) {
+  auto input = MakeQueueRuntime("in", 16);
+  std::atomic<bool> stop_flag{false};
+  StageContext ctx{StopToken(&stop_flag)};
+
+  for (int i = 0; i < 16; ++i) {
+    ASSERT_TRUE(input.queue->push(Payload{}, ctx.stop));
+  }
+  input.queue->close();
+
+  FakeSinkStage stage;
+  RecordingStageMetrics metrics(SamplingOptions{.one_in = 1, .max_per_second = 3});
+
+  RunSinkStage(&stage, ctx, input, &metrics);
+
+  // All 16 records fit in one budget window.
+  EXPECT_EQ(stage.seen_inputs.size(), 16u);
+  EXPECT_EQ(metrics.latency_calls, 3);
+  EXPECT_EQ(metrics.unsampled_records, 13);
+  EXPECT_EQ(metrics.queue_dequeues + metrics.unsampled_dequeues, 16);
+}
+
+TEST(RunSinkStageTest, RecordsEndToEndLatencyOfSampledRecords) {
+  auto input = MakeQueueRuntime("in", 9);
+  std::atomic<bool> stop_flag{false};
+  StageContext ctx{StopToken(&stop_flag)};
+
+  constexpr uint64_t kAgeNs = 5'000'000;
+  for (int i = 0; i < 8; ++i) {
+    Payload payload;
+    payload.meta.origin_ts_ns = FastNowNs() - kAgeNs;
+    ASSERT_TRUE(input.queue->push(std::move(payload), ctx.stop));
+  }
+  ASSERT_TRUE(input.queue->push(Payload{}, ctx.stop));  // no origin: not reported
+  input.queue->close();
+
+  FakeSinkStage stage;
+  RecordingStageMetrics metrics(SamplingOptions{.one_in = 2});
+
+  RunSinkStage(&stage, ctx, input, &metrics);
+
+  EXPECT_EQ(stage.seen_inputs.size(), 9u);
+  EXPECT_EQ(metrics.end_to_end_calls, 4);
+  EXPECT_GE(metrics.last_end_to_end, kAgeNs);
+}
+
 class RebuildTransformStage : public ITransformStage {
  public:
   std::string name() const override {
@@ -415,6 +541,360 @@ TEST(RunTransformStageTest, StopsWhenCancelledBeforeWork) {
   EXPECT_FALSE(output.queue->pop(ctx.stop).has_value());
 }
 
+// Emits input.meta.flags copies of each input; zero drops it.
+class RepeatingFlatMapStage : public IFlatMapStage {
+ public:
+  std::string name() const override {
+    return "repeating_flat_map";
+  }
+
+  void process(StageContext&, const Payload& input, Emitter& out) override {
+    for (uint32_t i = 0; i < input.meta.flags; ++i) {
+      Payload payload;
+      payload.meta.flags = i;
+      if (!out.emit(std::move(payload))) {
+        return;
+      }
+    }
+  }
+};
+
+class ThrowingFlatMapStage : public IFlatMapStage {
+ public:
+  std::string name() const override {
+    return "throwing_flat_map";
+  }
+
+  void process(StageContext&, const Payload&, Emitter&) override {
+    throw std::runtime_error("flat-map boom");
+  }
+};
+
+TEST(RunFlatMapStageTest, EmitsZeroOrManyPayloadsPerInput) {
+  auto input = MakeQueueRuntime("in", 4);
+  auto output = MakeQueueRuntime("out", 8);
+
+  std::atomic<bool> stop_flag{false};
+  StageContext ctx{StopToken(&stop_flag)};
+
+  Payload filtered;
+  filtered.meta.flags = 0;
+  Payload split;
+  split.meta.flags = 3;
+  ASSERT_TRUE(input.queue->push(filtered, ctx.stop));
+  ASSERT_TRUE(input.queue->push(split, ctx.stop));
+  input.queue->close();
+
+  RepeatingFlatMapStage stage;
+  RecordingStageMetrics metrics;
+
+  RunFlatMapStage(&stage, ctx, input, output, &metrics);
+  output.queue->close();
+
+  std::vector<Payload> emitted;
+  while (auto item = output.queue->pop(ctx.stop)) {
+    emitted.push_back(std::move(*item));
+  }
+
+  ASSERT_EQ(emitted.size(), 3u);
+  for (uint32_t i = 0; i < emitted.size(); ++i) {
+    EXPECT_EQ(emitted[i].meta.flags, i);
+    EXPECT_GT(emitted[i].meta.enqueue_ts_ns, 0u);
+  }
+  EXPECT_EQ(metrics.queue_dequeues, 2);
+  EXPECT_EQ(metrics.queue_enqueues, 3);
+  EXPECT_EQ(metrics.latency_calls, 2);
+  EXPECT_EQ(metrics.error_calls, 0);
+}
+
+TEST(RunFlatMapStageTest, EmittedPayloadsInheritInputMetadataAndOutputSchema) {
+  auto input = MakeQueueRuntime("in", 1);
+  auto output = MakeQueueRuntime("out", 4, "schema-out");
+
+  Payload input_payload;
+  input_payload.meta.flags = 2;
+  input_payload.meta.trace_id[0] = 0xAB;
+  input_payload.meta.set_attr("pipeline.partition", int64_t{9});
+
+  std::atomic<bool> stop_flag{false};
+  StageContext ctx{StopToken(&stop_flag)};
+
+  ASSERT_TRUE(input.queue->push(input_payload, ctx.stop));
+  input.queue->close();
+
+  RepeatingFlatMapStage stage;
+  RunFlatMapStage(&stage, ctx, input, output, nullptr);
+  output.queue->close();
+
+  int count = 0;
+  while (auto item = output.queue->pop(ctx.stop)) {
+    ++count;
+    EXPECT_EQ(item->meta.schema_id, "schema-out");
+    EXPECT_EQ(item->meta.trace_id[0], 0xAB);
+    const auto* attr = item->meta.get_attr("pipeline.partition");
+    ASSERT_NE(attr, nullptr);
+    EXPECT_EQ(std::get<int64_t>(*attr), 9);
+  }
+  EXPECT_EQ(count, 2);
+}
+
+TEST(RunFlatMapStageTest, StopsWhenOutputClosed) {
+  auto input = MakeQueueRuntime("in", 2);
+  auto output = MakeQueueRuntime("out", 2);
+
+  Payload split;
+  split.meta.flags = 5;
+
+  std::atomic<bool> stop_flag{false};
+  StageContext ctx{StopToken(&stop_flag)};
+
+  ASSERT_TRUE(input.queue->push(split, ctx.stop));
+  ASSERT_TRUE(input.queue->push(split, ctx.stop));
+  output.queue->close();
+
+  RepeatingFlatMapStage stage;
+  RecordingStageMetrics metrics;
+
+  RunFlatMapStage(&stage, ctx, input, output, &metrics);
+
+  EXPECT_EQ(metrics.queue_dequeues, 1);
+  EXPECT_EQ(metrics.queue_enqueues, 0);
+}
+
+TEST(RunFlatMapStageTest, ExceptionRequestsGlobalStop) {
+  auto input = MakeQueueRuntime("in", 1);
+  auto output = MakeQueueRuntime("out", 1);
+
+  std::atomic<bool> stop_flag{false};
+  StageContext ctx{StopToken(&stop_flag)};
+
+  ASSERT_TRUE(input.queue->push(Payload{}, ctx.stop));
+
+  ThrowingFlatMapStage stage;
+  RecordingStageMetrics metrics;
+
+  RunFlatMapStage(&stage, ctx, input, output, &metrics);
+
+  EXPECT_TRUE(stop_flag.load());
+  EXPECT_EQ(metrics.error_calls, 1);
+  EXPECT_EQ(metrics.queue_enqueues, 0);
+}
+
+// Routes each input to the output named by input.meta.flags.
+class RoutingFlatMapStage : public IFlatMapStage {
+ public:
+  std::string name() const override {
+    return "routing_flat_map";
+  }
+
+  void process(StageContext&, const Payload& input, Emitter& out) override {
+    out.emit_to(input.meta.flags, input);
+  }
+};
+
+TEST(RunFlatMapStageTest, EmitToRoutesToSelectedOutput) {
+  auto input = MakeQueueRuntime("in", 4);
+  auto left = MakeQueueRuntime("left", 4);
+  auto right = MakeQueueRuntime("right", 4);
+
+  std::atomic<bool> stop_flag{false};
+  StageContext ctx{StopToken(&stop_flag)};
+
+  for (uint32_t route : {1u, 0u, 1u, 7u}) {
+    Payload payload;
+    payload.meta.flags = route;
+    ASSERT_TRUE(input.queue->push(payload, ctx.stop));
+  }
+  input.queue->close();
+
+  RoutingFlatMapStage stage;
+  RecordingStageMetrics metrics;
+
+  RunFlatMapStage(&stage, ctx, QueueList{&input}, QueueList{&left, &right}, &metrics);
+  left.queue->close();
+  right.queue->close();
+
+  int left_count = 0;
+  while (left.queue->pop(ctx.stop)) {
+    ++left_count;
+  }
+  int right_count = 0;
+  while (right.queue->pop(ctx.stop)) {
+    ++right_count;
+  }
+
+  EXPECT_EQ(left_count, 1);
+  EXPECT_EQ(right_count, 2);
+  EXPECT_EQ(metrics.queue_enqueues, 3);
+  EXPECT_EQ(metrics.error_calls, 1);  // route 7 is out of range
+  EXPECT_FALSE(stop_flag.load());
+}
+
+TEST(RunTransformStageTest, BroadcastsToEveryOutput) {
+  auto input = MakeQueueRuntime("in", 2);
+  auto first = MakeQueueRuntime("first", 2, "schema-a");
+  auto second = MakeQueueRuntime("second", 2);
+
+  std::atomic<bool> stop_flag{false};
+  StageContext ctx{StopToken(&stop_flag)};
+
+  ASSERT_TRUE(input.queue->push(Payload{}, ctx.stop));
+  ASSERT_TRUE(input.queue->push(Payload{}, ctx.stop));
+  input.queue->close();
+
+  FakeTransformStage stage;
+  RecordingStageMetrics metrics;
+
+  RunTransformStage(&stage, ctx, QueueList{&input}, QueueList{&first, &second}, &metrics);
+  first.queue->close();
+  second.queue->close();
+
+  int first_count = 0;
+  while (auto item = first.queue->pop(ctx.stop)) {
+    EXPECT_EQ(item->meta.schema_id, "schema-a");
+    ++first_count;
+  }
+  int second_count = 0;
+  while (auto item = second.queue->pop(ctx.stop)) {
+    EXPECT_TRUE(item->meta.schema_id.empty());
+    ++second_count;
+  }
+
+  EXPECT_EQ(first_count, 2);
+  EXPECT_EQ(second_count, 2);
+  EXPECT_EQ(metrics.queue_dequeues, 2);
+  EXPECT_EQ(metrics.queue_enqueues, 4);
+  EXPECT_EQ(metrics.latency_calls, 2);
+}
+
+TEST(RunSinkStageTest, MergesInputsUntilAllAreDrained) {
+  auto busy = MakeQueueRuntime("busy", 8);
+  auto late = MakeQueueRuntime("late", 8);
+
+  std::atomic<bool> stop_flag{false};
+  StageContext ctx{StopToken(&stop_flag)};
+
+  for (uint32_t i = 0; i < 4; ++i) {
+    Payload payload;
+    payload.meta.flags = 0;
+    ASSERT_TRUE(busy.queue->push(payload, ctx.stop));
+  }
+  busy.queue->close();
+
+  FakeSinkStage stage;
+  RecordingStageMetrics metrics;
+
+  auto sink = std::async(std::launch::async, [&]() {
+    RunSinkStage(&stage, ctx, QueueList{&busy, &late}, &metrics);
+  });
+
+  // The sink must block on the idle input rather than exit or spin.
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_EQ(sink.wait_for(std::chrono::milliseconds(0)), std::future_status::timeout);
+
+  Payload payload;
+  payload.meta.flags = 1;
+  ASSERT_TRUE(late.queue->push(payload, ctx.stop));
+  late.queue->close();
+
+  ASSERT_EQ(sink.wait_for(std::chrono::seconds(1)), std::future_status::ready);
+  sink.get();
+
+  ASSERT_EQ(stage.seen_inputs.size(), 5u);
+  EXPECT_EQ(stage.seen_inputs.back().flags, 1u);
+  EXPECT_EQ(metrics.queue_dequeues, 5);
+}
+
+TEST(RunSinkStageTest, AlternatesBetweenReadyInputs) {
+  auto a = MakeQueueRuntime("a", 4);
+  auto b = MakeQueueRuntime("b", 4);
+
+  std::atomic<bool> stop_flag{false};
+  StageContext ctx{StopToken(&stop_flag)};
+
+  for (uint32_t i = 0; i < 3; ++i) {
+    Payload from_a;
+    from_a.meta.flags = 0;
+    Payload from_b;
+    from_b.meta.flags = 1;
+    ASSERT_TRUE(a.queue->push(from_a, ctx.stop));
+    ASSERT_TRUE(b.queue->push(from_b, ctx.stop));
+  }
+  a.queue->close();
+  b.queue->close();
+
+  FakeSinkStage stage;
+  RunSinkStage(&stage, ctx, QueueList{&a, &b}, nullptr);
+
+  ASSERT_EQ(stage.seen_inputs.size(), 6u);
+  for (std::size_t i = 1; i < stage.seen_inputs.size(); ++i) {
+    EXPECT_NE(stage.seen_inputs[i].flags, stage.seen_inputs[i - 1].flags);
+  }
+}
+
+TEST(FusedQueueTest, RunsConsumerChainOnProducerThread) {
+  auto edge = MakeQueueRuntime("edge", 1, "schema-1");
+  auto tail = MakeQueueRuntime("tail", 1);
+
+  std::atomic<bool> stop_flag{false};
+  StageContext ctx{StopToken(&stop_flag)};
+
+  FakeTransformStage transform;
+  FakeSinkStage sink;
+  RecordingStageMetrics metrics;
+
+  // source -> edge -> transform -> tail -> sink, all on this thread.
+  QueueList transform_outputs{&tail};
+  tail.queue = MakeFusedQueue(&sink, ctx, tail, {}, &metrics);
+  edge.queue = MakeFusedQueue(&transform, ctx, edge, transform_outputs, &metrics);
+
+  FakeSourceStage source(std::vector<Payload>(5));
+  RunSourceStage(&source, ctx, edge, &metrics);
+
+  EXPECT_EQ(transform.seen_inputs.size(), 5u);
+  ASSERT_EQ(sink.seen_inputs.size(), 5u);
+  EXPECT_EQ(sink.seen_inputs.front().schema_id, "schema-1");
+  EXPECT_EQ(metrics.queue_enqueues, 10);
+  EXPECT_EQ(metrics.queue_dequeues, 10);
+  EXPECT_EQ(metrics.latency_calls, 15);
+  EXPECT_FALSE(edge.queue->pop(ctx.stop).has_value());
+}
+
+TEST(FusedQueueTest, ClosedFusedQueueRejectsPushes) {
+  auto edge = MakeQueueRuntime("edge", 1);
+
+  std::atomic<bool> stop_flag{false};
+  StageContext ctx{StopToken(&stop_flag)};
+
+  FakeSinkStage sink;
+  edge.queue = MakeFusedQueue(&sink, ctx, edge, {}, nullptr);
+
+  EXPECT_TRUE(edge.queue->push(Payload{}, ctx.stop));
+  edge.queue->close();
+  EXPECT_FALSE(edge.queue->push(Payload{}, ctx.stop));
+  EXPECT_TRUE(edge.queue->drained());
+  EXPECT_EQ(sink.seen_inputs.size(), 1u);
+}
+
+TEST(FusedQueueTest, ConsumerExceptionStopsProducer) {
+  auto edge = MakeQueueRuntime("edge", 1);
+
+  std::atomic<bool> stop_flag{false};
+  StageContext ctx{StopToken(&stop_flag)};
+
+  ThrowingSinkStage sink;
+  RecordingStageMetrics metrics;
+  edge.queue = MakeFusedQueue(&sink, ctx, edge, {}, &metrics);
+
+  FakeSourceStage source(std::vector<Payload>(3));
+  RunSourceStage(&source, ctx, edge, &metrics);
+
+  EXPECT_TRUE(stop_flag.load());
+  EXPECT_EQ(metrics.error_calls, 1);
+  EXPECT_EQ(metrics.queue_dequeues, 1);
+  EXPECT_EQ(metrics.queue_enqueues, 0);
+}
+
 TEST(RunSinkStageTest, ConsumesPayloadsAndRecordsMetrics) {
   auto input = MakeQueueRuntime("in", 2);
 
@@ -517,6 +997,211 @@ TEST(RunSinkStageTest, EmptyPayloadSchemaIdDropsPayload) {
   EXPECT_EQ(stage.seen_inputs.size(), 0u);
 }
 
+class RecordingBatchSinkStage : public IBatchSinkStage {
+ public:
+  std::string name() const override {
+    return "recording_batch_sink";
+  }
+
+  void consume_batch(StageContext&, std::span<const Payload> batch) override {
+    std::lock_guard lock(mu);
+    std::vector<uint32_t> flags;
+    for (const auto& payload : batch) {
+      flags.push_back(payload.meta.flags);
+    }
+    batches.push_back(std::move(flags));
+    cv.notify_all();
+  }
+
+  size_t batch_count() {
+    std::lock_guard lock(mu);
+    return batches.size();
+  }
+
+  std::mutex mu;
+  std::condition_variable cv;
+  std::vector<std::vector<uint32_t>> batches;
+};
+
+Payload FlaggedPayload(uint32_t flags) {
+  Payload payload;
+  payload.meta.flags = flags;
+  return payload;
+}
+
+TEST(RunBatchSinkStageTest, SplitsQueuedPayloadsIntoFullBatches) {
+  auto input = MakeQueueRuntime("in", 8);
+  std::atomic<bool> stop_flag{false};
+  StageContext ctx{StopToken(&stop_flag)};
+
+  for (uint32_t i = 0; i < 5; ++i) {
+    ASSERT_TRUE(input.queue->push(FlaggedPayload(i), ctx.stop));
+  }
+  input.queue->close();
+
+  RecordingBatchSinkStage stage;
+  RecordingStageMetrics metrics;
+  RunBatchSinkStage(&stage, ctx, QueueList{&input}, &metrics,
+                    BatchOptions{.max_size = 2, .linger = std::chrono::milliseconds(0)});
+
+  ASSERT_EQ(stage.batches.size(), 3u);
+  EXPECT_EQ(stage.batches[0], (std::vector<uint32_t>{0, 1}));
+  EXPECT_EQ(stage.batches[1], (std::vector<uint32_t>{2, 3}));
+  EXPECT_EQ(stage.batches[2], (std::vector<uint32_t>{4}));
+  EXPECT_EQ(metrics.queue_dequeues, 5);
+  EXPECT_EQ(metrics.latency_calls, 3);
+}
+
+TEST(RunBatchSinkStageTest, LingerWaitsForLatePayloads) {
+  auto input = MakeQueueRuntime("in", 8);
+  std::atomic<bool> stop_flag{false};
+  StageContext ctx{StopToken(&stop_flag)};
+  RecordingBatchSinkStage stage;
+
+  auto runner = std::async(std::launch::async, [&]() {
+    RunBatchSinkStage(&stage, ctx, QueueList{&input}, nullptr,
+                      BatchOptions{.max_size = 3, .linger = std::chrono::seconds(5)});
+  });
+
+  ASSERT_TRUE(input.queue->push(FlaggedPayload(1), ctx.stop));
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_EQ(stage.batch_count(), 0u);
+  ASSERT_TRUE(input.queue->push(FlaggedPayload(2), ctx.stop));
+  ASSERT_TRUE(input.queue->push(FlaggedPayload(3), ctx.stop));
+
+  {
+    std::unique_lock lock(stage.mu);
+    ASSERT_TRUE(stage.cv.wait_for(lock, std::chrono::seconds(2),
+                                  [&] { return !stage.batches.empty(); }));
+    EXPECT_EQ(stage.batches[0], (std::vector<uint32_t>{1, 2, 3}));
+  }
+
+  input.queue->close();
+  ASSERT_EQ(runner.wait_for(std::chrono::seconds(2)), std::future_status::ready);
+}
+
+TEST(RunBatchSinkStageTest, FlushesPartialBatchWhenLingerExpires) {
+  auto input = MakeQueueRuntime("in", 8);
+  std::atomic<bool> stop_flag{false};
+  StageContext ctx{StopToken(&stop_flag)};
+  RecordingBatchSinkStage stage;
+
+  auto runner = std::async(std::launch::async, [&]() {
+    RunBatchSinkStage(&stage, ctx, QueueList{&input}, nullptr,
+                      BatchOptions{.max_size = 100, .linger = std::chrono::milliseconds(10)});
+  });
+
+  ASSERT_TRUE(input.queue->push(FlaggedPayload(7), ctx.stop));
+  {
+    std::unique_lock lock(stage.mu);
+    ASSERT_TRUE(stage.cv.wait_for(lock, std::chrono::seconds(2),
+                                  [&] { return !stage.batches.empty(); }));
+    EXPECT_EQ(stage.batches[0], (std::vector<uint32_t>{7}));
+  }
+
+  input.queue->close();
+  ASSERT_EQ(runner.wait_for(std::chrono::seconds(2)), std::future_status::ready);
+}
+
+class TimedSinkStage : public ISinkStage, public IStageTimers {
+ public:
+  std::string name() const override {
+    return "timed_sink";
+  }
+
+  void consume(StageContext&, const Payload&) override {
+    consumed.fetch_add(1);
+  }
+
+  void on_tick(StageContext&) override {
+    ticks.fetch_add(1);
+    if (throw_on_tick) {
+      throw std::runtime_error("tick failed");
+    }
+  }
+
+  void on_idle(StageContext&) override {
+    idles.fetch_add(1);
+  }
+
+  std::atomic<int> consumed{0};
+  std::atomic<int> ticks{0};
+  std::atomic<int> idles{0};
+  bool throw_on_tick = false;
+};
+
+TEST(StageTimersTest, TicksWhileInputIsEmpty) {
+  auto input = MakeQueueRuntime("in", 4);
+  std::atomic<bool> stop_flag{false};
+  StageContext ctx{StopToken(&stop_flag)};
+  TimedSinkStage sink;
+
+  TimerOptions timers;
+  timers.tick = std::chrono::milliseconds(5);
+  std::thread worker([&] { RunSinkStage(&sink, ctx, QueueList{&input}, nullptr, timers); });
+
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (sink.ticks.load() < 3 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  input.queue->close();
+  worker.join();
+
+  EXPECT_GE(sink.ticks.load(), 3);
+  EXPECT_EQ(sink.idles.load(), 0);
+  EXPECT_FALSE(stop_flag.load());
+}
+
+TEST(StageTimersTest, IdleFiresOncePerQuietPeriod) {
+  auto input = MakeQueueRuntime("in", 4);
+  std::atomic<bool> stop_flag{false};
+  StageContext ctx{StopToken(&stop_flag)};
+  TimedSinkStage sink;
+
+  TimerOptions timers;
+  timers.idle = std::chrono::milliseconds(20);
+  std::thread worker([&] { RunSinkStage(&sink, ctx, QueueList{&input}, nullptr, timers); });
+
+  // No payload yet: the idle period has not started.
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ(sink.idles.load(), 0);
+
+  ASSERT_TRUE(input.queue->push(Payload{}, ctx.stop));
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_EQ(sink.idles.load(), 1);
+
+  ASSERT_TRUE(input.queue->push(Payload{}, ctx.stop));
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (sink.idles.load() < 2 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  input.queue->close();
+  worker.join();
+
+  EXPECT_EQ(sink.consumed.load(), 2);
+  EXPECT_EQ(sink.idles.load(), 2);
+}
+
+TEST(StageTimersTest, ThrowingHookRequestsStop) {
+  auto input = MakeQueueRuntime("in", 4);
+  std::atomic<bool> stop_flag{false};
+  StageContext ctx{StopToken(&stop_flag)};
+  RecordingStageMetrics metrics;
+  TimedSinkStage sink;
+  sink.throw_on_tick = true;
+
+  TimerOptions timers;
+  timers.tick = std::chrono::milliseconds(1);
+  auto done = std::async(std::launch::async, [&] {
+    RunSinkStage(&sink, ctx, QueueList{&input}, &metrics, timers);
+  });
+
+  ASSERT_EQ(done.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+  EXPECT_TRUE(stop_flag.load());
+  EXPECT_EQ(sink.ticks.load(), 1);
+  EXPECT_EQ(metrics.error_calls, 1);
+}
+
 class SequencedSourceStage : public ISourceStage {
  public:
   explicit SequencedSourceStage(bool should_wait) : should_wait_(should_wait) {}
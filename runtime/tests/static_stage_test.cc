@@ -0,0 +1,151 @@
+// Compiles the stages below the way FLOWPIPE_STATIC_STAGES builds compile
+// stage sources into flow_runtime.
+#define FLOWPIPE_STATIC_STAGES 1
+
+#include "flowpipe/internal/static_stage_runner.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+
+#include "flowpipe/bounded_queue.h"
+#include "flowpipe/payload.h"
+#include "flowpipe/plugin.h"
+#include "flowpipe/queue_runtime.h"
+#include "flowpipe/stage.h"
+#include "flowpipe/stage_factory.h"
+#include "queue_runtime_helpers.h"
+
+namespace {
+
+class CountingSource final : public flowpipe::ISourceStage {
+ public:
+  std::string name() const override {
+    return "counting_source";
+  }
+
+  bool produce(flowpipe::StageContext&, flowpipe::Payload& out) override {
+    if (produced_ == 3) {
+      return false;
+    }
+    out = flowpipe::Payload(flowpipe::AllocatePayloadBuffer(1), 1);
+    out.data()[0] = ++produced_;
+    return true;
+  }
+
+ private:
+  uint8_t produced_ = 0;
+};
+
+class DoublingTransform final : public flowpipe::ITransformStage {
+ public:
+  std::string name() const override {
+    return "doubling_transform";
+  }
+
+  void process(flowpipe::StageContext&, const flowpipe::Payload& input,
+               flowpipe::Payload& output) override {
+    output = flowpipe::Payload(flowpipe::AllocatePayloadBuffer(1), 1);
+    output.data()[0] = input.data()[0] * 2;
+  }
+};
+
+class IdleBatchSink final : public flowpipe::IBatchSinkStage {
+ public:
+  std::string name() const override {
+    return "idle_batch_sink";
+  }
+
+  void consume_batch(flowpipe::StageContext&, std::span<const flowpipe::Payload>) override {}
+};
+
+}  // namespace
+
+FLOWPIPE_STAGE_PLUGIN(test_counting_source, CountingSource)
+FLOWPIPE_STAGE_PLUGIN(test_doubling_transform, DoublingTransform)
+FLOWPIPE_STAGE_PLUGIN(test_idle_batch_sink, IdleBatchSink)
+
+namespace flowpipe {
+namespace {
+
+TEST(StaticStageTest, FindsStagesByTypeOrPluginFileName) {
+  const StaticStage* by_type = FindStaticStage("test_doubling_transform");
+  ASSERT_NE(by_type, nullptr);
+  EXPECT_STREQ(by_type->type, "test_doubling_transform");
+  EXPECT_EQ(FindStaticStage("libstage_test_doubling_transform.so"), by_type);
+
+  EXPECT_EQ(FindStaticStage("/opt/plugins/libstage_test_doubling_transform.so"), nullptr);
+  EXPECT_EQ(FindStaticStage("libstage_missing.so"), nullptr);
+  EXPECT_EQ(FindStaticStage("libstage_.so"), nullptr);
+}
+
+TEST(StaticStageTest, DuplicateRegistrationIsRejected) {
+  const StaticStage* original = FindStaticStage("test_counting_source");
+  ASSERT_NE(original, nullptr);
+
+  EXPECT_FALSE(RegisterStaticStage(*original));
+  EXPECT_FALSE(RegisterStaticStage(StaticStage{.type = "test_incomplete"}));
+  EXPECT_EQ(FindStaticStage("test_incomplete"), nullptr);
+}
+
+TEST(StaticStageTest, FactoryResolvesLinkedStagesWithoutDlopen) {
+  StageFactory factory("/nonexistent");
+  LoadedPlugin plugin = factory.load("libstage_test_doubling_transform.so");
+
+  EXPECT_EQ(plugin.handle, nullptr);
+  EXPECT_EQ(plugin.path, "static:test_doubling_transform");
+  ASSERT_NE(plugin.create, nullptr);
+
+  IStage* stage = plugin.create();
+  ASSERT_NE(stage, nullptr);
+  EXPECT_EQ(stage->name(), "doubling_transform");
+  plugin.destroy(stage);
+  factory.unload(plugin);
+
+  EXPECT_THROW(factory.load("libstage_missing.so"), std::runtime_error);
+}
+
+TEST(StaticStageTest, OnlySpecializedKindsGetARunner) {
+  EXPECT_NE(FindStaticStage("test_counting_source")->run, nullptr);
+  EXPECT_NE(FindStaticStage("test_doubling_transform")->run, nullptr);
+  EXPECT_EQ(FindStaticStage("test_idle_batch_sink")->run, nullptr);
+}
+
+TEST(StaticStageTest, SpecializedRunnersMovePayloadsEndToEnd) {
+  auto source_out = MakeQueueRuntime("numbers", 4);
+  auto transform_out = MakeQueueRuntime("doubled", 4);
+  std::atomic<bool> stop_flag{false};
+  StageContext ctx{StopToken(&stop_flag)};
+
+  const StaticStage* source = FindStaticStage("test_counting_source");
+  const StaticStage* transform = FindStaticStage("test_doubling_transform");
+  IStage* source_stage = source->create();
+  IStage* transform_stage = transform->create();
+
+  source->run(source_stage, ctx, {}, QueueList{&source_out}, nullptr, {});
+  source_out.queue->close();
+  transform->run(transform_stage, ctx, QueueList{&source_out}, QueueList{&transform_out},
+                 nullptr, {});
+  transform_out.queue->close();
+
+  for (int expected : {2, 4, 6}) {
+    auto payload = transform_out.queue->pop(ctx.stop);
+    ASSERT_TRUE(payload.has_value());
+    ASSERT_EQ(payload->size, 1u);
+    EXPECT_EQ(payload->data()[0], expected);
+    EXPECT_GT(payload->meta.enqueue_ts_ns, 0u);
+  }
+  EXPECT_FALSE(transform_out.queue->pop(ctx.stop).has_value());
+  EXPECT_FALSE(stop_flag.load());
+
+  source->destroy(source_stage);
+  transform->destroy(transform_stage);
+}
+
+}  // namespace
+}  // namespace flowpipe
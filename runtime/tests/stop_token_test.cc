@@ -0,0 +1,46 @@
+#include "flowpipe/stop_token.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+
+namespace flowpipe {
+namespace {
+
+std::atomic<int> g_wakeups{0};
+
+void CountWakeup() noexcept {
+  g_wakeups.fetch_add(1);
+}
+
+TEST(StopTokenTest, FirstRequestStopWakesSupervisor) {
+  std::atomic<bool> stop_flag{false};
+  StopToken stop{&stop_flag, &CountWakeup};
+  g_wakeups = 0;
+
+  stop.request_stop();
+  stop.with_local(nullptr).request_stop();
+
+  EXPECT_TRUE(stop.stop_requested());
+  EXPECT_EQ(g_wakeups.load(), 1);
+}
+
+TEST(StopTokenTest, LocalFlagStopsOnlyItsCopy) {
+  std::atomic<bool> stop_flag{false};
+  std::atomic<bool> worker_flag{false};
+  StopToken stop{&stop_flag};
+  const StopToken worker = stop.with_local(&worker_flag);
+
+  worker_flag = true;
+  EXPECT_TRUE(worker.stop_requested());
+  EXPECT_FALSE(stop.stop_requested());
+  EXPECT_FALSE(stop_flag.load());
+
+  // request_stop() on the copy still stops everyone.
+  worker_flag = false;
+  worker.request_stop();
+  EXPECT_TRUE(stop.stop_requested());
+}
+
+}  // namespace
+}  // namespace flowpipe
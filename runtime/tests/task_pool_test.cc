@@ -0,0 +1,156 @@
+#include "flowpipe/task_pool.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "flowpipe/bounded_queue.h"
+#include "flowpipe/payload.h"
+#include "flowpipe/queue_runtime.h"
+#include "flowpipe/stage.h"
+#include "flowpipe/stage_runner.h"
+#include "queue_runtime_helpers.h"
+
+namespace flowpipe {
+namespace {
+
+class CountingSourceStage : public ISourceStage {
+ public:
+  explicit CountingSourceStage(uint32_t count) : count_(count) {}
+
+  std::string name() const override {
+    return "counting_source";
+  }
+
+  bool produce(StageContext&, Payload& out) override {
+    if (next_ >= count_) {
+      return false;
+    }
+    out.meta.flags = next_++;
+    return true;
+  }
+
+ private:
+  uint32_t count_;
+  uint32_t next_ = 0;
+};
+
+class PassThroughStage : public ITransformStage {
+ public:
+  std::string name() const override {
+    return "pass_through";
+  }
+
+  void process(StageContext&, const Payload& input, Payload& output) override {
+    output = input;
+  }
+};
+
+class CollectingSinkStage : public ISinkStage {
+ public:
+  std::string name() const override {
+    return "collecting_sink";
+  }
+
+  void consume(StageContext&, const Payload& input) override {
+    seen.push_back(input.meta.flags);
+  }
+
+  std::vector<uint32_t> seen;
+};
+
+// A single pool thread can only finish this pipeline if tasks yield when
+// their input is empty or their output is full.
+TEST(TaskPoolTest, SingleThreadRunsWholePipelineThroughSmallQueues) {
+  auto q1 = MakeQueueRuntime("q1", 1);
+  auto q2 = MakeQueueRuntime("q2", 1);
+
+  std::atomic<bool> stop_flag{false};
+  StageContext ctx{StopToken(&stop_flag)};
+
+  CountingSourceStage source(500);
+  PassThroughStage transform;
+  CollectingSinkStage sink;
+
+  std::promise<void> all_done;
+  std::atomic<int> remaining{3};
+  auto on_done = [&](QueueRuntime* output) {
+    return [&, output]() {
+      if (output) {
+        output->queue->close();
+      }
+      if (remaining.fetch_sub(1) == 1) {
+        all_done.set_value();
+      }
+    };
+  };
+
+  TaskPool pool(1);
+  pool.Submit(MakeStageTask(&sink, ctx, {&q2}, {}, nullptr), on_done(nullptr));
+  pool.Submit(MakeStageTask(&transform, ctx, {&q1}, {&q2}, nullptr), on_done(&q2));
+  pool.Submit(MakeStageTask(&source, ctx, {}, {&q1}, nullptr), on_done(&q1));
+
+  ASSERT_EQ(all_done.get_future().wait_for(std::chrono::seconds(5)), std::future_status::ready);
+  pool.Shutdown();
+
+  ASSERT_EQ(sink.seen.size(), 500u);
+  for (uint32_t i = 0; i < sink.seen.size(); ++i) {
+    EXPECT_EQ(sink.seen[i], i);
+  }
+}
+
+TEST(TaskPoolTest, ParkedTaskWakesWhenInputArrives) {
+  auto input = MakeQueueRuntime("in", 4);
+
+  std::atomic<bool> stop_flag{false};
+  StageContext ctx{StopToken(&stop_flag)};
+
+  CollectingSinkStage sink;
+  std::promise<void> done;
+
+  TaskPool pool(2);
+  pool.Submit(MakeStageTask(&sink, ctx, {&input}, {}, nullptr), [&]() { done.set_value(); });
+
+  auto finished = done.get_future();
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_EQ(finished.wait_for(std::chrono::milliseconds(0)), std::future_status::timeout);
+
+  Payload payload;
+  payload.meta.flags = 7;
+  ASSERT_TRUE(input.queue->push(payload, ctx.stop));
+  input.queue->close();
+
+  ASSERT_EQ(finished.wait_for(std::chrono::seconds(1)), std::future_status::ready);
+  pool.Shutdown();
+
+  ASSERT_EQ(sink.seen.size(), 1u);
+  EXPECT_EQ(sink.seen.front(), 7u);
+}
+
+TEST(TaskPoolTest, StopEndsTasksOnceQueuesClose) {
+  auto input = MakeQueueRuntime("in", 4);
+
+  std::atomic<bool> stop_flag{false};
+  StageContext ctx{StopToken(&stop_flag)};
+
+  CollectingSinkStage sink;
+  std::promise<void> done;
+
+  TaskPool pool(1);
+  pool.Submit(MakeStageTask(&sink, ctx, {&input}, {}, nullptr), [&]() { done.set_value(); });
+
+  ctx.request_stop();
+  input.queue->close();
+
+  EXPECT_EQ(done.get_future().wait_for(std::chrono::seconds(1)), std::future_status::ready);
+  pool.Shutdown();
+  EXPECT_TRUE(sink.seen.empty());
+}
+
+}  // namespace
+}  // namespace flowpipe
@@ -0,0 +1,60 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "flowpipe/observability/tracing.h"
+
+namespace flowpipe::observability {
+namespace {
+
+TEST(TraceIdsTest, SpanIdsAreNonZeroAndDistinct) {
+  constexpr int kIds = 100000;
+  std::set<uint64_t> seen;
+  for (int i = 0; i < kIds; ++i) {
+    const uint64_t id = NextSpanId();
+    EXPECT_NE(id, 0u);
+    seen.insert(id);
+  }
+  EXPECT_EQ(seen.size(), static_cast<size_t>(kIds));
+}
+
+TEST(TraceIdsTest, ThreadsDrawDifferentSequences) {
+  constexpr int kThreads = 4;
+  constexpr int kIds = 10000;
+  std::vector<std::vector<uint64_t>> ids(kThreads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&ids, t] {
+      for (int i = 0; i < kIds; ++i) {
+        ids[t].push_back(NextSpanId());
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  std::set<uint64_t> seen;
+  for (const auto& sequence : ids) {
+    seen.insert(sequence.begin(), sequence.end());
+  }
+  EXPECT_EQ(seen.size(), static_cast<size_t>(kThreads) * kIds);
+}
+
+TEST(TraceIdsTest, TraceIdsAreNonZeroAndDistinct) {
+  uint8_t first[16];
+  uint8_t second[16];
+  const uint8_t zero[16] = {};
+  NextTraceId(first);
+  NextTraceId(second);
+  EXPECT_NE(std::memcmp(first, zero, sizeof(first)), 0);
+  EXPECT_NE(std::memcmp(second, zero, sizeof(second)), 0);
+  EXPECT_NE(std::memcmp(first, second, sizeof(first)), 0);
+}
+
+}  // namespace
+}  // namespace flowpipe::observability
@@ -131,16 +131,4 @@ private:
   std::chrono::milliseconds delay_{0};
 };
 
-extern "C" {
-
-FLOWPIPE_PLUGIN_API IStage* flowpipe_create_stage() {
-  FP_LOG_INFO("creating noop_source stage");
-  return new NoopSource();
-}
-
-FLOWPIPE_PLUGIN_API void flowpipe_destroy_stage(IStage* stage) {
-  FP_LOG_INFO("destroying noop_source stage");
-  delete stage;
-}
-
-}  // extern "C"
+FLOWPIPE_STAGE_PLUGIN(noop_source, NoopSource)
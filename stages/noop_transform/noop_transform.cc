@@ -10,6 +10,7 @@
 
 #include <thread>
 #include <chrono>
+#include <memory>
 #include <string>
 
 using namespace flowpipe;
@@ -44,21 +45,26 @@ public:
       return false;
     }
 
-    config_ = std::move(cfg);
+    config_ = std::make_shared<const NoopTransformConfig>(std::move(cfg));
 
     FP_LOG_INFO("noop_transform configured");
 
-    if (config_.verbose()) {
+    if (config_->verbose()) {
       FP_LOG_INFO("noop_transform verbose logging enabled");
     }
 
-    if (config_.delay_ms() > 0) {
+    if (config_->delay_ms() > 0) {
       FP_LOG_INFO("noop_transform delay enabled");
     }
 
     return true;
   }
 
+  // Workers share the parsed config instead of re-parsing it.
+  IStage* clone() const override {
+    return new NoopTransform(*this);
+  }
+
   // ------------------------------------------------------------
   // ITransformStage
   // ------------------------------------------------------------
@@ -69,13 +75,13 @@ public:
       return;
     }
 
-    if (config_.verbose()) {
+    if (config_->verbose()) {
       FP_LOG_DEBUG("noop_transform processing payload");
     }
 
-    if (config_.delay_ms() > 0) {
+    if (config_->delay_ms() > 0) {
       std::this_thread::sleep_for(
-          std::chrono::milliseconds(config_.delay_ms()));
+          std::chrono::milliseconds(config_->delay_ms()));
     }
 
     // Pass-through
@@ -83,19 +89,11 @@ public:
   }
 
 private:
-  NoopTransformConfig config_{};
-};
+  NoopTransform(const NoopTransform&) = default;
 
-extern "C" {
-
-FLOWPIPE_PLUGIN_API IStage* flowpipe_create_stage() {
-  FP_LOG_INFO("creating noop_transform stage");
-  return new NoopTransform();
-}
-
-FLOWPIPE_PLUGIN_API void flowpipe_destroy_stage(IStage* stage) {
-  FP_LOG_INFO("destroying noop_transform stage");
-  delete stage;
-}
+  // Immutable once configured; shared with clones.
+  std::shared_ptr<const NoopTransformConfig> config_ =
+      std::make_shared<const NoopTransformConfig>();
+};
 
-}  // extern "C"
+FLOWPIPE_STAGE_PLUGIN(noop_transform, NoopTransform)
@@ -43,16 +43,4 @@ public:
   }
 };
 
-extern "C" {
-
-  FLOWPIPE_PLUGIN_API IStage* flowpipe_create_stage() {
-    FP_LOG_INFO("creating stdout_sink stage");
-    return new StdoutSink();
-  }
-
-  FLOWPIPE_PLUGIN_API void flowpipe_destroy_stage(IStage* stage) {
-    FP_LOG_INFO("destroying stdout_sink stage");
-    delete stage;
-  }
-
-}  // extern "C"
+FLOWPIPE_STAGE_PLUGIN(stdout_sink, StdoutSink)